@@ -24,6 +24,7 @@ using System.Windows.Automation.Peers;
 using System.Windows.Automation.Provider;
 using System.Diagnostics;
 using System.Threading;
+using System.Xml.Linq;
 namespace Configuration_Utility
 {
     /// <summary>
@@ -97,6 +98,11 @@ namespace Configuration_Utility
             Sensor3.service_name = "Tuio-to-Vmulti-Service-3.exe";
             Sensor4.service_name = "Tuio-to-Vmulti-Service-4.exe";
             Sensor5.service_name = "Tuio-to-Vmulti-Service-5.exe";
+            Sensor1.frame_mirror_name = "Global\\TuioFrames1";
+            Sensor2.frame_mirror_name = "Global\\TuioFrames2";
+            Sensor3.frame_mirror_name = "Global\\TuioFrames3";
+            Sensor4.frame_mirror_name = "Global\\TuioFrames4";
+            Sensor5.frame_mirror_name = "Global\\TuioFrames5";
 
             load_values_from_config_files();
 
@@ -651,6 +657,53 @@ namespace Configuration_Utility
             do_apply_stuff();
         }
 
+        // The services read the settings of all sensors from the profile in sensors.xml, where they
+        // take precedence over those in sensorN.cfg, and apply changes of it without a restart. The
+        // settings of this window replace their attributes in it, the rest of the profile is kept.
+        private void update_profile(string path)
+        {
+            XDocument profile = System.IO.File.Exists(path) ? XDocument.Load(path) : new XDocument(new XElement("profile"));
+            Sensor[] sensors = { Sensor1, Sensor2, Sensor3, Sensor4, Sensor5 };
+            for (int i = 0; i < sensors.Length; i++)
+            {
+                string id = (i + 1).ToString();
+                XElement sensor = profile.Root.Elements("sensor").FirstOrDefault(element => (string)element.Attribute("id") == id);
+                if (sensor == null)
+                {
+                    sensor = new XElement("sensor", new XAttribute("id", id));
+                    profile.Root.Add(sensor);
+                }
+                set_profile_setting(sensor, "input", "port", sensors[i].tuio_port.Text);
+                set_profile_setting(sensor, "transform", "invert_x", sensors[i].invert_horizontal.IsChecked.ToString());
+                set_profile_setting(sensor, "transform", "invert_y", sensors[i].invert_verticle.IsChecked.ToString());
+                set_profile_setting(sensor, "transform", "swap_xy", sensors[i].swap_xy.IsChecked.ToString());
+                set_profile_setting(sensor, "display", "xrange_min", sensors[i].xrange_min.Text);
+                set_profile_setting(sensor, "display", "xrange_max", sensors[i].xrange_max.Text);
+                set_profile_setting(sensor, "display", "yrange_min", sensors[i].yrange_min.Text);
+                set_profile_setting(sensor, "display", "yrange_max", sensors[i].yrange_max.Text);
+                set_profile_setting(sensor, "display", "x_offset", sensors[i].x_offset.Text);
+                set_profile_setting(sensor, "display", "y_offset", sensors[i].y_offset.Text);
+            }
+
+            // the services read the profile as soon as it is replaced, never while it is written
+            profile.Save(path + ".tmp");
+            if (System.IO.File.Exists(path))
+                System.IO.File.Replace(path + ".tmp", path, null);
+            else
+                System.IO.File.Move(path + ".tmp", path);
+        }
+
+        private void set_profile_setting(XElement sensor, string element, string attribute, string value)
+        {
+            XElement settings = sensor.Element(element);
+            if (settings == null)
+            {
+                settings = new XElement(element);
+                sensor.Add(settings);
+            }
+            settings.SetAttributeValue(attribute, value);
+        }
+
         private void do_apply_stuff()
         {
 
@@ -706,6 +759,7 @@ namespace Configuration_Utility
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\y03.txt", Sensor3.y_offset.Text);
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\y04.txt", Sensor4.y_offset.Text);
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\y05.txt", Sensor5.y_offset.Text);
+            update_profile("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\sensors.xml");
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\service1.txt", get_service_status("Tuio-To-vmulti-Device1"));
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\service2.txt", get_service_status("Tuio-To-vmulti-Device2"));
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\service3.txt", get_service_status("Tuio-To-vmulti-Device3"));
@@ -783,6 +837,7 @@ namespace Configuration_Utility
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\yrange_max3.txt", Sensor3.yrange_max.Text.ToString());
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\yrange_max4.txt", Sensor4.yrange_max.Text.ToString());
             System.IO.File.WriteAllText("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\yrange_max5.txt", Sensor5.yrange_max.Text.ToString());
+            update_profile("C:\\Users\\AppData\\TUIO-To-Vmulti\\Data\\sensors.xml");
             //Installs service if it's not already installed . 
             install_service(service_name, sensor.service_name, sensor.tuio_port.Text);
             
@@ -57,9 +57,14 @@ namespace Configuration_Utility
             debug.IsChecked = true;
         }
         public TuioClient client = null;
+        // the shared memory the running service publishes its frames in, see frame_mirror in the service settings
+        public string frame_mirror_name = "";
+        TuioFrameMirror mirror = null;
+        List<TuioFrameMirrorContact> mirrorContacts = new List<TuioFrameMirrorContact>(64);
         Timer timer1;
         public void addtuioclient()
         {
+            closeframemirror();
             client = null;
             client = new TuioClient(Convert.ToInt32(tuio_port.Text));
 
@@ -68,10 +73,7 @@ namespace Configuration_Utility
                 client.addTuioListener(Listener);
                 client.connect();
                 Console.WriteLine("listening to TUIO messages at port " + client.getPort());
-                timer1 = new Timer();
-                timer1.Interval = 100;
-                timer1.Enabled = true;
-                timer1.Tick += new System.EventHandler(OnTimerEvent);
+                starttimer();
             }
             else Console.WriteLine("usage: java TuioDump [port]");
         }
@@ -87,7 +89,64 @@ namespace Configuration_Utility
                 client.disconnect();
                 // Console.WriteLine("test 5.3");
             }
+            lock (cursorSync)
+            {
+                cursorList.Clear();
+            }
+            // the service owns the port now, follow the frames it writes to the device instead
+            openframemirror();
+
+        }
+
+        void starttimer()
+        {
+            if (timer1 != null) return;
+            timer1 = new Timer();
+            timer1.Interval = 100;
+            timer1.Enabled = true;
+            timer1.Tick += new System.EventHandler(OnTimerEvent);
+        }
+
+        void openframemirror()
+        {
+            if (frame_mirror_name == "" || mirror != null) return;
+            // opened on the next tick, once the service has started
+            mirror = new TuioFrameMirror(frame_mirror_name);
+            starttimer();
+        }
+
+        void closeframemirror()
+        {
+            if (mirror != null) mirror.close();
+            mirror = null;
+        }
 
+        void drawframemirror()
+        {
+            if (mirror.read(mirrorContacts) != true || mirrorContacts.Count == 0)
+            {
+                l2 = new System.Windows.Controls.Label();
+                l2.Content = mirror.isOpen() ? "Touch Your Sensor" : "Waiting for the Service";
+                VisualFeedback.Children.Add(l2);
+                Canvas.SetLeft(l2, 35);
+                Canvas.SetTop(l2, 130);
+                return;
+            }
+            foreach (TuioFrameMirrorContact contact in mirrorContacts)
+            {
+                // released contacts stay in the frame they were released in
+                if (contact.status == 0) continue;
+                // the service already applied the calibration, the position is drawn as it is sent
+                Ellipse ellipse = new Ellipse
+                {
+                    Fill = new SolidColorBrush(Colors.CadetBlue),
+                    Width = 15,
+                    Height = 15,
+                    Opacity = 1,
+                    Margin = new Thickness(contact.x * VisualFeedback.Width - VisualFeedback.Height / 100, contact.y * VisualFeedback.Height - VisualFeedback.Height / 100, 0, 0)
+                };
+                VisualFeedback.Children.Add(ellipse);
+            }
         }
         double xrangemin = 0;
         double xrangemax = 1;
@@ -97,6 +156,11 @@ namespace Configuration_Utility
         {
             // Console.WriteLine(System.IO.Path.GetDirectoryName(System.Diagnostics.Process.GetCurrentProcess().MainModule.FileName) + "\\" + service_name);
             VisualFeedback.Children.Clear();
+            if (mirror != null)
+            {
+                drawframemirror();
+                return;
+            }
             if (cursorList.Count > 0)
             {
                 lock (cursorSync)
@@ -0,0 +1,173 @@
+/*
+	TUIO C# Library - part of the reacTIVision project
+	http://reactivision.sourceforge.net/
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+using System;
+using System.Threading;
+using System.Collections.Generic;
+using System.IO.MemoryMappedFiles;
+
+namespace TUIO
+{
+	/**
+	 * A contact of a frame that was read from a {@link TuioFrameMirror}
+	 */
+	public struct TuioFrameMirrorContact
+	{
+		public int id;
+		public int status;
+		public float rawX, rawY;
+		public float sensorX, sensorY;
+		public float x, y;
+	}
+
+	/**
+	 * The TuioFrameMirror reads the last frame that a running service wrote to its device from the
+	 * shared memory the service publishes it in, "Global\TuioFrames1" for the first sensor unless the
+	 * frame_mirror setting names another one. It does not open a socket, so it can follow the sensor
+	 * while the service owns its port.
+	 *
+	 * The layout has to match TuioFrameMirror.cpp of the services: a 128 byte header followed by the
+	 * contacts of 32 bytes each. The frame is guarded by a sequence that is odd while the service
+	 * writes it, a copy that saw the sequence change is discarded and read again.
+	 */
+	public class TuioFrameMirror
+	{
+		private const int MAGIC = 0x54554646;
+		private const int VERSION = 1;
+		private const int CONTACT_SIZE = 32;
+		private const int CONTACTS_OFFSET = 128;
+		private const int READ_ATTEMPTS = 100;
+
+		private string name;
+		private MemoryMappedFile file;
+		private MemoryMappedViewAccessor view;
+		private int maxContacts;
+
+		private long frameID = -1;
+		private long frameTime = 0;
+		private long generation = 0;
+
+		/**
+		 * This constructor creates a reader of the provided shared memory, it is opened by {@link #read}
+		 *
+		 * @param name the name of the shared memory, as configured in the frame_mirror setting of the service
+		 */
+		public TuioFrameMirror(string name) {
+			this.name = name;
+		}
+
+		/**
+		 * Returns true while the shared memory of a running service is open.
+		 * @return	true while the shared memory is open
+		 */
+		public bool isOpen() { return view!=null; }
+
+		/**
+		 * Returns the TUIO frame ID of the last frame that was read.
+		 * @return	the frame ID, -1 before the first frame
+		 */
+		public long getFrameID() { return frameID; }
+
+		/**
+		 * Returns the TUIO time of the last frame that was read in microseconds.
+		 * @return	the frame time
+		 */
+		public long getFrameTime() { return frameTime; }
+
+		/**
+		 * Returns the configuration generation the last frame was transformed with.
+		 * @return	the configuration generation
+		 */
+		public long getGeneration() { return generation; }
+
+		/**
+		 * Copies the last published frame, the shared memory is opened first if it is not open yet,
+		 * and closed again once the service went away.
+		 *
+		 * @param contacts	the list that receives the contacts of the frame, it is cleared first
+		 * @return	false if no service publishes to the shared memory or the frame could not be read
+		 */
+		public bool read(List<TuioFrameMirrorContact> contacts) {
+			contacts.Clear();
+			if ((view==null) && !open()) return false;
+			if (view.ReadInt32(16)!=0) {
+				close();
+				return false;
+			}
+
+			for (int attempt=0; attempt<READ_ATTEMPTS; attempt++) {
+				int sequence = view.ReadInt32(64);
+				if ((sequence&1)!=0) {
+					Thread.SpinWait(20);
+					continue;
+				}
+				Thread.MemoryBarrier();
+
+				int count = Math.Min(Math.Max(view.ReadInt32(68), 0), maxContacts);
+				long id = view.ReadInt64(72);
+				long time = view.ReadInt64(80);
+				long gen = view.ReadInt64(88);
+				contacts.Clear();
+				for (int i=0; i<count; i++) {
+					TuioFrameMirrorContact contact;
+					view.Read(CONTACTS_OFFSET+i*CONTACT_SIZE, out contact);
+					contacts.Add(contact);
+				}
+
+				Thread.MemoryBarrier();
+				if (view.ReadInt32(64)==sequence) {
+					frameID = id;
+					frameTime = time;
+					generation = gen;
+					return true;
+				}
+			}
+			contacts.Clear();
+			return false;
+		}
+
+		/**
+		 * Closes the shared memory, it is opened again by the next {@link #read}
+		 */
+		public void close() {
+			if (view!=null) view.Dispose();
+			if (file!=null) file.Dispose();
+			view = null;
+			file = null;
+		}
+
+		private bool open() {
+			try {
+				file = MemoryMappedFile.OpenExisting(name, MemoryMappedFileRights.Read);
+				view = file.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+				if ((view.ReadInt32(0)!=MAGIC) || (view.ReadInt32(4)!=VERSION) || (view.ReadInt32(12)!=CONTACT_SIZE)) {
+					Console.WriteLine("incompatible frame mirror "+name);
+					close();
+					return false;
+				}
+				maxContacts = (int)Math.Min(view.ReadInt32(8), (view.Capacity-CONTACTS_OFFSET)/CONTACT_SIZE);
+				return true;
+			} catch (Exception) {
+				// the service is not running or publishes to another name
+				close();
+				return false;
+			}
+		}
+	}
+}
@@ -0,0 +1,231 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOATOMIC_H
+#define INCLUDED_TUIOATOMIC_H
+
+#ifndef WIN32
+#include <sched.h>
+#else
+#include <windows.h>
+#include <intrin.h>
+#endif
+
+namespace TUIO {
+
+	/**
+	 * Minimal set of atomic operations used by the lock-free parts of the TUIO library.
+	 * The posix implementation maps onto the GCC __atomic builtins, the Windows implementation
+	 * onto the Interlocked API, so that neither platform needs a C++11 runtime.
+	 * Loads have acquire semantics, stores have release semantics and all read-modify-write
+	 * operations are sequentially consistent.
+	 */
+
+	inline long atomicLoad(volatile long *value) {
+#ifndef WIN32
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+		long result = *value;
+		_ReadWriteBarrier();
+		return result;
+#endif
+	}
+
+	inline void atomicStore(volatile long *value, long v) {
+#ifndef WIN32
+		__atomic_store_n(value, v, __ATOMIC_RELEASE);
+#else
+		_ReadWriteBarrier();
+		*value = v;
+#endif
+	}
+
+	/**
+	 * Atomically adds the provided amount and returns the resulting value
+	 */
+	inline long atomicAdd(volatile long *value, long amount) {
+#ifndef WIN32
+		return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedExchangeAdd(value, amount) + amount;
+#endif
+	}
+
+	inline long atomicExchange(volatile long *value, long v) {
+#ifndef WIN32
+		return __atomic_exchange_n(value, v, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedExchange(value, v);
+#endif
+	}
+
+	/**
+	 * Replaces the value with desired if it currently equals expected
+	 *
+	 * @return true if the value was replaced
+	 */
+	inline bool atomicCompareExchange(volatile long *value, long expected, long desired) {
+#ifndef WIN32
+		return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedCompareExchange(value, desired, expected) == expected;
+#endif
+	}
+
+	/**
+	 * 32-bit values, for memory shared with processes of another word size.
+	 * Stores are sequentially consistent, so that a flag stored before checking
+	 * the other side's state is seen by that side
+	 */
+	inline int atomicLoad32(volatile int *value) {
+#ifndef WIN32
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+		int result = *value;
+		_ReadWriteBarrier();
+		return result;
+#endif
+	}
+
+	inline void atomicStore32(volatile int *value, int v) {
+#ifndef WIN32
+		__atomic_store_n(value, v, __ATOMIC_SEQ_CST);
+#else
+		InterlockedExchange((volatile LONG*)value, v);
+#endif
+	}
+
+	inline int atomicExchange32(volatile int *value, int v) {
+#ifndef WIN32
+		return __atomic_exchange_n(value, v, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedExchange((volatile LONG*)value, v);
+#endif
+	}
+
+	inline int atomicAdd32(volatile int *value, int amount) {
+#ifndef WIN32
+		return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedExchangeAdd((volatile LONG*)value, amount) + amount;
+#endif
+	}
+
+	/**
+	 * 64-bit counters, also atomic on 32-bit Windows builds
+	 */
+	inline long long atomicLoad64(volatile long long *value) {
+#ifndef WIN32
+		return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+		return InterlockedCompareExchange64(value, 0, 0);
+#endif
+	}
+
+	inline void atomicStore64(volatile long long *value, long long v) {
+#ifndef WIN32
+		__atomic_store_n(value, v, __ATOMIC_RELEASE);
+#else
+		InterlockedExchange64(value, v);
+#endif
+	}
+
+	inline long long atomicAdd64(volatile long long *value, long long amount) {
+#ifndef WIN32
+		return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedExchangeAdd64(value, amount) + amount;
+#endif
+	}
+
+	/**
+	 * Raises the stored value to v if v is larger, used for maximum trackers
+	 */
+	inline void atomicMax64(volatile long long *value, long long v) {
+		long long current = atomicLoad64(value);
+		while (v > current) {
+#ifndef WIN32
+			if (__atomic_compare_exchange_n(value, &current, v, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) break;
+#else
+			long long previous = InterlockedCompareExchange64(value, v, current);
+			if (previous == current) break;
+			current = previous;
+#endif
+		}
+	}
+
+	inline void* atomicLoadPointer(void * volatile *pointer) {
+#ifndef WIN32
+		return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+#else
+		void *result = *pointer;
+		_ReadWriteBarrier();
+		return result;
+#endif
+	}
+
+	inline void atomicStorePointer(void * volatile *pointer, void *p) {
+#ifndef WIN32
+		__atomic_store_n(pointer, p, __ATOMIC_RELEASE);
+#else
+		_ReadWriteBarrier();
+		*pointer = p;
+#endif
+	}
+
+	/**
+	 * Swaps in the provided pointer and returns the previously stored one
+	 */
+	inline void* atomicExchangePointer(void * volatile *pointer, void *p) {
+#ifndef WIN32
+		return __atomic_exchange_n(pointer, p, __ATOMIC_SEQ_CST);
+#else
+		return InterlockedExchangePointer(pointer, p);
+#endif
+	}
+
+	/**
+	 * Full memory fence
+	 */
+	inline void atomicFence() {
+#ifndef WIN32
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+		MemoryBarrier();
+#endif
+	}
+
+	/**
+	 * Hints the CPU that the calling thread is busy waiting
+	 */
+	inline void cpuRelax() {
+#ifndef WIN32
+#if defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+#else
+		sched_yield();
+#endif
+#else
+		YieldProcessor();
+#endif
+	}
+};
+#endif /* INCLUDED_TUIOATOMIC_H */
@@ -0,0 +1,171 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioCalibrationGrid.h"
+
+#include <math.h>
+
+// pivots below this part of the largest matrix entry make the system singular
+#define SINGULAR_PIVOT 1e-12
+
+using namespace TUIO;
+
+TuioCalibrationGrid::TuioCalibrationGrid(int c, int r)
+: columns(c<2 ? 2 : c)
+, rows   (r<2 ? 2 : r)
+, nodes  (columns*rows*2)
+, error  (0)
+{
+	for (int j=0; j<rows; j++) {
+		for (int i=0; i<columns; i++) {
+			nodes[(j*columns+i)*2] = (float)i/(columns-1);
+			nodes[(j*columns+i)*2+1] = (float)j/(rows-1);
+		}
+	}
+}
+
+// solves the n x n system in place with partial pivoting, for count right hand sides stored n x count
+static bool solve(std::vector<double> &matrix, std::vector<double> &rhs, int n, int count) {
+	double largest = 0;
+	for (int i=0; i<n*n; i++) if (fabs(matrix[i])>largest) largest = fabs(matrix[i]);
+	if (largest==0) return false;
+
+	for (int k=0; k<n; k++) {
+		int pivot = k;
+		for (int i=k+1; i<n; i++) if (fabs(matrix[i*n+k])>fabs(matrix[pivot*n+k])) pivot = i;
+		if (fabs(matrix[pivot*n+k])<SINGULAR_PIVOT*largest) return false;
+		if (pivot!=k) {
+			for (int j=0; j<n; j++) {
+				double tmp = matrix[k*n+j];
+				matrix[k*n+j] = matrix[pivot*n+j];
+				matrix[pivot*n+j] = tmp;
+			}
+			for (int j=0; j<count; j++) {
+				double tmp = rhs[k*count+j];
+				rhs[k*count+j] = rhs[pivot*count+j];
+				rhs[pivot*count+j] = tmp;
+			}
+		}
+		for (int i=k+1; i<n; i++) {
+			double f = matrix[i*n+k]/matrix[k*n+k];
+			if (f==0) continue;
+			for (int j=k; j<n; j++) matrix[i*n+j] -= f*matrix[k*n+j];
+			for (int j=0; j<count; j++) rhs[i*count+j] -= f*rhs[k*count+j];
+		}
+	}
+	for (int k=n-1; k>=0; k--) {
+		for (int j=0; j<count; j++) {
+			double sum = rhs[k*count+j];
+			for (int i=k+1; i<n; i++) sum -= matrix[k*n+i]*rhs[i*count+j];
+			rhs[k*count+j] = sum/matrix[k*n+k];
+		}
+	}
+	return true;
+}
+
+// the homography with h[8]=1, in the least squares sense for more than four points
+static bool fitHomography(const std::vector<TuioCalibrationPoint> &points, double *h) {
+	std::vector<double> normal(64, 0.0), rhs(8, 0.0);
+	for (size_t p=0; p<points.size(); p++) {
+		double x = points[p].sensorX, y = points[p].sensorY;
+		double u = points[p].screenX, v = points[p].screenY;
+		double rows[2][8] = {
+			{ x, y, 1, 0, 0, 0, -u*x, -u*y },
+			{ 0, 0, 0, x, y, 1, -v*x, -v*y }
+		};
+		double b[2] = { u, v };
+		for (int r=0; r<2; r++) {
+			for (int i=0; i<8; i++) {
+				for (int j=0; j<8; j++) normal[i*8+j] += rows[r][i]*rows[r][j];
+				rhs[i] += rows[r][i]*b[r];
+			}
+		}
+	}
+	if (!solve(normal, rhs, 8, 1)) return false;
+	for (int i=0; i<8; i++) h[i] = rhs[i];
+	h[8] = 1;
+	return true;
+}
+
+static bool applyHomography(const double *h, double x, double y, double &u, double &v) {
+	double w = h[6]*x+h[7]*y+h[8];
+	// the surface folds over behind the camera
+	if (w<=0) return false;
+	u = (h[0]*x+h[1]*y+h[2])/w;
+	v = (h[3]*x+h[4]*y+h[5])/w;
+	return true;
+}
+
+// the radial basis of the thin plate spline, r^2 log r
+static inline double spline(double dx, double dy) {
+	double r2 = dx*dx+dy*dy;
+	return (r2>0) ? 0.5*r2*log(r2) : 0;
+}
+
+bool TuioCalibrationGrid::fit(const std::vector<TuioCalibrationPoint> &points, float smoothing) {
+	int n = (int)points.size();
+	if (n<4) return false;
+
+	double h[9];
+	if (!fitHomography(points, h)) return false;
+
+	// the spline through the residuals of the homography, with an affine part
+	int size = n+3;
+	std::vector<double> matrix(size*size, 0.0), weights(size*2, 0.0);
+	for (int i=0; i<n; i++) {
+		double u, v;
+		if (!applyHomography(h, points[i].sensorX, points[i].sensorY, u, v)) return false;
+		for (int j=0; j<n; j++) matrix[i*size+j] = spline(points[i].sensorX-points[j].sensorX, points[i].sensorY-points[j].sensorY);
+		matrix[i*size+i] += smoothing;
+		matrix[i*size+n] = matrix[n*size+i] = 1;
+		matrix[i*size+n+1] = matrix[(n+1)*size+i] = points[i].sensorX;
+		matrix[i*size+n+2] = matrix[(n+2)*size+i] = points[i].sensorY;
+		weights[i*2] = points[i].screenX-u;
+		weights[i*2+1] = points[i].screenY-v;
+	}
+	if (!solve(matrix, weights, size, 2)) return false;
+
+	std::vector<float> baked(columns*rows*2);
+	for (int row=0; row<rows; row++) {
+		for (int column=0; column<columns; column++) {
+			double x = (double)column/(columns-1), y = (double)row/(rows-1);
+			double u, v;
+			if (!applyHomography(h, x, y, u, v)) return false;
+			u += weights[n*2]+weights[(n+1)*2]*x+weights[(n+2)*2]*y;
+			v += weights[n*2+1]+weights[(n+1)*2+1]*x+weights[(n+2)*2+1]*y;
+			for (int i=0; i<n; i++) {
+				double basis = spline(x-points[i].sensorX, y-points[i].sensorY);
+				u += weights[i*2]*basis;
+				v += weights[i*2+1]*basis;
+			}
+			baked[(row*columns+column)*2] = (float)u;
+			baked[(row*columns+column)*2+1] = (float)v;
+		}
+	}
+	nodes.swap(baked);
+
+	error = 0;
+	for (int i=0; i<n; i++) {
+		float x = points[i].sensorX, y = points[i].sensorY;
+		lookup(x, y);
+		float distance = sqrtf((x-points[i].screenX)*(x-points[i].screenX)+(y-points[i].screenY)*(y-points[i].screenY));
+		if (distance>error) error = distance;
+	}
+	return true;
+}
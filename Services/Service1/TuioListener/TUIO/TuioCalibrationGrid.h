@@ -0,0 +1,112 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOCALIBRATIONGRID_H
+#define INCLUDED_TUIOCALIBRATIONGRID_H
+
+#include <vector>
+
+// nodes per axis of the lookup grid, 32 cells of 1/32 of the surface
+#define TUIO_CALIBRATION_GRID_SIZE 33
+
+namespace TUIO {
+
+	/**
+	 * A calibration point, the position a sensor reports for a target and the position of the target,
+	 * both normalized
+	 */
+	struct TuioCalibrationPoint {
+		float sensorX, sensorY;
+		float screenX, screenY;
+	};
+
+	/**
+	 * <p>The TuioCalibrationGrid corrects the keystone of a projector and the lens distortion of a
+	 * camera. {@link #fit} solves a homography, which maps the keystone, and a thin plate spline
+	 * through its residuals, which bends the result onto the remaining calibration points, and bakes
+	 * both into a grid of corrected positions. Correcting a contact is then a bilinear interpolation
+	 * in that grid, a few loads and multiply-adds, independent of the number of points.</p>
+	 *
+	 * <p>Fitting takes milliseconds, so it has to run off the receiving thread. The grid is immutable
+	 * once fitted and is installed with {@link TuioCalibration#setGrid}.</p>
+	 */
+	class TuioCalibrationGrid {
+
+	public:
+		/**
+		 * Creates a grid that leaves the positions unchanged
+		 *
+		 * @param  columns	the nodes along the X axis, at least 2
+		 * @param  rows	the nodes along the Y axis, at least 2
+		 */
+		TuioCalibrationGrid(int columns=TUIO_CALIBRATION_GRID_SIZE, int rows=TUIO_CALIBRATION_GRID_SIZE);
+
+		/**
+		 * Fits the correction to the provided calibration points and bakes it into the grid. With
+		 * four points the correction is the homography through them, with more a thin plate spline
+		 * bends it onto all of them.
+		 *
+		 * @param  points	at least four calibration points, not all on one line
+		 * @param  smoothing	0 to pass exactly through the points, larger values let noisy points
+		 *					deviate in favor of a smoother correction
+		 * @return	false if the points do not determine a correction, the grid is unchanged then
+		 */
+		bool fit(const std::vector<TuioCalibrationPoint> &points, float smoothing=0);
+
+		/**
+		 * Returns the largest distance between a target and the corrected position of its calibration
+		 * point in the baked grid, which includes the error of the interpolation
+		 * @return	the largest error in surface widths
+		 */
+		float getError() const { return error; }
+
+		/**
+		 * Corrects a position, positions outside the unit square are extrapolated from the border cells
+		 *
+		 * @param	x	the normalized x coordinate, replaced by the corrected one
+		 * @param	y	the normalized y coordinate, replaced by the corrected one
+		 */
+		void lookup(float &x, float &y) const {
+			float fx = x*(columns-1);
+			float fy = y*(rows-1);
+			int ix = (int)fx;
+			int iy = (int)fy;
+			if (fx<0) ix = 0; else if (ix>columns-2) ix = columns-2;
+			if (fy<0) iy = 0; else if (iy>rows-2) iy = rows-2;
+			float tx = fx-ix;
+			float ty = fy-iy;
+
+			const float *top = &nodes[(iy*columns+ix)*2];
+			const float *bottom = top+columns*2;
+			float topX = top[0]+tx*(top[2]-top[0]);
+			float topY = top[1]+tx*(top[3]-top[1]);
+			float bottomX = bottom[0]+tx*(bottom[2]-bottom[0]);
+			float bottomY = bottom[1]+tx*(bottom[3]-bottom[1]);
+			x = topX+ty*(bottomX-topX);
+			y = topY+ty*(bottomY-topY);
+		}
+
+	private:
+		int columns, rows;
+		// the corrected x and y of every node, row by row
+		std::vector<float> nodes;
+		float error;
+	};
+};
+#endif /* INCLUDED_TUIOCALIBRATIONGRID_H */
@@ -0,0 +1,252 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioFileWatcher.h"
+#include "TuioLog.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+#include <string.h>
+
+#define TUIO_FILE_WATCHER_BUFFER_SIZE 4096
+
+using namespace TUIO;
+
+TuioFileWatcher::TuioFileWatcher(const char *p, TuioFileListener *l)
+: started (false)
+, path    (p)
+, listener(l)
+{
+	// the Windows API accepts both separators, the services use forward slashes
+	size_t separator = path.find_last_of("/\\");
+	if (separator==std::string::npos) {
+		directory = ".";
+		name = path;
+	} else {
+		directory = path.substr(0, separator);
+		name = path.substr(separator+1);
+		// "C://Users" leaves an empty name between the two slashes
+		while (!directory.empty() && ((directory[directory.size()-1]=='/') || (directory[directory.size()-1]=='\\')))
+			directory.erase(directory.size()-1);
+	}
+#ifndef WIN32
+	inotifyFd = -1;
+	stopPipe[0] = stopPipe[1] = -1;
+#else
+	thread = NULL;
+	directoryHandle = INVALID_HANDLE_VALUE;
+	stopEvent = NULL;
+	triggerEvent = NULL;
+#endif
+}
+
+TuioFileWatcher::~TuioFileWatcher() {
+	stop();
+}
+
+bool TuioFileWatcher::start() {
+	if (started) return true;
+
+#ifndef WIN32
+	inotifyFd = inotify_init();
+	if (inotifyFd<0) return false;
+	if ((inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE)<0) || (pipe(stopPipe)!=0)) {
+		TUIO_LOG_ERROR("could not watch %s", directory.c_str());
+		close(inotifyFd);
+		inotifyFd = -1;
+		return false;
+	}
+	fcntl(inotifyFd, F_SETFD, FD_CLOEXEC);
+	started = (pthread_create(&thread, NULL, threadFunc, this)==0);
+#else
+	directoryHandle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (directoryHandle==INVALID_HANDLE_VALUE) {
+		TUIO_LOG_ERROR("could not watch %s", directory.c_str());
+		return false;
+	}
+	stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	triggerEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	DWORD threadId;
+	thread = CreateThread(0, 0, threadFunc, this, 0, &threadId);
+	started = (thread!=NULL);
+#endif
+	if (!started) {
+		TUIO_LOG_ERROR("could not start the file watcher thread");
+		stop();
+	}
+	return started;
+}
+
+void TuioFileWatcher::stop() {
+#ifndef WIN32
+	if (started) {
+		char wake = 0;
+		if (write(stopPipe[1], &wake, 1)!=1) TUIO_LOG_ERROR("could not stop the file watcher");
+		pthread_join(thread, NULL);
+	}
+	if (inotifyFd>=0) close(inotifyFd);
+	if (stopPipe[0]>=0) close(stopPipe[0]);
+	if (stopPipe[1]>=0) close(stopPipe[1]);
+	inotifyFd = -1;
+	stopPipe[0] = stopPipe[1] = -1;
+#else
+	if (started) {
+		SetEvent(stopEvent);
+		WaitForSingleObject(thread, INFINITE);
+		CloseHandle(thread);
+		thread = NULL;
+	}
+	if (directoryHandle!=INVALID_HANDLE_VALUE) CloseHandle(directoryHandle);
+	if (stopEvent!=NULL) CloseHandle(stopEvent);
+	if (triggerEvent!=NULL) CloseHandle(triggerEvent);
+	directoryHandle = INVALID_HANDLE_VALUE;
+	stopEvent = NULL;
+	triggerEvent = NULL;
+#endif
+	started = false;
+}
+
+bool TuioFileWatcher::trigger() {
+	if (!started) return false;
+#ifndef WIN32
+	char wake = 1;
+	return (write(stopPipe[1], &wake, 1)==1);
+#else
+	return (SetEvent(triggerEvent)!=FALSE);
+#endif
+}
+
+void TuioFileWatcher::notify() {
+	TUIO_LOG_INFO("%s changed", path.c_str());
+	listener->fileChanged(path.c_str());
+}
+
+#ifndef WIN32
+
+void TuioFileWatcher::watch() {
+	char buffer[TUIO_FILE_WATCHER_BUFFER_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	struct pollfd fds[2];
+	fds[0].fd = inotifyFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = stopPipe[0];
+	fds[1].events = POLLIN;
+
+	bool changed = false;
+	while (true) {
+		// once the file changed, wait for the rest of the burst before reporting it
+		int ready = poll(fds, 2, changed ? TUIO_FILE_WATCHER_SETTLE_TIME : -1);
+		if (ready<0) continue;
+		if (fds[1].revents) {
+			char wake = 0;
+			if ((read(stopPipe[0], &wake, 1)!=1) || (wake==0)) return;
+			notify();
+			continue;
+		}
+		if (ready==0) {
+			changed = false;
+			notify();
+			continue;
+		}
+
+		ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+		for (char *next=buffer; (length>0) && (next<buffer+length); ) {
+			struct inotify_event *event = (struct inotify_event*)next;
+			if ((event->len>0) && (name==event->name)) changed = true;
+			next += sizeof(struct inotify_event)+event->len;
+		}
+	}
+}
+
+void* TuioFileWatcher::threadFunc( void* obj )
+{
+	static_cast<TuioFileWatcher*>(obj)->watch();
+	return 0;
+}
+
+#else
+
+void TuioFileWatcher::watch() {
+	DWORD buffer[TUIO_FILE_WATCHER_BUFFER_SIZE/sizeof(DWORD)];
+	WCHAR wideName[MAX_PATH];
+	int wideLength = MultiByteToWideChar(CP_ACP, 0, name.c_str(), -1, wideName, MAX_PATH)-1;
+
+	OVERLAPPED overlapped;
+	memset(&overlapped, 0, sizeof(overlapped));
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	HANDLE events[3] = { overlapped.hEvent, stopEvent, triggerEvent };
+
+	bool changed = false;
+	bool pending = false;
+	while (true) {
+		if (!pending) {
+			ResetEvent(overlapped.hEvent);
+			if (!ReadDirectoryChangesW(directoryHandle, buffer, sizeof(buffer), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, NULL, &overlapped, NULL)) {
+				TUIO_LOG_ERROR("could not watch %s", directory.c_str());
+				break;
+			}
+			pending = true;
+		}
+
+		// once the file changed, wait for the rest of the burst before reporting it
+		DWORD ready = WaitForMultipleObjects(3, events, FALSE, changed ? TUIO_FILE_WATCHER_SETTLE_TIME : INFINITE);
+		if (ready==WAIT_OBJECT_0+1) break;
+		if (ready==WAIT_OBJECT_0+2) {
+			notify();
+			continue;
+		}
+		if (ready==WAIT_TIMEOUT) {
+			changed = false;
+			notify();
+			continue;
+		}
+
+		DWORD length = 0;
+		pending = false;
+		if (!GetOverlappedResult(directoryHandle, &overlapped, &length, FALSE)) continue;
+		// an overflow of the buffer reports no entries, the file may be among them
+		if (length==0) changed = true;
+		for (char *next=(char*)buffer; length>0; ) {
+			FILE_NOTIFY_INFORMATION *info = (FILE_NOTIFY_INFORMATION*)next;
+			if ((info->FileNameLength==wideLength*sizeof(WCHAR)) &&
+				(CompareStringW(LOCALE_INVARIANT, NORM_IGNORECASE, info->FileName, wideLength, wideName, wideLength)==CSTR_EQUAL)) changed = true;
+			if (info->NextEntryOffset==0) break;
+			next += info->NextEntryOffset;
+		}
+	}
+
+	if (pending) {
+		CancelIo(directoryHandle);
+		GetOverlappedResult(directoryHandle, &overlapped, NULL, TRUE);
+	}
+	CloseHandle(overlapped.hEvent);
+}
+
+DWORD WINAPI TuioFileWatcher::threadFunc( LPVOID obj )
+{
+	static_cast<TuioFileWatcher*>(obj)->watch();
+	return 0;
+}
+
+#endif
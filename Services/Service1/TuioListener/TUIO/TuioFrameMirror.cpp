@@ -0,0 +1,259 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioFrameMirror.h"
+#include "TuioAtomic.h"
+#include "TuioLog.h"
+
+#include <string.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <sddl.h>
+#endif
+
+using namespace TUIO;
+
+#define TUIO_FRAME_MIRROR_MAGIC   0x54554646
+#define TUIO_FRAME_MIRROR_VERSION 1
+
+// all fields are explicitly sized and placed, so that 32 and 64-bit processes
+// and the C# reader agree on the layout. the contacts follow the header
+struct TUIO::TuioFrameMirrorHeader {
+	volatile int magic; // stored last by the creator
+	int version;
+	int maxContacts;
+	int contactSize;
+	volatile int closed; // set when the publisher goes away
+	int reserved0;
+	char pad0[40];
+
+	// the frame, guarded by the sequence
+	volatile int sequence; // odd while the frame is written
+	int contactCount;
+	long long frameID;
+	long long frameTime;
+	long long generation;
+	long long frames;
+	char pad1[24];
+};
+
+typedef char TuioFrameMirrorHeaderSizeCheck[(sizeof(TuioFrameMirrorHeader)==128)?1:-1];
+typedef char TuioFrameMirrorContactSizeCheck[(sizeof(TuioFrameMirrorContact)==32)?1:-1];
+
+TuioFrameMirror::TuioFrameMirror(const char *n, bool p, int c)
+: name        (n)
+, publisher   (p)
+, requestedContacts(c)
+, header      (NULL)
+, contacts    (NULL)
+, maxContacts (0)
+, writeCount  (0)
+#ifndef WIN32
+, mappingSize (0)
+#else
+, mapping     (NULL)
+#endif
+{
+	if (open() && publisher) TUIO_LOG_INFO("publishing the frames in %s", name.c_str());
+}
+
+TuioFrameMirror::~TuioFrameMirror() {
+	close();
+}
+
+#ifndef WIN32
+bool TuioFrameMirror::open() {
+	// a posix shared memory name has a leading and no other slash
+	std::string path = "/";
+	for (size_t i=0; i<name.size(); i++) path += ((name[i]=='/') || (name[i]=='\\')) ? '_' : name[i];
+
+	int size = 0;
+	int fd = -1;
+	if (publisher) {
+		// the readers of a previous region keep their mapping until they see it closed
+		shm_unlink(path.c_str());
+		size = (int)sizeof(TuioFrameMirrorHeader) + requestedContacts*(int)sizeof(TuioFrameMirrorContact);
+		fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+		if ((fd>=0) && (ftruncate(fd, size)!=0)) {
+			::close(fd);
+			shm_unlink(path.c_str());
+			fd = -1;
+		}
+	} else {
+		fd = shm_open(path.c_str(), O_RDONLY, 0);
+		struct stat status;
+		size = ((fd>=0) && (fstat(fd, &status)==0)) ? (int)status.st_size : 0;
+	}
+	if ((fd<0) || (size<(int)sizeof(TuioFrameMirrorHeader))) {
+		if (fd>=0) ::close(fd);
+		if (publisher) TUIO_LOG_ERROR("could not create the frame mirror %s", name.c_str());
+		return false;
+	}
+
+	void *memory = mmap(NULL, size, publisher ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (memory==MAP_FAILED) {
+		TUIO_LOG_ERROR("could not map the frame mirror %s", name.c_str());
+		return false;
+	}
+	header = (TuioFrameMirrorHeader*)memory;
+	mappingSize = size;
+	bool created = publisher;
+#else
+bool TuioFrameMirror::open() {
+	int size = (int)sizeof(TuioFrameMirrorHeader) + requestedContacts*(int)sizeof(TuioFrameMirrorContact);
+	bool created = false;
+	if (publisher) {
+		// the service writes, the tools of any user read
+		SECURITY_ATTRIBUTES attributes;
+		attributes.nLength = sizeof(attributes);
+		attributes.bInheritHandle = FALSE;
+		attributes.lpSecurityDescriptor = NULL;
+		ConvertStringSecurityDescriptorToSecurityDescriptorA("D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GR;;;AU)", SDDL_REVISION_1, &attributes.lpSecurityDescriptor, NULL);
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, &attributes, PAGE_READWRITE, 0, size, name.c_str());
+		created = (mapping!=NULL) && (GetLastError()!=ERROR_ALREADY_EXISTS);
+		LocalFree(attributes.lpSecurityDescriptor);
+	} else mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+
+	void *memory = (mapping!=NULL) ? MapViewOfFile(mapping, publisher ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (memory==NULL) {
+		if (mapping!=NULL) CloseHandle(mapping);
+		mapping = NULL;
+		if (publisher) TUIO_LOG_ERROR("could not create the frame mirror %s", name.c_str());
+		return false;
+	}
+	header = (TuioFrameMirrorHeader*)memory;
+	MEMORY_BASIC_INFORMATION region;
+	VirtualQuery(memory, &region, sizeof(region));
+	size = (int)region.RegionSize;
+#endif
+
+	if (created) {
+		header->version = TUIO_FRAME_MIRROR_VERSION;
+		header->maxContacts = requestedContacts;
+		header->contactSize = (int)sizeof(TuioFrameMirrorContact);
+		atomicStore32(&header->magic, TUIO_FRAME_MIRROR_MAGIC);
+	} else if ((atomicLoad32(&header->magic)!=TUIO_FRAME_MIRROR_MAGIC) || (header->version!=TUIO_FRAME_MIRROR_VERSION)
+			|| (header->contactSize!=(int)sizeof(TuioFrameMirrorContact)) || (header->maxContacts<0)
+			|| ((int)sizeof(TuioFrameMirrorHeader)+header->maxContacts*header->contactSize>size)) {
+		TUIO_LOG_ERROR("the frame mirror %s has an unknown format", name.c_str());
+		close();
+		return false;
+	}
+
+	if (publisher && !created) {
+		// a region that the readers kept, a publisher that went away while writing left the sequence odd
+		if (header->sequence&1) atomicStore32(&header->sequence, header->sequence+1);
+		atomicStore32(&header->closed, 0);
+	}
+
+	contacts = (TuioFrameMirrorContact*)((char*)header + sizeof(TuioFrameMirrorHeader));
+	maxContacts = header->maxContacts;
+	return true;
+}
+
+void TuioFrameMirror::close() {
+	if (header==NULL) return;
+
+	if (publisher) atomicStore32(&header->closed, 1);
+#ifndef WIN32
+	if (publisher) {
+		std::string path = "/";
+		for (size_t i=0; i<name.size(); i++) path += ((name[i]=='/') || (name[i]=='\\')) ? '_' : name[i];
+		shm_unlink(path.c_str());
+	}
+	munmap(header, mappingSize);
+#else
+	UnmapViewOfFile(header);
+	CloseHandle(mapping);
+	mapping = NULL;
+#endif
+	header = NULL;
+	contacts = NULL;
+	maxContacts = 0;
+}
+
+bool TuioFrameMirror::isClosed() const {
+	return (header==NULL) || (atomicLoad32(&header->closed)!=0);
+}
+
+void TuioFrameMirror::beginFrame(long long frameID, long long frameTime) {
+	if ((header==NULL) || !publisher) return;
+	// only the publisher writes the sequence, the fence keeps the frame from being written before it is odd
+	atomicStore32(&header->sequence, header->sequence+1);
+	atomicFence();
+	header->frameID = frameID;
+	header->frameTime = frameTime;
+	writeCount = 0;
+}
+
+void TuioFrameMirror::addContact(int id, int status, float rawX, float rawY, float sensorX, float sensorY, float x, float y) {
+	if ((header==NULL) || (writeCount>=maxContacts)) return;
+	TuioFrameMirrorContact &contact = contacts[writeCount++];
+	contact.id = id;
+	contact.status = status;
+	contact.rawX = rawX;
+	contact.rawY = rawY;
+	contact.sensorX = sensorX;
+	contact.sensorY = sensorY;
+	contact.x = x;
+	contact.y = y;
+}
+
+void TuioFrameMirror::commitFrame(long long generation) {
+	if ((header==NULL) || !publisher || !(header->sequence&1)) return;
+	header->contactCount = writeCount;
+	header->generation = generation;
+	header->frames++;
+	// the store releases the frame to the readers
+	atomicStore32(&header->sequence, header->sequence+1);
+}
+
+bool TuioFrameMirror::read(TuioFrameMirrorFrame &frame, TuioFrameMirrorContact *copy, int count) {
+	if ((header==NULL) || isClosed()) return false;
+
+	for (int attempt=0; attempt<TUIO_FRAME_MIRROR_READ_ATTEMPTS; attempt++) {
+		int sequence = atomicLoad32(&header->sequence);
+		if (sequence&1) {
+			cpuRelax();
+			continue;
+		}
+
+		frame.frameID = header->frameID;
+		frame.frameTime = header->frameTime;
+		frame.generation = header->generation;
+		frame.frames = header->frames;
+		frame.contactCount = header->contactCount;
+		// a torn count is discarded below, it must not overrun the copy meanwhile
+		if (frame.contactCount<0) frame.contactCount = 0;
+		if (frame.contactCount>maxContacts) frame.contactCount = maxContacts;
+		if (frame.contactCount>count) frame.contactCount = count;
+		memcpy(copy, contacts, frame.contactCount*sizeof(TuioFrameMirrorContact));
+
+		// the frame is read before the sequence is checked again
+		atomicFence();
+		if (atomicLoad32(&header->sequence)==sequence) return true;
+	}
+	return false;
+}
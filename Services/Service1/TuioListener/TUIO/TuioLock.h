@@ -0,0 +1,203 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOLOCK_H
+#define INCLUDED_TUIOLOCK_H
+
+#ifndef WIN32
+#include <pthread.h>
+#else
+#include <windows.h>
+// TryAcquireSRWLockExclusive() for tryLock() is only available from Windows 7 on
+#if (_WIN32_WINNT >= 0x0601)
+#define TUIO_SRWLOCK
+#endif
+#endif
+
+#include "TuioAtomic.h"
+
+namespace TUIO {
+
+	/**
+	 * The TuioMutex class is a process-local, non-recursive mutex.
+	 * On posix systems it wraps a pthread mutex, which only enters the kernel (futex) under contention.
+	 * On Windows 7 and later it wraps a slim reader/writer lock, on older systems a critical section with a short spin count.
+	 * Unlike the named kernel mutexes used before, two TuioClient instances (or two service processes) never share a TuioMutex.
+	 */
+	class TuioMutex {
+
+	public:
+		TuioMutex() {
+#ifndef WIN32
+			pthread_mutexattr_t attr;
+			pthread_mutexattr_init(&attr);
+#ifdef PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP
+			// spin briefly before sleeping, the protected sections are short
+			pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+#endif
+			pthread_mutex_init(&mutex, &attr);
+			pthread_mutexattr_destroy(&attr);
+#elif defined(TUIO_SRWLOCK)
+			InitializeSRWLock(&mutex);
+#else
+			InitializeCriticalSectionAndSpinCount(&mutex, 4000);
+#endif
+		}
+
+		~TuioMutex() {
+#ifndef WIN32
+			pthread_mutex_destroy(&mutex);
+#elif !defined(TUIO_SRWLOCK)
+			DeleteCriticalSection(&mutex);
+#endif
+		}
+
+		void lock() {
+#ifndef WIN32
+			pthread_mutex_lock(&mutex);
+#elif defined(TUIO_SRWLOCK)
+			AcquireSRWLockExclusive(&mutex);
+#else
+			EnterCriticalSection(&mutex);
+#endif
+		}
+
+		void unlock() {
+#ifndef WIN32
+			pthread_mutex_unlock(&mutex);
+#elif defined(TUIO_SRWLOCK)
+			ReleaseSRWLockExclusive(&mutex);
+#else
+			LeaveCriticalSection(&mutex);
+#endif
+		}
+
+		/**
+		 * Acquires the mutex only if it is currently free
+		 *
+		 * @return	true if the mutex was acquired
+		 */
+		bool tryLock() {
+#ifndef WIN32
+			return pthread_mutex_trylock(&mutex)==0;
+#elif defined(TUIO_SRWLOCK)
+			return TryAcquireSRWLockExclusive(&mutex)!=0;
+#else
+			return TryEnterCriticalSection(&mutex)!=0;
+#endif
+		}
+
+	private:
+		TuioMutex(const TuioMutex&);
+		TuioMutex& operator=(const TuioMutex&);
+
+#ifndef WIN32
+		pthread_mutex_t mutex;
+#elif defined(TUIO_SRWLOCK)
+		SRWLOCK mutex;
+#else
+		CRITICAL_SECTION mutex;
+#endif
+	};
+
+	/**
+	 * Locks the provided TuioMutex for the lifetime of the TuioScopedLock instance
+	 */
+	class TuioScopedLock {
+
+	public:
+		TuioScopedLock(TuioMutex &m):mutex(m) {
+			mutex.lock();
+		}
+
+		~TuioScopedLock() {
+			mutex.unlock();
+		}
+
+	private:
+		TuioScopedLock(const TuioScopedLock&);
+		TuioScopedLock& operator=(const TuioScopedLock&);
+
+		TuioMutex &mutex;
+	};
+
+	/**
+	 * <p>The TuioSeqLock class is the lock-free option for data that has exactly one writer thread.
+	 * The writer never blocks and never waits for readers, readers copy the protected data
+	 * and retry if a write happened in the meantime. The protected data must be plain values
+	 * that are safe to copy while being written, never pointers into structures the writer frees.</p>
+	 * <p><code>
+	 * // writer<br/>
+	 * seqlock.writeBegin(); data = newData; seqlock.writeEnd();<br/>
+	 * // reader<br/>
+	 * long seq; do { seq = seqlock.readBegin(); copy = data; } while (seqlock.readRetry(seq));<br/>
+	 * </code></p>
+	 */
+	class TuioSeqLock {
+
+	public:
+		TuioSeqLock():sequence(0) {}
+
+		/**
+		 * Marks the protected data as being written, only one thread may ever call this method
+		 */
+		void writeBegin() {
+			atomicStore(&sequence, sequence+1);
+			atomicFence();
+		}
+
+		/**
+		 * Publishes the data written since writeBegin()
+		 */
+		void writeEnd() {
+			atomicStore(&sequence, sequence+1);
+		}
+
+		/**
+		 * Waits for a pending write to complete and returns the sequence to pass to readRetry()
+		 */
+		long readBegin() const {
+			long seq = atomicLoad(&sequence);
+			while (seq & 1) {
+				cpuRelax();
+				seq = atomicLoad(&sequence);
+			}
+			return seq;
+		}
+
+		/**
+		 * Returns true if the data copied since readBegin() may be torn and has to be read again
+		 */
+		bool readRetry(long seq) const {
+			atomicFence();
+			return atomicLoad(&sequence)!=seq;
+		}
+
+		/**
+		 * Returns the number of completed writes
+		 */
+		long getVersion() const {
+			return atomicLoad(&sequence)/2;
+		}
+
+	private:
+		mutable volatile long sequence;
+	};
+};
+#endif /* INCLUDED_TUIOLOCK_H */
@@ -0,0 +1,199 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIORELAY_H
+#define INCLUDED_TUIORELAY_H
+
+#ifndef WIN32
+#include <pthread.h>
+#else
+#include <windows.h>
+#endif
+
+#include <map>
+#include <vector>
+
+#include "ip/UdpSocket.h"
+#include "ip/ReceiveBufferPool.h"
+
+#include "TuioListener.h"
+#include "TuioServer.h"
+#include "TuioStats.h"
+#include "TuioCalibration.h"
+#include "TuioThreadRole.h"
+
+#define TUIO_RELAY_QUEUE_LENGTH 256
+
+namespace TUIO {
+
+	struct TuioRelayDestination;
+
+	/**
+	 * <p>The TuioRelay forwards TUIO packets unchanged to a list of UDP destinations, for example to
+	 * fan one sensor out to a display host, a logging host and the configuration monitor. It does not
+	 * decode the packets. A {@link TuioClient} hands it every packet it receives, see
+	 * {@link TuioClient#setRelay}.</p>
+	 *
+	 * <p>Each destination has its own socket and a bounded queue of packets, which a sender thread
+	 * drains with one sendmmsg() call per destination and wakeup. Datagrams received by the UdpSocket
+	 * of the client are queued by reference, without a copy, other packets are copied once. A
+	 * destination whose send buffer is full keeps its packets queued, and once its queue is full it
+	 * drops the new ones, so one slow destination never delays the others or the receiving thread.</p>
+	 */
+	class TuioRelay : public TuioStatsSource {
+
+	public:
+		/**
+		 * Creates a relay without destinations and starts its sender thread
+		 *
+		 * @param  queueLength  the number of packets queued per destination, rounded up to a power of two
+		 * @param  role  the priority and CPU of the sender thread
+		 */
+		TuioRelay(int queueLength=TUIO_RELAY_QUEUE_LENGTH, const TuioThreadRole &role=TuioThreadRole());
+
+		/**
+		 * Stops the sender thread, queued packets are dropped
+		 */
+		~TuioRelay();
+
+		/**
+		 * Adds a destination, only before the first packet is forwarded
+		 *
+		 * @param  host  the host name, IPv4 or IPv6 address or multicast group
+		 * @param  port  the UDP port
+		 * @return	true if the destination was added
+		 */
+		bool addDestination(const char *host, int port);
+
+		/**
+		 * Returns the number of destinations
+		 * @return	the number of destinations
+		 */
+		int getDestinationCount() const { return (int)destinationList.size(); }
+
+		/**
+		 * Queues a packet for all destinations. Only one thread may forward at a time.
+		 *
+		 * @param  data	the packet
+		 * @param  size	the size of the packet in bytes
+		 * @param  retainable	true if data was passed to ProcessPacket() by a SocketReceiveMultiplexer for
+		 *                      a UdpSocket and can be retained instead of copied
+		 */
+		void forward(const char *data, int size, bool retainable);
+
+		/**
+		 * Stops the sender thread and releases all queued packets. Has to be called before the
+		 * multiplexer that received retained packets is deleted, later packets are dropped.
+		 */
+		void stop();
+
+		/**
+		 * Returns the number of packets sent to a destination
+		 * @param  index	the index of the destination
+		 * @return	the number of packets sent
+		 */
+		long long getSentPackets(int index) const;
+
+		/**
+		 * Returns the number of packets dropped for a destination because its queue was full
+		 * @param  index	the index of the destination
+		 * @return	the number of packets dropped
+		 */
+		long long getDroppedPackets(int index) const;
+
+		void writeStats(TuioStatsReport &report);
+		void resetStats();
+
+	private:
+		int send();
+		void waitForPackets();
+		void wake();
+		void releaseQueued();
+
+#ifndef WIN32
+		static void* senderThreadFunc( void* obj );
+#else
+		static DWORD WINAPI senderThreadFunc( LPVOID obj );
+#endif
+
+		std::vector<TuioRelayDestination*> destinationList;
+		ReceiveBufferPool bufferPool;
+		int queueLength;
+		TuioThreadRole threadRole;
+		bool forwarding;
+		volatile long running;
+		volatile long waiting;
+
+#ifndef WIN32
+		pthread_t senderThread;
+		pthread_mutex_t wakeMutex;
+		pthread_cond_t wakeCondition;
+#else
+		HANDLE senderThread;
+		HANDLE wakeEvent;
+#endif
+	};
+
+	/**
+	 * <p>The TuioCalibratedRelay re-emits the cursors and objects a {@link TuioClient} receives through
+	 * a {@link TuioServer}, with the calibration of the service applied to their coordinates. Add it as
+	 * a {@link TuioListener} to the client, it sends on the receiving thread of the client.</p>
+	 */
+	class TuioCalibratedRelay : public TuioListener {
+
+	public:
+		/**
+		 * @param  server	the server to send the calibrated contacts with, owned by the caller
+		 */
+		TuioCalibratedRelay(TuioServer *server);
+
+		/**
+		 * Sets the calibration, which is applied in the same order as by the service: the axes are
+		 * inverted, mapped to the given ranges and finally swapped
+		 */
+		void setCalibration(bool invertX, bool invertY, float xMin, float xMax, float yMin, float yMax, bool swapXY);
+
+		/**
+		 * Sets the calibration without its offset, which moves the HID output by whole screens and
+		 * would take the re-emitted coordinates out of the normalized range
+		 */
+		void setCalibration(const TuioCalibration &c) {
+			calibration = c;
+			calibration.setOffset(0, 0);
+		}
+
+		void addTuioObject(TuioObject *tobj);
+		void updateTuioObject(TuioObject *tobj);
+		void removeTuioObject(TuioObject *tobj);
+		void addTuioCursor(TuioCursor *tcur);
+		void updateTuioCursor(TuioCursor *tcur);
+		void removeTuioCursor(TuioCursor *tcur);
+		void refresh(TuioTime frameTime);
+
+	private:
+		void beginFrame();
+
+		TuioServer *server;
+		std::map<long, TuioCursor*> cursorMap;
+		std::map<long, TuioObject*> objectMap;
+		bool frameOpen;
+		TuioCalibration calibration;
+	};
+};
+#endif /* INCLUDED_TUIORELAY_H */
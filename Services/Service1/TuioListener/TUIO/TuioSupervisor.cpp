@@ -0,0 +1,215 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioSupervisor.h"
+#include "TuioLog.h"
+
+#ifndef WIN32
+#include <errno.h>
+#include <time.h>
+#else
+#include "ip/NetworkingUtils.h"
+#endif
+
+using namespace TUIO;
+
+TuioSupervisor::TuioSupervisor(int initial, int max, int stable)
+: initialDelay(initial)
+, maxDelay    (max<initial ? initial : max)
+, stableTime  (stable)
+, delay       (initial)
+, failures    (0)
+, startTime   (0)
+, attempted   (false)
+, stopping    (false)
+, state       (STARTING)
+, client      (NULL)
+{
+#ifndef WIN32
+	pthread_mutex_init(&mutex, NULL);
+	// the delays are measured on the monotonic clock, like currentTime()
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&condition, &attr);
+	pthread_condattr_destroy(&attr);
+#else
+	InitializeCriticalSection(&mutex);
+	stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+#endif
+}
+
+TuioSupervisor::~TuioSupervisor() {
+#ifndef WIN32
+	pthread_cond_destroy(&condition);
+	pthread_mutex_destroy(&mutex);
+#else
+	CloseHandle(stopEvent);
+	DeleteCriticalSection(&mutex);
+#endif
+}
+
+long long TuioSupervisor::currentTime() {
+#ifndef WIN32
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec*1000LL+ts.tv_nsec/1000000;
+#else
+	return GetCurrentTimeNanoseconds()/1000000;
+#endif
+}
+
+// called with the mutex held, returns false if the supervisor was stopped while waiting
+bool TuioSupervisor::wait(int milliseconds) {
+#ifndef WIN32
+	struct timespec until;
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	until.tv_sec += milliseconds/1000;
+	until.tv_nsec += (long)(milliseconds%1000)*1000000L;
+	if (until.tv_nsec>=1000000000L) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	}
+	while (!stopping) {
+		if (pthread_cond_timedwait(&condition, &mutex, &until)==ETIMEDOUT) break;
+	}
+#else
+	LeaveCriticalSection(&mutex);
+	WaitForSingleObject(stopEvent, milliseconds);
+	EnterCriticalSection(&mutex);
+#endif
+	return !stopping;
+}
+
+bool TuioSupervisor::start() {
+#ifndef WIN32
+	pthread_mutex_lock(&mutex);
+#else
+	EnterCriticalSection(&mutex);
+#endif
+
+	if (attempted && !stopping) {
+		// a sensor that ran for a while failed for a new reason, and is retried quickly again
+		if ((startTime>0) && (currentTime()-startTime>=stableTime)) {
+			delay = initialDelay;
+			failures = 0;
+		}
+		failures++;
+		state = WAITING;
+		TUIO_LOG_WARNING("sensor failed %d times in a row, retrying in %d ms", failures, delay);
+		wait(delay);
+		delay = (delay>maxDelay/2) ? maxDelay : delay*2;
+	}
+
+	attempted = true;
+	startTime = 0;
+	state = stopping ? STOPPED : STARTING;
+	bool started = !stopping;
+
+#ifndef WIN32
+	pthread_mutex_unlock(&mutex);
+#else
+	LeaveCriticalSection(&mutex);
+#endif
+	return started;
+}
+
+bool TuioSupervisor::attach(TuioClient *c) {
+#ifndef WIN32
+	pthread_mutex_lock(&mutex);
+#else
+	EnterCriticalSection(&mutex);
+#endif
+
+	bool attached = !stopping;
+	if (attached) {
+		client = c;
+		startTime = currentTime();
+		state = RUNNING;
+	}
+
+#ifndef WIN32
+	pthread_mutex_unlock(&mutex);
+#else
+	LeaveCriticalSection(&mutex);
+#endif
+	return attached;
+}
+
+void TuioSupervisor::detach() {
+#ifndef WIN32
+	pthread_mutex_lock(&mutex);
+#else
+	EnterCriticalSection(&mutex);
+#endif
+
+	client = NULL;
+	state = stopping ? STOPPED : STARTING;
+
+#ifndef WIN32
+	pthread_mutex_unlock(&mutex);
+#else
+	LeaveCriticalSection(&mutex);
+#endif
+}
+
+void TuioSupervisor::stop() {
+#ifndef WIN32
+	pthread_mutex_lock(&mutex);
+#else
+	EnterCriticalSection(&mutex);
+#endif
+
+	stopping = true;
+	// the client stays valid until it is detached, which waits for the mutex
+	if (client!=NULL) client->interrupt();
+#ifndef WIN32
+	pthread_cond_broadcast(&condition);
+	pthread_mutex_unlock(&mutex);
+#else
+	SetEvent(stopEvent);
+	LeaveCriticalSection(&mutex);
+#endif
+}
+
+TuioSupervisor::State TuioSupervisor::getState() {
+#ifndef WIN32
+	pthread_mutex_lock(&mutex);
+	State current = state;
+	pthread_mutex_unlock(&mutex);
+#else
+	EnterCriticalSection(&mutex);
+	State current = state;
+	LeaveCriticalSection(&mutex);
+#endif
+	return current;
+}
+
+int TuioSupervisor::getFailures() {
+#ifndef WIN32
+	pthread_mutex_lock(&mutex);
+	int current = failures;
+	pthread_mutex_unlock(&mutex);
+#else
+	EnterCriticalSection(&mutex);
+	int current = failures;
+	LeaveCriticalSection(&mutex);
+#endif
+	return current;
+}
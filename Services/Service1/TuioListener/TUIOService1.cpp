@@ -25,8 +25,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "TuioDump.h"
-#include <map>
-#include <list>
+#include "TuioRelay.h"
+#include "TuioConfig.h"
+#include "TuioProfile.h"
+#include "TuioFileWatcher.h"
+#include "TuioTransform.h"
+#include "TuioSupervisor.h"
+#include "TuioThreadRole.h"
+#include "TuioFrameMirror.h"
+#include "TuioLog.h"
+#include "TuioTrace.h"
 #include "ServiceInstaller.h"
 #include "ServiceBase.h"
 #include "TUIOService.h"
@@ -73,148 +81,481 @@ CSampleService::~CSampleService(void)
 
 void SendHidRequests_updatetouch(pvmulti_client vmulti,BYTE requestType);
 
+// the sensor of this service in the profile, and the device it drives unless the profile selects another
+#define SENSOR_INDEX 1
+
 pvmulti_client vmulti;
 BYTE   reportId = REPORTID_MTOUCH;
-int port;
-string invert_x="False";
-string invert_y="False";
-string swap_xy="False";
-string x_offset="0";
-string y_offset="0";
-string xrange_min="0";
-string xrange_max="1";
-string yrange_min="0";
-string yrange_max="1";
-int xoffset=0;
-int yoffset=0;
-float xrangemin=0;
-float yrangemin=0;
-float xrangemax=1;
-float yrangemax=1;
-
-int offset=0;
-
-std::ofstream fslog("C://log.txt"); 
-map<int,float> tcur_x;
-map<int,float> tcur_y;
-map<int,BYTE> tcur_status;
-list<int> idsToRemove;
+
+// the calibration, smoothing and prediction in use, replaced between two frames when the configuration changes
+TuioTransform *active_transform = NULL;
+TuioTransformExchange transform_exchange;
+TuioCalibratedRelay *calibrated_relay = NULL;
+
+// one entry per contact ID of the device report, so that no frame allocates
+#define MAX_CONTACTS 256
+
+// the state of a contact from its first to its last frame, indexed by its cursor ID
+struct TuioContact {
+	bool active;
+	// lifted, cleared once it was reported with its status cleared
+	bool removed;
+	BYTE status;
+	// the filtered and extrapolated position, before the calibration
+	float x, y;
+	// the position as received, for the frame mirror
+	float raw_x, raw_y;
+	TuioFilterState filter;
+	TuioPredictionState prediction;
+};
+
+TuioContact contacts[MAX_CONTACTS];
+// one past the highest cursor ID in use, and the number of contacts in use
+int contact_end = 0;
+int contact_count = 0;
+TOUCH touches[MAX_CONTACTS];
+TuioLatency *latency = NULL;
+// the frames written to the device, for the monitor of the Configuration Utility
+TuioFrameMirror *frame_mirror = NULL;
+TuioClient *frame_client = NULL;
+long long frame_id = -1;
+long long frame_time = 0;
+// restarts the sensor when it fails, and ends it when the service stops
+TuioSupervisor supervisor;
+
+//
+//   Counts the reports written to the device and keeps the generation of the configuration in
+//   use, for the statistics of the sensor. Written by the receiving thread only.
+//
+class TuioServiceStats : public TuioStatsSource {
+
+public:
+	TuioServiceStats() : writes(0), failures(0), generation(0) {
+		sprintf(name, "sensor%d", SENSOR_INDEX);
+		TuioStats::addSource(this);
+	}
+
+	~TuioServiceStats() {
+		TuioStats::removeSource(this);
+	}
+
+	void written(bool ok) {
+		atomicAdd64(&writes, 1);
+		if (!ok) atomicAdd64(&failures, 1);
+	}
+
+	void applied(long g) {
+		atomicStore(&generation, g);
+	}
+
+	void writeStats(TuioStatsReport &report) {
+		report.beginSection(name);
+		report.addValue("config_generation", atomicLoad(&generation));
+		report.addValue("hid_writes", atomicLoad64(&writes));
+		report.addValue("hid_failures", atomicLoad64(&failures));
+	}
+
+	void resetStats() {
+		atomicStore64(&writes, 0);
+		atomicStore64(&failures, 0);
+	}
+
+private:
+	char name[16];
+	volatile long long writes, failures;
+	volatile long generation;
+};
+
+TuioServiceStats *service_stats = NULL;
+
+//
+//   Carries out the commands of the control port, which arrive on the receiving thread. The
+//   configuration is reloaded by the watcher of sensor1.cfg, as if the file was written, and a
+//   trace is written by a thread of the pool, so that neither holds up the frames.
+//
+class TuioServiceControl : public TuioControlListener {
+
+public:
+	TuioServiceControl() : watcher(NULL) {}
+
+	void setWatcher(TuioFileWatcher *w) {
+		watcher = w;
+	}
+
+	bool processCommand(const string &command, const string &argument, string &reply) {
+		if (command=="reload") {
+			if ((watcher==NULL) || !watcher->trigger()) {
+				reply = "configuration changes apply when the service restarts";
+				return false;
+			}
+			reply = "reloading the configuration";
+			return true;
+		}
+
+		if ((command=="trace") && (argument=="start")) {
+			// starting only clears the buffers of the threads. the control port is open to every
+			// local user, so the trace always goes to the data directory
+			string path = "C://Users//AppData//TUIO-To-Vmulti//Data//trace1.json";
+			if (!TuioTrace::start(path.c_str())) {
+				reply = "a trace is running already";
+				return false;
+			}
+			reply = "tracing to "+path;
+			return true;
+		}
+
+		if ((command=="trace") && (argument=="stop")) {
+			if (!TuioTrace::isEnabled()) {
+				reply = "no trace is running";
+				return false;
+			}
+			try {
+				CThreadPool::QueueUserWorkItem(&TuioServiceControl::writeTrace, this);
+			} catch (DWORD) {
+				reply = "could not write the trace";
+				return false;
+			}
+			reply = "writing the trace";
+			return true;
+		}
+		return false;
+	}
+
+	void writeTrace() {
+		TuioTrace::stop();
+	}
+
+private:
+	TuioFileWatcher *watcher;
+};
+
+TuioServiceControl service_control;
 
 
 void TuioDump::addTuioObject(TuioObject *tobj) {
-	std::cout << "add obj " << tobj->getSymbolID() << " (" << tobj->getSessionID() << ") "<< tobj->getX() << " " << tobj->getY() << " " << tobj->getAngle() << std::endl;
+	TUIO_LOG_DEBUG("add obj %d (%ld) %f %f %f", tobj->getSymbolID(), tobj->getSessionID(), tobj->getX(), tobj->getY(), tobj->getAngle());
 	
 }
 
 void TuioDump::updateTuioObject(TuioObject *tobj) {
-	std::cout << "set obj " << tobj->getSymbolID() << " (" << tobj->getSessionID() << ") "<< tobj->getX() << " " << tobj->getY() << " " << tobj->getAngle() 
-				<< " " << tobj->getMotionSpeed() << " " << tobj->getRotationSpeed() << " " << tobj->getMotionAccel() << " " << tobj->getRotationAccel() << std::endl;
+	TUIO_LOG_DEBUG("set obj %d (%ld) %f %f %f %f %f %f %f", tobj->getSymbolID(), tobj->getSessionID(), tobj->getX(), tobj->getY(), tobj->getAngle(),
+				tobj->getMotionSpeed(), tobj->getRotationSpeed(), tobj->getMotionAccel(), tobj->getRotationAccel());
 }
 
 void TuioDump::removeTuioObject(TuioObject *tobj) {
-	std::cout << "del obj " << tobj->getSymbolID() << " (" << tobj->getSessionID() << ")" << std::endl;
+	TUIO_LOG_DEBUG("del obj %d (%ld)", tobj->getSymbolID(), tobj->getSessionID());
+}
+
+static double seconds(TuioTime time) {
+	return time.getSeconds()+time.getMicroseconds()/1000000.0;
+}
+
+// the contact of a cursor, NULL if its ID does not fit into the device report
+static TuioContact* getContact(TuioCursor *tcur) {
+	int id = tcur->getCursorID();
+	if ((id<0) || (id>=MAX_CONTACTS)) {
+		TUIO_LOG_WARNING("cursor %d exceeds the %d contacts of the device", id, MAX_CONTACTS);
+		return NULL;
+	}
+	return &contacts[id];
 }
 
 void TuioDump::addTuioCursor(TuioCursor *tcur) {
-	
-	tcur_x[tcur->getCursorID()]=tcur->getX();
-	tcur_y[tcur->getCursorID()]=tcur->getY();
-	tcur_status[tcur->getCursorID()]=MULTI_CONFIDENCE_BIT | MULTI_IN_RANGE_BIT | MULTI_TIPSWITCH_BIT;
+	TuioContact *contact = getContact(tcur);
+	if (contact==NULL) return;
+	if (!contact->active) {
+		contact->active = true;
+		contact_count++;
+		if (tcur->getCursorID()>=contact_end) contact_end = tcur->getCursorID()+1;
+	}
+	contact->removed = false;
+	contact->x = contact->raw_x = tcur->getX();
+	contact->y = contact->raw_y = tcur->getY();
+	active_transform->filter.reset(contact->filter, tcur->getX(), tcur->getY(), seconds(tcur->getTuioTime()));
+	active_transform->prediction.reset(contact->prediction);
+	contact->status = MULTI_CONFIDENCE_BIT | MULTI_IN_RANGE_BIT | MULTI_TIPSWITCH_BIT;
     //SendHidRequests_updatetouch(vmulti,reportId,false);
 
 }
 
 void TuioDump::updateTuioCursor(TuioCursor *tcur) {
-	tcur_x[tcur->getCursorID()]=tcur->getX();
-	tcur_y[tcur->getCursorID()]=tcur->getY();
+	TuioContact *contact = getContact(tcur);
+	if ((contact==NULL) || !contact->active) return;
+	float x = tcur->getX();
+	float y = tcur->getY();
+	active_transform->filter.apply(contact->filter, x, y, seconds(tcur->getTuioTime()));
+	active_transform->prediction.apply(contact->prediction, x, y, tcur->getXSpeed(), tcur->getYSpeed(), tcur->getMotionAccel());
+	contact->x = x;
+	contact->y = y;
+	contact->raw_x = tcur->getX();
+	contact->raw_y = tcur->getY();
 	
 	//SendHidRequests_updatetouch(vmulti,reportId,false);
 }
   
 void TuioDump::removeTuioCursor(TuioCursor *tcur) {
-	idsToRemove.push_back(tcur->getCursorID());
-	tcur_x[tcur->getCursorID()]=tcur->getX();
-	tcur_y[tcur->getCursorID()]=tcur->getY();
-	tcur_status[tcur->getCursorID()]=0;
+	TuioContact *contact = getContact(tcur);
+	if ((contact==NULL) || !contact->active) return;
+	// the contact is released where the filtered contact was last reported
+	contact->removed = true;
+	contact->status = 0;
 	//SendHidRequests_updatetouch(vmulti,reportId,true);
 }
 
+// frees the contacts that were reported with their status cleared
+static void clearRemovedContacts() {
+	for (int id=0; id<contact_end; id++) {
+		if (contacts[id].removed) {
+			contacts[id].active = contacts[id].removed = false;
+			contact_count--;
+		}
+	}
+	while ((contact_end>0) && !contacts[contact_end-1].active) contact_end--;
+}
+
+// replaces the transform in use, on the receiving thread between two frames
+static void useTransform(TuioTransform *next) {
+	// the contacts continue from their smoothed positions, with the state of the new filter,
+	// the reported positions include the prediction and would be extrapolated once more
+	for (int id=0; id<contact_end; id++) {
+		TuioContact &contact = contacts[id];
+		if (!contact.active) continue;
+		float x = contact.raw_x;
+		float y = contact.raw_y;
+		active_transform->filter.getPosition(contact.filter, x, y);
+		next->filter.reset(contact.filter, x, y, contact.filter.time);
+		next->prediction.reset(contact.prediction);
+	}
+	// the relay keeps a copy that refers to the grid of the previous transform
+	if (calibrated_relay!=NULL) calibrated_relay->setCalibration(next->calibration);
+	delete active_transform;
+	active_transform = next;
+	if (service_stats!=NULL) service_stats->applied(active_transform->generation);
+	TUIO_LOG_INFO("configuration %ld applied", active_transform->generation);
+}
+
 void  TuioDump::refresh(TuioTime frameTime) {
+	// the mean latency up to the last report, in nanoseconds
+	if ((latency!=NULL) && active_transform->prediction.isAutomatic()) active_transform->prediction.setMeasuredLatency(latency->getTotalHistogram().getMean()/1000000000.0f);
+	if (frame_mirror!=NULL) {
+		frame_id = (frame_client!=NULL) ? frame_client->getFrameInfo().frameID : -1;
+		frame_time = frameTime.getSeconds()*1000000LL+frameTime.getMicroseconds();
+	}
 	SendHidRequests_updatetouch(vmulti,reportId);
-	for(list<int>::iterator i = idsToRemove.begin(); i != idsToRemove.end(); i++)
-	{
-		int idToRemove = *i;
-		tcur_x.erase(idToRemove);
-		tcur_y.erase(idToRemove);
-		tcur_status.erase(idToRemove);
+	clearRemovedContacts();
+
+	TuioTransform *next = transform_exchange.take();
+	if (next!=NULL) useTransform(next);
+}
+
+// lifts the contacts that are still down when the sensor ends, so that none is left pressed
+static void releaseContacts() {
+	if (contact_count>0) {
+		for (int id=0; id<contact_end; id++) contacts[id].status = 0;
+		SendHidRequests_updatetouch(vmulti,reportId);
 	}
-	idsToRemove.clear();
+	for (int id=0; id<contact_end; id++) contacts[id].active = contacts[id].removed = false;
+	contact_end = contact_count = 0;
 }
 
 float x,y;
 int i=0;
-float tmp;
 
 void SendHidRequests_updatetouch(pvmulti_client vmulti,BYTE requestType)
 {
 	
 	i=0;
-	int actualCount = tcur_x.size();
+	int actualCount = contact_count;
 			
-	PTOUCH pTouch = (PTOUCH)malloc(actualCount * sizeof(TOUCH));
-	for( map<int,float>::iterator ii=tcur_x.begin(); ii!=tcur_x.end(); ++ii)
+	// the readers of the mirror retry while the frame is written, they never hold up the device
+	if (frame_mirror!=NULL) frame_mirror->beginFrame(frame_id, frame_time);
+	for (int id=0; id<contact_end; id++)
     {
+		const TuioContact &contact = contacts[id];
+		if (!contact.active) continue;
 				
-		x=(*ii).second;
-		y=tcur_y[(*ii).first];
-		
-		if(invert_x=="True")
-			x=1-x;
-		if(invert_y=="True")
-			y=1-y;
-	
-	
-		if(xrangemin!=0 || xrangemax!=1)
-		{
-			float xrange=xrangemax-xrangemin;
-			x=xrangemin+(xrange*x);
-		}
-		if(yrangemin!=0 || yrangemax!=1)
-		{
-			float yrange=yrangemax-yrangemin;
-			y=yrangemin+(yrange*y);
-		}
-		if(xoffset!=0 && yoffset!=0)
-		{
-			x=x+xoffset/100;
-			y=y+yoffset/100;
-		}
-		if(swap_xy=="True")
-		{
-			tmp=y;
-			y=x;
-			x=tmp;
-		}
+		x=contact.x;
+		y=contact.y;
+		float sensor_x = x;
+		float sensor_y = y;
+		active_transform->calibration.apply(x,y);
+		if (frame_mirror!=NULL) frame_mirror->addContact(id, contact.status, contact.raw_x, contact.raw_y, sensor_x, sensor_y, x, y);
 		
 
-		pTouch[i].ContactID = (*ii).first;
-		pTouch[i].Status = tcur_status[(*ii).first];
-		pTouch[i].XValue = USHORT(x * (int)MULTI_MAX_COORDINATE);
-        pTouch[i].YValue = USHORT(y * (int)MULTI_MAX_COORDINATE);
-		pTouch[i].Width = 20;
-        pTouch[i].Height = 30;
+		touches[i].ContactID = (BYTE)id;
+		touches[i].Status = contact.status;
+		touches[i].XValue = USHORT(x * (int)MULTI_MAX_COORDINATE);
+        touches[i].YValue = USHORT(y * (int)MULTI_MAX_COORDINATE);
+		touches[i].Width = 20;
+        touches[i].Height = 30;
         
 		i++; 
     }
+	if (frame_mirror!=NULL) frame_mirror->commitFrame(active_transform->generation);
+
+	if (latency!=NULL) latency->mark(TuioLatency::TRANSFORM);
 			
-	if (!vmulti_update_multitouch(vmulti, pTouch, actualCount,requestType,REPORTID_CONTROL))
+	TuioTraceScope hidScope("HID write", "contacts", actualCount);
+	bool written = (vmulti_update_multitouch(vmulti, touches, actualCount,requestType,REPORTID_CONTROL)!=FALSE);
+	if (!written)
     { 
-		fslog<<"touch ";
-		fslog<<" failed \n";
+		TUIO_LOG_ERROR("touch failed");
 	}
+	hidScope.end();
+	if (service_stats!=NULL) service_stats->written(written);
+
+	if (latency!=NULL) latency->mark(TuioLatency::OUTPUT);
 	
 }
 
+// reads the first line of a settings file of the previous versions, nothing if the file is missing
+static void readSetting(TuioConfig &config, const char *key, const char *path)
+{
+	string value;
+	ifstream file;
+	file.open (path);
+	if (getline(file,value) && !value.empty()) config.add(key, value);
+	file.close();
+}
+
+// reads a settings file of the previous versions with one value per line
+static void readSettings(TuioConfig &config, const char *key, const char *path)
+{
+	string value;
+	ifstream file;
+	file.open (path);
+	while (getline(file,value)) {
+		if (!value.empty() && value!="\r") config.add(key, value);
+	}
+	file.close();
+}
+
+//
+//   Reads the settings of the sensor from sensor1.cfg, one "key value" per line:
+//   port, invert_x, invert_y, swap_xy, xrange_min, xrange_max, yrange_min, yrange_max,
+//   x_offset, y_offset, filter, prediction, calibration_point (repeated), stats_port,
+//   rcvbuf, receive_backend, stream_port, shared_memory, multicast_group, multicast_source, relay (repeated)
+//   calibrated_relay and device. Without sensor1.cfg the single files of the previous
+//   versions are read into the same keys, and sensor1.cfg is written from them.
+//
+static void loadSensorConfig(TuioConfig &config)
+{
+	if (config.load("C://Users//AppData//TUIO-To-Vmulti//Data//sensor1.cfg")) return;
+
+	readSetting(config, "port", "C://Users//AppData//TUIO-To-Vmulti//Data//tuioport1.txt");
+	readSetting(config, "invert_x", "C://Users//AppData//TUIO-To-Vmulti//Data//inverthorizontal1.txt");
+	readSetting(config, "invert_y", "C://Users//AppData//TUIO-To-Vmulti//Data//invertverticle1.txt");
+	readSetting(config, "swap_xy", "C://Users//AppData//TUIO-To-Vmulti//Data//swapxy1.txt");
+	readSetting(config, "xrange_min", "C://Users//AppData//TUIO-To-Vmulti//Data//xrange_min1.txt");
+	readSetting(config, "xrange_max", "C://Users//AppData//TUIO-To-Vmulti//Data//xrange_max1.txt");
+	readSetting(config, "yrange_min", "C://Users//AppData//TUIO-To-Vmulti//Data//yrange_min1.txt");
+	readSetting(config, "yrange_max", "C://Users//AppData//TUIO-To-Vmulti//Data//yrange_max1.txt");
+	readSetting(config, "x_offset", "C://Users//AppData//TUIO-To-Vmulti//Data//x01.txt");
+	readSetting(config, "y_offset", "C://Users//AppData//TUIO-To-Vmulti//Data//y01.txt");
+	readSettings(config, "calibration_point", "C://Users//AppData//TUIO-To-Vmulti//Data//calibrationpoints1.txt");
+	readSetting(config, "stats_port", "C://Users//AppData//TUIO-To-Vmulti//Data//stats1.txt");
+	readSetting(config, "rcvbuf", "C://Users//AppData//TUIO-To-Vmulti//Data//rcvbuf1.txt");
+	readSetting(config, "stream_port", "C://Users//AppData//TUIO-To-Vmulti//Data//stream1.txt");
+	readSetting(config, "shared_memory", "C://Users//AppData//TUIO-To-Vmulti//Data//sharedmemory1.txt");
+	readSettings(config, "relay", "C://Users//AppData//TUIO-To-Vmulti//Data//relay1.txt");
+	readSetting(config, "calibrated_relay", "C://Users//AppData//TUIO-To-Vmulti//Data//calibratedrelay1.txt");
+	readSetting(config, "filter", "C://Users//AppData//TUIO-To-Vmulti//Data//filter1.txt");
+	readSetting(config, "prediction", "C://Users//AppData//TUIO-To-Vmulti//Data//prediction1.txt");
+
+	// the group on the first line, the only tracker to accept in it on the second
+	string multicast_group, multicast_source;
+	ifstream multicastfile;
+	multicastfile.open ("C://Users//AppData//TUIO-To-Vmulti//Data//multicast1.txt");
+	if (getline(multicastfile,multicast_group) && !multicast_group.empty()) config.add("multicast_group", multicast_group);
+	if (getline(multicastfile,multicast_source) && !multicast_source.empty()) config.add("multicast_source", multicast_source);
+	multicastfile.close();
+
+	if (config.save("C://Users//AppData//TUIO-To-Vmulti//Data//sensor1.cfg")) TUIO_LOG_INFO("settings moved to sensor1.cfg");
+}
+
+// the settings in the profile of all sensors take precedence over those of sensor1.cfg, setting by setting
+static void loadConfig(TuioConfig &config)
+{
+	loadSensorConfig(config);
+	TuioConfig profile;
+	if (TuioProfile::load("C://Users//AppData//TUIO-To-Vmulti//Data//sensors.xml", SENSOR_INDEX, profile)) config.merge(profile);
+}
+
+// compiles the calibration, smoothing and prediction settings, the grid is fitted here and not on the receiving thread
+static TuioTransform* compileTransform(const TuioConfig &config, long generation)
+{
+	TuioTransform *next = new TuioTransform();
+	next->generation = generation;
+
+	next->calibration.setInvert(config.getBool("invert_x"), config.getBool("invert_y"));
+	next->calibration.setRange(config.getFloat("xrange_min", 0), config.getFloat("xrange_max", 1), config.getFloat("yrange_min", 0), config.getFloat("yrange_max", 1));
+	// whole screens, the offset only applies when both are set
+	int xoffset = config.getInt("x_offset");
+	int yoffset = config.getInt("y_offset");
+	if(xoffset!=0 && yoffset!=0)
+		next->calibration.setOffset((float)(xoffset/100), (float)(yoffset/100));
+	next->calibration.setSwap(config.getBool("swap_xy"));
+
+	// calibration points for keystone and lens correction, "sensor_x sensor_y screen_x screen_y"
+	vector<string> lines = config.getAll("calibration_point");
+	vector<TuioCalibrationPoint> calibration_points;
+	TuioCalibrationPoint calibration_point;
+	for (size_t i=0; i<lines.size(); i++) {
+		if (sscanf(lines[i].c_str(), "%f %f %f %f", &calibration_point.sensorX, &calibration_point.sensorY, &calibration_point.screenX, &calibration_point.screenY)==4)
+			calibration_points.push_back(calibration_point);
+	}
+	if (!calibration_points.empty()) {
+		TuioCalibrationGrid *calibration_grid = new TuioCalibrationGrid();
+		if (calibration_grid->fit(calibration_points)) {
+			TUIO_LOG_INFO("calibration fitted to %d points, error %f", (int)calibration_points.size(), calibration_grid->getError());
+			next->setGrid(calibration_grid);
+		} else {
+			TUIO_LOG_ERROR("calibration points do not determine a correction");
+			delete calibration_grid;
+		}
+	}
+
+	// "oneeuro", "kalman" or "none" with optional parameters
+	if (!next->filter.configure(config.getString("filter", "none").c_str()))
+		TUIO_LOG_ERROR("unknown filter %s", config.getString("filter").c_str());
+	// the latency in milliseconds or "auto" for the measured one, with an optional additional latency and the largest extrapolation
+	if (!next->prediction.configure(config.getString("prediction", "none").c_str()))
+		TUIO_LOG_ERROR("unknown prediction %s", config.getString("prediction").c_str());
+	return next;
+}
+
+//
+//   Compiles the settings on the thread of a watcher when sensor1.cfg or the profile changes,
+//   and hands the result to the receiving thread, which continues with it after the frame it
+//   is working on. The settings of the sockets, relays and the device are used from the start
+//   and change when the service restarts.
+//
+class TuioConfigReloader : public TuioFileListener {
+
+public:
+	TuioConfigReloader(const TuioConfig &c) : started(c), generation(1) {}
+
+	void fileChanged(const char *path) {
+		// both watchers report here, the transforms are published in the order of the changes
+		TuioScopedLock lock(mutex);
+		TuioConfig config;
+		loadConfig(config);
+
+		static const char *restart[] = { "port", "stats_port", "control_port", "rcvbuf", "receive_backend", "stream_port", "shared_memory",
+			"multicast_group", "multicast_source", "relay", "calibrated_relay", "device", "receive_thread", "relay_thread", "lock_memory", "frame_mirror" };
+		for (size_t i=0; i<sizeof(restart)/sizeof(restart[0]); i++) {
+			if (!config.same(started, restart[i])) TUIO_LOG_WARNING("%s changes when the service restarts", restart[i]);
+		}
+
+		transform_exchange.publish(compileTransform(config, ++generation));
+	}
+
+private:
+	TuioMutex mutex;
+	TuioConfig started;
+	long generation;
+};
+
 //
 //   FUNCTION: CSampleService::OnStart(DWORD, LPWSTR *)
 //
@@ -249,7 +590,16 @@ void CSampleService::OnStart(DWORD dwArgc, LPWSTR *lpszArgv)
         EVENTLOG_INFORMATION_TYPE);
 
 	
-				 fslog<<"service started";
+	TuioLog::open("C://log.txt");
+	TUIO_LOG_INFO("service started");
+
+	// the trace file is written when the service stops
+	string trace_path;
+	ifstream tracefile;
+	tracefile.open ("C://Users//AppData//TUIO-To-Vmulti//Data//trace1.txt");
+	getline(tracefile,trace_path);
+	tracefile.close();
+	if (!trace_path.empty()) TuioTrace::start(trace_path.c_str());
 				
 
 	// std::ofstream fs("C://Users//AppData//TUIO-To-Vmulti//Data//service1.txt"); 
@@ -270,128 +620,139 @@ void CSampleService::OnStart(DWORD dwArgc, LPWSTR *lpszArgv)
 //
 void CSampleService::ServiceWorkerThread(void)
 {
-    // Periodically check if the service is stopping.
-    while (!m_fStopping)
-    {
-        // Perform main service function here...
-    //declare the client
-	//std::cout << "Minimum coordinate on screen is " << MULTI_MIN_COORDINATE << std::endl;
+    //std::cout << "Minimum coordinate on screen is " << MULTI_MIN_COORDINATE << std::endl;
     //std::cout << "Maximum coordinate on screen is " << MULTI_MAX_COORDINATE << std::endl;
-    vmulti = vmulti_alloc();
+	// the settings of the sensor, from the profile, sensor1.cfg or the files of the previous versions
+	TuioConfig config;
+	loadConfig(config);
 
- 
-    if (!vmulti_connect(vmulti,1))
-    {
-        vmulti_free(vmulti);
-       
-    }
-	
-    //printf("...sending request(s) to our device\n");
-    
+	// the device stays open while the sensor is restarted, it is connected again only when it failed
+	vmulti = vmulti_alloc();
+	bool vmulti_connected = false;
 
-	/*if( argc >= 2 && strcmp( argv[1], "-h" ) == 0 ){
-        	std::cout << "usage: TuioDump [port]\n";
-        	return 0;
-	}*/
-	
-	
-     //	if( argc >= 2 ) port = atoi( argv[1] );
-//	 CIniReader iniReader(".\\Logger.ini");
-	
 	TuioDump dump;
-	//Getting the port from the file . 
-	port=0;
-	string STRING;
-	ifstream infile;
-	infile.open ("C://Users//AppData//TUIO-To-Vmulti//Data//tuioport1.txt");
-    
-	getline(infile,STRING); // Saves the line in STRING.
-	cout<<"rajat2";
-	
-	infile.close();
-	char *a=new char[STRING.size()+1];
-	a[STRING.size()]=0;
-	memcpy(a,STRING.c_str(),STRING.size());
-	int port = atoi( a );
-
-	ifstream infile2;
-	infile2.open ("C://Users//AppData//TUIO-To-Vmulti//Data//inverthorizontal1.txt");
-    getline(infile2,invert_x); // Saves the line in STRING.
-	infile2.close();
-
-	ifstream infile3;
-	infile3.open ("C://Users//AppData//TUIO-To-Vmulti//Data//invertverticle1.txt");
-    getline(infile3,invert_y); // Saves the line in STRING.
-	infile3.close();
-		
-	ifstream infile4;
-	infile4.open ("C://Users//AppData//TUIO-To-Vmulti//Data//swapxy1.txt");
-    getline(infile4,swap_xy); // Saves the line in STRING.
-	infile4.close();
-	
-	ifstream infile5;
-	infile5.open ("C://Users//AppData//TUIO-To-Vmulti//Data//xrange_min1.txt");
-    getline(infile5,xrange_min); // Saves the line in STRING.
-	infile5.close();
-	char *b=new char[xrange_min.size()+1];
-	b[xrange_min.size()]=0;
-	memcpy(b,xrange_min.c_str(),xrange_min.size());
-	xrangemin = atof( b );
-	
-	
-	ifstream infile6;
-	infile6.open ("C://Users//AppData//TUIO-To-Vmulti//Data//xrange_max1.txt");
-    getline(infile6,xrange_max); // Saves the line in STRING.
-	infile6.close();
-	char *c=new char[xrange_max.size()+1];
-	c[xrange_max.size()]=0;
-	memcpy(c,xrange_max.c_str(),xrange_max.size());
-	xrangemax= atof(c);
-	
-	
-	ifstream infile7;
-	infile7.open ("C://Users//AppData//TUIO-To-Vmulti//Data//yrange_min1.txt");
-    getline(infile7,yrange_min); // Saves the line in STRING.
-	infile7.close();
-	char *d=new char[yrange_min.size()+1];
-	d[yrange_min.size()]=0;
-	memcpy(d,yrange_min.c_str(),yrange_min.size());
-	yrangemin = atof( d );
-	
-	ifstream infile8;
-	infile8.open ("C://Users//AppData//TUIO-To-Vmulti//Data//yrange_max1.txt");
-    getline(infile8,yrange_max); // Saves the line in STRING.
-	infile8.close();
-	char *e=new char[yrange_max.size()+1];
-	e[yrange_max.size()]=0;
-	memcpy(e,yrange_max.c_str(),yrange_max.size());
-	yrangemax = atof( e );
-	
-		
-	ifstream infile9;
-	infile9.open ("C://Users//AppData//TUIO-To-Vmulti//Data//x01.txt");
-    getline(infile9,x_offset); // Saves the line in STRING.
-	infile9.close();
-	char *f=new char[x_offset.size()+1];
-	f[x_offset.size()]=0;
-	memcpy(f,x_offset.c_str(),x_offset.size());
-	xoffset = atoi( f );
-		
-	ifstream infile10;
-	infile10.open ("C://Users//AppData//TUIO-To-Vmulti//Data//y01.txt");
-    getline(infile10,y_offset); // Saves the line in STRING.
-	infile10.close();
-	char *g=new char[y_offset.size()+1];
-	g[y_offset.size()]=0;
-	memcpy(g,y_offset.c_str(),y_offset.size());
-	yoffset = atoi( g );
-
-	//ends here
-	TuioClient client(port);
-	client.addTuioListener(&dump);
-	client.connect(true);
-	
-    }
+	int port = config.getInt("port");
+
+	active_transform = compileTransform(config, 1);
+	TuioServiceStats stats;
+	stats.applied(active_transform->generation);
+	service_stats = &stats;
+	TuioConfigReloader reloader(config);
+	TuioFileWatcher watcher("C://Users//AppData//TUIO-To-Vmulti//Data//sensor1.cfg", &reloader);
+	TuioFileWatcher profile_watcher("C://Users//AppData//TUIO-To-Vmulti//Data//sensors.xml", &reloader);
+	if (!watcher.start() || !profile_watcher.start()) TUIO_LOG_WARNING("configuration changes apply when the service restarts");
+	// "reload" on the control port is carried out by the watcher thread
+	service_control.setWatcher(&watcher);
+
+	// hosts to relay the received TUIO packets to unchanged
+	vector<string> relay_destinations = config.getAll("relay");
+	char relay_host[256];
+	int relay_port;
+
+	// host to send the cursors and objects to with the calibration applied
+	TuioServer *calibrated_server = NULL;
+	if (sscanf(config.getString("calibrated_relay").c_str(), "%255s %d", relay_host, &relay_port)==2) {
+		calibrated_server = new TuioServer(relay_host, relay_port);
+		calibrated_relay = new TuioCalibratedRelay(calibrated_server);
+		calibrated_relay->setCalibration(active_transform->calibration);
+		// the periodic full update runs on the receiving thread, between the frames it re-emits
+		calibrated_server->enablePeriodicMessages();
+	}
+
+	string multicast_group = config.getString("multicast_group");
+	string multicast_source = config.getString("multicast_source");
+	string shm_name = config.getString("shared_memory");
+
+	// the priority and CPU of the receiving thread and of the relay, "realtime 80 cpu 2" for example
+	TuioThreadRole receive_role, relay_role;
+	if (!receive_role.configure(config.getString("receive_thread", "normal").c_str()))
+		TUIO_LOG_ERROR("unknown thread role %s", config.getString("receive_thread").c_str());
+	if (!relay_role.configure(config.getString("relay_thread", "normal").c_str()))
+		TUIO_LOG_ERROR("unknown thread role %s", config.getString("relay_thread").c_str());
+	if (config.getBool("lock_memory")) TuioThreadRole::lockMemory();
+
+	// the frames written to the device are mirrored for the Configuration Utility unless the mirror is "none"
+	char frame_mirror_name[64];
+	sprintf(frame_mirror_name, "Global\\TuioFrames%d", SENSOR_INDEX);
+	string frame_mirror_setting = config.getString("frame_mirror", frame_mirror_name);
+	if (frame_mirror_setting!="none") frame_mirror = new TuioFrameMirror(frame_mirror_setting.c_str(), true);
+
+	// a sensor that fails, because the port is taken, the device is missing or the socket breaks,
+	// is started again after a delay that grows with every failure, until the service stops
+	while (supervisor.start())
+	{
+		if (!vmulti_connected) {
+			vmulti_connected = (vmulti_connect(vmulti,config.getInt("device", SENSOR_INDEX))!=FALSE);
+			if (!vmulti_connected) {
+				TUIO_LOG_ERROR("could not connect to device %d", config.getInt("device", SENSOR_INDEX));
+				continue;
+			}
+		}
+
+		TuioClient client(port);
+		client.addTuioListener(&dump);
+		// statistics on the UDP stats_port, statistics and commands on the TCP control_port
+		client.enableStats(config.getInt("stats_port"), 60, config.getInt("control_port"), &service_control);
+		if (config.getInt("rcvbuf")>0) client.setReceiveBufferSize(config.getInt("rcvbuf"));
+		if (!client.setReceiveBackend(config.getString("receive_backend", "select").c_str()))
+			TUIO_LOG_ERROR("unknown receive backend %s", config.getString("receive_backend").c_str());
+		if (config.getInt("stream_port")>0) client.enableStream(config.getInt("stream_port"));
+		if (!shm_name.empty()) client.enableSharedMemory(shm_name.c_str());
+		if (!multicast_group.empty()) client.joinMulticastGroup(multicast_group.c_str(), multicast_source.empty() ? NULL : multicast_source.c_str());
+
+		// the relay holds packets of the socket of the client, it lives as long as the client
+		TuioRelay *relay = NULL;
+		for (size_t i=0; i<relay_destinations.size(); i++) {
+			if (sscanf(relay_destinations[i].c_str(), "%255s %d", relay_host, &relay_port)!=2) continue;
+			if (relay==NULL) relay = new TuioRelay(TUIO_RELAY_QUEUE_LENGTH, relay_role);
+			relay->addDestination(relay_host, relay_port);
+		}
+		if (relay!=NULL) client.setRelay(relay);
+		// the contacts are written to the device on the receiving thread, which is the thread of this loop
+		client.setThreadRole(receive_role);
+		if (calibrated_relay!=NULL) {
+			client.addTuioListener(calibrated_relay);
+			client.attachTimerWheel(TuioTimerWheel::getShared());
+		}
+
+		// OnStop breaks the client out of connect() once it is attached
+		if (supervisor.attach(&client)) {
+			latency = &client.getLatency();
+			frame_client = &client;
+			try {
+				client.connect(true);
+			} catch (std::exception &e) {
+				TUIO_LOG_ERROR("sensor failed: %s", e.what());
+			}
+			latency = NULL;
+			frame_client = NULL;
+			supervisor.detach();
+		}
+		client.disconnect();
+		releaseContacts();
+
+		// the relay releases the packets it still holds while the socket of the client is open
+		client.setRelay(NULL);
+		delete relay;
+	}
+
+	releaseContacts();
+	service_stats = NULL;
+	service_control.setWatcher(NULL);
+	if (vmulti_connected) vmulti_disconnect(vmulti);
+	vmulti_free(vmulti);
+	vmulti = NULL;
+
+	delete calibrated_relay;
+	calibrated_relay = NULL;
+	delete calibrated_server;
+	delete frame_mirror;
+	frame_mirror = NULL;
+	watcher.stop();
+	profile_watcher.stop();
+	delete transform_exchange.take();
+	delete active_transform;
+	active_transform = NULL;
 
     // Signal the stopped event.
     SetEvent(m_hStoppedEvent);
@@ -413,7 +774,6 @@ void CSampleService::ServiceWorkerThread(void)
 //TuioClient Client();
 void CSampleService::OnStop()
 {
-	 fslog.close();
     // Log a service stop message to the Application log.
     WriteEventLogEntry(L"CppWindowsService in OnStop", 
         EVENTLOG_INFORMATION_TYPE);
@@ -423,12 +783,14 @@ void CSampleService::OnStop()
     // Indicate that the service is stopping and wait for the finish of the 
     // main service function (ServiceWorkerThread).
     m_fStopping = TRUE;
-	
-	vmulti_disconnect(vmulti);
-    vmulti_free(vmulti);
-	
-   /* if (WaitForSingleObject(m_hStoppedEvent, INFINITE) != WAIT_OBJECT_0)
+	supervisor.stop();
+
+    if (WaitForSingleObject(m_hStoppedEvent, INFINITE) != WAIT_OBJECT_0)
     {
         throw GetLastError();
-    }*/
+    }
+
+	TuioTrace::stop();
+	TUIO_LOG_INFO("service stopped");
+	TuioLog::close();
 }
\ No newline at end of file
@@ -30,6 +30,7 @@
 #include "IpEndpointName.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "NetworkingUtils.h"
 
@@ -40,9 +41,77 @@ unsigned long IpEndpointName::GetHostByName( const char *s )
 }
 
 
+void IpEndpointName::SetAddressName( const char *s )
+{
+	if( strchr( s, ':' ) ){
+		unsigned char a[16];
+		if( GetHostByName6( s, a ) ){
+			SetAddress6( a );
+			return;
+		}
+	}
+
+	address = GetHostByName( s );
+	isIpv6 = false;
+	ClearAddress6();
+}
+
+
+void IpEndpointName::SetAddress6( const unsigned char *address6_ )
+{
+	static const unsigned char v4MappedPrefix[12] = { 0,0,0,0, 0,0,0,0, 0,0,0xFF,0xFF };
+
+	if( memcmp( address6_, v4MappedPrefix, 12 ) == 0 ){
+		address = ((unsigned long)address6_[12] << 24) | ((unsigned long)address6_[13] << 16)
+				| ((unsigned long)address6_[14] << 8) | (unsigned long)address6_[15];
+		isIpv6 = false;
+		ClearAddress6();
+	}else{
+		address = 0;
+		isIpv6 = true;
+		memcpy( address6, address6_, 16 );
+	}
+}
+
+
+// writes the address in the RFC 5952 form, the longest run of two or more
+// zero groups is compressed to "::"
+static void Address6AsString( char *s, const unsigned char *a )
+{
+	int group[8];
+	for( int i=0; i < 8; ++i )
+		group[i] = (a[2*i] << 8) | a[2*i+1];
+
+	int bestStart = -1, bestLength = 1;
+	for( int i=0; i < 8; ){
+		int j = i;
+		while( j < 8 && group[j] == 0 )
+			++j;
+		if( j - i > bestLength ){
+			bestStart = i;
+			bestLength = j - i;
+		}
+		i = (j > i) ? j : i + 1;
+	}
+
+	for( int i=0; i < 8; ){
+		if( i == bestStart ){
+			s += sprintf( s, "::" );
+			i += bestLength;
+			continue;
+		}
+		s += sprintf( s, (i == 0 || i == bestStart + bestLength) ? "%x" : ":%x", group[i] );
+		++i;
+	}
+	*s = '\0';
+}
+
+
 void IpEndpointName::AddressAsString( char *s ) const
 {
-	if( address == ANY_ADDRESS ){
+	if( isIpv6 ){
+		Address6AsString( s, address6 );
+	}else if( address == ANY_ADDRESS ){
 		sprintf( s, "<any>" );
 	}else{
 		sprintf( s, "%d.%d.%d.%d",
@@ -56,7 +125,15 @@ void IpEndpointName::AddressAsString( char *s ) const
 
 void IpEndpointName::AddressAndPortAsString( char *s ) const
 {
-	if( port == ANY_PORT ){
+	if( isIpv6 ){
+		*s++ = '[';
+		Address6AsString( s, address6 );
+		s += strlen( s );
+		if( port == ANY_PORT )
+			sprintf( s, "]:<any>" );
+		else
+			sprintf( s, "]:%d", port );
+	}else if( port == ANY_PORT ){
 		if( address == ANY_ADDRESS ){
 			sprintf( s, "<any>:<any>" );
 		}else{
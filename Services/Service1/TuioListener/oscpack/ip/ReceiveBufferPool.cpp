@@ -0,0 +1,229 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "ip/ReceiveBufferPool.h"
+
+#include <vector>
+#include <assert.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+namespace{
+
+const long BUFFER_MAGIC = 0x52427566; // "RBuf"
+
+// the header precedes the data of every buffer, so the data pointer
+// passed to ProcessPacket() is enough to find its buffer again
+struct BufferHeader{
+    long magic;
+    volatile long references;
+    ReceiveBufferPool *pool;    // 0 for lent buffers
+    ReceiveBufferOwner *owner;  // keeps the data 16 byte aligned on 64 bit systems
+};
+
+// a compile time check that lent buffers reserve enough room for the header
+typedef char HeaderFitsReservedSpace[ (sizeof(BufferHeader) <= RECEIVE_BUFFER_HEADER_SIZE) ? 1 : -1 ];
+
+inline BufferHeader *HeaderFromData( const char *data )
+{
+    BufferHeader *header = (BufferHeader*)(data - sizeof(BufferHeader));
+    assert( header->magic == BUFFER_MAGIC );
+    return header;
+}
+
+inline long IncrementReferences( volatile long *references )
+{
+#ifdef WIN32
+    return InterlockedIncrement( references );
+#else
+    return __sync_add_and_fetch( references, 1 );
+#endif
+}
+
+inline long DecrementReferences( volatile long *references )
+{
+#ifdef WIN32
+    return InterlockedDecrement( references );
+#else
+    return __sync_sub_and_fetch( references, 1 );
+#endif
+}
+
+class PoolLock{
+#ifdef WIN32
+    CRITICAL_SECTION mutex_;
+#else
+    pthread_mutex_t mutex_;
+#endif
+
+public:
+#ifdef WIN32
+    PoolLock() { InitializeCriticalSection( &mutex_ ); }
+    ~PoolLock() { DeleteCriticalSection( &mutex_ ); }
+    void Lock() { EnterCriticalSection( &mutex_ ); }
+    void Unlock() { LeaveCriticalSection( &mutex_ ); }
+#else
+    PoolLock() { pthread_mutex_init( &mutex_, 0 ); }
+    ~PoolLock() { pthread_mutex_destroy( &mutex_ ); }
+    void Lock() { pthread_mutex_lock( &mutex_ ); }
+    void Unlock() { pthread_mutex_unlock( &mutex_ ); }
+#endif
+};
+
+} // anonymous namespace
+
+
+class ReceiveBufferPool::Implementation{
+    PoolLock lock_;
+    std::vector< BufferHeader* > free_;
+    int maxFreeBuffers_;
+    int inUse_;
+
+public:
+    Implementation( int maxFreeBuffers )
+        : maxFreeBuffers_( maxFreeBuffers )
+        , inUse_( 0 )
+    {
+        free_.reserve( maxFreeBuffers );
+    }
+
+    ~Implementation()
+    {
+        // buffers still retained by a listener are leaked rather than freed under it
+        for( std::vector< BufferHeader* >::iterator i = free_.begin(); i != free_.end(); ++i )
+            free( *i );
+    }
+
+    char *Acquire( ReceiveBufferPool *pool )
+    {
+        BufferHeader *header = 0;
+
+        lock_.Lock();
+        if( !free_.empty() ){
+            header = free_.back();
+            free_.pop_back();
+        }
+        ++inUse_;
+        lock_.Unlock();
+
+        if( header == 0 ){
+            header = (BufferHeader*)malloc( sizeof(BufferHeader) + RECEIVE_BUFFER_SIZE );
+            if( header == 0 ){
+                lock_.Lock();
+                --inUse_;
+                lock_.Unlock();
+                return 0;
+            }
+            header->magic = BUFFER_MAGIC;
+            header->pool = pool;
+            header->owner = 0;
+        }
+
+        header->references = 1;
+        return (char*)(header + 1);
+    }
+
+    void Recycle( BufferHeader *header )
+    {
+        lock_.Lock();
+        --inUse_;
+        if( (int)free_.size() < maxFreeBuffers_ ){
+            free_.push_back( header );
+            header = 0;
+        }
+        lock_.Unlock();
+
+        if( header != 0 )
+            free( header );
+    }
+
+    int BuffersInUse()
+    {
+        lock_.Lock();
+        int result = inUse_;
+        lock_.Unlock();
+        return result;
+    }
+};
+
+
+ReceiveBufferPool::ReceiveBufferPool( int maxFreeBuffers )
+{
+    impl_ = new Implementation( maxFreeBuffers );
+}
+
+ReceiveBufferPool::~ReceiveBufferPool()
+{
+    delete impl_;
+}
+
+char *ReceiveBufferPool::Acquire()
+{
+    return impl_->Acquire( this );
+}
+
+int ReceiveBufferPool::BuffersInUse() const
+{
+    return impl_->BuffersInUse();
+}
+
+void ReceiveBufferPool::Lend( char *data, ReceiveBufferOwner *owner )
+{
+    BufferHeader *header = (BufferHeader*)(data - sizeof(BufferHeader));
+    header->magic = BUFFER_MAGIC;
+    header->references = 1;
+    header->pool = 0;
+    header->owner = owner;
+}
+
+void ReceiveBufferPool::Retain( const char *data )
+{
+    IncrementReferences( &HeaderFromData( data )->references );
+}
+
+bool ReceiveBufferPool::IsShared( const char *data )
+{
+    return HeaderFromData( data )->references > 1;
+}
+
+void ReceiveBufferPool::Release( const char *data )
+{
+    BufferHeader *header = HeaderFromData( data );
+    if( DecrementReferences( &header->references ) == 0 ){
+        if( header->pool != 0 )
+            header->pool->impl_->Recycle( header );
+        else
+            header->owner->RecycleReceiveBuffer( (char*)data );
+    }
+}
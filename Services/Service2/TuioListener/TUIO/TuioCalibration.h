@@ -0,0 +1,147 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOCALIBRATION_H
+#define INCLUDED_TUIOCALIBRATION_H
+
+#include <math.h>
+
+#include "TuioAtomic.h"
+#include "TuioCalibrationGrid.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioCalibration class maps the normalized coordinates of a sensor onto the screen.
+	 * The positions are corrected with the {@link TuioCalibrationGrid} if there is one, then the
+	 * axes are inverted, mapped to the configured ranges, shifted by the offset and finally
+	 * swapped, in this order. It is shared by the HID output of the service and the
+	 * {@link TuioCalibratedRelay}, and applied to every contact of every frame, so it is inline
+	 * and never allocates.</p>
+	 */
+	class TuioCalibration {
+
+	public:
+		TuioCalibration()
+		: invertX(false), invertY(false), swapXY(false)
+		, xMin(0), xMax(1), yMin(0), yMax(1)
+		, xOffset(0), yOffset(0), grid(NULL) {}
+
+		/**
+		 * Inverts the axes before all other steps
+		 */
+		void setInvert(bool x, bool y) {
+			invertX = x;
+			invertY = y;
+		}
+
+		/**
+		 * Maps the unit range of the axes to the provided ranges
+		 */
+		void setRange(float x0, float x1, float y0, float y1) {
+			xMin = x0;
+			xMax = x1;
+			yMin = y0;
+			yMax = y1;
+		}
+
+		/**
+		 * Shifts the mapped coordinates by the provided offset, only for the HID output
+		 */
+		void setOffset(float x, float y) {
+			xOffset = x;
+			yOffset = y;
+		}
+
+		/**
+		 * Installs the grid that corrects the positions before all other steps, while other threads
+		 * may be applying the calibration. The grid is not copied and has to stay valid while it is
+		 * installed, and the previous grid while the other threads may still be using it.
+		 *
+		 * @param	g	the fitted grid, NULL for none
+		 * @return	the previous grid
+		 */
+		const TuioCalibrationGrid* setGrid(const TuioCalibrationGrid *g) {
+			return (const TuioCalibrationGrid*)atomicExchangePointer(&grid, (void*)g);
+		}
+
+		/**
+		 * Returns the installed grid
+		 * @return	the installed grid, NULL for none
+		 */
+		const TuioCalibrationGrid* getGrid() const {
+			return (const TuioCalibrationGrid*)atomicLoadPointer(const_cast<void * volatile *>(&grid));
+		}
+
+		/**
+		 * Swaps the axes after all other steps
+		 */
+		void setSwap(bool swap) {
+			swapXY = swap;
+		}
+
+		/**
+		 * Calibrates a position
+		 *
+		 * @param	x	the normalized x coordinate, replaced by the calibrated one
+		 * @param	y	the normalized y coordinate, replaced by the calibrated one
+		 */
+		void apply(float &x, float &y) const {
+			const TuioCalibrationGrid *g = getGrid();
+			if (g!=NULL) g->lookup(x, y);
+			if (invertX) x = 1-x;
+			if (invertY) y = 1-y;
+			x = xMin+(xMax-xMin)*x+xOffset;
+			y = yMin+(yMax-yMin)*y+yOffset;
+			if (swapXY) {
+				float tmp = x;
+				x = y;
+				y = tmp;
+			}
+		}
+
+		/**
+		 * Calibrates a position and an angle, the angle is mirrored along with the axes
+		 * and left as it is by the grid and the range mapping
+		 *
+		 * @param	x	the normalized x coordinate, replaced by the calibrated one
+		 * @param	y	the normalized y coordinate, replaced by the calibrated one
+		 * @param	angle	the angle in radians, replaced by the calibrated one in [0,2PI)
+		 */
+		void apply(float &x, float &y, float &angle) const {
+			if (invertX) angle = (float)M_PI-angle;
+			if (invertY) angle = -angle;
+			if (swapXY) angle = (float)(M_PI/2)-angle;
+			while (angle<0) angle += (float)(2*M_PI);
+			while (angle>=2*M_PI) angle -= (float)(2*M_PI);
+			apply(x, y);
+		}
+
+	private:
+		bool invertX, invertY, swapXY;
+		float xMin, xMax, yMin, yMax;
+		float xOffset, yOffset;
+		void * volatile grid;
+	};
+};
+#endif /* INCLUDED_TUIOCALIBRATION_H */
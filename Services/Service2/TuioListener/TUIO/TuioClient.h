@@ -38,12 +38,46 @@
 #include "osc/OscPrintReceivedElements.h"
 
 #include "ip/UdpSocket.h"
+#include "ip/TcpListeningSocket.h"
 #include "ip/PacketListener.h"
 
 #include "TuioListener.h"
 #include "TuioObject.h"
 #include "TuioCursor.h"
+#include "TuioLock.h"
+#include "TuioLatency.h"
+#include "TuioStats.h"
+#include "TuioSharedMemory.h"
+#include "TuioThreadRole.h"
 namespace TUIO {
+
+	class TuioStreamReceiver;
+	class TuioRelay;
+	class TuioTimerWheel;
+
+	/**
+	 * A consistent snapshot of the last frame committed by a TuioClient, see {@link TuioClient::getFrameInfo}
+	 */
+	struct TuioFrameInfo {
+		long frameID;
+		TuioTime frameTime;
+		int cursorCount;
+		int objectCount;
+	};
+
+	/**
+	 * The fragments received so far of a frame that a {@link TuioServer} split over several packets,
+	 * see {@link TuioServer#setMaxPacketSize}
+	 */
+	struct TuioFragmentState {
+		long frame;
+		int count;
+		unsigned long long received;
+		// the entries of the frame list that the earlier fragments added
+		int pending;
+		// true while the current bundle is a fragment, and it is not the last one
+		bool fragment, deferred;
+	};
 	
 	/**
 	 * <p>The TuioClient class is the central TUIO protocol decoder component. It provides a simple callback infrastructure using the {@link TuioListener} interface.
@@ -65,8 +99,10 @@ namespace TUIO {
 		 * This constructor creates a TuioClient that listens to the provided port
 		 *
 		 * @param  port  the incoming TUIO UDP port number, defaults to 3333 if no argument is provided
+		 * @param  shard  the index of this TuioClient if it shares the port with others, see {@link TuioShardedClient},
+		 *                or -1 (default) to bind the port exclusively
 		 */
-		TuioClient(int port=3333);
+		TuioClient(int port=3333, int shard=-1);
 
 		/**
 		 * The destructor is doing nothing in particular. 
@@ -86,6 +122,12 @@ namespace TUIO {
 		 */
 		void disconnect();
 
+		/**
+		 * Makes a connect(true) that is running on another thread return, the lists are kept until
+		 * the thread that connected calls disconnect()
+		 */
+		void interrupt();
+
 		/**
 		 * Returns true if this TuioClient is currently connected.
 		 * @return	true if this TuioClient is currently connected
@@ -163,6 +205,120 @@ namespace TUIO {
 		 */
 		void unlockCursorList();
 
+		/**
+		 * Returns the ID, time and active cursor and object counts of the last committed frame.
+		 * This method never blocks the receiving thread and can be called from any thread.
+		 *
+		 * @return	a consistent snapshot of the last committed frame
+		 */
+		TuioFrameInfo getFrameInfo() const;
+
+		/**
+		 * Returns the latency measurement of this TuioClient, listeners that forward
+		 * the frame mark the TRANSFORM and OUTPUT stages from within refresh()
+		 *
+		 * @return	the latency measurement of this TuioClient
+		 */
+		TuioLatency& getLatency() { return latency; }
+
+		/**
+		 * Answers statistics requests on the provided local UDP port, and statistics and control
+		 * requests on the provided local TCP port, and writes the statistics to the log periodically.
+		 * The requests are answered by the receiving thread, see {@link TuioStatsEndpoint}.
+		 * Has to be called before connect().
+		 *
+		 * @param  port	the local UDP port for statistics requests, or 0 for no endpoint
+		 * @param  dumpSeconds	the period of the log dump in seconds, or 0 for no dump
+		 * @param  controlPort	the local TCP port for statistics and control requests, or 0 for none
+		 * @param  listener	carries out the control commands, or NULL to refuse them
+		 */
+		void enableStats(int port, int dumpSeconds=60, int controlPort=0, TuioControlListener *listener=NULL);
+
+		/**
+		 * Requests a kernel receive buffer of the provided size for the TUIO socket,
+		 * large enough to hold the bursts of the sensor. Has to be called before connect().
+		 *
+		 * @param  bytes	the receive buffer size in bytes
+		 */
+		void setReceiveBufferSize(int bytes);
+
+		/**
+		 * Selects how the TUIO socket is received: "select" (default) waits with select() on posix
+		 * systems and with event objects on Windows, "io_uring" receives into kernel provided buffers
+		 * without a copy. io_uring needs Linux 6.0 and no TCP ports on the client, otherwise the client
+		 * falls back to select() and logs a warning with the first datagram. Has to be called before connect().
+		 *
+		 * @param  name	the name of the backend
+		 * @return	false if the name is unknown
+		 */
+		bool setReceiveBackend(const char *name);
+
+		/**
+		 * Also receives the TUIO packets sent to a multicast group on the port of this client, so that one
+		 * tracker can feed any number of hosts with a single send. IPv4 and IPv6 groups are supported, IPv6
+		 * groups not on Windows. With a source only the packets of that tracker are received (source-specific
+		 * multicast). Can be called several times to join further groups or sources.
+		 *
+		 * @param  group	the group address, like "239.255.84.85" or "ff15::7475:696f"
+		 * @param  source	the address of the only tracker to receive from, or NULL (default) for any tracker
+		 * @return	true if the group could be joined
+		 */
+		bool joinMulticastGroup(const char *group, const char *source=NULL);
+
+		/**
+		 * Forwards every received TUIO packet unchanged to the destinations of the provided relay,
+		 * before it is decoded. Without decoding the client only relays, its listeners are not called.
+		 * Has to be called before connect(). The relay is stopped when the client is deleted.
+		 *
+		 * @param  relay	the relay, owned by the caller, or NULL to stop relaying
+		 * @param  decode	false to forward the packets without decoding them
+		 */
+		void setRelay(TuioRelay *relay, bool decode=true) { this->relay = relay; decodePackets = decode; }
+
+		/**
+		 * Advances the provided timer wheel on the receiving thread, so that its timers, for example the
+		 * periodic full update of a TuioServer fed by a listener, run between two packets instead of on
+		 * another thread. Has to be called before connect(), the wheel is detached when the client is deleted.
+		 *
+		 * @param  wheel	the timer wheel, owned by the caller
+		 */
+		void attachTimerWheel(TuioTimerWheel *wheel);
+
+		/**
+		 * Schedules the receiving threads with the provided priority and CPU, while they receive.
+		 * In the foreground the role is applied to the thread that calls connect(true) until it returns.
+		 * Has to be called before connect().
+		 *
+		 * @param  role	the role of the receiving threads
+		 */
+		void setThreadRole(const TuioThreadRole &role) { threadRole = role; }
+
+		/**
+		 * Returns the role of the receiving threads
+		 * @return	the role of the receiving threads
+		 */
+		const TuioThreadRole& getThreadRole() const { return threadRole; }
+
+		/**
+		 * Also receives TUIO over TCP on the provided port, from any number of senders that frame
+		 * the OSC packets with SLIP, with a length prefix or as WebSocket binary messages.
+		 * The connections are served by the receiving thread. Has to be called before connect().
+		 *
+		 * @param  port	the local TCP port
+		 * @return	true if the port could be bound
+		 */
+		bool enableStream(int port);
+
+		/**
+		 * Also receives TUIO packets that a tracker on the same machine writes to the named shared memory ring,
+		 * see {@link TuioSharedMemory}. The ring is read by a second thread. Has to be called before connect().
+		 *
+		 * @param  name	the name of the ring
+		 * @param  capacity	the size of the ring in bytes, if it is created
+		 * @return	true if the ring could be mapped
+		 */
+		bool enableSharedMemory(const char *name, int capacity=TUIO_SHARED_MEMORY_CAPACITY);
+
 		void ProcessPacket( const char *data, int size, const IpEndpointName &remoteEndpoint );
 		UdpListeningReceiveSocket *socket;
 				
@@ -179,12 +335,21 @@ namespace TUIO {
 		void ProcessMessage( const osc::ReceivedMessage& message, const IpEndpointName& remoteEndpoint);
 		
 	private:
+		friend class TuioStreamReceiver;
+		void processPacket(const char *data, int size, const IpEndpointName &remoteEndpoint, long long receiveTime, bool retainable);
+#ifndef WIN32
+		static void* sharedMemoryThreadFunc(void *obj);
+#else
+		static DWORD WINAPI sharedMemoryThreadFunc(LPVOID obj);
+#endif
+
 		std::list<TuioListener*> listenerList;
 		
 		std::list<TuioObject*> objectList, frameObjects;
 		std::list<long> aliveObjectList;
 		std::list<TuioCursor*> cursorList, frameCursors;
 		std::list<long> aliveCursorList;
+		TuioFragmentState objectFragments, cursorFragments;
 		
 		osc::int32 currentFrame;
 		TuioTime currentTime;
@@ -192,17 +357,42 @@ namespace TUIO {
 		std::list<TuioCursor*> freeCursorList, freeCursorBuffer;
 		int maxCursorID;
 		
+		void publishFrameInfo();
+
+		TuioMutex objectMutex;
+		TuioMutex cursorMutex;
+
+		TuioSeqLock frameInfoLock;
+		TuioFrameInfo frameInfo;
+
+		TuioLatency latency;
+		TuioFrameStats frameStats;
+		TuioSocketStats *socketStats;
+		TuioStatsEndpoint *statsEndpoint;
+		TcpListeningSocket *streamSocket;
+		TuioStreamReceiver *streamReceiver;
+
+		// serializes the packets of the UDP and the shared memory thread
+		TuioMutex packetMutex;
+		TuioSharedMemory *sharedMemory;
+		TuioRelay *relay;
+		bool decodePackets;
+		// io_uring was requested, the backend in use is checked with the first datagram
+		bool checkBackend;
+		TuioTimerWheel *timerWheel;
+
 #ifndef WIN32
 		pthread_t thread;
-		pthread_mutex_t objectMutex;
-		pthread_mutex_t cursorMutex;
-		//pthread_mutexattr_t attr_p;
 #else
 		HANDLE thread;
-		HANDLE objectMutex;
-		HANDLE cursorMutex;
 #endif	
+#ifndef WIN32
+		pthread_t sharedMemoryThread;
+#else
+		HANDLE sharedMemoryThread;
+#endif
 				
+		TuioThreadRole threadRole;
 		bool locked;
 		bool connected;
 	};
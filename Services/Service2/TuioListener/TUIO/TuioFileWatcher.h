@@ -0,0 +1,122 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOFILEWATCHER_H
+#define INCLUDED_TUIOFILEWATCHER_H
+
+#ifndef WIN32
+#include <pthread.h>
+#else
+#include <windows.h>
+#endif
+
+#include <string>
+
+// milliseconds without further changes before a change is reported, editors write files in several steps
+#define TUIO_FILE_WATCHER_SETTLE_TIME 100
+
+namespace TUIO {
+
+	/**
+	 * The interface of the objects that are notified about changes of a watched file
+	 */
+	class TuioFileListener {
+
+	public:
+		virtual ~TuioFileListener() {};
+
+		/**
+		 * Called on the thread of the {@link TuioFileWatcher} after the file was written, created,
+		 * replaced or deleted
+		 *
+		 * @param  path	the path of the watched file
+		 */
+		virtual void fileChanged(const char *path)=0;
+	};
+
+	/**
+	 * <p>The TuioFileWatcher reports the changes of a single file to a {@link TuioFileListener}, with
+	 * inotify on Linux and ReadDirectoryChangesW on Windows. It watches the directory of the file, so
+	 * that files which are replaced by a rename, or created later, are reported as well. A burst of
+	 * changes is reported once, after the file did not change for TUIO_FILE_WATCHER_SETTLE_TIME.</p>
+	 */
+	class TuioFileWatcher {
+
+	public:
+		/**
+		 * @param  path	the file to watch, its directory has to exist
+		 * @param  listener	the listener to notify, it has to outlive the watcher
+		 */
+		TuioFileWatcher(const char *path, TuioFileListener *listener);
+
+		/**
+		 * Stops watching
+		 */
+		~TuioFileWatcher();
+
+		/**
+		 * Starts the thread that watches the file
+		 *
+		 * @return	false if the directory could not be watched
+		 */
+		bool start();
+
+		/**
+		 * Stops the thread, a notification in progress is completed first
+		 */
+		void stop();
+
+		/**
+		 * Notifies the listener on the thread of the watcher as if the file changed, for changes
+		 * that are requested by another thread which must not wait for the listener
+		 *
+		 * @return	false if the watcher is not running
+		 */
+		bool trigger();
+
+		/**
+		 * Returns the watched file
+		 */
+		const char* getPath() const { return path.c_str(); }
+
+	private:
+		void watch();
+		void notify();
+
+#ifndef WIN32
+		static void* threadFunc( void* obj );
+		pthread_t thread;
+		int inotifyFd;
+		// a 0 stops the thread, a 1 triggers a notification
+		int stopPipe[2];
+#else
+		static DWORD WINAPI threadFunc( LPVOID obj );
+		HANDLE thread;
+		HANDLE directoryHandle;
+		HANDLE stopEvent;
+		HANDLE triggerEvent;
+#endif
+		bool started;
+		std::string path;
+		std::string directory;
+		std::string name;
+		TuioFileListener *listener;
+	};
+};
+#endif /* INCLUDED_TUIOFILEWATCHER_H */
@@ -0,0 +1,157 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOFRAMEMIRROR_H
+#define INCLUDED_TUIOFRAMEMIRROR_H
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <string>
+
+// the contacts of a frame that are published, further contacts are left out
+#define TUIO_FRAME_MIRROR_CONTACTS 64
+// the attempts of read() while the frame changes under it
+#define TUIO_FRAME_MIRROR_READ_ATTEMPTS 100
+
+namespace TUIO {
+
+	struct TuioFrameMirrorHeader;
+
+	/**
+	 * A contact of a published frame, in the layout of the shared memory
+	 */
+	struct TuioFrameMirrorContact {
+		int id;			// the cursor ID
+		int status;		// the HID status bits, 0 once the contact is released
+		float rawX, rawY;	// the position as received from the sensor
+		float sensorX, sensorY;	// the position after the smoothing and the prediction
+		float x, y;		// the calibrated position on the screens, from 0 to 1
+	};
+
+	/**
+	 * The frame information of a published frame
+	 */
+	struct TuioFrameMirrorFrame {
+		long long frameID;	// the TUIO frame ID
+		long long frameTime;	// the TUIO time of the frame in microseconds
+		long long generation;	// the configuration the frame was transformed with
+		long long frames;	// the number of frames published so far
+		int contactCount;
+	};
+
+	/**
+	 * <p>The TuioFrameMirror publishes the last frame that a service wrote to its device in shared
+	 * memory, with the raw and the calibrated position of every contact, so that local tools such
+	 * as the monitor of the Configuration Utility follow the contacts without a socket of their own
+	 * and without decoding TUIO again. There is one publisher and any number of readers.</p>
+	 *
+	 * <p>The frame is guarded by a sequence counter like a {@link TuioSeqLock}, with 32 bits in the
+	 * shared memory: the publisher makes the counter odd, writes the frame in place and makes it even
+	 * again, a reader copies the frame and retries when the counter was odd or changed meanwhile.
+	 * The publisher never waits for the readers.</p>
+	 *
+	 * <p>The layout is versioned and explicitly sized, so that 32 and 64-bit processes and the C#
+	 * reader of the Configuration Utility agree on it. The publisher creates the region and marks it
+	 * closed when it goes away. On Windows a publisher that starts again takes over the region while
+	 * readers still map it, on Linux it creates a new one that the readers map once the old one is
+	 * closed. On Windows a service has to use a name that starts with "Global\", which other users
+	 * may read but not write.</p>
+	 */
+	class TuioFrameMirror {
+
+	public:
+		/**
+		 * Creates the region as the publisher, or maps it as a reader
+		 *
+		 * @param  name  the name of the region
+		 * @param  publisher  true for the publisher, false for a reader
+		 * @param  maxContacts  the contacts per frame if the region is created
+		 */
+		TuioFrameMirror(const char *name, bool publisher, int maxContacts=TUIO_FRAME_MIRROR_CONTACTS);
+
+		/**
+		 * Unmaps the region, the publisher marks it closed
+		 */
+		~TuioFrameMirror();
+
+		/**
+		 * Returns true if the region could be created or mapped
+		 * @return	true if the region is mapped
+		 */
+		bool isOpen() const { return header!=NULL; }
+
+		/**
+		 * Starts to write a frame, readers retry until it is committed. Only the publisher calls it.
+		 *
+		 * @param  frameID	the TUIO frame ID
+		 * @param  frameTime	the TUIO time of the frame in microseconds
+		 */
+		void beginFrame(long long frameID, long long frameTime);
+
+		/**
+		 * Adds a contact to the frame that is written, contacts beyond the capacity are left out
+		 */
+		void addContact(int id, int status, float rawX, float rawY, float sensorX, float sensorY, float x, float y);
+
+		/**
+		 * Publishes the frame that is written
+		 *
+		 * @param  generation	the configuration the frame was transformed with
+		 */
+		void commitFrame(long long generation);
+
+		/**
+		 * Copies the last published frame. Only readers call it.
+		 *
+		 * @param  frame	the frame information
+		 * @param  contacts	room for maxContacts contacts
+		 * @param  maxContacts	the number of contacts to copy at most
+		 * @return	false if the region is not mapped, closed, or the publisher kept writing
+		 */
+		bool read(TuioFrameMirrorFrame &frame, TuioFrameMirrorContact *contacts, int maxContacts);
+
+		/**
+		 * Returns true if the publisher closed the region, a reader has to map it again
+		 * @return	true if the region is closed
+		 */
+		bool isClosed() const;
+
+	private:
+		bool open();
+		void close();
+
+		std::string name;
+		bool publisher;
+		int requestedContacts;
+
+		TuioFrameMirrorHeader *header;
+		TuioFrameMirrorContact *contacts;
+		int maxContacts;
+		int writeCount;
+
+#ifndef WIN32
+		int mappingSize;
+#else
+		HANDLE mapping;
+#endif
+	};
+};
+#endif /* INCLUDED_TUIOFRAMEMIRROR_H */
@@ -0,0 +1,71 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioLatency.h"
+
+#include <string.h>
+
+using namespace TUIO;
+
+static const char *stageNames[TuioLatency::STAGE_COUNT] = { "receive", "decode", "update", "transform", "output" };
+
+TuioLatency::TuioLatency(const char *n) {
+	setName(n);
+	discard();
+	TuioStats::addSource(this);
+}
+
+void TuioLatency::setName(const char *n) {
+	strncpy(name, n, sizeof(name)-1);
+	name[sizeof(name)-1] = 0;
+}
+
+TuioLatency::~TuioLatency() {
+	TuioStats::removeSource(this);
+}
+
+void TuioLatency::commit() {
+	long long first = 0;
+	long long last = 0;
+	for (int stage=0; stage<STAGE_COUNT; stage++) {
+		if (stamps[stage]==0) continue;
+		if (last!=0) stageHistogram[stage].record(stamps[stage]-last);
+		else first = stamps[stage];
+		last = stamps[stage];
+	}
+	if (last!=first) totalHistogram.record(last-first);
+	discard();
+}
+
+void TuioLatency::discard() {
+	for (int stage=0; stage<STAGE_COUNT; stage++) stamps[stage] = 0;
+}
+
+void TuioLatency::writeStats(TuioStatsReport &report) {
+	report.beginSection(name);
+	// RECEIVE starts the frame, there is no time spent before it
+	for (int stage=DECODE; stage<STAGE_COUNT; stage++)
+		report.addHistogram(stageNames[stage], stageHistogram[stage]);
+	report.addHistogram("total", totalHistogram);
+}
+
+void TuioLatency::resetStats() {
+	for (int stage=0; stage<STAGE_COUNT; stage++) stageHistogram[stage].reset();
+	totalHistogram.reset();
+}
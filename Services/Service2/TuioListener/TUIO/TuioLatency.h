@@ -0,0 +1,114 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOLATENCY_H
+#define INCLUDED_TUIOLATENCY_H
+
+#include "ip/NetworkingUtils.h"
+
+#include "TuioHistogram.h"
+#include "TuioStats.h"
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioLatency class measures how long a frame spends in each stage of the pipeline,
+	 * from the arrival of its datagram to the return of the HID report. The receiving thread
+	 * marks the end of every stage it passes, commit() then records the time between consecutive
+	 * marks and the end-to-end latency into per-stage histograms. Stages that were not marked
+	 * are merged into the next marked stage.</p>
+	 * <p>Every TuioClient owns one instance, which registers itself with TuioStats under the
+	 * name of the sensor. All marks have to be set by the receiving thread.</p>
+	 */
+	class TuioLatency : public TuioStatsSource {
+
+	public:
+		enum Stage {
+			RECEIVE,	// the datagram arrived at the socket
+			DECODE,		// the OSC bundle up to the fseq message is decoded
+			UPDATE,		// the TuioClient state is updated, before the listeners are refreshed
+			TRANSFORM,	// the contacts are mapped to screen coordinates
+			OUTPUT,		// the HID report returned
+			STAGE_COUNT
+		};
+
+		/**
+		 * @param	name	the sensor name used in the statistics report
+		 */
+		TuioLatency(const char *name);
+		~TuioLatency();
+
+		/**
+		 * Changes the sensor name used in the statistics report
+		 */
+		void setName(const char *name);
+
+		/**
+		 * Marks the end of a stage now
+		 */
+		void mark(Stage stage) {
+			stamps[stage] = GetCurrentTimeNanoseconds();
+		}
+
+		/**
+		 * Marks the end of a stage at the given time, in nanoseconds of GetCurrentTimeNanoseconds()
+		 */
+		void mark(Stage stage, long long time) {
+			stamps[stage] = time;
+		}
+
+		/**
+		 * Marks the end of a stage unless it was marked since the last commit,
+		 * used for the arrival of frames that span more than one datagram
+		 */
+		void markFirst(Stage stage, long long time) {
+			if (stamps[stage]==0) stamps[stage] = time;
+		}
+
+		/**
+		 * Records the marked stages of the current frame and clears the marks
+		 */
+		void commit();
+
+		/**
+		 * Clears the marks without recording, for frames that are dropped
+		 */
+		void discard();
+
+		/**
+		 * Returns the histogram of the time spent before the end of the given stage
+		 */
+		const TuioHistogram& getHistogram(Stage stage) const { return stageHistogram[stage]; }
+
+		/**
+		 * Returns the histogram of the end-to-end latency
+		 */
+		const TuioHistogram& getTotalHistogram() const { return totalHistogram; }
+
+		void writeStats(TuioStatsReport &report);
+		void resetStats();
+
+	private:
+		char name[32];
+		long long stamps[STAGE_COUNT];
+		TuioHistogram stageHistogram[STAGE_COUNT];
+		TuioHistogram totalHistogram;
+	};
+};
+#endif /* INCLUDED_TUIOLATENCY_H */
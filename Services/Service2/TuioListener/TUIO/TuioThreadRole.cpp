@@ -0,0 +1,218 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioThreadRole.h"
+#include "TuioLog.h"
+
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+
+#ifndef WIN32
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#else
+#include <avrt.h>
+#endif
+
+using namespace TUIO;
+
+bool TuioThreadRole::configure(const char *description) {
+	std::istringstream words(description);
+	std::string word;
+	Priority p = NORMAL;
+	int level = TUIO_THREAD_ROLE_REALTIME_PRIORITY;
+	int c = -1;
+
+	if (!(words >> word)) return false;
+	if (word=="normal") p = NORMAL;
+	else if (word=="high") p = HIGH;
+	else if (word=="realtime") p = REALTIME;
+	else if (word!="cpu") return false;
+
+	if (word!="cpu") {
+		if (!(words >> word)) word.clear();
+		// an optional SCHED_FIFO priority, 99 is left to the watchdog threads of the kernel
+		if ((p==REALTIME) && !word.empty() && (word!="cpu")) {
+			level = atoi(word.c_str());
+			if ((level<1) || (level>98)) return false;
+			if (!(words >> word)) word.clear();
+		}
+	}
+
+	if (word=="cpu") {
+		if (!(words >> c) || (c<0)) return false;
+		if (words >> word) return false;
+	} else if (!word.empty()) return false;
+
+	priority = p;
+	realtimePriority = level;
+	cpu = c;
+	return true;
+}
+
+bool TuioThreadRole::lockMemory() {
+#ifndef WIN32
+	if (mlockall(MCL_CURRENT | MCL_FUTURE)!=0) {
+		TUIO_LOG_WARNING("could not lock the memory: %s", strerror(errno));
+		return false;
+	}
+#else
+	if (!SetProcessWorkingSetSizeEx(GetCurrentProcess(), TUIO_THREAD_ROLE_WORKING_SET, 2*TUIO_THREAD_ROLE_WORKING_SET,
+		QUOTA_LIMITS_HARDWS_MIN_ENABLE | QUOTA_LIMITS_HARDWS_MAX_DISABLE)) {
+		TUIO_LOG_WARNING("could not lock the memory: error %lu", GetLastError());
+		return false;
+	}
+#endif
+	TUIO_LOG_INFO("memory locked");
+	return true;
+}
+
+TuioThreadRoleScope::TuioThreadRoleScope(const TuioThreadRole &role, const char *name)
+: restorePriority(false)
+, restoreAffinity(false)
+#ifndef WIN32
+, restoreNice    (false)
+#else
+, mmcssHandle    (NULL)
+#endif
+{
+	if (role.getPriority()!=TuioThreadRole::NORMAL) setPriority(role, name);
+	if (role.getCpu()>=0) setCpu(role.getCpu(), name);
+}
+
+#ifndef WIN32
+
+bool TuioThreadRoleScope::setPriority(const TuioThreadRole &role, const char *name) {
+	if (role.getPriority()==TuioThreadRole::REALTIME) {
+		pthread_getschedparam(pthread_self(), &oldPolicy, &oldParam);
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = role.getRealtimePriority();
+		int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (error==0) {
+			restorePriority = true;
+			TUIO_LOG_INFO("%s thread runs with SCHED_FIFO priority %d", name, param.sched_priority);
+			return true;
+		}
+		// without CAP_SYS_NICE or an rtprio limit the thread is only raised within SCHED_OTHER
+		TUIO_LOG_WARNING("could not run the %s thread with SCHED_FIFO: %s", name, strerror(error));
+	}
+	return setHighPriority(name);
+}
+
+bool TuioThreadRoleScope::setHighPriority(const char *name) {
+#ifdef __linux__
+	// the nice value of a single thread is set through its thread id
+	pid_t tid = (pid_t)syscall(SYS_gettid);
+	errno = 0;
+	oldNice = getpriority(PRIO_PROCESS, tid);
+	if ((errno==0) && (setpriority(PRIO_PROCESS, tid, TUIO_THREAD_ROLE_HIGH_NICE)==0)) {
+		restoreNice = true;
+		TUIO_LOG_INFO("%s thread runs with nice %d", name, TUIO_THREAD_ROLE_HIGH_NICE);
+		return true;
+	}
+	TUIO_LOG_WARNING("could not raise the priority of the %s thread: %s", name, strerror(errno));
+#endif
+	return false;
+}
+
+bool TuioThreadRoleScope::setCpu(int cpu, const char *name) {
+#ifdef __linux__
+	if ((cpu<0) || (cpu>=CPU_SETSIZE)) {
+		TUIO_LOG_WARNING("could not bind the %s thread to CPU %d, beyond the %d CPUs of a set", name, cpu, CPU_SETSIZE);
+		return false;
+	}
+	if (pthread_getaffinity_np(pthread_self(), sizeof(oldCpus), &oldCpus)!=0) CPU_ZERO(&oldCpus);
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)==0) {
+		restoreAffinity = (CPU_COUNT(&oldCpus)>0);
+		return true;
+	}
+	TUIO_LOG_WARNING("could not bind the %s thread to CPU %d", name, cpu);
+#endif
+	return false;
+}
+
+TuioThreadRoleScope::~TuioThreadRoleScope() {
+	if (restorePriority) pthread_setschedparam(pthread_self(), oldPolicy, &oldParam);
+#ifdef __linux__
+	if (restoreNice) setpriority(PRIO_PROCESS, (pid_t)syscall(SYS_gettid), oldNice);
+	if (restoreAffinity) pthread_setaffinity_np(pthread_self(), sizeof(oldCpus), &oldCpus);
+#endif
+}
+
+#else
+
+bool TuioThreadRoleScope::setPriority(const TuioThreadRole &role, const char *name) {
+	if (role.getPriority()==TuioThreadRole::REALTIME) {
+		// MMCSS raises the thread into the realtime range for most of every period and keeps the rest for the system
+		DWORD taskIndex = 0;
+		mmcssHandle = AvSetMmThreadCharacteristicsA(TUIO_THREAD_ROLE_MMCSS_TASK, &taskIndex);
+		if (mmcssHandle!=NULL) {
+			AvSetMmThreadPriority(mmcssHandle, AVRT_PRIORITY_CRITICAL);
+			TUIO_LOG_INFO("%s thread runs in the MMCSS task %s", name, TUIO_THREAD_ROLE_MMCSS_TASK);
+			return true;
+		}
+		TUIO_LOG_WARNING("could not register the %s thread with MMCSS: error %lu", name, GetLastError());
+	}
+	return setHighPriority(name);
+}
+
+bool TuioThreadRoleScope::setHighPriority(const char *name) {
+	oldPriority = GetThreadPriority(GetCurrentThread());
+	if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+		restorePriority = true;
+		TUIO_LOG_INFO("%s thread runs with THREAD_PRIORITY_HIGHEST", name);
+		return true;
+	}
+	TUIO_LOG_WARNING("could not raise the priority of the %s thread: error %lu", name, GetLastError());
+	return false;
+}
+
+bool TuioThreadRoleScope::setCpu(int cpu, const char *name) {
+	// the mask has one bit per CPU of the processor group, shifting beyond it is undefined
+	if ((cpu<0) || (cpu>=(int)(sizeof(DWORD_PTR)*8))) {
+		TUIO_LOG_WARNING("could not bind the %s thread to CPU %d, beyond the %d CPUs of a group", name, cpu, (int)(sizeof(DWORD_PTR)*8));
+		return false;
+	}
+	oldMask = SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR)1)<<cpu);
+	if (oldMask!=0) {
+		restoreAffinity = true;
+		return true;
+	}
+	TUIO_LOG_WARNING("could not bind the %s thread to CPU %d", name, cpu);
+	return false;
+}
+
+TuioThreadRoleScope::~TuioThreadRoleScope() {
+	if (mmcssHandle!=NULL) AvRevertMmThreadCharacteristics(mmcssHandle);
+	if (restorePriority) SetThreadPriority(GetCurrentThread(), oldPriority);
+	if (restoreAffinity) SetThreadAffinityMask(GetCurrentThread(), oldMask);
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOTRANSFORM_H
+#define INCLUDED_TUIOTRANSFORM_H
+
+#include "TuioAtomic.h"
+#include "TuioCalibration.h"
+#include "TuioCalibrationGrid.h"
+#include "TuioFilter.h"
+#include "TuioPrediction.h"
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioTransform holds everything that is applied to the contacts between the receiving
+	 * and the output: the {@link TuioCalibration} with its grid, the {@link TuioFilter} and the
+	 * {@link TuioPrediction}. It is compiled from the configuration on another thread and used
+	 * unchanged by the receiving thread, a new configuration is a new TuioTransform.</p>
+	 */
+	class TuioTransform {
+
+	public:
+		TuioTransform() : generation(0), grid(NULL) {}
+
+		/**
+		 * Deletes the grid of the calibration
+		 */
+		~TuioTransform() {
+			calibration.setGrid(NULL);
+			delete grid;
+		}
+
+		/**
+		 * Installs the grid in the calibration, the transform takes its ownership
+		 *
+		 * @param  g	the fitted grid, NULL for none
+		 */
+		void setGrid(TuioCalibrationGrid *g) {
+			calibration.setGrid(g);
+			delete grid;
+			grid = g;
+		}
+
+		TuioCalibration calibration;
+		TuioFilter filter;
+		TuioPrediction prediction;
+		// counts the configurations that were compiled, starting with 1
+		long generation;
+
+	private:
+		TuioTransform(const TuioTransform&);
+		TuioTransform& operator=(const TuioTransform&);
+
+		TuioCalibrationGrid *grid;
+	};
+
+	/**
+	 * <p>The TuioTransformExchange hands a new {@link TuioTransform} from the thread that compiles it
+	 * to the receiving thread, which picks it up between two frames without waiting for the other
+	 * thread. A transform that is published before the previous one was taken replaces it.</p>
+	 */
+	class TuioTransformExchange {
+
+	public:
+		TuioTransformExchange() : pending(NULL) {}
+
+		/**
+		 * Deletes the transform that was not taken
+		 */
+		~TuioTransformExchange() {
+			delete (TuioTransform*)atomicExchangePointer(&pending, NULL);
+		}
+
+		/**
+		 * Publishes a new transform, the exchange takes its ownership until it is taken
+		 *
+		 * @param  transform	the new transform
+		 */
+		void publish(TuioTransform *transform) {
+			delete (TuioTransform*)atomicExchangePointer(&pending, transform);
+		}
+
+		/**
+		 * Takes the transform that was published last, only called by the receiving thread
+		 *
+		 * @return	the new transform which the caller owns, NULL if there is none
+		 */
+		TuioTransform* take() {
+			// a plain load per frame, the exchange only when there is something to take
+			if (atomicLoadPointer(&pending)==NULL) return NULL;
+			return (TuioTransform*)atomicExchangePointer(&pending, NULL);
+		}
+
+	private:
+		TuioTransformExchange(const TuioTransformExchange&);
+		TuioTransformExchange& operator=(const TuioTransformExchange&);
+
+		void * volatile pending;
+	};
+};
+#endif /* INCLUDED_TUIOTRANSFORM_H */
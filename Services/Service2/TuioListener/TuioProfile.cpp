@@ -0,0 +1,124 @@
+/*
+	TUIO C++ Example - part of the reacTIVision project
+	http://reactivision.sourceforge.net/
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "TuioProfile.h"
+#include "TuioLog.h"
+#include "tinyxml.h"
+
+#include <string.h>
+
+// the elements of a sensor whose attributes are settings of the same name
+static const char *SETTING_ELEMENTS[] = { "input", "transform", "display", "output", "threads" };
+
+static const char *SETTINGS[] = { "port", "stats_port", "control_port", "rcvbuf", "receive_backend", "stream_port", "shared_memory", "multicast_group", "multicast_source",
+	"invert_x", "invert_y", "swap_xy", "xrange_min", "xrange_max", "yrange_min", "yrange_max", "x_offset", "y_offset", "device",
+	"receive_thread", "relay_thread", "lock_memory", "frame_mirror" };
+
+static bool isSetting(const char *name) {
+	for (size_t i=0; i<sizeof(SETTINGS)/sizeof(SETTINGS[0]); i++) {
+		if (strcmp(name, SETTINGS[i])==0) return true;
+	}
+	return false;
+}
+
+// the attributes of a destination as "host port", false if one is missing
+static bool readDestination(const TiXmlElement *element, std::string &destination) {
+	const char *host = element->Attribute("host");
+	const char *port = element->Attribute("port");
+	if ((host==NULL) || (port==NULL)) return false;
+	destination = std::string(host)+" "+port;
+	return true;
+}
+
+// the attributes of a calibration point as "sensor_x sensor_y screen_x screen_y", false if one is missing
+static bool readPoint(const TiXmlElement *element, std::string &point) {
+	static const char *COORDINATES[] = { "sensor_x", "sensor_y", "screen_x", "screen_y" };
+	point.clear();
+	for (int i=0; i<4; i++) {
+		const char *value = element->Attribute(COORDINATES[i]);
+		if (value==NULL) return false;
+		if (i>0) point += " ";
+		point += value;
+	}
+	return true;
+}
+
+static void readSettings(const TiXmlElement *element, TuioConfig &config) {
+	for (const TiXmlAttribute *attribute=element->FirstAttribute(); attribute!=NULL; attribute=attribute->Next()) {
+		if (isSetting(attribute->Name())) config.add(attribute->Name(), attribute->Value());
+		else TUIO_LOG_WARNING("unknown setting %s of %s in line %d", attribute->Name(), element->Value(), element->Row());
+	}
+
+	for (const TiXmlElement *child=element->FirstChildElement(); child!=NULL; child=child->NextSiblingElement()) {
+		std::string value;
+		if (strcmp(child->Value(), "point")==0) {
+			if (readPoint(child, value)) config.add("calibration_point", value);
+			else TUIO_LOG_ERROR("incomplete calibration point in line %d", child->Row());
+		} else if ((strcmp(child->Value(), "relay")==0) || (strcmp(child->Value(), "calibrated_relay")==0)) {
+			if (readDestination(child, value)) config.add(child->Value(), value);
+			else TUIO_LOG_ERROR("incomplete %s in line %d", child->Value(), child->Row());
+		} else {
+			TUIO_LOG_WARNING("unknown element %s in line %d", child->Value(), child->Row());
+		}
+	}
+}
+
+bool TuioProfile::load(const char *path, int sensor, TuioConfig &config) {
+	TiXmlDocument document;
+	if (!document.LoadFile(path)) {
+		// a missing profile is not an error, the other settings files are used then
+		if (document.ErrorId()!=TiXmlBase::TIXML_ERROR_OPENING_FILE)
+			TUIO_LOG_ERROR("%s: %s in line %d", path, document.ErrorDesc(), document.ErrorRow());
+		return false;
+	}
+
+	const TiXmlElement *root = document.RootElement();
+	if ((root==NULL) || (strcmp(root->Value(), "profile")!=0)) {
+		TUIO_LOG_ERROR("%s is not a sensor profile", path);
+		return false;
+	}
+
+	for (const TiXmlElement *element=root->FirstChildElement("sensor"); element!=NULL; element=element->NextSiblingElement("sensor")) {
+		int id = 0;
+		if ((element->QueryIntAttribute("id", &id)!=TIXML_SUCCESS) || (id!=sensor)) continue;
+
+		for (const TiXmlElement *child=element->FirstChildElement(); child!=NULL; child=child->NextSiblingElement()) {
+			bool settings = false;
+			for (size_t i=0; i<sizeof(SETTING_ELEMENTS)/sizeof(SETTING_ELEMENTS[0]); i++) {
+				if (strcmp(child->Value(), SETTING_ELEMENTS[i])==0) settings = true;
+			}
+			if (settings) readSettings(child, config);
+			else if ((strcmp(child->Value(), "filter")==0) || (strcmp(child->Value(), "prediction")==0))
+				config.add(child->Value(), child->GetText()!=NULL ? child->GetText() : "none");
+			else TUIO_LOG_WARNING("unknown element %s in line %d", child->Value(), child->Row());
+		}
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,555 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "ip/StreamDecoder.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "ip/ReceiveBufferPool.h"
+
+
+namespace{
+
+const int INITIAL_CAPACITY = 4096;
+// room for a packet of the maximum size and the start of the next one
+const int MAX_CAPACITY = 2 * RECEIVE_BUFFER_SIZE;
+const int MAX_HANDSHAKE_SIZE = 8192;
+
+const unsigned char SLIP_END = 0xC0;
+const unsigned char SLIP_ESC = 0xDB;
+const unsigned char SLIP_ESC_END = 0xDC;
+const unsigned char SLIP_ESC_ESC = 0xDD;
+
+const char *WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+
+// SHA-1 is only needed for the Sec-WebSocket-Accept header
+class Sha1{
+    unsigned long h_[5];
+    unsigned char block_[64];
+    int blockSize_;
+    unsigned long long length_;
+
+    static unsigned long Rotate( unsigned long x, int n )
+    {
+        return ((x << n) | (x >> (32 - n))) & 0xFFFFFFFFUL;
+    }
+
+    void ProcessBlock()
+    {
+        unsigned long w[80];
+        for( int i = 0; i < 16; ++i )
+            w[i] = ((unsigned long)block_[i*4] << 24) | ((unsigned long)block_[i*4+1] << 16)
+                    | ((unsigned long)block_[i*4+2] << 8) | (unsigned long)block_[i*4+3];
+        for( int i = 16; i < 80; ++i )
+            w[i] = Rotate( w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1 );
+
+        unsigned long a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4];
+        for( int i = 0; i < 80; ++i ){
+            unsigned long f, k;
+            if( i < 20 ){
+                f = (b & c) | (~b & d);
+                k = 0x5A827999UL;
+            }else if( i < 40 ){
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1UL;
+            }else if( i < 60 ){
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDCUL;
+            }else{
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6UL;
+            }
+            unsigned long t = (Rotate( a, 5 ) + (f & 0xFFFFFFFFUL) + e + k + w[i]) & 0xFFFFFFFFUL;
+            e = d;
+            d = c;
+            c = Rotate( b, 30 );
+            b = a;
+            a = t;
+        }
+
+        h_[0] = (h_[0] + a) & 0xFFFFFFFFUL;
+        h_[1] = (h_[1] + b) & 0xFFFFFFFFUL;
+        h_[2] = (h_[2] + c) & 0xFFFFFFFFUL;
+        h_[3] = (h_[3] + d) & 0xFFFFFFFFUL;
+        h_[4] = (h_[4] + e) & 0xFFFFFFFFUL;
+        blockSize_ = 0;
+    }
+
+public:
+    Sha1()
+        : blockSize_( 0 )
+        , length_( 0 )
+    {
+        h_[0] = 0x67452301UL;
+        h_[1] = 0xEFCDAB89UL;
+        h_[2] = 0x98BADCFEUL;
+        h_[3] = 0x10325476UL;
+        h_[4] = 0xC3D2E1F0UL;
+    }
+
+    void Update( const char *data, int size )
+    {
+        for( int i = 0; i < size; ++i ){
+            block_[ blockSize_++ ] = (unsigned char)data[i];
+            if( blockSize_ == 64 )
+                ProcessBlock();
+        }
+        length_ += size;
+    }
+
+    void Final( unsigned char digest[20] )
+    {
+        unsigned long long bits = length_ * 8;
+        block_[ blockSize_++ ] = 0x80;
+        if( blockSize_ > 56 ){
+            while( blockSize_ < 64 )
+                block_[ blockSize_++ ] = 0;
+            ProcessBlock();
+        }
+        while( blockSize_ < 56 )
+            block_[ blockSize_++ ] = 0;
+        for( int i = 7; i >= 0; --i )
+            block_[ blockSize_++ ] = (unsigned char)(bits >> (i * 8));
+        ProcessBlock();
+
+        for( int i = 0; i < 20; ++i )
+            digest[i] = (unsigned char)(h_[i/4] >> (24 - (i % 4) * 8));
+    }
+};
+
+
+std::string Base64( const unsigned char *data, int size )
+{
+    static const char *digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string result;
+    for( int i = 0; i < size; i += 3 ){
+        unsigned long group = (unsigned long)data[i] << 16;
+        if( i + 1 < size ) group |= (unsigned long)data[i+1] << 8;
+        if( i + 2 < size ) group |= data[i+2];
+        result += digits[ (group >> 18) & 63 ];
+        result += digits[ (group >> 12) & 63 ];
+        result += (i + 1 < size) ? digits[ (group >> 6) & 63 ] : '=';
+        result += (i + 2 < size) ? digits[ group & 63 ] : '=';
+    }
+    return result;
+}
+
+
+// the trimmed value of an HTTP header field, empty if it is missing
+std::string HeaderField( const std::string& request, const char *name )
+{
+    size_t nameLength = strlen( name );
+    size_t line = request.find( "\r\n" );
+    while( line != std::string::npos && line + 2 < request.size() ){
+        size_t start = line + 2;
+        line = request.find( "\r\n", start );
+        size_t end = (line == std::string::npos) ? request.size() : line;
+
+        if( end - start > nameLength && request[ start + nameLength ] == ':' ){
+            bool match = true;
+            for( size_t i = 0; i < nameLength && match; ++i )
+                match = tolower( (unsigned char)request[ start + i ] ) == tolower( (unsigned char)name[i] );
+            if( match ){
+                size_t valueStart = start + nameLength + 1;
+                while( valueStart < end && (request[ valueStart ] == ' ' || request[ valueStart ] == '\t') )
+                    ++valueStart;
+                size_t valueEnd = end;
+                while( valueEnd > valueStart && (request[ valueEnd - 1 ] == ' ' || request[ valueEnd - 1 ] == '\t') )
+                    --valueEnd;
+                return request.substr( valueStart, valueEnd - valueStart );
+            }
+        }
+    }
+    return std::string();
+}
+
+} // anonymous namespace
+
+
+StreamDecoder::StreamDecoder( Framing framing )
+    : framing_( framing )
+    , finished_( false )
+    , buffer_( 0 )
+    , capacity_( 0 )
+    , begin_( 0 )
+    , decoded_( 0 )
+    , scan_( 0 )
+    , end_( 0 )
+    , slipEscape_( false )
+    , handshakeDone_( false )
+    , fragmented_( false )
+{
+}
+
+StreamDecoder::~StreamDecoder()
+{
+    free( buffer_ );
+}
+
+void StreamDecoder::Fail()
+{
+    finished_ = true;
+}
+
+char *StreamDecoder::ReceiveBuffer( int& space )
+{
+    space = 0;
+    if( finished_ )
+        return 0;
+
+    if( begin_ > 0 || (end_ == capacity_ && scan_ > decoded_) ){
+        // move the unfinished packet to the front, closing the gap that
+        // escapes and frame headers left between decoded and new bytes
+        memmove( buffer_, buffer_ + begin_, decoded_ );
+        memmove( buffer_ + decoded_, buffer_ + scan_, end_ - scan_ );
+        end_ = decoded_ + (end_ - scan_);
+        scan_ = decoded_;
+        begin_ = 0;
+    }
+
+    if( end_ == capacity_ ){
+        if( capacity_ >= MAX_CAPACITY ){
+            Fail();
+            return 0;
+        }
+
+        // connections start small, most only ever carry small packets
+        int capacity = (capacity_ == 0) ? INITIAL_CAPACITY : capacity_ * 2;
+        if( capacity > MAX_CAPACITY )
+            capacity = MAX_CAPACITY;
+        char *buffer = (char*)realloc( buffer_, capacity );
+        if( buffer == 0 ){
+            Fail();
+            return 0;
+        }
+        buffer_ = buffer;
+        capacity_ = capacity;
+    }
+
+    space = capacity_ - end_;
+    return buffer_ + end_;
+}
+
+void StreamDecoder::Received( int count )
+{
+    end_ += count;
+}
+
+bool StreamDecoder::NextPacket( char*& data, int& size )
+{
+    if( finished_ )
+        return false;
+
+    if( framing_ == AUTO_FRAMING ){
+        if( scan_ == end_ )
+            return false;
+
+        unsigned char first = (unsigned char)buffer_[ scan_ ];
+        if( first == 'G' )
+            framing_ = WEBSOCKET_FRAMING;
+        else if( first == 0 )
+            framing_ = LENGTH_PREFIX_FRAMING;
+        else if( first == SLIP_END || first == '/' || first == '#' )
+            framing_ = SLIP_FRAMING;
+        else{
+            Fail();
+            return false;
+        }
+    }
+
+    switch( framing_ ){
+        case SLIP_FRAMING:
+            return NextSlipPacket( data, size );
+        case LENGTH_PREFIX_FRAMING:
+            return NextLengthPrefixPacket( data, size );
+        case WEBSOCKET_FRAMING:
+            return NextWebSocketPacket( data, size );
+        case LINE_FRAMING:
+            return NextLinePacket( data, size );
+        default:
+            return false;
+    }
+}
+
+bool StreamDecoder::NextSlipPacket( char*& data, int& size )
+{
+    while( scan_ < end_ ){
+        if( !slipEscape_ ){
+            // take the bytes up to the next END or ESC at once, they only
+            // move if an escape sequence before them left a gap
+            const unsigned char *run = (const unsigned char*)buffer_ + scan_;
+            int length = 0;
+            int available = end_ - scan_;
+            while( length < available && run[length] != SLIP_END && run[length] != SLIP_ESC )
+                ++length;
+            if( length > 0 ){
+                if( decoded_ + length > RECEIVE_BUFFER_SIZE ){
+                    Fail();
+                    return false;
+                }
+                if( begin_ + decoded_ != scan_ )
+                    memmove( buffer_ + begin_ + decoded_, run, length );
+                decoded_ += length;
+                scan_ += length;
+                continue;
+            }
+        }
+
+        unsigned char c = (unsigned char)buffer_[ scan_++ ];
+
+        if( slipEscape_ ){
+            slipEscape_ = false;
+            if( c == SLIP_ESC_END )
+                c = SLIP_END;
+            else if( c == SLIP_ESC_ESC )
+                c = SLIP_ESC;
+        }else if( c == SLIP_END ){
+            if( decoded_ > 0 ){
+                data = buffer_ + begin_;
+                size = decoded_;
+                begin_ = scan_;
+                decoded_ = 0;
+                return true;
+            }
+            // the END that some senders put before every packet
+            begin_ = scan_;
+            continue;
+        }else if( c == SLIP_ESC ){
+            slipEscape_ = true;
+            continue;
+        }
+
+        // unescaping never writes ahead of the scan position
+        buffer_[ begin_ + decoded_++ ] = (char)c;
+        if( decoded_ > RECEIVE_BUFFER_SIZE ){
+            Fail();
+            return false;
+        }
+    }
+    return false;
+}
+
+bool StreamDecoder::NextLengthPrefixPacket( char*& data, int& size )
+{
+    for(;;){
+        if( end_ - scan_ < 4 )
+            return false;
+
+        const unsigned char *prefix = (const unsigned char*)buffer_ + scan_;
+        unsigned long length = ((unsigned long)prefix[0] << 24) | ((unsigned long)prefix[1] << 16)
+                | ((unsigned long)prefix[2] << 8) | (unsigned long)prefix[3];
+        if( length > RECEIVE_BUFFER_SIZE ){
+            Fail();
+            return false;
+        }
+        if( end_ - scan_ - 4 < (int)length )
+            return false;
+
+        data = buffer_ + scan_ + 4;
+        size = (int)length;
+        scan_ += 4 + (int)length;
+        begin_ = scan_;
+        if( size > 0 )
+            return true;
+    }
+}
+
+bool StreamDecoder::NextLinePacket( char*& data, int& size )
+{
+    for(;;){
+        const char *line = buffer_ + scan_;
+        const char *newline = (const char*)memchr( line, '\n', end_ - scan_ );
+        if( newline == 0 ){
+            if( end_ - scan_ > RECEIVE_BUFFER_SIZE )
+                Fail();
+            return false;
+        }
+
+        data = buffer_ + scan_;
+        size = (int)(newline - line);
+        if( size > 0 && data[ size - 1 ] == '\r' )
+            --size;
+        scan_ += (int)(newline - line) + 1;
+        begin_ = scan_;
+        // empty lines are skipped like empty length prefixed packets
+        if( size > 0 )
+            return true;
+    }
+}
+
+bool StreamDecoder::WebSocketHandshake()
+{
+    std::string pending( buffer_ + scan_, end_ - scan_ );
+    size_t headerEnd = pending.find( "\r\n\r\n" );
+    if( headerEnd == std::string::npos ){
+        if( end_ - scan_ > MAX_HANDSHAKE_SIZE )
+            Fail();
+        return false;
+    }
+
+    std::string request = pending.substr( 0, headerEnd + 2 );
+    std::string key = HeaderField( request, "Sec-WebSocket-Key" );
+    if( request.compare( 0, 4, "GET " ) != 0 || key.empty() ){
+        reply_ = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+        Fail();
+        return false;
+    }
+
+    Sha1 sha1;
+    sha1.Update( key.data(), (int)key.size() );
+    sha1.Update( WEBSOCKET_GUID, (int)strlen( WEBSOCKET_GUID ) );
+    unsigned char digest[20];
+    sha1.Final( digest );
+
+    reply_ = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ";
+    reply_ += Base64( digest, 20 );
+    reply_ += "\r\n";
+
+    // browsers drop the connection unless one of their subprotocols is confirmed
+    std::string protocols = HeaderField( request, "Sec-WebSocket-Protocol" );
+    if( !protocols.empty() ){
+        reply_ += "Sec-WebSocket-Protocol: ";
+        reply_ += protocols.substr( 0, protocols.find( ',' ) );
+        reply_ += "\r\n";
+    }
+    reply_ += "\r\n";
+
+    scan_ += (int)headerEnd + 4;
+    begin_ = scan_;
+    handshakeDone_ = true;
+    return true;
+}
+
+bool StreamDecoder::NextWebSocketPacket( char*& data, int& size )
+{
+    if( !handshakeDone_ && !WebSocketHandshake() )
+        return false;
+
+    for(;;){
+        int available = end_ - scan_;
+        if( available < 2 )
+            return false;
+
+        const unsigned char *header = (const unsigned char*)buffer_ + scan_;
+        bool final = (header[0] & 0x80) != 0;
+        int opcode = header[0] & 0x0F;
+        bool masked = (header[1] & 0x80) != 0;
+        unsigned long long length = header[1] & 0x7F;
+        int headerSize = 2;
+
+        // clients mask every frame, and OSC packets are only carried in binary
+        // messages, text and reserved data frames are protocol errors
+        if( !masked || (opcode != 0x0 && opcode != 0x2 && opcode < 0x8) ){
+            Fail();
+            return false;
+        }
+
+        if( length == 126 ){
+            if( available < 4 )
+                return false;
+            length = ((unsigned long long)header[2] << 8) | header[3];
+            headerSize = 4;
+        }else if( length == 127 ){
+            if( available < 10 )
+                return false;
+            length = 0;
+            for( int i = 2; i < 10; ++i )
+                length = (length << 8) | header[i];
+            headerSize = 10;
+        }
+        headerSize += 4; // the mask
+
+        // control frames are never fragmented and carry at most 125 bytes
+        if( length > (unsigned long long)(RECEIVE_BUFFER_SIZE - decoded_)
+                || (opcode >= 0x8 && (!final || length > 125)) ){
+            Fail();
+            return false;
+        }
+        if( available < headerSize + (int)length )
+            return false;
+
+        char *payload = buffer_ + scan_ + headerSize;
+        const unsigned char *mask = header + headerSize - 4;
+        for( int i = 0; i < (int)length; ++i )
+            payload[i] ^= mask[ i & 3 ];
+        scan_ += headerSize + (int)length;
+
+        if( opcode >= 0x8 ){
+            // control frames, they may arrive between the fragments of a message
+            if( opcode == 0x8 ){
+                // echo the status code and close
+                int echo = (length < 2) ? (int)length : 2;
+                reply_ += (char)0x88;
+                reply_ += (char)echo;
+                reply_.append( payload, echo );
+                finished_ = true;
+                return false;
+            }
+            if( opcode == 0x9 ){
+                reply_ += (char)0x8A;
+                reply_ += (char)length;
+                reply_.append( payload, (size_t)length );
+            }
+            if( !fragmented_ )
+                begin_ = scan_;
+            continue;
+        }
+
+        if( (opcode == 0) != fragmented_ ){
+            // a continuation without a message, or a new message before the last one ended
+            Fail();
+            return false;
+        }
+
+        if( !fragmented_ && final ){
+            // the usual case, the payload is the packet
+            begin_ = scan_;
+            if( length == 0 )
+                continue;
+            data = payload;
+            size = (int)length;
+            return true;
+        }
+
+        // move the fragments of a message together
+        memmove( buffer_ + begin_ + decoded_, payload, (size_t)length );
+        decoded_ += (int)length;
+        fragmented_ = !final;
+        if( final ){
+            data = buffer_ + begin_;
+            size = decoded_;
+            decoded_ = 0;
+            begin_ = scan_;
+            if( size > 0 )
+                return true;
+        }
+    }
+}
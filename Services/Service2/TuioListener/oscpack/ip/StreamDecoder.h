@@ -0,0 +1,109 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef INCLUDED_STREAMDECODER_H
+#define INCLUDED_STREAMDECODER_H
+
+#include <string>
+
+
+// StreamDecoder splits a byte stream from a TCP connection into OSC
+// packets. packets are reassembled in the receive buffer itself: the
+// caller receives straight into ReceiveBuffer(), and NextPacket() returns
+// pointers into that buffer, so complete packets are never copied. only
+// the unfinished tail of the stream moves to the front of the buffer
+// before the next receive. supported framings are:
+//
+//  SLIP (OSC 1.1): packets end with 0xC0, 0xC0 and 0xDB inside a packet
+//      are escaped as 0xDB 0xDC and 0xDB 0xDD, unescaped in place
+//  LENGTH_PREFIX (OSC 1.0): a 32 bit big endian size precedes each packet
+//  WEBSOCKET (RFC 6455): an HTTP upgrade, then one packet per binary
+//      message. the masked payloads are unmasked in place, fragmented
+//      messages are joined by moving the fragments together. unmasked
+//      and text frames close the connection
+//  LINE: text commands, each ends with '\n', a '\r' before it is dropped.
+//      never chosen by AUTO, for control connections that are typed
+//  AUTO: chosen by the first byte, 'G' for a WebSocket upgrade request,
+//      0 for a length prefix, 0xC0 or an OSC packet start for SLIP
+
+class StreamDecoder{
+public:
+    enum Framing { AUTO_FRAMING, SLIP_FRAMING, LENGTH_PREFIX_FRAMING, WEBSOCKET_FRAMING, LINE_FRAMING };
+
+    StreamDecoder( Framing framing );
+    ~StreamDecoder();
+
+    Framing ActiveFraming() const { return framing_; }
+
+    // where to receive the next bytes, at most space bytes. returns 0 if a
+    // packet exceeds the maximum size. invalidates the packets returned so far
+    char *ReceiveBuffer( int& space );
+
+    // count bytes were received into ReceiveBuffer()
+    void Received( int count );
+
+    // returns the next complete packet, false if more bytes are needed.
+    // data stays valid until the next call to ReceiveBuffer()
+    bool NextPacket( char*& data, int& size );
+
+    // bytes the peer expects in response: the WebSocket handshake, pongs
+    // and the closing handshake. call after NextPacket() returned false
+    const std::string& Reply() const { return reply_; }
+    void ReplySent() { reply_.clear(); }
+
+    // the connection has to be closed, after sending the reply. set on
+    // protocol errors, oversized packets and WebSocket close frames
+    bool Finished() const { return finished_; }
+
+private:
+    bool NextSlipPacket( char*& data, int& size );
+    bool NextLengthPrefixPacket( char*& data, int& size );
+    bool NextWebSocketPacket( char*& data, int& size );
+    bool NextLinePacket( char*& data, int& size );
+    bool WebSocketHandshake();
+    void Fail();
+
+    Framing framing_;
+    bool finished_;
+
+    // [begin_, begin_+decoded_) holds the part of the current packet that
+    // is already decoded, [scan_, end_) the bytes not yet looked at
+    char *buffer_;
+    int capacity_;
+    int begin_;
+    int decoded_;
+    int scan_;
+    int end_;
+
+    bool slipEscape_;
+    bool handshakeDone_;
+    bool fragmented_;
+    std::string reply_;
+};
+
+
+#endif /* INCLUDED_STREAMDECODER_H */
@@ -0,0 +1,399 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include "ip/posix/IoUring.h"
+
+#ifdef OSC_HAVE_IO_URING
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+namespace{
+
+int SetupRing( unsigned entries, struct io_uring_params *params )
+{
+    return (int)syscall( __NR_io_uring_setup, entries, params );
+}
+
+int EnterRing( int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, void *arg, size_t argSize )
+{
+    return (int)syscall( __NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize );
+}
+
+int RegisterRing( int fd, unsigned opcode, void *arg, unsigned count )
+{
+    return (int)syscall( __NR_io_uring_register, fd, opcode, arg, count );
+}
+
+// the head and tail indices are shared with the kernel
+inline unsigned LoadAcquire( const unsigned *p )
+{
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+}
+
+inline void StoreRelease( unsigned *p, unsigned value )
+{
+    __atomic_store_n( p, value, __ATOMIC_RELEASE );
+}
+
+size_t RoundToPages( size_t size )
+{
+    size_t page = (size_t)sysconf( _SC_PAGESIZE );
+    return (size + page - 1) & ~(page - 1);
+}
+
+} // anonymous namespace
+
+
+IoUring::IoUring()
+    : ringFd_( -1 )
+    , ringMemory_( MAP_FAILED )
+    , ringSize_( 0 )
+    , sqes_( (struct io_uring_sqe*)MAP_FAILED )
+    , sqesSize_( 0 )
+    , sqeTail_( 0 )
+    , bufferRing_( (struct io_uring_buf*)MAP_FAILED )
+    , bufferRingSize_( 0 )
+    , bufferCount_( 0 )
+    , bufferTail_( 0 )
+    , buffers_( (char*)MAP_FAILED )
+    , available_( 0 )
+    , lent_( 0 )
+    , wakeRequested_( 0 )
+    , wakeFd_( -1 )
+{
+    pthread_mutex_init( &recycleMutex_, 0 );
+
+    memset( &receiveHeader_, 0, sizeof(receiveHeader_) );
+    receiveHeader_.msg_namelen = NAME_SIZE;
+    receiveHeader_.msg_controllen = CONTROL_SIZE;
+}
+
+IoUring::~IoUring()
+{
+    Close();
+
+    // like ReceiveBufferPool, buffers still retained by a listener are
+    // leaked rather than unmapped under it
+    if( buffers_ != MAP_FAILED && lent_ == 0 )
+        munmap( buffers_, (size_t)bufferCount_ * BUFFER_SIZE );
+
+    pthread_mutex_destroy( &recycleMutex_ );
+}
+
+bool IoUring::Initialize( unsigned entries, unsigned bufferCount, int wakeFd )
+{
+    wakeFd_ = wakeFd;
+
+    struct io_uring_params params;
+    memset( &params, 0, sizeof(params) );
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    ringFd_ = SetupRing( entries, &params );
+    if( ringFd_ < 0 ){
+        // COOP_TASKRUN needs 5.19, without it completions just arrive a little earlier
+        memset( &params, 0, sizeof(params) );
+        ringFd_ = SetupRing( entries, &params );
+    }
+    if( ringFd_ < 0 )
+        return false;
+
+    if( !(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG) ){
+        Close();
+        return false;
+    }
+
+    // the submission and completion rings share one mapping
+    ringSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if( cqSize > ringSize_ )
+        ringSize_ = cqSize;
+    ringMemory_ = mmap( 0, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING );
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = (struct io_uring_sqe*)mmap( 0, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES );
+    if( ringMemory_ == MAP_FAILED || sqes_ == (struct io_uring_sqe*)MAP_FAILED ){
+        Close();
+        return false;
+    }
+
+    char *ring = (char*)ringMemory_;
+    sqHead_ = (unsigned*)(ring + params.sq_off.head);
+    sqTail_ = (unsigned*)(ring + params.sq_off.tail);
+    sqArray_ = (unsigned*)(ring + params.sq_off.array);
+    sqMask_ = *(unsigned*)(ring + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    sqeTail_ = *sqTail_;
+    cqHead_ = (unsigned*)(ring + params.cq_off.head);
+    cqTail_ = (unsigned*)(ring + params.cq_off.tail);
+    cqMask_ = *(unsigned*)(ring + params.cq_off.ring_mask);
+    cqes_ = (struct io_uring_cqe*)(ring + params.cq_off.cqes);
+
+    // register the buffer ring, supported since 5.19
+    bufferCount_ = bufferCount;
+    bufferRingSize_ = RoundToPages( bufferCount * sizeof(struct io_uring_buf) );
+    bufferRing_ = (struct io_uring_buf*)mmap( 0, bufferRingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    buffers_ = (char*)mmap( 0, (size_t)bufferCount * BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( bufferRing_ == (struct io_uring_buf*)MAP_FAILED || buffers_ == (char*)MAP_FAILED ){
+        Close();
+        return false;
+    }
+
+    struct io_uring_buf_reg registration;
+    memset( &registration, 0, sizeof(registration) );
+    registration.ring_addr = (unsigned long long)bufferRing_;
+    registration.ring_entries = bufferCount;
+    registration.bgid = BUFFER_GROUP;
+    if( RegisterRing( ringFd_, IORING_REGISTER_PBUF_RING, &registration, 1 ) < 0 ){
+        Close();
+        return false;
+    }
+
+    for( unsigned i = 0; i < bufferCount; ++i )
+        AddBuffer( i );
+    __atomic_store_n( &bufferRing_[0].resv, bufferTail_, __ATOMIC_RELEASE );
+    available_ = bufferCount;
+
+    return true;
+}
+
+void IoUring::Close()
+{
+    pthread_mutex_lock( &recycleMutex_ );
+    if( ringFd_ >= 0 && bufferRing_ != (struct io_uring_buf*)MAP_FAILED ){
+        // take the buffers away from the kernel before the ring is torn down
+        struct io_uring_buf_reg registration;
+        memset( &registration, 0, sizeof(registration) );
+        registration.bgid = BUFFER_GROUP;
+        RegisterRing( ringFd_, IORING_UNREGISTER_PBUF_RING, &registration, 1 );
+    }
+    if( ringFd_ >= 0 ){
+        close( ringFd_ );
+        ringFd_ = -1;
+    }
+    pthread_mutex_unlock( &recycleMutex_ );
+
+    if( ringMemory_ != MAP_FAILED ){
+        munmap( ringMemory_, ringSize_ );
+        ringMemory_ = MAP_FAILED;
+    }
+    if( sqes_ != (struct io_uring_sqe*)MAP_FAILED ){
+        munmap( sqes_, sqesSize_ );
+        sqes_ = (struct io_uring_sqe*)MAP_FAILED;
+    }
+    if( bufferRing_ != (struct io_uring_buf*)MAP_FAILED ){
+        munmap( bufferRing_, bufferRingSize_ );
+        bufferRing_ = (struct io_uring_buf*)MAP_FAILED;
+    }
+}
+
+struct io_uring_sqe *IoUring::GetSqe()
+{
+    if( sqeTail_ - LoadAcquire( sqHead_ ) >= sqEntries_ ){
+        // the submission ring is full, hand the queued entries to the kernel
+        EnterRing( ringFd_, Flush(), 0, 0, 0, 0 );
+        if( sqeTail_ - LoadAcquire( sqHead_ ) >= sqEntries_ )
+            return 0;
+    }
+
+    struct io_uring_sqe *sqe = &sqes_[ sqeTail_ & sqMask_ ];
+    ++sqeTail_;
+    memset( sqe, 0, sizeof(*sqe) );
+    return sqe;
+}
+
+unsigned IoUring::Flush()
+{
+    unsigned tail = *sqTail_;
+    unsigned count = sqeTail_ - tail;
+    for( ; tail != sqeTail_; ++tail )
+        sqArray_[ tail & sqMask_ ] = tail & sqMask_;
+    StoreRelease( sqTail_, sqeTail_ );
+    return count;
+}
+
+bool IoUring::PrepareReceive( int fd, unsigned long long userData )
+{
+    struct io_uring_sqe *sqe = GetSqe();
+    if( sqe == 0 )
+        return false;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)&receiveHeader_;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_TRUNC; // report the full length of truncated datagrams
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool IoUring::PreparePoll( int fd, unsigned long long userData )
+{
+    struct io_uring_sqe *sqe = GetSqe();
+    if( sqe == 0 )
+        return false;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = userData;
+    return true;
+}
+
+int IoUring::SubmitAndWait( double timeoutMs )
+{
+    unsigned toSubmit = Flush();
+
+    if( PeekCompletion() != 0 ){
+        // don't wait, there is work already
+        if( toSubmit > 0 && EnterRing( ringFd_, toSubmit, 0, 0, 0, 0 ) < 0 )
+            return -errno;
+        return 0;
+    }
+
+    struct __kernel_timespec timeout;
+    struct io_uring_getevents_arg arg;
+    memset( &arg, 0, sizeof(arg) );
+
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    void *argPtr = 0;
+    size_t argSize = 0;
+    if( timeoutMs >= 0 ){
+        timeout.tv_sec = (long long)(timeoutMs * .001);
+        timeout.tv_nsec = (long long)((timeoutMs - timeout.tv_sec * 1000.) * 1000000.);
+        arg.ts = (unsigned long long)&timeout;
+        flags |= IORING_ENTER_EXT_ARG;
+        argPtr = &arg;
+        argSize = sizeof(arg);
+    }
+
+    if( EnterRing( ringFd_, toSubmit, 1, flags, argPtr, argSize ) < 0 )
+        return -errno;
+    return 0;
+}
+
+struct io_uring_cqe *IoUring::PeekCompletion()
+{
+    unsigned head = *cqHead_;
+    if( head == LoadAcquire( cqTail_ ) )
+        return 0;
+    return &cqes_[ head & cqMask_ ];
+}
+
+void IoUring::AdvanceCompletion()
+{
+    StoreRelease( cqHead_, *cqHead_ + 1 );
+}
+
+char *IoUring::ReceivedMessage( unsigned bufferId, int length, struct msghdr& msg, int& size )
+{
+    __sync_sub_and_fetch( &available_, 1 );
+
+    if( bufferId >= bufferCount_ || length < (int)PAYLOAD_OFFSET )
+        return 0;
+
+    char *buffer = buffers_ + (size_t)bufferId * BUFFER_SIZE;
+    struct io_uring_recvmsg_out *out = (struct io_uring_recvmsg_out*)buffer;
+
+    memset( &msg, 0, sizeof(msg) );
+    msg.msg_name = buffer + sizeof(struct io_uring_recvmsg_out);
+    msg.msg_namelen = (out->namelen < NAME_SIZE) ? out->namelen : NAME_SIZE;
+    msg.msg_control = buffer + sizeof(struct io_uring_recvmsg_out) + NAME_SIZE;
+    msg.msg_controllen = (out->controllen < CONTROL_SIZE) ? out->controllen : CONTROL_SIZE;
+    msg.msg_flags = out->flags;
+
+    // with MSG_TRUNC payloadlen is the length of the datagram, not what fitted
+    size = (int)out->payloadlen;
+    return buffer + PAYLOAD_OFFSET;
+}
+
+bool IoUring::Lend( char *payload )
+{
+    const struct io_uring_recvmsg_out *out = (const struct io_uring_recvmsg_out*)(payload - PAYLOAD_OFFSET);
+    if( out->controllen > CONTROL_SIZE - RECEIVE_BUFFER_HEADER_SIZE )
+        return false;
+
+    __sync_add_and_fetch( &lent_, 1 );
+    ReceiveBufferPool::Lend( payload, this );
+    return true;
+}
+
+void IoUring::RecycleReceiveBuffer( char *data )
+{
+    Recycle( (unsigned)((data - PAYLOAD_OFFSET - buffers_) / BUFFER_SIZE) );
+
+    // last, the multiplexer deletes retired rings once nothing is lent
+    __sync_sub_and_fetch( &lent_, 1 );
+}
+
+void IoUring::AddBuffer( unsigned bufferId )
+{
+    struct io_uring_buf *buffer = &bufferRing_[ bufferTail_ & (bufferCount_ - 1) ];
+    buffer->addr = (unsigned long long)(buffers_ + (size_t)bufferId * BUFFER_SIZE);
+    buffer->len = BUFFER_SIZE;
+    buffer->bid = (unsigned short)bufferId;
+    ++bufferTail_;
+}
+
+void IoUring::Recycle( unsigned bufferId )
+{
+    // retained buffers may be released from other threads
+    pthread_mutex_lock( &recycleMutex_ );
+    bool open = (ringFd_ >= 0);
+    if( open ){
+        AddBuffer( bufferId );
+        __atomic_store_n( &bufferRing_[0].resv, bufferTail_, __ATOMIC_RELEASE );
+    }
+    pthread_mutex_unlock( &recycleMutex_ );
+
+    if( open ){
+        __sync_add_and_fetch( &available_, 1 );
+        if( __sync_lock_test_and_set( &wakeRequested_, 0 ) ){
+            ssize_t ret;
+            ret = write( wakeFd_, "!", 1 );
+            (void)ret;
+        }
+    }
+}
+
+bool IoUring::WaitForBuffers()
+{
+    __sync_lock_test_and_set( &wakeRequested_, 1 );
+    __sync_synchronize();
+    if( available_ > 0 ){
+        __sync_lock_test_and_set( &wakeRequested_, 0 );
+        return true;
+    }
+    return false;
+}
+
+#endif /* OSC_HAVE_IO_URING */
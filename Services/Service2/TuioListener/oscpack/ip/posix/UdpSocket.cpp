@@ -47,9 +47,15 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <netinet/in.h> // for sockaddr_in
+#include <netinet/tcp.h> // for TCP_NODELAY
+#include <fcntl.h>
 
+#include "ip/NetworkingUtils.h"
 #include "ip/PacketListener.h"
+#include "ip/ReceiveBufferPool.h"
+#include "ip/TcpListeningSocket.h"
 #include "ip/TimerListener.h"
+#include "ip/posix/IoUring.h"
 
 
 #if defined(__APPLE__) && !defined(_SOCKLEN_T)
@@ -58,43 +64,165 @@ typedef ssize_t socklen_t;
 #endif
 
 
-static void SockaddrFromIpEndpointName( struct sockaddr_in& sockAddr, const IpEndpointName& endpoint )
+// fills in the address of an endpoint for a socket of the given family and
+// returns its length. IPv6 sockets reach IPv4 endpoints by IPv4 mapped
+// addresses, the IPv4 any address becomes the IPv6 any address
+static socklen_t SockaddrFromIpEndpointName( struct sockaddr_storage& sockAddr, const IpEndpointName& endpoint, int family )
 {
     memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
-    sockAddr.sin_family = AF_INET;
 
-	sockAddr.sin_addr.s_addr = 
+	unsigned short port =
+		(endpoint.port == IpEndpointName::ANY_PORT)
+		? 0
+		: htons( endpoint.port );
+
+	if( family == AF_INET6 ){
+		struct sockaddr_in6& sockAddr6 = (struct sockaddr_in6&)sockAddr;
+		sockAddr6.sin6_family = AF_INET6;
+		sockAddr6.sin6_port = port;
+		if( endpoint.isIpv6 ){
+			memcpy( &sockAddr6.sin6_addr, endpoint.address6, 16 );
+		}else if( endpoint.address != IpEndpointName::ANY_ADDRESS ){
+			unsigned long address = htonl( endpoint.address );
+			sockAddr6.sin6_addr.s6_addr[10] = 0xFF;
+			sockAddr6.sin6_addr.s6_addr[11] = 0xFF;
+			memcpy( &sockAddr6.sin6_addr.s6_addr[12], &address, 4 );
+		}
+		return sizeof(struct sockaddr_in6);
+	}
+
+	struct sockaddr_in& sockAddr4 = (struct sockaddr_in&)sockAddr;
+    sockAddr4.sin_family = AF_INET;
+
+	sockAddr4.sin_addr.s_addr = 
 		(endpoint.address == IpEndpointName::ANY_ADDRESS)
 		? INADDR_ANY
 		: htonl( endpoint.address );
 
-	sockAddr.sin_port =
-		(endpoint.port == IpEndpointName::ANY_PORT)
-		? 0
-		: htons( endpoint.port );
+	sockAddr4.sin_port = port;
+	return sizeof(struct sockaddr_in);
 }
 
 
-static IpEndpointName IpEndpointNameFromSockaddr( const struct sockaddr_in& sockAddr )
+static IpEndpointName IpEndpointNameFromSockaddr( const struct sockaddr_storage& sockAddr )
 {
+	if( sockAddr.ss_family == AF_INET6 ){
+		const struct sockaddr_in6& sockAddr6 = (const struct sockaddr_in6&)sockAddr;
+		return IpEndpointName(
+			sockAddr6.sin6_addr.s6_addr,
+			(sockAddr6.sin6_port == 0)
+				? IpEndpointName::ANY_PORT
+				: ntohs( sockAddr6.sin6_port )
+			);
+	}
+
+	const struct sockaddr_in& sockAddr4 = (const struct sockaddr_in&)sockAddr;
 	return IpEndpointName( 
-		(sockAddr.sin_addr.s_addr == INADDR_ANY) 
+		(sockAddr4.sin_addr.s_addr == INADDR_ANY) 
 			? IpEndpointName::ANY_ADDRESS 
-			: ntohl( sockAddr.sin_addr.s_addr ),
-		(sockAddr.sin_port == 0)
+			: ntohl( sockAddr4.sin_addr.s_addr ),
+		(sockAddr4.sin_port == 0)
 			? IpEndpointName::ANY_PORT
-			: ntohs( sockAddr.sin_port )
+			: ntohs( sockAddr4.sin_port )
 		);
 }
 
 
+static int CreateSocket( int family, int type )
+{
+	int s = socket( family, type, 0 );
+	if( s != -1 && family == AF_INET6 ){
+		// one socket for both families, IPv4 peers appear with mapped addresses
+		int off=0;
+		setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&off, sizeof(off));
+	}
+	return s;
+}
+
+
 class UdpSocket::Implementation{
 	bool isBound_;
 	bool isConnected_;
 
 	int socket_;
-	struct sockaddr_in connectedAddr_;
-	struct sockaddr_in sendToAddr_;
+	int family_;
+	struct sockaddr_storage connectedAddr_;
+	socklen_t connectedAddrLength_;
+
+	// options that have to be set again when the socket is replaced
+	bool reusePort_;
+	int receiveBufferSize_;
+
+	long long lastReceiveTime_;
+	UdpSocketStatistics statistics_;
+
+	// sockets start out as IPv4 sockets. before they are bound or connected
+	// they are replaced with an IPv6 socket for an IPv6 endpoint, and for
+	// binding the any address, so that both families are received. returns
+	// false if the system has no IPv6
+	bool UseIpv6()
+	{
+		if( family_ == AF_INET6 )
+			return true;
+		if( isBound_ || isConnected_ )
+			return false;
+
+		int s = CreateSocket( AF_INET6, SOCK_DGRAM );
+		if( s == -1 )
+			return false;
+		close( socket_ );
+		socket_ = s;
+		family_ = AF_INET6;
+
+		int on=1;
+		setsockopt(socket_, SOL_SOCKET, SO_BROADCAST, (char*)&on, sizeof(on));
+		if( reusePort_ )
+			SetReusePort( true );
+		if( receiveBufferSize_ > 0 )
+			SetReceiveBufferSize( receiveBufferSize_ );
+		return true;
+	}
+
+	// MCAST_JOIN_GROUP and friends (RFC 3678) take the interface by index and
+	// the addresses as sockaddr_storage, for IPv4 and IPv6 groups alike
+	bool ChangeMembership( int option, int sourceOption, const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+	{
+		if( !group.IsMulticastAddress() || (group.isIpv6 && family_ != AF_INET6) )
+			return false;
+
+		// IPv4 groups are joined on the IPv4 level of a dual stack socket too
+		int level = group.isIpv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+		int family = group.isIpv6 ? AF_INET6 : AF_INET;
+
+		// Linux delivers the groups that any socket on the host joined to
+		// every socket bound to the port, unless told to deliver only the
+		// groups and sources of this socket
+		int off=0;
+#ifdef IP_MULTICAST_ALL
+		setsockopt(socket_, IPPROTO_IP, IP_MULTICAST_ALL, (char*)&off, sizeof(off));
+#endif
+#ifdef IPV6_MULTICAST_ALL
+		if( family_ == AF_INET6 )
+			setsockopt(socket_, IPPROTO_IPV6, IPV6_MULTICAST_ALL, (char*)&off, sizeof(off));
+#endif
+
+		if( source.address == IpEndpointName::ANY_ADDRESS && !source.isIpv6 ){
+			struct group_req request;
+			memset( &request, 0, sizeof(request) );
+			request.gr_interface = interfaceIndex;
+			SockaddrFromIpEndpointName( request.gr_group, group, family );
+			return setsockopt(socket_, level, option, (char*)&request, sizeof(request)) == 0;
+		}
+
+		if( source.isIpv6 != group.isIpv6 )
+			return false;
+		struct group_source_req request;
+		memset( &request, 0, sizeof(request) );
+		request.gsr_interface = interfaceIndex;
+		SockaddrFromIpEndpointName( request.gsr_group, group, family );
+		SockaddrFromIpEndpointName( request.gsr_source, source, family );
+		return setsockopt(socket_, level, sourceOption, (char*)&request, sizeof(request)) == 0;
+	}
 
 public:
 
@@ -102,15 +230,20 @@ public:
 		: isBound_( false )
 		, isConnected_( false )
 		, socket_( -1 )
+		, family_( AF_INET )
+		, connectedAddrLength_( 0 )
+		, reusePort_( false )
+		, receiveBufferSize_( 0 )
+		, lastReceiveTime_( 0 )
 	{
-		if( (socket_ = socket( AF_INET, SOCK_DGRAM, 0 )) == -1 ){
+		memset( &statistics_, 0, sizeof(statistics_) );
+
+		if( (socket_ = CreateSocket( AF_INET, SOCK_DGRAM )) == -1 ){
             throw std::runtime_error("unable to create udp socket\n");
         }
 
 		int on=1;
 		setsockopt(socket_, SOL_SOCKET, SO_BROADCAST, (char*)&on, sizeof(on));
-		memset( &sendToAddr_, 0, sizeof(sendToAddr_) );
-        sendToAddr_.sin_family = AF_INET;
 	}
 
 	~Implementation()
@@ -124,16 +257,16 @@ public:
 
 		// first connect the socket to the remote server
         
-        struct sockaddr_in connectSockAddr;
-		SockaddrFromIpEndpointName( connectSockAddr, remoteEndpoint );
+        struct sockaddr_storage connectSockAddr;
+		socklen_t connectLength = SockaddrFromIpEndpointName( connectSockAddr, remoteEndpoint, family_ );
        
-        if (connect(socket_, (struct sockaddr *)&connectSockAddr, sizeof(connectSockAddr)) < 0) {
+        if (connect(socket_, (struct sockaddr *)&connectSockAddr, connectLength) < 0) {
             throw std::runtime_error("unable to connect udp socket\n");
         }
 
         // get the address
 
-        struct sockaddr_in sockAddr;
+        struct sockaddr_storage sockAddr;
         memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
         socklen_t length = sizeof(sockAddr);
         if (getsockname(socket_, (struct sockaddr *)&sockAddr, &length) < 0) {
@@ -143,18 +276,18 @@ public:
 		if( isConnected_ ){
 			// reconnect to the connected address
 			
-			if (connect(socket_, (struct sockaddr *)&connectedAddr_, sizeof(connectedAddr_)) < 0) {
+			if (connect(socket_, (struct sockaddr *)&connectedAddr_, connectedAddrLength_) < 0) {
 				throw std::runtime_error("unable to connect udp socket\n");
 			}
 
 		}else{
 			// unconnect from the remote address
 		
-			struct sockaddr_in unconnectSockAddr;
+			struct sockaddr_storage unconnectSockAddr;
 			memset( (char *)&unconnectSockAddr, 0, sizeof(unconnectSockAddr ) );
-			unconnectSockAddr.sin_family = AF_UNSPEC;
+			unconnectSockAddr.ss_family = AF_UNSPEC;
 			// address fields are zero
-			int connectResult = connect(socket_, (struct sockaddr *)&unconnectSockAddr, sizeof(unconnectSockAddr));
+			int connectResult = connect(socket_, (struct sockaddr *)&unconnectSockAddr, connectLength);
 			if ( connectResult < 0 && errno != EAFNOSUPPORT ) {
 				throw std::runtime_error("unable to un-connect udp socket\n");
 			}
@@ -165,9 +298,11 @@ public:
 
 	void Connect( const IpEndpointName& remoteEndpoint )
 	{
-		SockaddrFromIpEndpointName( connectedAddr_, remoteEndpoint );
+		if( remoteEndpoint.isIpv6 )
+			UseIpv6();
+		connectedAddrLength_ = SockaddrFromIpEndpointName( connectedAddr_, remoteEndpoint, family_ );
        
-        if (connect(socket_, (struct sockaddr *)&connectedAddr_, sizeof(connectedAddr_)) < 0) {
+        if (connect(socket_, (struct sockaddr *)&connectedAddr_, connectedAddrLength_) < 0) {
             throw std::runtime_error("unable to connect udp socket\n");
         }
 
@@ -181,46 +316,204 @@ public:
         send( socket_, data, size, 0 );
 	}
 
+	int SendMultiple( const char * const *data, const int *sizes, int count )
+	{
+		assert( isConnected_ );
+
+		enum { BATCH = 64 };
+		int sent = 0;
+		while( sent < count ){
+			int batch = (count - sent < BATCH) ? count - sent : BATCH;
+#ifdef __linux__
+			struct iovec iov[BATCH];
+			struct mmsghdr msgs[BATCH];
+			memset( msgs, 0, sizeof(struct mmsghdr) * batch );
+			for( int i=0; i < batch; ++i ){
+				iov[i].iov_base = (void*)data[sent + i];
+				iov[i].iov_len = sizes[sent + i];
+				msgs[i].msg_hdr.msg_iov = &iov[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+			}
+			int result = sendmmsg( socket_, msgs, batch, MSG_DONTWAIT );
+#else
+			int result = 0;
+			while( result < batch && send( socket_, data[sent + result], sizes[sent + result], MSG_DONTWAIT ) >= 0 )
+				++result;
+			if( result == 0 )
+				result = -1;
+#endif
+			if( result > 0 ){
+				sent += result;
+			}else if( errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ){
+				break;
+			}else if( errno != EINTR ){
+				++sent; // refused, go on with the next one
+			}
+		}
+		return sent;
+	}
+
     void SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
 	{
-		sendToAddr_.sin_addr.s_addr = htonl( remoteEndpoint.address );
-        sendToAddr_.sin_port = htons( remoteEndpoint.port );
+		if( remoteEndpoint.isIpv6 )
+			UseIpv6();
 
-        sendto( socket_, data, size, 0, (sockaddr*)&sendToAddr_, sizeof(sendToAddr_) );
+		struct sockaddr_storage sendToAddr;
+		socklen_t length = SockaddrFromIpEndpointName( sendToAddr, remoteEndpoint, family_ );
+
+        sendto( socket_, data, size, 0, (sockaddr*)&sendToAddr, length );
 	}
 
 	void Bind( const IpEndpointName& localEndpoint )
 	{
-		struct sockaddr_in bindSockAddr;
-		SockaddrFromIpEndpointName( bindSockAddr, localEndpoint );
+		if( localEndpoint.isIpv6 || localEndpoint.address == IpEndpointName::ANY_ADDRESS )
+			UseIpv6();
+
+		struct sockaddr_storage bindSockAddr;
+		socklen_t length = SockaddrFromIpEndpointName( bindSockAddr, localEndpoint, family_ );
 
-        if (bind(socket_, (struct sockaddr *)&bindSockAddr, sizeof(bindSockAddr)) < 0) {
+        if (bind(socket_, (struct sockaddr *)&bindSockAddr, length) < 0) {
             throw std::runtime_error("unable to bind udp socket\n");
         }
 
+		int on = 1;
+#ifdef SO_TIMESTAMPNS
+		// have the kernel stamp every datagram on arrival
+		setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPNS, (char*)&on, sizeof(on));
+#endif
+#ifdef SO_RXQ_OVFL
+		// and report how many datagrams it dropped for lack of buffer space
+		setsockopt(socket_, SOL_SOCKET, SO_RXQ_OVFL, (char*)&on, sizeof(on));
+#endif
+
 		isBound_ = true;
 	}
 
 	bool IsBound() const { return isBound_; }
 
+	bool SetReusePort( bool enable )
+	{
+		reusePort_ = enable;
+#ifdef SO_REUSEPORT
+		int on = enable ? 1 : 0;
+		return setsockopt(socket_, SOL_SOCKET, SO_REUSEPORT, (char*)&on, sizeof(on)) == 0;
+#else
+		return false;
+#endif
+	}
+
+	void SetReceiveBufferSize( int size )
+	{
+		receiveBufferSize_ = size;
+		setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, (char*)&size, sizeof(size));
+	}
+
+	int ReceiveBufferSize() const
+	{
+		int size = 0;
+		socklen_t length = sizeof(size);
+		if( getsockopt(socket_, SOL_SOCKET, SO_RCVBUF, (char*)&size, &length) < 0 )
+			return 0;
+		return size;
+	}
+
+	bool JoinGroup( const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+	{
+#ifdef MCAST_JOIN_GROUP
+		return ChangeMembership( MCAST_JOIN_GROUP, MCAST_JOIN_SOURCE_GROUP, group, source, interfaceIndex );
+#else
+		return false;
+#endif
+	}
+
+	bool LeaveGroup( const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+	{
+#ifdef MCAST_LEAVE_GROUP
+		return ChangeMembership( MCAST_LEAVE_GROUP, MCAST_LEAVE_SOURCE_GROUP, group, source, interfaceIndex );
+#else
+		return false;
+#endif
+	}
+
     int ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size )
 	{
 		assert( isBound_ );
 
-		struct sockaddr_in fromAddr;
-        socklen_t fromAddrLen = sizeof(fromAddr);
-             	 
-        int result = recvfrom(socket_, data, size, 0,
-                    (struct sockaddr *) &fromAddr, (socklen_t*)&fromAddrLen);
+		struct sockaddr_storage fromAddr;
+		struct iovec iov;
+		iov.iov_base = data;
+		iov.iov_len = size;
+
+		// room for the SO_TIMESTAMPNS and SO_RXQ_OVFL control messages
+		char control[128];
+
+		struct msghdr msg;
+		memset( &msg, 0, sizeof(msg) );
+		msg.msg_name = &fromAddr;
+		msg.msg_namelen = sizeof(fromAddr);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+        int result = recvmsg(socket_, &msg, 0);
 		if( result < 0 )
 			return 0;
 
-		remoteEndpoint.address = ntohl(fromAddr.sin_addr.s_addr);
-		remoteEndpoint.port = ntohs(fromAddr.sin_port);
+		return ReceivedMessage( msg, result, remoteEndpoint );
+	}
+
+	// takes the arrival time and drop count from the control messages of a
+	// datagram received with recvmsg(), here or by the io_uring backend, and
+	// counts it. returns its size, or 0 if it was truncated
+	int ReceivedMessage( struct msghdr& msg, int result, IpEndpointName& remoteEndpoint )
+	{
+		lastReceiveTime_ = 0;
+		for( struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != 0; cmsg = CMSG_NXTHDR(&msg, cmsg) ){
+			if( cmsg->cmsg_level != SOL_SOCKET )
+				continue;
+#ifdef SO_TIMESTAMPNS
+			if( cmsg->cmsg_type == SCM_TIMESTAMPNS ){
+				struct timespec t;
+				memcpy( &t, CMSG_DATA(cmsg), sizeof(t) );
+				lastReceiveTime_ = (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+			}
+#endif
+#ifdef SO_RXQ_OVFL
+			if( cmsg->cmsg_type == SO_RXQ_OVFL ){
+				// the total number of drops on this socket so far
+				unsigned int drops;
+				memcpy( &drops, CMSG_DATA(cmsg), sizeof(drops) );
+				statistics_.kernelDrops = drops;
+			}
+#endif
+		}
+		if( lastReceiveTime_ == 0 )
+			lastReceiveTime_ = GetCurrentTimeNanoseconds();
+
+		statistics_.datagrams++;
+		statistics_.bytes += result;
+		if( msg.msg_flags & MSG_TRUNC ){
+			// the rest of the datagram is lost, don't pass on a malformed packet
+			statistics_.truncated++;
+			return 0;
+		}
+
+		if( ((const struct sockaddr*)msg.msg_name)->sa_family == AF_INET6 ){
+			const struct sockaddr_in6& fromAddr = *(const struct sockaddr_in6*)msg.msg_name;
+			remoteEndpoint = IpEndpointName( fromAddr.sin6_addr.s6_addr, ntohs(fromAddr.sin6_port) );
+		}else{
+			const struct sockaddr_in& fromAddr = *(const struct sockaddr_in*)msg.msg_name;
+			remoteEndpoint = IpEndpointName( ntohl(fromAddr.sin_addr.s_addr), ntohs(fromAddr.sin_port) );
+		}
 
 		return result;
 	}
 
+	long long LastReceiveTime() const { return lastReceiveTime_; }
+
+	UdpSocketStatistics Statistics() const { return statistics_; }
+
 	int Socket() { return socket_; }
 };
 
@@ -254,6 +547,11 @@ void UdpSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data,
 	impl_->SendTo( remoteEndpoint, data, size );
 }
 
+int UdpSocket::SendMultiple( const char * const *data, const int *sizes, int count )
+{
+	return impl_->SendMultiple( data, sizes, count );
+}
+
 void UdpSocket::Bind( const IpEndpointName& localEndpoint )
 {
 	impl_->Bind( localEndpoint );
@@ -264,11 +562,273 @@ bool UdpSocket::IsBound() const
 	return impl_->IsBound();
 }
 
+bool UdpSocket::SetReusePort( bool enable )
+{
+	return impl_->SetReusePort( enable );
+}
+
+void UdpSocket::SetReceiveBufferSize( int size )
+{
+	impl_->SetReceiveBufferSize( size );
+}
+
+int UdpSocket::ReceiveBufferSize() const
+{
+	return impl_->ReceiveBufferSize();
+}
+
+bool UdpSocket::JoinGroup( const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+{
+	return impl_->JoinGroup( group, source, interfaceIndex );
+}
+
+bool UdpSocket::LeaveGroup( const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+{
+	return impl_->LeaveGroup( group, source, interfaceIndex );
+}
+
 int UdpSocket::ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size )
 {
 	return impl_->ReceiveFrom( remoteEndpoint, data, size );
 }
 
+long long UdpSocket::LastReceiveTime() const
+{
+	return impl_->LastReceiveTime();
+}
+
+UdpSocketStatistics UdpSocket::Statistics() const
+{
+	return impl_->Statistics();
+}
+
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+struct StreamConnection{
+	StreamConnection( int s, const IpEndpointName& endpoint, StreamDecoder::Framing framing )
+		: socket( s )
+		, remoteEndpoint( endpoint )
+		, decoder( framing ) {}
+	int socket;
+	IpEndpointName remoteEndpoint;
+	StreamDecoder decoder;
+	// what the listener sent with SendTo() while it processed the packets
+	std::string reply;
+};
+
+class TcpListeningSocket::Implementation{
+	int socket_;
+	StreamDecoder::Framing framing_;
+	int maxConnections_;
+	std::vector< StreamConnection* > connections_;
+
+	static void SetNonBlocking( int socket )
+	{
+		fcntl( socket, F_SETFL, fcntl( socket, F_GETFL, 0 ) | O_NONBLOCK );
+	}
+
+	// replies are a few kilobytes at most, they fit the empty send buffer
+	// of a connection. a peer that doesn't read them is dropped
+	static bool SendReply( int socket, const std::string& reply )
+	{
+		size_t sent = 0;
+		while( sent < reply.size() ){
+			ssize_t result = send( socket, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL );
+			if( result < 0 && errno == EINTR )
+				continue;
+			if( result <= 0 )
+				return false;
+			sent += result;
+		}
+		return true;
+	}
+
+	// reads what arrived on a connection and passes the packets it
+	// completed to the listener. returns false once the connection is done
+	static bool Receive( StreamConnection& connection, PacketListener *listener )
+	{
+		int space;
+		char *buffer = connection.decoder.ReceiveBuffer( space );
+		if( buffer == 0 )
+			return false;
+
+		ssize_t result = recv( connection.socket, buffer, space, 0 );
+		if( result < 0 )
+			return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+		if( result == 0 )
+			return false;
+		connection.decoder.Received( (int)result );
+
+		char *data;
+		int size;
+		while( connection.decoder.NextPacket( data, size ) )
+			listener->ProcessPacket( data, size, connection.remoteEndpoint );
+
+		if( !connection.decoder.Reply().empty() ){
+			if( !SendReply( connection.socket, connection.decoder.Reply() ) )
+				return false;
+			connection.decoder.ReplySent();
+		}
+		if( !connection.reply.empty() ){
+			if( !SendReply( connection.socket, connection.reply ) )
+				return false;
+			connection.reply.clear();
+		}
+		return !connection.decoder.Finished();
+	}
+
+public:
+	Implementation( const IpEndpointName& localEndpoint, StreamDecoder::Framing framing, int maxConnections )
+		: framing_( framing )
+		, maxConnections_( maxConnections )
+	{
+		// like UdpSocket, IPv6 for IPv6 endpoints and the any address
+		int family = AF_INET;
+		socket_ = -1;
+		if( localEndpoint.isIpv6 || localEndpoint.address == IpEndpointName::ANY_ADDRESS ){
+			family = AF_INET6;
+			socket_ = CreateSocket( AF_INET6, SOCK_STREAM );
+		}
+		if( socket_ == -1 && !localEndpoint.isIpv6 ){
+			family = AF_INET;
+			socket_ = CreateSocket( AF_INET, SOCK_STREAM );
+		}
+		if( socket_ == -1 ){
+            throw std::runtime_error("unable to create tcp socket\n");
+        }
+
+		int on=1;
+		setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, (char*)&on, sizeof(on));
+
+		struct sockaddr_storage bindSockAddr;
+		socklen_t length = SockaddrFromIpEndpointName( bindSockAddr, localEndpoint, family );
+		if( bind(socket_, (struct sockaddr *)&bindSockAddr, length) < 0
+				|| listen(socket_, SOMAXCONN) < 0 ){
+			close(socket_);
+            throw std::runtime_error("unable to bind tcp socket\n");
+        }
+		SetNonBlocking( socket_ );
+	}
+
+	~Implementation()
+	{
+		for( std::vector< StreamConnection* >::iterator i = connections_.begin(); i != connections_.end(); ++i ){
+			close( (*i)->socket );
+			delete *i;
+		}
+		close(socket_);
+	}
+
+	IpEndpointName LocalEndpoint() const
+	{
+		struct sockaddr_storage sockAddr;
+		memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
+		socklen_t length = sizeof(sockAddr);
+		if (getsockname(socket_, (struct sockaddr *)&sockAddr, &length) < 0) {
+			throw std::runtime_error("unable to getsockname\n");
+		}
+		return IpEndpointNameFromSockaddr( sockAddr );
+	}
+
+	int ConnectionCount() const { return (int)connections_.size(); }
+
+	bool SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
+	{
+		for( std::vector< StreamConnection* >::iterator i = connections_.begin(); i != connections_.end(); ++i ){
+			if( (*i)->remoteEndpoint == remoteEndpoint ){
+				(*i)->reply.append( data, size );
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void AddDescriptors( fd_set& fds, int& fdmax ) const
+	{
+		FD_SET( socket_, &fds );
+		if( fdmax < socket_ )
+			fdmax = socket_;
+		for( std::vector< StreamConnection* >::const_iterator i = connections_.begin(); i != connections_.end(); ++i ){
+			FD_SET( (*i)->socket, &fds );
+			if( fdmax < (*i)->socket )
+				fdmax = (*i)->socket;
+		}
+	}
+
+	void Accept()
+	{
+		for(;;){
+			struct sockaddr_storage fromAddr;
+			socklen_t length = sizeof(fromAddr);
+			int connection = accept( socket_, (struct sockaddr *)&fromAddr, &length );
+			if( connection < 0 ){
+				if( errno == EINTR || errno == ECONNABORTED )
+					continue;
+				return; // EAGAIN, or out of descriptors until a connection closes
+			}
+
+			if( (int)connections_.size() >= maxConnections_ || connection >= FD_SETSIZE ){
+				close( connection );
+				continue;
+			}
+
+			int on=1;
+			setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+			setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, (char*)&on, sizeof(on));
+#endif
+			SetNonBlocking( connection );
+			connections_.push_back( new StreamConnection( connection, IpEndpointNameFromSockaddr( fromAddr ), framing_ ) );
+		}
+	}
+
+	// accepts new connections and reads every readable one once
+	void Process( const fd_set& fds, PacketListener *listener )
+	{
+		std::vector< StreamConnection* >::iterator i = connections_.begin();
+		while( i != connections_.end() ){
+			if( FD_ISSET( (*i)->socket, &fds ) && !Receive( **i, listener ) ){
+				close( (*i)->socket );
+				delete *i;
+				i = connections_.erase( i );
+			}else{
+				++i;
+			}
+		}
+
+		if( FD_ISSET( socket_, &fds ) )
+			Accept();
+	}
+};
+
+TcpListeningSocket::TcpListeningSocket( const IpEndpointName& localEndpoint, StreamDecoder::Framing framing, int maxConnections )
+{
+	impl_ = new Implementation( localEndpoint, framing, maxConnections );
+}
+
+TcpListeningSocket::~TcpListeningSocket()
+{
+	delete impl_;
+}
+
+IpEndpointName TcpListeningSocket::LocalEndpoint() const
+{
+	return impl_->LocalEndpoint();
+}
+
+int TcpListeningSocket::ConnectionCount() const
+{
+	return impl_->ConnectionCount();
+}
+
+bool TcpListeningSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
+{
+	return impl_->SendTo( remoteEndpoint, data, size );
+}
+
 
 struct AttachedTimerListener{
 	AttachedTimerListener( int id, int p, TimerListener *tl )
@@ -298,9 +858,31 @@ extern "C" /*static*/ void InterruptSignalHandler( int );
 }
 
 
+typedef std::vector< std::pair< double, AttachedTimerListener > > TimerQueue;
+
+
+#ifdef OSC_HAVE_IO_URING
+// 64 buffers of 64 KB take 4 MB per multiplexer and absorb bursts from
+// several sensors between two passes of the loop
+static const unsigned IO_URING_BUFFERS = 64;
+static const unsigned IO_URING_ENTRIES = 64;
+static const unsigned long long IO_URING_BREAK = 0; // user data of the break pipe poll, sockets are 1..n
+static const unsigned long long IO_URING_POLL = 1ULL << 32; // flags a socket poll while buffers run short
+#endif
+
+
 class SocketReceiveMultiplexer::Implementation{
 	std::vector< std::pair< PacketListener*, UdpSocket* > > socketListeners_;
+	std::vector< std::pair< PacketListener*, TcpListeningSocket* > > streamListeners_;
 	std::vector< AttachedTimerListener > timerListeners_;
+	ReceiveBufferPool bufferPool_;
+
+	Backend backend_;
+	Backend activeBackend_;
+#ifdef OSC_HAVE_IO_URING
+	// rings of earlier runs whose buffers are still retained by listeners
+	std::vector< IoUring* > retiredRings_;
+#endif
 
 	volatile bool break_;
 	int breakPipe_[2]; // [0] is the reader descriptor and [1] the writer
@@ -314,63 +896,55 @@ class SocketReceiveMultiplexer::Implementation{
 		return ((double)t.tv_sec*1000.) + ((double)t.tv_usec / 1000.);
 	}
 
-public:
-    Implementation()
+	char *AcquireBuffer()
 	{
-		if( pipe(breakPipe_) != 0 )
-			throw std::runtime_error( "creation of asynchronous break pipes failed\n" );
+		char *data = bufferPool_.Acquire();
+		if( data == 0 )
+			throw std::runtime_error( "unable to allocate receive buffer\n" );
+		return data;
 	}
 
-    ~Implementation()
+	void InitializeTimerQueue( TimerQueue& timerQueue )
 	{
-		close( breakPipe_[0] );
-		close( breakPipe_[1] );
-	}
+		double currentTimeMs = GetCurrentTimeMs();
 
-    void AttachSocketListener( UdpSocket *socket, PacketListener *listener )
-	{
-		assert( std::find( socketListeners_.begin(), socketListeners_.end(), std::make_pair(listener, socket) ) == socketListeners_.end() );
-		// we don't check that the same socket has been added multiple times, even though this is an error
-		socketListeners_.push_back( std::make_pair( listener, socket ) );
+		timerQueue.clear();
+		for( std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+				i != timerListeners_.end(); ++i )
+			timerQueue.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
+		std::sort( timerQueue.begin(), timerQueue.end(), CompareScheduledTimerCalls );
 	}
 
-    void DetachSocketListener( UdpSocket *socket, PacketListener *listener )
+	// milliseconds until the next timer expires, or -1 without timers
+	double TimerTimeoutMs( const TimerQueue& timerQueue ) const
 	{
-		std::vector< std::pair< PacketListener*, UdpSocket* > >::iterator i = 
-				std::find( socketListeners_.begin(), socketListeners_.end(), std::make_pair(listener, socket) );
-		assert( i != socketListeners_.end() );
-
-		socketListeners_.erase( i );
-	}
+		if( timerQueue.empty() )
+			return -1;
 
-    void AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
-	{
-		timerListeners_.push_back( AttachedTimerListener( periodMilliseconds, periodMilliseconds, listener ) );
+		double timeoutMs = timerQueue.front().first - GetCurrentTimeMs();
+		return (timeoutMs < 0) ? 0 : timeoutMs;
 	}
 
-	void AttachPeriodicTimerListener( int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener )
+	void ExecuteExpiredTimers( TimerQueue& timerQueue )
 	{
-		timerListeners_.push_back( AttachedTimerListener( initialDelayMilliseconds, periodMilliseconds, listener ) );
-	}
+		double currentTimeMs = GetCurrentTimeMs();
+		bool resort = false;
+		for( TimerQueue::iterator i = timerQueue.begin();
+				i != timerQueue.end() && i->first <= currentTimeMs; ++i ){
 
-    void DetachPeriodicTimerListener( TimerListener *listener )
-	{
-		std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
-		while( i != timerListeners_.end() ){
-			if( i->listener == listener )
+			i->second.listener->TimerExpired();
+			if( break_ )
 				break;
-			++i;
-		}
 
-		assert( i != timerListeners_.end() );
-
-		timerListeners_.erase( i );
+			i->first += i->second.periodMs;
+			resort = true;
+		}
+		if( resort )
+			std::sort( timerQueue.begin(), timerQueue.end(), CompareScheduledTimerCalls );
 	}
 
-    void Run()
+	void RunSelect( TimerQueue& timerQueue )
 	{
-		break_ = false;
-
 		// configure the master fd_set for select()
 
 		fd_set masterfds, tempfds;
@@ -391,19 +965,7 @@ public:
 			FD_SET( i->second->impl_->Socket(), &masterfds );
 		}
 
-
-		// configure the timer queue
-		double currentTimeMs = GetCurrentTimeMs();
-
-		// expiry time ms, listener
-		std::vector< std::pair< double, AttachedTimerListener > > timerQueue_;
-		for( std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
-				i != timerListeners_.end(); ++i )
-			timerQueue_.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
-		std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
-
-		const int MAX_BUFFER_SIZE = 4098;
-		char *data = new char[ MAX_BUFFER_SIZE ];
+		char *data = AcquireBuffer();
 		IpEndpointName remoteEndpoint;
 
 		struct timeval timeout;
@@ -411,19 +973,22 @@ public:
 		while( !break_ ){
 			tempfds = masterfds;
 
+			// stream connections come and go while running
+			int streamFdmax = fdmax;
+			for( std::vector< std::pair< PacketListener*, TcpListeningSocket* > >::iterator i = streamListeners_.begin();
+					i != streamListeners_.end(); ++i )
+				i->second->impl_->AddDescriptors( tempfds, streamFdmax );
+
 			struct timeval *timeoutPtr = 0;
-			if( !timerQueue_.empty() ){
-				double timeoutMs = timerQueue_.front().first - GetCurrentTimeMs();
-				if( timeoutMs < 0 )
-					timeoutMs = 0;
-			
+			double timeoutMs = TimerTimeoutMs( timerQueue );
+			if( timeoutMs >= 0 ){
 				// 1000000 microseconds in a second
 				timeout.tv_sec = (long)(timeoutMs * .001);
 				timeout.tv_usec = (long)((timeoutMs - (timeout.tv_sec * 1000)) * 1000);
 				timeoutPtr = &timeout;
 			}
 
-			if( select( fdmax + 1, &tempfds, 0, 0, timeoutPtr ) < 0 && errno != EINTR ){
+			if( select( streamFdmax + 1, &tempfds, 0, 0, timeoutPtr ) < 0 && errno != EINTR ){
    				if (!break_) throw std::runtime_error("select failed\n");
 				else break;
 			}
@@ -443,33 +1008,298 @@ public:
 
 				if( FD_ISSET( i->second->impl_->Socket(), &tempfds ) ){
 
-					int size = i->second->ReceiveFrom( remoteEndpoint, data, MAX_BUFFER_SIZE );
+					int size = i->second->ReceiveFrom( remoteEndpoint, data, RECEIVE_BUFFER_SIZE );
 					if( size > 0 ){
 						i->first->ProcessPacket( data, size, remoteEndpoint );
+
+						// the listener kept the buffer for a later stage, continue with a fresh one
+						if( ReceiveBufferPool::IsShared( data ) ){
+							ReleaseReceiveBuffer( data );
+							data = AcquireBuffer();
+						}
+
 						if( break_ )
 							break;
 					}
 				}
 			}
 
+			for( std::vector< std::pair< PacketListener*, TcpListeningSocket* > >::iterator i = streamListeners_.begin();
+					i != streamListeners_.end() && !break_; ++i )
+				i->second->impl_->Process( tempfds, i->first );
+
 			// execute any expired timers
-			currentTimeMs = GetCurrentTimeMs();
-			bool resort = false;
-			for( std::vector< std::pair< double, AttachedTimerListener > >::iterator i = timerQueue_.begin();
-					i != timerQueue_.end() && i->first <= currentTimeMs; ++i ){
+			ExecuteExpiredTimers( timerQueue );
+		}
+
+		ReleaseReceiveBuffer( data );
+	}
+
+#ifdef OSC_HAVE_IO_URING
+	void RetireRing( IoUring *ring )
+	{
+		ring->Close();
+		retiredRings_.push_back( ring );
+
+		std::vector< IoUring* >::iterator i = retiredRings_.begin();
+		while( i != retiredRings_.end() ){
+			if( (*i)->BuffersLent() == 0 ){
+				delete *i;
+				i = retiredRings_.erase( i );
+			}else{
+				++i;
+			}
+		}
+	}
+
+	// hands a datagram the kernel received into a provided buffer to the
+	// listener of socket index, then gives the buffer back to the kernel
+	// unless the listener retained it
+	void ProcessReceivedBuffer( IoUring *ring, unsigned index, unsigned bufferId, int length )
+	{
+		struct msghdr msg;
+		int size;
+		char *data = ring->ReceivedMessage( bufferId, length, msg, size );
+		if( data == 0 ){
+			ring->Recycle( bufferId );
+			return;
+		}
+
+		std::pair< PacketListener*, UdpSocket* >& socketListener = socketListeners_[ index ];
+		IpEndpointName remoteEndpoint;
+		size = socketListener.second->impl_->ReceivedMessage( msg, size, remoteEndpoint );
+		if( size <= 0 ){
+			ring->Recycle( bufferId );
+			return;
+		}
+
+		if( !ring->Lend( data ) ){
+			// unusually long control messages took the space of the reference count
+			char *copy = AcquireBuffer();
+			memcpy( copy, data, size );
+			ring->Recycle( bufferId );
+			data = copy;
+		}
+
+		socketListener.first->ProcessPacket( data, size, remoteEndpoint );
+		ReleaseReceiveBuffer( data );
+	}
+
+	void ReceiveIntoPool( unsigned index )
+	{
+		std::pair< PacketListener*, UdpSocket* >& socketListener = socketListeners_[ index ];
+		IpEndpointName remoteEndpoint;
+		char *data = AcquireBuffer();
+		int size = socketListener.second->ReceiveFrom( remoteEndpoint, data, RECEIVE_BUFFER_SIZE );
+		if( size > 0 )
+			socketListener.first->ProcessPacket( data, size, remoteEndpoint );
+		ReleaseReceiveBuffer( data );
+	}
+
+	// receives with multishot recvmsg into the provided buffers of an
+	// io_uring instance. returns false before receiving anything if the
+	// kernel does not support it or TCP connections have to be served,
+	// Run() then continues with select()
+	bool RunIoUring( TimerQueue& timerQueue )
+	{
+		// connections are only multiplexed by select()
+		if( !streamListeners_.empty() )
+			return false;
+
+		IoUring *ring = new IoUring();
+		if( !ring->Initialize( IO_URING_ENTRIES, IO_URING_BUFFERS, breakPipe_[1] ) ){
+			delete ring;
+			return false;
+		}
+
+		// requests that ended, without IORING_CQE_F_MORE, and have to be submitted again
+		std::vector< bool > rearm( socketListeners_.size(), true );
+		std::vector< bool > polling( socketListeners_.size(), false );
+		bool received = false;
+
+		ring->PreparePoll( breakPipe_[0], IO_URING_BREAK );
 
-				i->second.listener->TimerExpired();
+		while( !break_ ){
+			for( unsigned i = 0; i < rearm.size(); ++i ){
+				if( !rearm[i] || polling[i] )
+					continue;
+
+				int socket = socketListeners_[i].second->impl_->Socket();
+				if( ring->WaitForBuffers() ){
+					ring->PrepareReceive( socket, i + 1 );
+					rearm[i] = false;
+				}else{
+					// listeners retained all provided buffers, receive into
+					// pooled buffers like the select() backend until one returns
+					ring->PreparePoll( socket, IO_URING_POLL | (i + 1) );
+					polling[i] = true;
+				}
+			}
+
+			int error = ring->SubmitAndWait( TimerTimeoutMs( timerQueue ) );
+			if( error < 0 && error != -ETIME && error != -EINTR && error != -EBUSY ){
 				if( break_ )
 					break;
+				RetireRing( ring );
+				throw std::runtime_error( "io_uring_enter failed\n" );
+			}
 
-				i->first += i->second.periodMs;
-				resort = true;
+			struct io_uring_cqe *cqe;
+			while( !break_ && (cqe = ring->PeekCompletion()) != 0 ){
+				unsigned long long userData = cqe->user_data;
+				int result = cqe->res;
+				unsigned flags = cqe->flags;
+				ring->AdvanceCompletion();
+
+				if( userData == IO_URING_BREAK ){
+					// clear pending data from the asynchronous break pipe, it
+					// is also written to when a recycled buffer ends a shortage
+					char c;
+					ssize_t ret;
+					ret = read( breakPipe_[0], &c, 1 );
+					(void)ret;
+					ring->PreparePoll( breakPipe_[0], IO_URING_BREAK );
+					continue;
+				}
+
+				if( userData & IO_URING_POLL ){
+					unsigned index = (unsigned)((userData & ~IO_URING_POLL) - 1);
+					polling[ index ] = false;
+					if( result > 0 )
+						ReceiveIntoPool( index );
+					continue;
+				}
+
+				unsigned index = (unsigned)(userData - 1);
+				if( !(flags & IORING_CQE_F_MORE) )
+					rearm[ index ] = true;
+
+				if( flags & IORING_CQE_F_BUFFER ){
+					received = true;
+					ProcessReceivedBuffer( ring, index, flags >> IORING_CQE_BUFFER_SHIFT, result );
+				}else if( result == -EINVAL && !received ){
+					// multishot recvmsg needs Linux 6.0
+					RetireRing( ring );
+					return false;
+				}
+				// -ENOBUFS: all buffers are in use, rearm waits for one to be recycled
 			}
-			if( resort )
-				std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+
+			// execute any expired timers
+			ExecuteExpiredTimers( timerQueue );
 		}
 
-		delete [] data;
+		RetireRing( ring );
+		return true;
+	}
+#endif
+
+public:
+    Implementation()
+		: backend_( DEFAULT_BACKEND )
+		, activeBackend_( DEFAULT_BACKEND )
+		, break_( false )
+	{
+		if( pipe(breakPipe_) != 0 )
+			throw std::runtime_error( "creation of asynchronous break pipes failed\n" );
+	}
+
+    ~Implementation()
+	{
+#ifdef OSC_HAVE_IO_URING
+		for( std::vector< IoUring* >::iterator i = retiredRings_.begin(); i != retiredRings_.end(); ++i )
+			delete *i;
+#endif
+		close( breakPipe_[0] );
+		close( breakPipe_[1] );
+	}
+
+    void AttachSocketListener( UdpSocket *socket, PacketListener *listener )
+	{
+		assert( std::find( socketListeners_.begin(), socketListeners_.end(), std::make_pair(listener, socket) ) == socketListeners_.end() );
+		// we don't check that the same socket has been added multiple times, even though this is an error
+		socketListeners_.push_back( std::make_pair( listener, socket ) );
+	}
+
+    void DetachSocketListener( UdpSocket *socket, PacketListener *listener )
+	{
+		std::vector< std::pair< PacketListener*, UdpSocket* > >::iterator i = 
+				std::find( socketListeners_.begin(), socketListeners_.end(), std::make_pair(listener, socket) );
+		assert( i != socketListeners_.end() );
+
+		socketListeners_.erase( i );
+	}
+
+    void AttachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+	{
+		assert( std::find( streamListeners_.begin(), streamListeners_.end(), std::make_pair(listener, socket) ) == streamListeners_.end() );
+		streamListeners_.push_back( std::make_pair( listener, socket ) );
+	}
+
+    void DetachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+	{
+		std::vector< std::pair< PacketListener*, TcpListeningSocket* > >::iterator i =
+				std::find( streamListeners_.begin(), streamListeners_.end(), std::make_pair(listener, socket) );
+		assert( i != streamListeners_.end() );
+
+		streamListeners_.erase( i );
+	}
+
+    void AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
+	{
+		timerListeners_.push_back( AttachedTimerListener( periodMilliseconds, periodMilliseconds, listener ) );
+	}
+
+	void AttachPeriodicTimerListener( int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener )
+	{
+		timerListeners_.push_back( AttachedTimerListener( initialDelayMilliseconds, periodMilliseconds, listener ) );
+	}
+
+    void DetachPeriodicTimerListener( TimerListener *listener )
+	{
+		std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+		while( i != timerListeners_.end() ){
+			if( i->listener == listener )
+				break;
+			++i;
+		}
+
+		assert( i != timerListeners_.end() );
+
+		timerListeners_.erase( i );
+	}
+
+    void SetBackend( Backend backend )
+	{
+		backend_ = backend;
+	}
+
+	Backend ActiveBackend() const
+	{
+		return activeBackend_;
+	}
+
+    void Run()
+	{
+		// configure the timer queue, expiry time ms, listener
+		TimerQueue timerQueue;
+		InitializeTimerQueue( timerQueue );
+
+#ifdef OSC_HAVE_IO_URING
+		if( backend_ == IO_URING_BACKEND ){
+			activeBackend_ = IO_URING_BACKEND;
+			if( RunIoUring( timerQueue ) ){
+				break_ = false;
+				return;
+			}
+		}
+#endif
+		activeBackend_ = DEFAULT_BACKEND;
+		RunSelect( timerQueue );
+
+		// cleared on the way out rather than on the way in, so that a break
+		// from another thread just before Run() is not lost
+		break_ = false;
 	}
 
     void Break()
@@ -509,6 +1339,16 @@ void SocketReceiveMultiplexer::DetachSocketListener( UdpSocket *socket, PacketLi
 	impl_->DetachSocketListener( socket, listener );
 }
 
+void SocketReceiveMultiplexer::AttachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+{
+	impl_->AttachStreamListener( socket, listener );
+}
+
+void SocketReceiveMultiplexer::DetachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+{
+	impl_->DetachStreamListener( socket, listener );
+}
+
 void SocketReceiveMultiplexer::AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
 {
 	impl_->AttachPeriodicTimerListener( periodMilliseconds, listener );
@@ -524,6 +1364,16 @@ void SocketReceiveMultiplexer::DetachPeriodicTimerListener( TimerListener *liste
 	impl_->DetachPeriodicTimerListener( listener );
 }
 
+void SocketReceiveMultiplexer::SetBackend( Backend backend )
+{
+	impl_->SetBackend( backend );
+}
+
+SocketReceiveMultiplexer::Backend SocketReceiveMultiplexer::ActiveBackend() const
+{
+	return impl_->ActiveBackend();
+}
+
 void SocketReceiveMultiplexer::Run()
 {
 	impl_->Run();
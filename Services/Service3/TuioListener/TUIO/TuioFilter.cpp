@@ -0,0 +1,163 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioFilter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// positions closer in time are treated as one frame apart
+#define FILTER_MIN_INTERVAL 0.001f
+
+using namespace TUIO;
+
+TuioFilter::TuioFilter()
+: type            (NONE)
+, minCutoff       (ONE_EURO_MIN_CUTOFF)
+, beta            (ONE_EURO_BETA)
+, derivativeCutoff(ONE_EURO_DERIVATIVE_CUTOFF)
+, processNoise    (KALMAN_PROCESS_NOISE)
+, measurementNoise(KALMAN_MEASUREMENT_NOISE)
+{
+}
+
+void TuioFilter::setOneEuro(float mc, float b, float dc) {
+	type = ONE_EURO;
+	minCutoff = mc;
+	beta = b;
+	derivativeCutoff = dc;
+}
+
+void TuioFilter::setKalman(float q, float r) {
+	type = KALMAN;
+	processNoise = q;
+	measurementNoise = r;
+}
+
+bool TuioFilter::configure(const char *config) {
+	char name[32];
+	float a, b, c;
+	int count = sscanf(config, "%31s %f %f %f", name, &a, &b, &c);
+	if (count<1) {
+		disable();
+		return false;
+	}
+
+	if (strcmp(name, "oneeuro")==0) {
+		setOneEuro(count>1 ? a : ONE_EURO_MIN_CUTOFF, count>2 ? b : ONE_EURO_BETA, count>3 ? c : ONE_EURO_DERIVATIVE_CUTOFF);
+	} else if (strcmp(name, "kalman")==0) {
+		setKalman(count>1 ? a : KALMAN_PROCESS_NOISE, count>2 ? b : KALMAN_MEASUREMENT_NOISE);
+	} else {
+		disable();
+		return (strcmp(name, "none")==0);
+	}
+	return true;
+}
+
+void TuioFilter::reset(TuioFilterState &state, float x, float y, double time) const {
+	state.time = time;
+	state.x = x;
+	state.y = y;
+	state.dx = state.dy = 0;
+
+	state.kx[0] = x;
+	state.ky[0] = y;
+	state.kx[1] = state.ky[1] = 0;
+	// the position is known up to the measurement noise, the velocity not at all
+	state.px[0] = state.py[0] = measurementNoise;
+	state.px[1] = state.py[1] = 0;
+	state.px[2] = state.py[2] = 1.0f;
+}
+
+void TuioFilter::apply(TuioFilterState &state, float &x, float &y, double time) const {
+	if (type==NONE) return;
+
+	double interval = time-state.time;
+	if ((interval>FILTER_RESET_TIME) || (interval<0)) {
+		reset(state, x, y, time);
+		return;
+	}
+	float dt = (float)interval;
+	if (dt<FILTER_MIN_INTERVAL) dt = FILTER_MIN_INTERVAL;
+	state.time = time;
+
+	if (type==ONE_EURO) applyOneEuro(state, x, y, dt);
+	else applyKalman(state, x, y, dt);
+}
+
+void TuioFilter::getPosition(const TuioFilterState &state, float &x, float &y) const {
+	if (type==ONE_EURO) {
+		x = state.x;
+		y = state.y;
+	} else if (type==KALMAN) {
+		x = state.kx[0];
+		y = state.ky[0];
+	}
+}
+
+// the smoothing factor of a first order low pass filter
+static inline float smoothing(float cutoff, float dt) {
+	float tau = 1.0f/(2*(float)M_PI*cutoff);
+	return 1.0f/(1.0f+tau/dt);
+}
+
+void TuioFilter::applyOneEuro(TuioFilterState &state, float &x, float &y, float dt) const {
+	float a = smoothing(derivativeCutoff, dt);
+	state.dx += a*((x-state.x)/dt-state.dx);
+	state.dy += a*((y-state.y)/dt-state.dy);
+
+	// both axes share the cutoff, so that diagonal motion is not distorted
+	float speed = sqrtf(state.dx*state.dx+state.dy*state.dy);
+	a = smoothing(minCutoff+beta*speed, dt);
+	state.x += a*(x-state.x);
+	state.y += a*(y-state.y);
+	x = state.x;
+	y = state.y;
+}
+
+// one axis of the constant velocity model, s is position and velocity, p the covariance p00 p01 p11
+static inline float kalmanAxis(float *s, float *p, float z, float dt, float q, float r) {
+	// predict, with white noise acceleration of density q
+	s[0] += s[1]*dt;
+	float dt2 = dt*dt;
+	p[0] += dt*(2*p[1]+dt*p[2])+q*dt2*dt/3;
+	p[1] += dt*p[2]+q*dt2/2;
+	p[2] += q*dt;
+
+	// correct with the measured position
+	float k0 = p[0]/(p[0]+r);
+	float k1 = p[1]/(p[0]+r);
+	float innovation = z-s[0];
+	s[0] += k0*innovation;
+	s[1] += k1*innovation;
+	p[2] -= k1*p[1];
+	p[1] -= k0*p[1];
+	p[0] -= k0*p[0];
+	return s[0];
+}
+
+void TuioFilter::applyKalman(TuioFilterState &state, float &x, float &y, float dt) const {
+	x = kalmanAxis(state.kx, state.px, x, dt, processNoise, measurementNoise);
+	y = kalmanAxis(state.ky, state.py, y, dt, processNoise, measurementNoise);
+}
@@ -0,0 +1,263 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioLog.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WIN32
+#include <pthread.h>
+#include <sys/time.h>
+#else
+#include <windows.h>
+#endif
+
+using namespace TUIO;
+
+// the ring is a bounded multi-producer queue with one consumer, the writer thread.
+// every record carries a sequence number that tells producers and the consumer
+// whether it is free or holds a message. The sequence is stored relative to the
+// record index so that the zero-initialized ring is valid before any constructor runs.
+struct TuioLogRecord {
+	volatile long sequence;
+	int level;
+	long seconds;
+	long microSeconds;
+	long suppressed;
+	char text[TUIO_LOG_RECORD_SIZE];
+};
+
+static TuioLogRecord ring[TUIO_LOG_RECORDS];
+static volatile long enqueuePos = 0;
+static long dequeuePos = 0;
+
+static FILE *logFile = NULL;
+static bool ownsFile = false;
+static volatile long running = 0;
+
+#ifndef WIN32
+static pthread_t writerThread;
+static pthread_mutex_t wakeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeCondition = PTHREAD_COND_INITIALIZER;
+#else
+static HANDLE writerThread = NULL;
+static HANDLE wakeEvent = NULL;
+#endif
+
+volatile long TuioLog::dropped = 0;
+volatile long TuioLog::suppressed = 0;
+
+static const char* levelName(int level) {
+	switch (level) {
+		case TUIO_LOG_LEVEL_ERROR: return "ERROR";
+		case TUIO_LOG_LEVEL_WARNING: return "WARN ";
+		case TUIO_LOG_LEVEL_INFO: return "INFO ";
+		default: return "DEBUG";
+	}
+}
+
+static void currentTime(long &seconds, long &microSeconds) {
+#ifndef WIN32
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	seconds = (long)tv.tv_sec;
+	microSeconds = (long)tv.tv_usec;
+#else
+	FILETIME ft;
+	GetSystemTimeAsFileTime(&ft);
+	unsigned long long t = (((unsigned long long)ft.dwHighDateTime)<<32) | ft.dwLowDateTime;
+	t = t/10 - 11644473600000000ULL; // 100ns since 1601 to us since 1970
+	seconds = (long)(t/1000000);
+	microSeconds = (long)(t%1000000);
+#endif
+}
+
+// writes out all published records, returns the number of records written
+static int drain() {
+	int count = 0;
+	for (;;) {
+		long index = dequeuePos & (TUIO_LOG_RECORDS-1);
+		TuioLogRecord &record = ring[index];
+		if (atomicLoad(&record.sequence)+index != dequeuePos+1) break;
+
+		if (logFile!=NULL) {
+			time_t seconds = (time_t)record.seconds;
+			struct tm local;
+#ifndef WIN32
+			localtime_r(&seconds, &local);
+#else
+			localtime_s(&local, &seconds);
+#endif
+			char stamp[32];
+			strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+			if (record.suppressed>0)
+				fprintf(logFile, "%s.%06ld %s %s (%ld similar messages suppressed)\n", stamp, record.microSeconds, levelName(record.level), record.text, record.suppressed);
+			else
+				fprintf(logFile, "%s.%06ld %s %s\n", stamp, record.microSeconds, levelName(record.level), record.text);
+		}
+
+		atomicStore(&record.sequence, dequeuePos+TUIO_LOG_RECORDS-index);
+		dequeuePos++;
+		count++;
+	}
+
+	if ((count>0) && (logFile!=NULL)) fflush(logFile);
+	return count;
+}
+
+#ifndef WIN32
+static void* WriterThreadFunc( void* )
+#else
+static DWORD WINAPI WriterThreadFunc( LPVOID )
+#endif
+{
+	while (atomicLoad(&running)) {
+		if (drain()>0) continue;
+#ifndef WIN32
+		struct timespec timeout;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += 100*1000000;
+		if (timeout.tv_nsec>=1000000000) {
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
+		}
+		pthread_mutex_lock(&wakeMutex);
+		pthread_cond_timedwait(&wakeCondition, &wakeMutex, &timeout);
+		pthread_mutex_unlock(&wakeMutex);
+#else
+		WaitForSingleObject(wakeEvent, 100);
+#endif
+	}
+	drain();
+	return 0;
+}
+
+bool TuioLog::open(const char *path) {
+	if (atomicLoad(&running)) return true;
+
+	if (path==NULL) {
+		logFile = stderr;
+		ownsFile = false;
+	} else {
+		logFile = fopen(path, "a");
+		ownsFile = (logFile!=NULL);
+	}
+
+	atomicStore(&running, 1);
+#ifndef WIN32
+	pthread_create(&writerThread, NULL, WriterThreadFunc, NULL);
+#else
+	wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	DWORD threadId;
+	writerThread = CreateThread(0, 0, WriterThreadFunc, NULL, 0, &threadId);
+#endif
+	return (logFile!=NULL);
+}
+
+void TuioLog::close() {
+	if (!atomicExchange(&running, 0)) return;
+
+	wake();
+#ifndef WIN32
+	pthread_join(writerThread, NULL);
+#else
+	WaitForSingleObject(writerThread, INFINITE);
+	CloseHandle(writerThread);
+	writerThread = NULL;
+	CloseHandle(wakeEvent);
+	wakeEvent = NULL;
+#endif
+
+	if (ownsFile) fclose(logFile);
+	logFile = NULL;
+	ownsFile = false;
+}
+
+void TuioLog::wake() {
+#ifndef WIN32
+	pthread_mutex_lock(&wakeMutex);
+	pthread_cond_signal(&wakeCondition);
+	pthread_mutex_unlock(&wakeMutex);
+#else
+	if (wakeEvent!=NULL) SetEvent(wakeEvent);
+#endif
+}
+
+bool TuioLog::allow(TuioLogLimit *limit, long now, long &suppressedCount) {
+	suppressedCount = 0;
+	if (limit==NULL) return true;
+
+	long second = atomicLoad(&limit->second);
+	if ((second!=now) && atomicCompareExchange(&limit->second, second, now)) {
+		atomicStore(&limit->count, 0);
+		suppressedCount = atomicExchange(&limit->suppressed, 0);
+	}
+
+	if (atomicAdd(&limit->count, 1)>TUIO_LOG_RATE_LIMIT) {
+		atomicAdd(&limit->suppressed, 1);
+		atomicAdd(&suppressed, 1);
+		return false;
+	}
+	return true;
+}
+
+void TuioLog::write(int level, TuioLogLimit *limit, const char *format, ...) {
+	long seconds, microSeconds;
+	currentTime(seconds, microSeconds);
+
+	long suppressedCount;
+	if (!allow(limit, seconds, suppressedCount)) return;
+
+	// claim a free record
+	long pos = atomicLoad(&enqueuePos);
+	TuioLogRecord *record;
+	for (;;) {
+		long index = pos & (TUIO_LOG_RECORDS-1);
+		record = &ring[index];
+		long diff = atomicLoad(&record->sequence)+index-pos;
+		if (diff==0) {
+			if (atomicCompareExchange(&enqueuePos, pos, pos+1)) break;
+			pos = atomicLoad(&enqueuePos);
+		} else if (diff<0) {
+			// the writer is behind, drop rather than block the caller
+			atomicAdd(&dropped, 1);
+			return;
+		} else pos = atomicLoad(&enqueuePos);
+	}
+
+	record->level = level;
+	record->seconds = seconds;
+	record->microSeconds = microSeconds;
+	record->suppressed = suppressedCount;
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(record->text, TUIO_LOG_RECORD_SIZE, format, args);
+	va_end(args);
+	record->text[TUIO_LOG_RECORD_SIZE-1] = 0;
+
+	long index = pos & (TUIO_LOG_RECORDS-1);
+	atomicStore(&record->sequence, pos+1-index);
+
+	// the writer polls, only wake it early when the ring starts filling up
+	if (pos-dequeuePos>TUIO_LOG_RECORDS/2) wake();
+}
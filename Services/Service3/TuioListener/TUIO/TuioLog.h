@@ -0,0 +1,144 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOLOG_H
+#define INCLUDED_TUIOLOG_H
+
+#include "TuioAtomic.h"
+
+#define TUIO_LOG_LEVEL_NONE    -1
+#define TUIO_LOG_LEVEL_ERROR    0
+#define TUIO_LOG_LEVEL_WARNING  1
+#define TUIO_LOG_LEVEL_INFO     2
+#define TUIO_LOG_LEVEL_DEBUG    3
+
+// messages above this level are removed at compile time
+#ifndef TUIO_LOG_LEVEL
+#ifdef _DEBUG
+#define TUIO_LOG_LEVEL TUIO_LOG_LEVEL_DEBUG
+#else
+#define TUIO_LOG_LEVEL TUIO_LOG_LEVEL_INFO
+#endif
+#endif
+
+// maximum number of messages per second from a single log statement
+#ifndef TUIO_LOG_RATE_LIMIT
+#define TUIO_LOG_RATE_LIMIT 10
+#endif
+
+#define TUIO_LOG_RECORDS 256
+#define TUIO_LOG_RECORD_SIZE 224
+
+namespace TUIO {
+
+	/**
+	 * Per call site state of the rate limiter, every TUIO_LOG_* statement owns one static instance
+	 */
+	struct TuioLogLimit {
+		volatile long second;
+		volatile long count;
+		volatile long suppressed;
+	};
+
+	/**
+	 * <p>The TuioLog class is an asynchronous logger that keeps file I/O off the touch path.
+	 * Log statements format their message into a preallocated ring of fixed-size records
+	 * and return immediately, a background thread writes the records to the log file.
+	 * When the ring is full new messages are dropped and counted instead of blocking the caller.</p>
+	 * <p>Use the TUIO_LOG_ERROR, TUIO_LOG_WARNING, TUIO_LOG_INFO and TUIO_LOG_DEBUG macros rather
+	 * than calling write() directly. Levels above TUIO_LOG_LEVEL compile to nothing, and every
+	 * statement is limited to TUIO_LOG_RATE_LIMIT messages per second.</p>
+	 * <p><code>
+	 * TuioLog::open("C://log.txt");<br/>
+	 * TUIO_LOG_ERROR("could not bind to UDP port %d", port);<br/>
+	 * TuioLog::close();<br/>
+	 * </code></p>
+	 */
+	class TuioLog {
+
+	public:
+		/**
+		 * Starts the background writer thread, messages logged before are kept in the ring
+		 *
+		 * @param	path	the log file to append to, or NULL to write to stderr
+		 * @return	true if the log file could be opened
+		 */
+		static bool open(const char *path);
+
+		/**
+		 * Writes all pending messages and stops the background writer thread
+		 */
+		static void close();
+
+		/**
+		 * Queues a message, called by the TUIO_LOG_* macros
+		 *
+		 * @param	level	one of the TUIO_LOG_LEVEL_* values
+		 * @param	limit	the rate limiter of the calling log statement, or NULL
+		 * @param	format	printf style format string
+		 */
+		static void write(int level, TuioLogLimit *limit, const char *format, ...);
+
+		/**
+		 * Returns the number of messages dropped because the ring was full
+		 */
+		static long getDroppedCount() { return atomicLoad(&dropped); }
+
+		/**
+		 * Returns the number of messages suppressed by the rate limiter
+		 */
+		static long getSuppressedCount() { return atomicLoad(&suppressed); }
+
+	private:
+		static bool allow(TuioLogLimit *limit, long now, long &suppressedCount);
+		static void wake();
+
+		static volatile long dropped;
+		static volatile long suppressed;
+	};
+};
+
+#define TUIO_LOG_AT(level, ...) \
+	do { static TUIO::TuioLogLimit tuio_log_limit_ = {0, 0, 0}; TUIO::TuioLog::write(level, &tuio_log_limit_, __VA_ARGS__); } while (0)
+
+#if TUIO_LOG_LEVEL >= TUIO_LOG_LEVEL_ERROR
+#define TUIO_LOG_ERROR(...) TUIO_LOG_AT(TUIO_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define TUIO_LOG_ERROR(...) ((void)0)
+#endif
+
+#if TUIO_LOG_LEVEL >= TUIO_LOG_LEVEL_WARNING
+#define TUIO_LOG_WARNING(...) TUIO_LOG_AT(TUIO_LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define TUIO_LOG_WARNING(...) ((void)0)
+#endif
+
+#if TUIO_LOG_LEVEL >= TUIO_LOG_LEVEL_INFO
+#define TUIO_LOG_INFO(...) TUIO_LOG_AT(TUIO_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define TUIO_LOG_INFO(...) ((void)0)
+#endif
+
+#if TUIO_LOG_LEVEL >= TUIO_LOG_LEVEL_DEBUG
+#define TUIO_LOG_DEBUG(...) TUIO_LOG_AT(TUIO_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define TUIO_LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif /* INCLUDED_TUIOLOG_H */
@@ -0,0 +1,158 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "TuioShardedClient.h"
+#include "TuioLog.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+using namespace TUIO;
+
+int TuioShardedClient::getCpuCount() {
+#ifndef WIN32
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count>0)?(int)count:1;
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#endif
+}
+
+TuioShardedClient::TuioShardedClient(int port, int count)
+: connected(false)
+{
+	if (count<=0) count = getCpuCount();
+
+	// the first socket tells whether the port can be shared at all
+	UdpSocket probe;
+	if ((count>1) && !probe.SetReusePort(true)) {
+		TUIO_LOG_WARNING("UDP port sharing is not supported, receiving port %d with a single shard", port);
+		count = 1;
+	}
+
+	for (int i=0; i<count; i++) {
+		TuioClient *shard = new TuioClient(port, (count>1)?i:-1);
+		if (shard->socket==NULL) {
+			delete shard;
+			break;
+		}
+		shards.push_back(shard);
+	}
+
+	if ((int)shards.size()<count)
+		TUIO_LOG_ERROR("only %d of %d shards could bind UDP port %d", (int)shards.size(), count, port);
+}
+
+TuioShardedClient::~TuioShardedClient() {
+	if (connected) disconnect();
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		delete *shard;
+}
+
+void TuioShardedClient::connect() {
+	if (connected) return;
+
+	int cpus = getCpuCount();
+	for (int i=0; i<(int)shards.size(); i++) {
+		// with more shards than CPUs the system schedules the threads
+		if ((int)shards.size()<=cpus) {
+			TuioThreadRole role = shards[i]->getThreadRole();
+			role.setCpu(i);
+			shards[i]->setThreadRole(role);
+		}
+		shards[i]->connect(false);
+	}
+	connected = true;
+}
+
+void TuioShardedClient::disconnect() {
+	if (!connected) return;
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		(*shard)->disconnect();
+	connected = false;
+}
+
+void TuioShardedClient::addTuioListener(TuioListener *listener) {
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		(*shard)->addTuioListener(listener);
+}
+
+void TuioShardedClient::removeTuioListener(TuioListener *listener) {
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		(*shard)->removeTuioListener(listener);
+}
+
+void TuioShardedClient::setReceiveBufferSize(int bytes) {
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		(*shard)->setReceiveBufferSize(bytes);
+}
+
+bool TuioShardedClient::setReceiveBackend(const char *name) {
+	bool known = true;
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		known = (*shard)->setReceiveBackend(name);
+	return known;
+}
+
+void TuioShardedClient::enableStats(int port, int dumpSeconds, int controlPort, TuioControlListener *listener) {
+	// the statistics registry is shared, one endpoint reports every shard
+	if (!shards.empty()) shards.front()->enableStats(port, dumpSeconds, controlPort, listener);
+}
+
+std::list<TuioCursor*> TuioShardedClient::getTuioCursors() {
+	std::list<TuioCursor*> cursors;
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++) {
+		std::list<TuioCursor*> shardCursors = (*shard)->getTuioCursors();
+		cursors.splice(cursors.end(), shardCursors);
+	}
+	return cursors;
+}
+
+std::list<TuioObject*> TuioShardedClient::getTuioObjects() {
+	std::list<TuioObject*> objects;
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++) {
+		std::list<TuioObject*> shardObjects = (*shard)->getTuioObjects();
+		objects.splice(objects.end(), shardObjects);
+	}
+	return objects;
+}
+
+void TuioShardedClient::lockCursorList() {
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		(*shard)->lockCursorList();
+}
+
+void TuioShardedClient::unlockCursorList() {
+	for (std::vector<TuioClient*>::reverse_iterator shard=shards.rbegin(); shard!=shards.rend(); shard++)
+		(*shard)->unlockCursorList();
+}
+
+void TuioShardedClient::lockObjectList() {
+	for (std::vector<TuioClient*>::iterator shard=shards.begin(); shard!=shards.end(); shard++)
+		(*shard)->lockObjectList();
+}
+
+void TuioShardedClient::unlockObjectList() {
+	for (std::vector<TuioClient*>::reverse_iterator shard=shards.rbegin(); shard!=shards.rend(); shard++)
+		(*shard)->unlockObjectList();
+}
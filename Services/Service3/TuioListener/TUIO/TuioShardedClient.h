@@ -0,0 +1,172 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef INCLUDED_TUIOSHARDEDCLIENT_H
+#define INCLUDED_TUIOSHARDEDCLIENT_H
+
+#include <vector>
+
+#include "TuioClient.h"
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioShardedClient class receives one UDP port with several TuioClient shards, each with
+	 * its own socket, receiving thread and cursor and object state. All sockets bind the port with
+	 * SO_REUSEPORT and the kernel assigns every datagram by a hash of its source address and port,
+	 * so all frames of a source arrive at the same shard and the shards never share state.
+	 * This scales a relay that fans many sources into one port beyond a single receiving thread.</p>
+	 * <p>Listeners are called from all receiving threads concurrently. Session IDs are unique per source only,
+	 * sources that feed one port have to use disjoint session ID ranges just as with a single TuioClient.
+	 * Where the system cannot balance a port over several sockets, as on Windows, a single shard is used.</p>
+	 * <p><code>
+	 * TuioShardedClient *client = new TuioShardedClient(3333, 4);<br/>
+	 * client->addTuioListener(myTuioListener);<br/>
+	 * client->connect();<br/>
+	 * </code></p>
+	 */
+	class TuioShardedClient {
+
+	public:
+		/**
+		 * Creates the shards and binds their sockets to the provided port
+		 *
+		 * @param  port	the incoming TUIO UDP port number
+		 * @param  shards	the number of shards, or 0 (default) for one shard per CPU
+		 */
+		TuioShardedClient(int port=3333, int shards=0);
+
+		/**
+		 * Disconnects and deletes all shards
+		 */
+		~TuioShardedClient();
+
+		/**
+		 * Starts the receiving thread of every shard, each bound to its own CPU
+		 */
+		void connect();
+
+		/**
+		 * Stops the receiving threads of all shards
+		 */
+		void disconnect();
+
+		/**
+		 * Returns true if the shards are currently connected
+		 */
+		bool isConnected() const { return connected; }
+
+		/**
+		 * Adds the provided TuioListener to all shards, it is called from every receiving thread
+		 *
+		 * @param  listener  the TuioListener to add
+		 */
+		void addTuioListener(TuioListener *listener);
+
+		/**
+		 * Removes the provided TuioListener from all shards
+		 *
+		 * @param  listener  the TuioListener to remove
+		 */
+		void removeTuioListener(TuioListener *listener);
+
+		/**
+		 * Requests a kernel receive buffer of the provided size for every shard socket. Has to be called before connect().
+		 *
+		 * @param  bytes	the receive buffer size in bytes
+		 */
+		void setReceiveBufferSize(int bytes);
+
+		/**
+		 * Selects how every shard socket is received, see {@link TuioClient#setReceiveBackend}.
+		 * Has to be called before connect().
+		 *
+		 * @param  name	the name of the backend, "select" or "io_uring"
+		 * @return	false if the name is unknown
+		 */
+		bool setReceiveBackend(const char *name);
+
+		/**
+		 * Answers statistics requests on the provided local UDP port, and statistics and control
+		 * requests on the provided local TCP port, the report includes all shards.
+		 * Has to be called before connect().
+		 *
+		 * @param  port	the local UDP port for statistics requests, or 0 for no endpoint
+		 * @param  dumpSeconds	the period of the log dump in seconds, or 0 for no dump
+		 * @param  controlPort	the local TCP port for statistics and control requests, or 0 for none
+		 * @param  listener	carries out the control commands, or NULL to refuse them
+		 */
+		void enableStats(int port, int dumpSeconds=60, int controlPort=0, TuioControlListener *listener=NULL);
+
+		/**
+		 * Returns a copy of the List of all currently active TuioCursors of all shards
+		 *
+		 * @return  a List of all currently active TuioCursors
+		 */
+		std::list<TuioCursor*> getTuioCursors();
+
+		/**
+		 * Returns a copy of the List of all currently active TuioObjects of all shards
+		 *
+		 * @return  a List of all currently active TuioObjects
+		 */
+		std::list<TuioObject*> getTuioObjects();
+
+		/**
+		 * Locks the cursor lists of all shards, in shard order
+		 */
+		void lockCursorList();
+
+		/**
+		 * Unlocks the cursor lists of all shards
+		 */
+		void unlockCursorList();
+
+		/**
+		 * Locks the object lists of all shards, in shard order
+		 */
+		void lockObjectList();
+
+		/**
+		 * Unlocks the object lists of all shards
+		 */
+		void unlockObjectList();
+
+		/**
+		 * Returns the number of shards that could bind the port
+		 */
+		int getShardCount() const { return (int)shards.size(); }
+
+		/**
+		 * Returns the shard with the provided index
+		 */
+		TuioClient* getShard(int index) { return shards[index]; }
+
+		/**
+		 * Returns the number of CPUs available to this process
+		 */
+		static int getCpuCount();
+
+	private:
+		std::vector<TuioClient*> shards;
+		bool connected;
+	};
+};
+#endif /* INCLUDED_TUIOSHARDEDCLIENT_H */
@@ -0,0 +1,145 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOTHREADROLE_H
+#define INCLUDED_TUIOTHREADROLE_H
+
+#ifndef WIN32
+#include <pthread.h>
+#include <sched.h>
+#else
+#include <windows.h>
+#endif
+
+// the SCHED_FIFO priority of realtime threads unless another one is configured, below the kernel threads at 99
+#define TUIO_THREAD_ROLE_REALTIME_PRIORITY 50
+// the nice value of high priority threads
+#define TUIO_THREAD_ROLE_HIGH_NICE -10
+// the MMCSS task of realtime threads on Windows, the one with the shortest scheduling period
+#define TUIO_THREAD_ROLE_MMCSS_TASK "Pro Audio"
+// the memory that Windows keeps resident once the memory is locked, in bytes
+#define TUIO_THREAD_ROLE_WORKING_SET (64*1024*1024)
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioThreadRole describes how a thread on the touch path is scheduled: its priority
+	 * and the CPU it runs on. A realtime thread runs with SCHED_FIFO on Linux and is registered
+	 * with the Multimedia Class Scheduler Service on Windows, a high priority thread runs with a
+	 * lower nice value or THREAD_PRIORITY_HIGHEST. A role is applied by the thread itself with a
+	 * {@link TuioThreadRoleScope}, a role that is not permitted falls back to a lower priority
+	 * with a warning.</p>
+	 *
+	 * <p>The description of a role is the priority, "normal", "high" or "realtime" with an optional
+	 * SCHED_FIFO priority from 1 to 98, followed by an optional "cpu" and the index of the CPU, as
+	 * in "realtime 80 cpu 2" or "cpu 1".</p>
+	 */
+	class TuioThreadRole {
+
+	public:
+		enum Priority { NORMAL, HIGH, REALTIME };
+
+		TuioThreadRole() : priority(NORMAL), realtimePriority(TUIO_THREAD_ROLE_REALTIME_PRIORITY), cpu(-1) {}
+
+		/**
+		 * Reads the role from its description
+		 *
+		 * @param  description	the description of the role, "normal" for the default
+		 * @return	false if the description is invalid, the role is unchanged then
+		 */
+		bool configure(const char *description);
+
+		/**
+		 * Sets the priority of the thread
+		 *
+		 * @param  p	the priority
+		 * @param  level	the SCHED_FIFO priority of a realtime thread, not used on Windows
+		 */
+		void setPriority(Priority p, int level=TUIO_THREAD_ROLE_REALTIME_PRIORITY) { priority = p; realtimePriority = level; }
+		Priority getPriority() const { return priority; }
+		int getRealtimePriority() const { return realtimePriority; }
+
+		/**
+		 * Runs the thread on the provided CPU only
+		 *
+		 * @param  c	the index of the CPU, or -1 to let the system schedule the thread
+		 */
+		void setCpu(int c) { cpu = c; }
+		int getCpu() const { return cpu; }
+
+		/**
+		 * Locks the memory of the process, so that the touch path does not wait for pages to be
+		 * read back. On Linux all current and future pages are locked, on Windows the minimum
+		 * working set is raised to TUIO_THREAD_ROLE_WORKING_SET.
+		 *
+		 * @return	false if the process is not permitted to lock its memory
+		 */
+		static bool lockMemory();
+
+	private:
+		Priority priority;
+		int realtimePriority;
+		int cpu;
+	};
+
+	/**
+	 * <p>The TuioThreadRoleScope applies a {@link TuioThreadRole} to the calling thread while it
+	 * exists, the previous scheduling of the thread is restored when it is deleted.</p>
+	 *
+	 * <pre>
+	 * TuioThreadRoleScope scope(role, "receive");
+	 * socket->Run();
+	 * </pre>
+	 */
+	class TuioThreadRoleScope {
+
+	public:
+		/**
+		 * @param  role	the role of the calling thread
+		 * @param  name	the name of the thread in the log
+		 */
+		TuioThreadRoleScope(const TuioThreadRole &role, const char *name);
+		~TuioThreadRoleScope();
+
+	private:
+		TuioThreadRoleScope(const TuioThreadRoleScope&);
+		TuioThreadRoleScope& operator=(const TuioThreadRoleScope&);
+
+		bool setPriority(const TuioThreadRole &role, const char *name);
+		bool setHighPriority(const char *name);
+		bool setCpu(int cpu, const char *name);
+
+		bool restorePriority;
+		bool restoreAffinity;
+#ifndef WIN32
+		int oldPolicy;
+		struct sched_param oldParam;
+		bool restoreNice;
+		int oldNice;
+#ifdef __linux__
+		cpu_set_t oldCpus;
+#endif
+#else
+		HANDLE mmcssHandle;
+		int oldPriority;
+		DWORD_PTR oldMask;
+#endif
+	};
+};
+#endif /* INCLUDED_TUIOTHREADROLE_H */
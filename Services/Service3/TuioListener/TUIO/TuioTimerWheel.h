@@ -0,0 +1,168 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOTIMERWHEEL_H
+#define INCLUDED_TUIOTIMERWHEEL_H
+
+#ifndef WIN32
+#include <pthread.h>
+#else
+#include <windows.h>
+#endif
+
+#include <map>
+
+#include "ip/TimerListener.h"
+#include "ip/UdpSocket.h"
+
+#include "TuioLock.h"
+
+// the tick of the timer wheel in milliseconds
+#define TUIO_TIMER_RESOLUTION 10
+#define TUIO_TIMER_LEVELS 4
+#define TUIO_TIMER_SLOT_BITS 6
+#define TUIO_TIMER_SLOTS (1<<TUIO_TIMER_SLOT_BITS)
+
+namespace TUIO {
+
+	struct TuioTimerEntry;
+
+	/**
+	 * <p>The TuioTimerWheel calls periodic TimerListeners, for example the periodic full update of
+	 * many {@link TuioServer} instances, from a single thread. The timers are kept in a hierarchical
+	 * wheel of four levels with 64 slots each, so scheduling, cancelling and expiring a timer take
+	 * constant time however many timers are active, and periods range from one tick up to days.</p>
+	 *
+	 * <p>The wheel is advanced by the SocketReceiveMultiplexer of a {@link TuioClient} it is attached
+	 * to, see {@link TuioClient#attachTimerWheel}, so the timers run on the receiving thread between two
+	 * packets. Without a running multiplexer a single helper thread of the wheel advances it instead.
+	 * The listeners are called one at a time, and once cancel() returns a listener is not called
+	 * anymore and may be deleted.</p>
+	 */
+	class TuioTimerWheel : public TimerListener {
+
+	public:
+		/**
+		 * Creates an empty timer wheel, its helper thread is started with the first timer
+		 *
+		 * @param  resolution	the tick of the wheel in milliseconds
+		 */
+		TuioTimerWheel(int resolution=TUIO_TIMER_RESOLUTION);
+
+		/**
+		 * Stops the helper thread and drops all timers, the wheel has to be detached from all multiplexers
+		 */
+		~TuioTimerWheel();
+
+		/**
+		 * Returns the timer wheel shared by all TuioServer instances of the process
+		 * @return	the shared timer wheel, which is never deleted
+		 */
+		static TuioTimerWheel* getShared();
+
+		/**
+		 * Calls the provided listener periodically until it is cancelled. A listener that is
+		 * already scheduled is rescheduled with the new period.
+		 *
+		 * @param  listener	the listener to call, owned by the caller
+		 * @param  period	the period in milliseconds, rounded up to whole ticks
+		 * @param  initialDelay	the delay of the first call in milliseconds, or -1 for one period
+		 */
+		void schedule(TimerListener *listener, int period, int initialDelay=-1);
+
+		/**
+		 * Cancels the provided listener. If it is being called on another thread, waits until the call returns.
+		 *
+		 * @param  listener	the listener to cancel
+		 */
+		void cancel(TimerListener *listener);
+
+		/**
+		 * Returns true if the provided listener is scheduled
+		 * @return	true if the provided listener is scheduled
+		 */
+		bool isScheduled(TimerListener *listener);
+
+		/**
+		 * Returns the tick of the wheel in milliseconds
+		 * @return	the tick of the wheel in milliseconds
+		 */
+		int getResolution() const { return resolution; }
+
+		/**
+		 * Calls all listeners that expired since the last advance
+		 */
+		void advance();
+
+		/**
+		 * Advances the wheel on every tick of the multiplexer, which must not be running
+		 */
+		void attach(SocketReceiveMultiplexer &multiplexer);
+
+		/**
+		 * Stops advancing the wheel on the multiplexer, which must not be running
+		 */
+		void detach(SocketReceiveMultiplexer &multiplexer);
+
+		void TimerExpired();
+
+	private:
+		long long currentTime() const;
+		void insert(TuioTimerEntry *entry);
+		void cascade(int level, int index);
+		void expire(TuioTimerEntry *list, long long target);
+		void step();
+		void lock();
+		void unlock();
+		bool isDispatchThread();
+		void startThread();
+
+#ifndef WIN32
+		static void* threadFunc( void* obj );
+#else
+		static DWORD WINAPI threadFunc( LPVOID obj );
+#endif
+
+		int resolution;
+		long long origin;
+		long long tick;
+		volatile long advanced;
+
+		TuioTimerEntry *slots[TUIO_TIMER_LEVELS][TUIO_TIMER_SLOTS];
+		std::map<TimerListener*, TuioTimerEntry*> entryMap;
+		TuioTimerEntry *current;
+
+		TuioMutex mutex;
+		volatile long dispatching;
+#ifndef WIN32
+		pthread_t dispatchThread;
+#else
+		DWORD dispatchThread;
+#endif
+
+		volatile long running;
+		bool threadStarted;
+#ifndef WIN32
+		pthread_t thread;
+#else
+		HANDLE thread;
+#endif
+	};
+};
+#endif /* INCLUDED_TUIOTIMERWHEEL_H */
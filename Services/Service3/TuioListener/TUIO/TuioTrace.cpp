@@ -0,0 +1,149 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioTrace.h"
+#include "TuioLock.h"
+#include "TuioLog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#define TUIO_THREAD_LOCAL __declspec(thread)
+#else
+#define TUIO_THREAD_LOCAL __thread
+#endif
+
+using namespace TUIO;
+
+// events that may still be written by threads that saw tracing enabled just before stop()
+#define TUIO_TRACE_INFLIGHT 8
+
+namespace TUIO {
+	struct TuioTraceEvent {
+		const char *name;
+		const char *argName;
+		long long begin;
+		long long end;
+		long long argValue;
+	};
+
+	// written only by its own thread, read by stop() after recording was disabled
+	struct TuioTraceBuffer {
+		int threadID;
+		volatile long count;
+		TuioTraceEvent events[TUIO_TRACE_EVENTS];
+		TuioTraceBuffer *next;
+	};
+};
+
+volatile long TuioTrace::enabled = 0;
+
+static TuioMutex traceMutex;
+static TuioTraceBuffer *bufferList = NULL;
+static int threadCount = 0;
+static long long traceStart = 0;
+static char tracePath[260];
+
+// buffers are kept for the lifetime of the process and reused by the next trace
+static TUIO_THREAD_LOCAL TuioTraceBuffer *localBuffer = NULL;
+
+TuioTraceBuffer* TuioTrace::threadBuffer() {
+	if (localBuffer!=NULL) return localBuffer;
+
+	TuioTraceBuffer *buffer = (TuioTraceBuffer*)malloc(sizeof(TuioTraceBuffer));
+	if (buffer==NULL) return NULL;
+
+	TuioScopedLock lock(traceMutex);
+	buffer->threadID = ++threadCount;
+	buffer->count = 0;
+	buffer->next = bufferList;
+	bufferList = buffer;
+	localBuffer = buffer;
+	return buffer;
+}
+
+void TuioTrace::complete(const char *name, long long begin, long long end, const char *argName, long long argValue) {
+	if (!isEnabled()) return;
+	TuioTraceBuffer *buffer = threadBuffer();
+	if (buffer==NULL) return;
+
+	long count = buffer->count;
+	TuioTraceEvent &event = buffer->events[count % TUIO_TRACE_EVENTS];
+	event.name = name;
+	event.argName = argName;
+	event.begin = begin;
+	event.end = end;
+	event.argValue = argValue;
+	atomicStore(&buffer->count, count+1);
+}
+
+bool TuioTrace::start(const char *path) {
+	TuioScopedLock lock(traceMutex);
+	if (isEnabled()) return false;
+
+	strncpy(tracePath, path, sizeof(tracePath)-1);
+	tracePath[sizeof(tracePath)-1] = 0;
+
+	for (TuioTraceBuffer *buffer=bufferList; buffer!=NULL; buffer=buffer->next)
+		atomicStore(&buffer->count, 0);
+
+	traceStart = GetCurrentTimeNanoseconds();
+	atomicStore(&enabled, 1);
+	TUIO_LOG_INFO("tracing to %s", tracePath);
+	return true;
+}
+
+bool TuioTrace::stop() {
+	TuioScopedLock lock(traceMutex);
+	if (!atomicExchange(&enabled, 0)) return false;
+
+	FILE *file = fopen(tracePath, "w");
+	if (file==NULL) {
+		TUIO_LOG_ERROR("could not write trace to %s", tracePath);
+		return false;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	long written = 0;
+	for (TuioTraceBuffer *buffer=bufferList; buffer!=NULL; buffer=buffer->next) {
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"TUIO thread %d\"}}", (written>0)?",\n":"", buffer->threadID, buffer->threadID);
+		written++;
+
+		long count = atomicLoad(&buffer->count);
+		long first = 0;
+		// after a wrap the oldest slots may be overwritten while we read them
+		if (count>TUIO_TRACE_EVENTS) first = count-TUIO_TRACE_EVENTS+TUIO_TRACE_INFLIGHT;
+
+		for (long i=first; i<count; i++) {
+			const TuioTraceEvent &event = buffer->events[i % TUIO_TRACE_EVENTS];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"tuio\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+				event.name, buffer->threadID, (event.begin-traceStart)/1000.0, (event.end-event.begin)/1000.0);
+			if (event.argName!=NULL) fprintf(file, ",\"args\":{\"%s\":%lld}", event.argName, event.argValue);
+			fprintf(file, "}");
+			written++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	TUIO_LOG_INFO("wrote %ld trace events to %s", written, tracePath);
+	return true;
+}
@@ -0,0 +1,133 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOTRACE_H
+#define INCLUDED_TUIOTRACE_H
+
+#include "ip/NetworkingUtils.h"
+
+#include "TuioAtomic.h"
+
+// number of events kept per thread, older events are overwritten
+#ifndef TUIO_TRACE_EVENTS
+#define TUIO_TRACE_EVENTS 16384
+#endif
+
+namespace TUIO {
+
+	struct TuioTraceBuffer;
+
+	/**
+	 * <p>The TuioTrace class records the duration of the pipeline stages of individual frames
+	 * and writes them to a Trace Event Format JSON file that can be opened in Perfetto
+	 * (ui.perfetto.dev) or chrome://tracing.</p>
+	 * <p>Every thread writes to its own buffer, so recording takes no lock. While tracing is
+	 * stopped a trace point costs a single load and branch; define TUIO_NO_TRACE
+	 * to compile the TUIO_TRACE_SCOPE points out completely.</p>
+	 * <p><code>
+	 * TuioTrace::start("C://trace.json");<br/>
+	 * { TUIO_TRACE_SCOPE("ProcessBundle"); ... }<br/>
+	 * TuioTrace::stop();<br/>
+	 * </code></p>
+	 */
+	class TuioTrace {
+
+	public:
+		/**
+		 * Clears all buffers and starts recording
+		 *
+		 * @param	path	the file stop() writes the trace to
+		 * @return	false if tracing is already running
+		 */
+		static bool start(const char *path);
+
+		/**
+		 * Stops recording and writes the recorded events
+		 *
+		 * @return	true if the trace file was written
+		 */
+		static bool stop();
+
+		/**
+		 * Returns true while recording
+		 */
+		static bool isEnabled() { return atomicLoad(&enabled)!=0; }
+
+		/**
+		 * Records a completed event of the calling thread
+		 *
+		 * @param	name	the event name, must be a string literal
+		 * @param	begin	the start time in nanoseconds of GetCurrentTimeNanoseconds()
+		 * @param	end	the end time in nanoseconds of GetCurrentTimeNanoseconds()
+		 * @param	argName	the name of an optional numeric argument, a string literal or NULL
+		 * @param	argValue	the value of the optional argument
+		 */
+		static void complete(const char *name, long long begin, long long end, const char *argName=NULL, long long argValue=0);
+
+	private:
+		static TuioTraceBuffer* threadBuffer();
+
+		static volatile long enabled;
+	};
+
+	/**
+	 * Records the lifetime of the TuioTraceScope instance, or the time until end() is called
+	 */
+	class TuioTraceScope {
+
+	public:
+		TuioTraceScope(const char *n, const char *an=NULL, long long av=0)
+		: name    (n)
+		, argName (an)
+		, argValue(av)
+		, begin   (TuioTrace::isEnabled()?GetCurrentTimeNanoseconds():0)
+		{
+		}
+
+		~TuioTraceScope() {
+			end();
+		}
+
+		/**
+		 * Records the event now instead of at the end of the scope
+		 */
+		void end() {
+			if (begin==0) return;
+			TuioTrace::complete(name, begin, GetCurrentTimeNanoseconds(), argName, argValue);
+			begin = 0;
+		}
+
+	private:
+		TuioTraceScope(const TuioTraceScope&);
+		TuioTraceScope& operator=(const TuioTraceScope&);
+
+		const char *name;
+		const char *argName;
+		long long argValue;
+		long long begin;
+	};
+};
+
+#ifndef TUIO_NO_TRACE
+#define TUIO_TRACE_SCOPE(...) TUIO::TuioTraceScope tuio_trace_scope_(__VA_ARGS__)
+#else
+#define TUIO_TRACE_SCOPE(...) ((void)0)
+#endif
+
+#endif /* INCLUDED_TUIOTRACE_H */
@@ -45,5 +45,13 @@ public:
 // return ip address of host name in host byte order
 unsigned long GetHostByName( const char *name );
 
+// resolve an IPv6 address or host name to 16 address bytes in network byte
+// order. returns false if the name has no IPv6 address
+bool GetHostByName6( const char *name, unsigned char *address6 );
+
+// return the current time in nanoseconds, measured with the same clock as
+// UdpSocket::LastReceiveTime(). only differences between two values are meaningful
+long long GetCurrentTimeNanoseconds();
+
 
 #endif /* INCLUDED_NETWORKINGUTILS_H */
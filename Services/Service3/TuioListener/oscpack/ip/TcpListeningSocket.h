@@ -0,0 +1,77 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef INCLUDED_TCPLISTENINGSOCKET_H
+#define INCLUDED_TCPLISTENINGSOCKET_H
+
+#ifndef INCLUDED_UDPSOCKET_H
+#include "UdpSocket.h"
+#endif /* INCLUDED_UDPSOCKET_H */
+
+#ifndef INCLUDED_STREAMDECODER_H
+#include "StreamDecoder.h"
+#endif /* INCLUDED_STREAMDECODER_H */
+
+
+// TcpListeningSocket accepts TCP connections that carry OSC packets in a
+// stream framing, see StreamDecoder. attach it to a SocketReceiveMultiplexer
+// with AttachStreamListener(), the multiplexer then accepts and reads the
+// connections on its own thread and passes every packet to the listener,
+// with the remote endpoint of the connection. connections beyond
+// maxConnections are closed right after they are accepted.
+//
+// stream packets are passed in place from the receive buffer of their
+// connection, they can not be retained with RetainReceiveBuffer().
+//
+// a listener answers a packet with SendTo() and the remote endpoint it was
+// passed, the answer is sent on the connection once the listener returned.
+
+class TcpListeningSocket{
+    class Implementation;
+    Implementation *impl_;
+
+	friend class SocketReceiveMultiplexer::Implementation;
+
+public:
+	// ctor throws std::runtime_error if the endpoint can't be bound
+	TcpListeningSocket( const IpEndpointName& localEndpoint,
+			StreamDecoder::Framing framing=StreamDecoder::AUTO_FRAMING, int maxConnections=64 );
+	~TcpListeningSocket();
+
+	// the bound endpoint, with the port the system chose for ANY_PORT
+	IpEndpointName LocalEndpoint() const;
+
+	// the number of open connections, read from the receiving thread
+	int ConnectionCount() const;
+
+	// queues data for the connection of remoteEndpoint, only called by the
+	// listener from ProcessPacket(). returns false if the connection is gone
+	bool SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size );
+};
+
+
+#endif /* INCLUDED_TCPLISTENINGSOCKET_H */
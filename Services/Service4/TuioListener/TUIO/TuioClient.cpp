@@ -20,6 +20,12 @@
  */
 
 #include "TuioClient.h"
+#include "TuioRelay.h"
+#include "TuioTimerWheel.h"
+#include "TuioLog.h"
+#include "TuioTrace.h"
+
+#include <stdio.h>
 
 using namespace TUIO;
 using namespace osc;
@@ -30,58 +36,148 @@ static void* ClientThreadFunc( void* obj )
 static DWORD WINAPI ClientThreadFunc( LPVOID obj )
 #endif
 {
-	static_cast<TuioClient*>(obj)->socket->Run();
+	TuioClient *client = static_cast<TuioClient*>(obj);
+	TuioThreadRoleScope role(client->getThreadRole(), "receive");
+	client->socket->Run();
 	return 0;
 };
 
 void TuioClient::lockObjectList() {
-	if(!connected) return;
-#ifndef WIN32	
-	pthread_mutex_lock(&objectMutex);
-#else
-	WaitForSingleObject(objectMutex, INFINITE);
-#endif		
+	objectMutex.lock();
 }
 
 void TuioClient::unlockObjectList() {
-	if(!connected) return;
-#ifndef WIN32	
-	pthread_mutex_unlock(&objectMutex);
-#else
-	ReleaseMutex(objectMutex);
-#endif
+	objectMutex.unlock();
 }
 
 void TuioClient::lockCursorList() {
-	if(!connected) return;
-#ifndef WIN32	
-	pthread_mutex_lock(&cursorMutex);
-#else
-	WaitForSingleObject(cursorMutex, INFINITE);
-#endif		
+	cursorMutex.lock();
 }
 
 void TuioClient::unlockCursorList() {
-	if(!connected) return;
-#ifndef WIN32	
-	pthread_mutex_unlock(&cursorMutex);
-#else
-	ReleaseMutex(cursorMutex);
-#endif		
+	cursorMutex.unlock();
+}
+
+TuioFrameInfo TuioClient::getFrameInfo() const {
+	TuioFrameInfo info;
+	long seq;
+	do {
+		seq = frameInfoLock.readBegin();
+		info = frameInfo;
+	} while (frameInfoLock.readRetry(seq));
+	return info;
+}
+
+void TuioClient::publishFrameInfo() {
+	frameInfoLock.writeBegin();
+	frameInfo.frameID = currentFrame;
+	frameInfo.frameTime = currentTime;
+	frameInfo.cursorCount = (int)cursorList.size();
+	frameInfo.objectCount = (int)objectList.size();
+	frameInfoLock.writeEnd();
+}
+
+// passes the packets of TCP connections on, with the time they were read
+// since there is no arrival time of the socket to take
+class TUIO::TuioStreamReceiver : public PacketListener {
+public:
+	TuioStreamReceiver(TuioClient *c):client(c) {}
+	void ProcessPacket( const char *data, int size, const IpEndpointName& remoteEndpoint ) {
+		client->processPacket(data, size, remoteEndpoint, GetCurrentTimeNanoseconds(), false);
+	}
+private:
+	TuioClient *client;
+};
+
+// a TuioServer that splits a frame over several packets sends "frag <fseq> <index> <count>"
+// after the alive message of each fragment. the set messages are collected until the last
+// fragment arrived, so the listeners only see complete frames. an incomplete frame is dropped
+// once a fragment of another frame or a bundle that is no fragment arrives
+#define TUIO_MAX_FRAGMENTS 64
+
+static void resetFragments(TuioFragmentState &state) {
+	state.frame = -1;
+	state.count = 0;
+	state.received = 0;
+	state.pending = 0;
+	state.fragment = state.deferred = false;
+}
+
+template <class T> static void discardFragments(TuioFragmentState &state, std::list<T*> &frameList) {
+	for (int i=0; (i<state.pending) && !frameList.empty(); i++) {
+		delete frameList.front();
+		frameList.pop_front();
+	}
+	resetFragments(state);
+}
+
+template <class T> static void beginFragment(TuioFragmentState &state, std::list<T*> &frameList, long fseq, int index, int count, TuioFrameStats &stats) {
+	if ((count<2) || (count>TUIO_MAX_FRAGMENTS) || (index<0) || (index>=count)) return;
+
+	unsigned long long bit = 1ULL<<index;
+	if ((state.received!=0) && ((fseq!=state.frame) || (count!=state.count) || (state.received & bit))) {
+		discardFragments(state, frameList);
+		stats.droppedFrame();
+	}
+
+	state.frame = fseq;
+	state.count = count;
+	state.received |= bit;
+	state.fragment = true;
+	state.deferred = (state.received!=((count==TUIO_MAX_FRAGMENTS) ? ~0ULL : (1ULL<<count)-1));
+}
+
+// returns false if the fseq message ends a fragment that must not commit the frame yet
+template <class T> static bool endFragment(TuioFragmentState &state, std::list<T*> &frameList, TuioFrameStats &stats) {
+	if (state.deferred) {
+		state.pending = (int)frameList.size();
+		state.fragment = state.deferred = false;
+		return false;
+	}
+
+	if (state.fragment) resetFragments(state);
+	else if (state.received!=0) {
+		discardFragments(state, frameList);
+		stats.droppedFrame();
+	}
+	return true;
 }
 
-TuioClient::TuioClient(int port)
+TuioClient::TuioClient(int port, int shard)
 : socket      (NULL)
 , currentFrame(-1)
 , maxCursorID (-1)
+, latency     ("udp")
+, frameStats  ("udp")
+, socketStats (NULL)
+, statsEndpoint(NULL)
+, streamSocket(NULL)
+, streamReceiver(NULL)
+, sharedMemory(NULL)
+, relay       (NULL)
+, decodePackets(true)
+, checkBackend(false)
+, timerWheel  (NULL)
 , thread      (NULL)
 , locked      (false)
 , connected   (false)
 {
+	frameInfo.frameID = -1;
+	frameInfo.cursorCount = 0;
+	frameInfo.objectCount = 0;
+	resetFragments(objectFragments);
+	resetFragments(cursorFragments);
+
+	char name[32];
+	if (shard<0) sprintf(name, "udp:%d", port);
+	else sprintf(name, "udp:%d/%d", port, shard);
+	latency.setName(name);
+	frameStats.setName(name);
+
 	try {
-		socket = new UdpListeningReceiveSocket(IpEndpointName( IpEndpointName::ANY_ADDRESS, port ), this );
+		socket = new UdpListeningReceiveSocket(IpEndpointName( IpEndpointName::ANY_ADDRESS, port ), this, shard>=0 );
 	} catch (std::exception &e) { 
-		std::cerr << "could not bind to UDP port " << port << std::endl;
+		TUIO_LOG_ERROR("could not bind to UDP port %d", port);
 		socket = NULL;
 	}
 	
@@ -89,16 +185,130 @@ TuioClient::TuioClient(int port)
 		if (!socket->IsBound()) {
 			delete socket;
 			socket = NULL;
-		} else std::cout << "listening to TUIO messages on UDP port " << port << std::endl;
+		} else {
+			TUIO_LOG_INFO("listening to TUIO messages on %s", name);
+			socketStats = new TuioSocketStats(name, socket);
+		}
 	}	
 }
 
 TuioClient::~TuioClient() {	
+	if ((timerWheel!=NULL) && (socket!=NULL)) timerWheel->detach(socket->Multiplexer());
+	if (statsEndpoint!=NULL) {
+		if (socket!=NULL) statsEndpoint->detach(socket->Multiplexer());
+		delete statsEndpoint;
+	}
+	if (streamSocket!=NULL) {
+		if (socket!=NULL) socket->Multiplexer().DetachStreamListener(streamSocket, streamReceiver);
+		delete streamSocket;
+		delete streamReceiver;
+	}
+	// the relay may hold datagrams received by our socket
+	if (relay!=NULL) relay->stop();
+	delete sharedMemory;
+	delete socketStats;
 	delete socket;
 }
 
+void TuioClient::setReceiveBufferSize(int bytes) {
+	if (socket==NULL) return;
+	socket->SetReceiveBufferSize(bytes);
+	TUIO_LOG_INFO("requested a %d byte receive buffer, got %d bytes", bytes, socket->ReceiveBufferSize());
+}
+
+bool TuioClient::setReceiveBackend(const char *name) {
+	bool ioUring = (strcmp(name, "io_uring")==0);
+	if (!ioUring && (strcmp(name, "select")!=0)) return false;
+	if (socket==NULL) return true;
+#ifdef WIN32
+	if (ioUring) TUIO_LOG_WARNING("io_uring is only available on Linux");
+#else
+	socket->Multiplexer().SetBackend(ioUring ? SocketReceiveMultiplexer::IO_URING_BACKEND : SocketReceiveMultiplexer::DEFAULT_BACKEND);
+	// the multiplexer only finds out on the receiving thread whether the kernel supports it
+	checkBackend = ioUring;
+#endif
+	return true;
+}
+
+bool TuioClient::joinMulticastGroup(const char *group, const char *source) {
+	if (socket==NULL) return false;
+
+	IpEndpointName groupEndpoint(group);
+	IpEndpointName sourceEndpoint;
+	if (source!=NULL) sourceEndpoint = IpEndpointName(source);
+	if (!groupEndpoint.IsMulticastAddress() || !socket->JoinGroup(groupEndpoint, sourceEndpoint)) {
+		TUIO_LOG_ERROR("could not join the multicast group %s", group);
+		return false;
+	}
+
+	if (source!=NULL) TUIO_LOG_INFO("receiving TUIO from %s in the multicast group %s", source, group);
+	else TUIO_LOG_INFO("receiving TUIO in the multicast group %s", group);
+	return true;
+}
+
+void TuioClient::enableStats(int port, int dumpSeconds, int controlPort, TuioControlListener *listener) {
+	if ((socket==NULL) || (statsEndpoint!=NULL)) return;
+	statsEndpoint = new TuioStatsEndpoint(port, dumpSeconds, controlPort, listener);
+	statsEndpoint->attach(socket->Multiplexer());
+}
+
+void TuioClient::attachTimerWheel(TuioTimerWheel *wheel) {
+	if ((socket==NULL) || (timerWheel!=NULL) || (wheel==NULL)) return;
+	timerWheel = wheel;
+	timerWheel->attach(socket->Multiplexer());
+}
+
+bool TuioClient::enableStream(int port) {
+	if (socket==NULL) return false;
+	if (streamSocket!=NULL) return true;
+
+	try {
+		streamSocket = new TcpListeningSocket(IpEndpointName( IpEndpointName::ANY_ADDRESS, port ));
+	} catch (std::exception &e) {
+		TUIO_LOG_ERROR("could not bind to TCP port %d", port);
+		return false;
+	}
+	streamReceiver = new TuioStreamReceiver(this);
+	socket->Multiplexer().AttachStreamListener(streamSocket, streamReceiver);
+	TUIO_LOG_INFO("listening to TUIO streams on tcp:%d", port);
+	return true;
+}
+
+bool TuioClient::enableSharedMemory(const char *name, int capacity) {
+	if ((socket==NULL) || (sharedMemory!=NULL)) return (sharedMemory!=NULL);
+
+	sharedMemory = new TuioSharedMemory(name, capacity);
+	if (!sharedMemory->isOpen()) {
+		delete sharedMemory;
+		sharedMemory = NULL;
+		return false;
+	}
+	return true;
+}
+
+#ifndef WIN32
+void* TuioClient::sharedMemoryThreadFunc( void* obj )
+#else
+DWORD WINAPI TuioClient::sharedMemoryThreadFunc( LPVOID obj )
+#endif
+{
+	TuioClient *client = static_cast<TuioClient*>(obj);
+	TuioThreadRoleScope role(client->threadRole, "shared memory");
+	// the packets are local, they have no remote endpoint
+	IpEndpointName local;
+	const char *data;
+	int size;
+	long long sendTime;
+	while (client->sharedMemory->nextPacket(data, size, sendTime)) {
+		client->processPacket(data, size, local, sendTime, false);
+		client->sharedMemory->releasePacket();
+	}
+	return 0;
+}
+
 void TuioClient::ProcessBundle( const ReceivedBundle& b, const IpEndpointName& remoteEndpoint) {
 	
+	TUIO_TRACE_SCOPE("ProcessBundle");
 	try {
 		for( ReceivedBundle::const_iterator i = b.ElementsBegin(); i != b.ElementsEnd(); ++i ){
 			if( i->IsBundle() )
@@ -107,7 +317,7 @@ void TuioClient::ProcessBundle( const ReceivedBundle& b, const IpEndpointName& r
 				ProcessMessage( ReceivedMessage(*i), remoteEndpoint);
 		}
 	} catch (MalformedBundleException& e) {
-		std::cerr << "malformed OSC bundle: " << e.what() << std::endl;
+		TUIO_LOG_ERROR("malformed OSC bundle: %s", e.what());
 	}
 	
 }
@@ -156,10 +366,19 @@ void TuioClient::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNam
 					aliveObjectList.push_back((long)s_id);
 				}
 				
+			} else if (strcmp(cmd,"frag")==0) {
+				
+				int32 fseq, index, count;
+				args >> fseq >> index >> count;
+				beginFragment(objectFragments, frameObjects, fseq, index, count, frameStats);
+				
 			} else if (strcmp(cmd,"fseq")==0) {
 				
 				int32 fseq;
 				args >> fseq;
+				if (!endFragment(objectFragments, frameObjects, frameStats)) return;
+				latency.mark(TuioLatency::DECODE);
+				TuioTraceScope commitScope("fseq commit", "fseq", fseq);
 				bool lateFrame = false;
 				if (fseq>0) {
 					if (fseq>currentFrame) currentTime = TuioTime::getSessionTime();
@@ -224,7 +443,10 @@ void TuioClient::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNam
 										break;
 									}
 								}
-								if(iter==objectList.end()) break;
+								if(iter==objectList.end()) {
+									unlockObjectList();
+									break;
+								}
 								
 								if ( (tobj->getX()!=frameObject->getX() && tobj->getXSpeed()==0) || (tobj->getY()!=frameObject->getY() && tobj->getYSpeed()==0) )
 									frameObject->update(currentTime,tobj->getX(),tobj->getY(),tobj->getAngle());
@@ -239,10 +461,19 @@ void TuioClient::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNam
 						delete tobj;
 					}
 
+					latency.mark(TuioLatency::UPDATE);
+					publishFrameInfo();
+					commitScope.end();
+
+					TuioTraceScope dispatchScope("dispatch", "fseq", fseq);
 					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
 						(*listener)->refresh(currentTime);
+					latency.commit();
+					frameStats.frame((int)cursorList.size());
 					
 				} else {
+					latency.discard();
+					frameStats.lateFrame();
 					for (std::list<TuioObject*>::iterator iter=frameObjects.begin(); iter != frameObjects.end(); iter++) {
 						TuioObject *tobj = (*iter);
 						delete tobj;
@@ -289,10 +520,19 @@ void TuioClient::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNam
 					aliveCursorList.push_back((long)s_id);
 				}
 				
+			} else if (strcmp(cmd,"frag")==0) {
+				
+				int32 fseq, index, count;
+				args >> fseq >> index >> count;
+				beginFragment(cursorFragments, frameCursors, fseq, index, count, frameStats);
+				
 			} else if( strcmp( cmd, "fseq" ) == 0 ){
 				
 				int32 fseq;
 				args >> fseq;
+				if (!endFragment(cursorFragments, frameCursors, frameStats)) return;
+				latency.mark(TuioLatency::DECODE);
+				TuioTraceScope commitScope("fseq commit", "fseq", fseq);
 				bool lateFrame = false;
 				if (fseq>0) {
 					if (fseq>currentFrame) currentTime = TuioTime::getSessionTime();
@@ -420,10 +660,19 @@ void TuioClient::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNam
 						}	
 					}
 					
+					latency.mark(TuioLatency::UPDATE);
+					publishFrameInfo();
+					commitScope.end();
+
+					TuioTraceScope dispatchScope("dispatch", "fseq", fseq);
 					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
 						(*listener)->refresh(currentTime);
+					latency.commit();
+					frameStats.frame((int)cursorList.size());
 					
 				} else {
+					latency.discard();
+					frameStats.lateFrame();
 					for (std::list<TuioCursor*>::iterator iter=frameCursors.begin(); iter != frameCursors.end(); iter++) {
 						TuioCursor *tcur = (*iter);
 						delete tcur;
@@ -434,38 +683,57 @@ void TuioClient::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNam
 			}
 		}
 	} catch( Exception& e ){
-		std::cerr << "error parsing TUIO message: "<< msg.AddressPattern() <<  " - " << e.what() << std::endl;
+		TUIO_LOG_ERROR("error parsing TUIO message: %s - %s", msg.AddressPattern(), e.what());
 	}
 }
 
 void TuioClient::ProcessPacket( const char *data, int size, const IpEndpointName& remoteEndpoint ) {
-	try {
+	if (checkBackend) {
+		checkBackend = false;
+		if (socket->Multiplexer().ActiveBackend()!=SocketReceiveMultiplexer::IO_URING_BACKEND)
+			TUIO_LOG_WARNING("io_uring needs Linux 6.0 and no TCP ports, falling back to select()");
+	}
+	processPacket(data, size, remoteEndpoint, (socket!=NULL)?socket->LastReceiveTime():0, true);
+}
+
+void TuioClient::processPacket( const char *data, int size, const IpEndpointName& remoteEndpoint, long long receiveTime, bool retainable ) {
+	if (sharedMemory!=NULL) packetMutex.lock();
+	if (relay!=NULL) relay->forward(data, size, retainable);
+	if (decodePackets) try {
+		if (receiveTime!=0) {
+			latency.markFirst(TuioLatency::RECEIVE, receiveTime);
+			// from the arrival of the packet until the receive loop picked it up
+			if (TuioTrace::isEnabled()) TuioTrace::complete("wakeup", receiveTime, GetCurrentTimeNanoseconds(), "bytes", size);
+		}
+		TUIO_TRACE_SCOPE("ProcessPacket", "bytes", size);
 		ReceivedPacket p( data, size );
 		if(p.IsBundle()) ProcessBundle( ReceivedBundle(p), remoteEndpoint);
 		else ProcessMessage( ReceivedMessage(p), remoteEndpoint);
 	} catch (MalformedBundleException& e) {
-		std::cerr << "malformed OSC bundle: " << e.what() << std::endl;
+		TUIO_LOG_ERROR("malformed OSC bundle: %s", e.what());
+	} catch (Exception& e) {
+		// malformed packets and messages inside bundles must not end the receive loop
+		TUIO_LOG_ERROR("malformed OSC packet: %s", e.what());
 	}
+	if (sharedMemory!=NULL) packetMutex.unlock();
 }
 
 void TuioClient::connect(bool lk) {
 
-#ifndef WIN32	
-	/*pthread_mutexattr_settype(&attr_p, PTHREAD_MUTEX_RECURSIVE);
-	pthread_mutex_init(&cursorMutex,&attr_p);
-	pthread_mutex_init(&objectMutex,&attr_p);*/
-	pthread_mutex_init(&cursorMutex,NULL);
-	pthread_mutex_init(&objectMutex,NULL);	
-#else
-	cursorMutex = CreateMutex(NULL,FALSE,TEXT("cursorMutex"));
-	objectMutex = CreateMutex(NULL,FALSE,TEXT("objectMutex"));
-#endif		
-		
 	if (socket==NULL) return;
 	TuioTime::initSession();
 	currentTime.reset();
 	
 	locked = lk;
+	connected = true;
+	if (sharedMemory!=NULL) {
+#ifndef WIN32
+		pthread_create(&sharedMemoryThread, NULL, sharedMemoryThreadFunc, this);
+#else
+		DWORD threadId;
+		sharedMemoryThread = CreateThread( 0, 0, sharedMemoryThreadFunc, this, 0, &threadId );
+#endif
+	}
 	if (!locked) {
 #ifndef WIN32
 		pthread_create(&thread , NULL, ClientThreadFunc, this);
@@ -473,36 +741,53 @@ void TuioClient::connect(bool lk) {
 		DWORD threadId;
 		thread = CreateThread( 0, 0, ClientThreadFunc, this, 0, &threadId );
 #endif
-	} else socket->Run();
-	
-	connected = true;
-	unlockCursorList();
-	unlockObjectList();
+	} else {
+		TuioThreadRoleScope role(threadRole, "receive");
+		socket->Run();
+	}
+}
+
+void TuioClient::interrupt() {
+	if (socket!=NULL) socket->AsynchronousBreak();
 }
 
 void TuioClient::disconnect() {
 	
 	if (socket==NULL) return;
-	socket->Break();
+	// Break() only takes effect once the next packet arrives
+	socket->AsynchronousBreak();
 	
 	if (!locked) {
-#ifdef WIN32
-		if( thread ) CloseHandle( thread );
+		// wait for the receiving thread before its lists are cleared
+#ifndef WIN32
+		if (connected) pthread_join(thread, NULL);
+#else
+		if( thread ) {
+			WaitForSingleObject( thread, INFINITE );
+			CloseHandle( thread );
+		}
 #endif
 		thread = 0;
 		locked = false;
 	}
-	
-#ifndef WIN32	
-	pthread_mutex_destroy(&cursorMutex);
-	pthread_mutex_destroy(&objectMutex);
+
+	if ((sharedMemory!=NULL) && connected) {
+		sharedMemory->breakReceive();
+#ifndef WIN32
+		pthread_join(sharedMemoryThread, NULL);
 #else
-	CloseHandle(cursorMutex);
-	CloseHandle(objectMutex);
+		WaitForSingleObject( sharedMemoryThread, INFINITE );
+		CloseHandle( sharedMemoryThread );
 #endif
+	}
+	
+	lockObjectList();
+	lockCursorList();
 
 	aliveObjectList.clear();
 	aliveCursorList.clear();
+	discardFragments(objectFragments, frameObjects);
+	discardFragments(cursorFragments, frameCursors);
 
 	for (std::list<TuioObject*>::iterator iter=objectList.begin(); iter != objectList.end(); iter++)
 		delete (*iter);
@@ -516,6 +801,9 @@ void TuioClient::disconnect() {
 		delete(*iter);
 	freeCursorList.clear();
 
+	unlockCursorList();
+	unlockObjectList();
+
 	connected = false;
 }
 
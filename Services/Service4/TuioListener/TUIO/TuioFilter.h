@@ -0,0 +1,144 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOFILTER_H
+#define INCLUDED_TUIOFILTER_H
+
+// One Euro defaults for normalized coordinates: cutoff in Hz at rest, cutoff increase per surface width per second
+#define ONE_EURO_MIN_CUTOFF 1.0f
+#define ONE_EURO_BETA 40.0f
+#define ONE_EURO_DERIVATIVE_CUTOFF 2.0f
+// Kalman defaults for normalized coordinates: acceleration noise density and measurement variance
+#define KALMAN_PROCESS_NOISE 1.0f
+#define KALMAN_MEASUREMENT_NOISE 0.000004f
+// a contact that was not seen for this many seconds starts over
+#define FILTER_RESET_TIME 0.5
+
+namespace TUIO {
+
+	/**
+	 * The filter state of one contact. The caller keeps it along with the contact, so that
+	 * filtering never allocates, and initializes it with {@link TuioFilter#reset}.
+	 */
+	struct TuioFilterState {
+		double time;
+		// One Euro: the filtered position and speed
+		float x, y, dx, dy;
+		// Kalman: position and velocity per axis, and their covariance p00 p01 p11
+		float kx[2], ky[2];
+		float px[3], py[3];
+	};
+
+	/**
+	 * <p>The TuioFilter smoothes the jitter of contact positions from noisy optical trackers, which
+	 * otherwise causes spurious inertia and extra HID reports. It is stateless, the state of every
+	 * contact is a {@link TuioFilterState} kept by the caller, and filtering a position costs a few
+	 * dozen floating point operations.</p>
+	 *
+	 * <p>The One Euro filter (Casiez et al., CHI 2012) is a low pass filter whose cutoff frequency
+	 * rises with the speed of the contact, so it smoothes resting contacts strongly and adds little
+	 * lag to fast ones. The Kalman filter assumes a constant velocity with random accelerations, it
+	 * follows steady motion without lag but overshoots sudden stops.</p>
+	 */
+	class TuioFilter {
+
+	public:
+		enum FilterType { NONE, ONE_EURO, KALMAN };
+
+		/**
+		 * Creates a filter that passes the positions unchanged
+		 */
+		TuioFilter();
+
+		/**
+		 * Selects the One Euro filter
+		 *
+		 * @param  minCutoff	the cutoff frequency of a resting contact in Hz, lower values smooth more
+		 * @param  beta	the increase of the cutoff frequency per surface width per second, higher values lag less
+		 * @param  derivativeCutoff	the cutoff frequency of the speed estimate in Hz
+		 */
+		void setOneEuro(float minCutoff=ONE_EURO_MIN_CUTOFF, float beta=ONE_EURO_BETA, float derivativeCutoff=ONE_EURO_DERIVATIVE_CUTOFF);
+
+		/**
+		 * Selects the constant velocity Kalman filter
+		 *
+		 * @param  processNoise	the spectral density of the acceleration, higher values follow changes faster
+		 * @param  measurementNoise	the variance of the measured positions, higher values smooth more
+		 */
+		void setKalman(float processNoise=KALMAN_PROCESS_NOISE, float measurementNoise=KALMAN_MEASUREMENT_NOISE);
+
+		/**
+		 * Passes the positions unchanged
+		 */
+		void disable() { type = NONE; }
+
+		/**
+		 * Returns the selected filter
+		 * @return	the selected filter
+		 */
+		FilterType getType() const { return type; }
+
+		/**
+		 * Configures the filter from a line like "oneeuro 1.0 40 2.0", "kalman 1.0 0.000004" or "none",
+		 * missing parameters keep their defaults
+		 *
+		 * @param  config	the configuration line
+		 * @return	false if the line could not be parsed, the filter is disabled then
+		 */
+		bool configure(const char *config);
+
+		/**
+		 * Starts filtering a new contact at the provided position
+		 *
+		 * @param  state	the filter state of the contact
+		 * @param  x	the position
+		 * @param  y	the position
+		 * @param  time	the time of the position in seconds
+		 */
+		void reset(TuioFilterState &state, float x, float y, double time) const;
+
+		/**
+		 * Filters the next position of a contact
+		 *
+		 * @param  state	the filter state of the contact
+		 * @param  x	the measured position, replaced by the filtered one
+		 * @param  y	the measured position, replaced by the filtered one
+		 * @param  time	the time of the position in seconds
+		 */
+		void apply(TuioFilterState &state, float &x, float &y, double time) const;
+
+		/**
+		 * Returns the smoothed position of a contact, without the prediction that follows the filter
+		 *
+		 * @param  state	the filter state of the contact
+		 * @param  x	the last measured position, replaced by the smoothed one unless the filter is disabled
+		 * @param  y	the last measured position, replaced by the smoothed one unless the filter is disabled
+		 */
+		void getPosition(const TuioFilterState &state, float &x, float &y) const;
+
+	private:
+		void applyOneEuro(TuioFilterState &state, float &x, float &y, float dt) const;
+		void applyKalman(TuioFilterState &state, float &x, float &y, float dt) const;
+
+		FilterType type;
+		float minCutoff, beta, derivativeCutoff;
+		float processNoise, measurementNoise;
+	};
+};
+#endif /* INCLUDED_TUIOFILTER_H */
@@ -0,0 +1,130 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOPREDICTION_H
+#define INCLUDED_TUIOPREDICTION_H
+
+// the largest extrapolation in surface widths, the error when a contact stops or turns unexpectedly
+#define PREDICTION_MAX_DISTANCE 0.05f
+// contacts slower than this in surface widths per second are not extrapolated, their speed is mostly jitter
+#define PREDICTION_MIN_SPEED 0.1f
+// the part of the full extrapolation regained per update after a change of direction
+#define PREDICTION_RECOVERY 0.25f
+
+namespace TUIO {
+
+	/**
+	 * The prediction state of one contact. The caller keeps it along with the contact and
+	 * initializes it with {@link TuioPrediction#reset}.
+	 */
+	struct TuioPredictionState {
+		// the velocity of the previous update and the current part of the extrapolation
+		float xSpeed, ySpeed;
+		float damping;
+	};
+
+	/**
+	 * <p>The TuioPrediction compensates the latency between a sensor and the screen by extrapolating
+	 * every contact forward along the speed and acceleration of its {@link TuioContainer}, so that a
+	 * dragged object follows the finger more closely.</p>
+	 *
+	 * <p>The extrapolation follows a decelerating contact only up to where it would stop, is bounded
+	 * by a maximum distance and is left out for slow contacts, whose speed is mostly jitter. When a
+	 * contact changes its direction the extrapolation is damped by the cosine of the turn and then
+	 * regained over a few updates, so it does not shoot past corners and reversals.</p>
+	 */
+	class TuioPrediction {
+
+	public:
+		/**
+		 * Creates a prediction that leaves the positions unchanged
+		 */
+		TuioPrediction();
+
+		/**
+		 * Sets the latency to compensate
+		 *
+		 * @param  seconds	the latency in seconds, 0 disables the prediction
+		 * @param  automatic	adds the latency measured with {@link #setMeasuredLatency}
+		 */
+		void setLatency(float seconds, bool automatic=false);
+
+		/**
+		 * Sets the latency of the pipeline as it is measured, which is added to the configured
+		 * latency if the prediction is automatic
+		 *
+		 * @param  seconds	the measured latency in seconds
+		 */
+		void setMeasuredLatency(float seconds) { measuredLatency = seconds; }
+
+		/**
+		 * Returns the latency that is compensated
+		 * @return	the latency in seconds
+		 */
+		float getLatency() const { return automatic ? latency+measuredLatency : latency; }
+
+		/**
+		 * Returns true if the latency is measured
+		 * @return	true if the latency is measured
+		 */
+		bool isAutomatic() const { return automatic; }
+
+		/**
+		 * Sets the largest extrapolation
+		 *
+		 * @param  distance	the largest distance in surface widths
+		 */
+		void setMaxDistance(float distance) { maxDistance = distance; }
+
+		/**
+		 * Configures the prediction from a line like "16", "16 0.05", "auto", "auto 8 0.05" or "none",
+		 * the latency in milliseconds, measured or measured plus the given latency with "auto",
+		 * and the largest distance
+		 *
+		 * @param  config	the configuration line
+		 * @return	false if the line could not be parsed, the prediction is disabled then
+		 */
+		bool configure(const char *config);
+
+		/**
+		 * Starts predicting a new contact
+		 *
+		 * @param  state	the prediction state of the contact
+		 */
+		void reset(TuioPredictionState &state) const;
+
+		/**
+		 * Extrapolates a position
+		 *
+		 * @param  state	the prediction state of the contact
+		 * @param  x	the position, replaced by the predicted one
+		 * @param  y	the position, replaced by the predicted one
+		 * @param  xSpeed	the velocity of the contact in surface widths per second
+		 * @param  ySpeed	the velocity of the contact in surface heights per second
+		 * @param  motionAccel	the change of the speed in surface widths per second squared
+		 */
+		void apply(TuioPredictionState &state, float &x, float &y, float xSpeed, float ySpeed, float motionAccel) const;
+
+	private:
+		float latency, measuredLatency;
+		bool automatic;
+		float maxDistance;
+	};
+};
+#endif /* INCLUDED_TUIOPREDICTION_H */
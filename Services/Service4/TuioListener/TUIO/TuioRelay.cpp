@@ -0,0 +1,376 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioRelay.h"
+#include "TuioAtomic.h"
+#include "TuioLog.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace TUIO;
+
+// the most packets sent to one destination per wakeup
+#define TUIO_RELAY_BATCH 64
+
+namespace TUIO {
+
+	// one destination with its single producer, single consumer queue. head is
+	// advanced by the forwarding thread, tail by the sender thread
+	struct TuioRelayDestination {
+		UdpTransmitSocket *socket;
+		char name[IpEndpointName::ADDRESS_AND_PORT_STRING_LENGTH+8];
+		const char **data;
+		int *size;
+		volatile long head;
+		volatile long tail;
+		volatile long long sent;
+		volatile long long dropped;
+		long long sentBaseline;
+		long long droppedBaseline;
+		bool warned;
+	};
+};
+
+TuioRelay::TuioRelay(int length, const TuioThreadRole &role)
+: queueLength (1)
+, threadRole  (role)
+, forwarding  (false)
+, running     (1)
+, waiting     (0)
+{
+	while (queueLength<length) queueLength <<= 1;
+
+#ifndef WIN32
+	pthread_mutex_init(&wakeMutex, NULL);
+	pthread_cond_init(&wakeCondition, NULL);
+	pthread_create(&senderThread, NULL, senderThreadFunc, this);
+#else
+	wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	DWORD threadId;
+	senderThread = CreateThread(0, 0, senderThreadFunc, this, 0, &threadId);
+#endif
+	TuioStats::addSource(this);
+}
+
+TuioRelay::~TuioRelay() {
+	TuioStats::removeSource(this);
+	stop();
+
+#ifndef WIN32
+	pthread_mutex_destroy(&wakeMutex);
+	pthread_cond_destroy(&wakeCondition);
+#else
+	CloseHandle(wakeEvent);
+#endif
+
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++) {
+		delete (*iter)->socket;
+		delete[] (*iter)->data;
+		delete[] (*iter)->size;
+		delete *iter;
+	}
+}
+
+bool TuioRelay::addDestination(const char *host, int port) {
+	if (forwarding) return false;
+
+	UdpTransmitSocket *socket;
+	try {
+		socket = new UdpTransmitSocket(IpEndpointName(host, port));
+	} catch (std::exception &e) {
+		TUIO_LOG_ERROR("could not relay to %s:%d", host, port);
+		return false;
+	}
+
+	TuioRelayDestination *destination = new TuioRelayDestination();
+	destination->socket = socket;
+	strcpy(destination->name, "relay:");
+	IpEndpointName(host, port).AddressAndPortAsString(destination->name+6);
+	destination->data = new const char*[queueLength];
+	destination->size = new int[queueLength];
+	destination->head = 0;
+	destination->tail = 0;
+	destination->sent = 0;
+	destination->dropped = 0;
+	destination->sentBaseline = 0;
+	destination->droppedBaseline = 0;
+	destination->warned = false;
+	destinationList.push_back(destination);
+
+	TUIO_LOG_INFO("relaying TUIO to %s", destination->name+6);
+	return true;
+}
+
+void TuioRelay::forward(const char *data, int size, bool retainable) {
+	if (destinationList.empty() || !atomicLoad(&running)) return;
+	forwarding = true;
+
+	// packets from streams and shared memory are copied into a buffer of our own once
+	if (!retainable) {
+		if (size>RECEIVE_BUFFER_SIZE) return;
+		char *copy = bufferPool.Acquire();
+		memcpy(copy, data, size);
+		data = copy;
+	}
+
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++) {
+		TuioRelayDestination *destination = *iter;
+		long head = destination->head;
+		if (head-atomicLoad(&destination->tail)>=queueLength) {
+			atomicAdd64(&destination->dropped, 1);
+			if (!destination->warned) {
+				TUIO_LOG_WARNING("%s can't keep up, dropping packets", destination->name);
+				destination->warned = true;
+			}
+			continue;
+		}
+
+		RetainReceiveBuffer(data);
+		destination->data[head&(queueLength-1)] = data;
+		destination->size[head&(queueLength-1)] = size;
+		atomicStore(&destination->head, head+1);
+	}
+
+	if (!retainable) ReleaseReceiveBuffer(data);
+	// the sending thread sets the flag before it looks at the queues a last time, with the
+	// fences on both sides either it sees these packets or this sees it waiting
+	atomicFence();
+	if (atomicLoad(&waiting) && atomicExchange(&waiting, 0)) wake();
+}
+
+// sends what is queued, up to one batch per destination. returns the number
+// of destinations that still have packets queued
+int TuioRelay::send() {
+	const char *data[TUIO_RELAY_BATCH];
+	int size[TUIO_RELAY_BATCH];
+	int pending = 0;
+
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++) {
+		TuioRelayDestination *destination = *iter;
+		long tail = destination->tail;
+		long queued = atomicLoad(&destination->head)-tail;
+		if (queued==0) continue;
+
+		int count = (queued<TUIO_RELAY_BATCH) ? (int)queued : TUIO_RELAY_BATCH;
+		for (int i=0; i<count; i++) {
+			data[i] = destination->data[(tail+i)&(queueLength-1)];
+			size[i] = destination->size[(tail+i)&(queueLength-1)];
+		}
+
+		int sent = destination->socket->SendMultiple(data, size, count);
+		for (int i=0; i<sent; i++) ReleaseReceiveBuffer(data[i]);
+		atomicAdd64(&destination->sent, sent);
+		atomicStore(&destination->tail, tail+sent);
+
+		if (queued>sent) pending++;
+		else destination->warned = false;
+	}
+	return pending;
+}
+
+void TuioRelay::waitForPackets() {
+#ifndef WIN32
+	struct timespec timeout;
+	clock_gettime(CLOCK_REALTIME, &timeout);
+	timeout.tv_nsec += 100*1000000;
+	if (timeout.tv_nsec>=1000000000) {
+		timeout.tv_sec++;
+		timeout.tv_nsec -= 1000000000;
+	}
+	pthread_mutex_lock(&wakeMutex);
+	atomicStore(&waiting, 1);
+	// a packet forwarded before the flag was set would not wake us
+	atomicFence();
+	bool empty = true;
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++)
+		if (atomicLoad(&(*iter)->head)!=(*iter)->tail) empty = false;
+	if (empty && atomicLoad(&running)) pthread_cond_timedwait(&wakeCondition, &wakeMutex, &timeout);
+	atomicStore(&waiting, 0);
+	pthread_mutex_unlock(&wakeMutex);
+#else
+	atomicStore(&waiting, 1);
+	atomicFence();
+	bool empty = true;
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++)
+		if (atomicLoad(&(*iter)->head)!=(*iter)->tail) empty = false;
+	if (empty && atomicLoad(&running)) WaitForSingleObject(wakeEvent, 100);
+	atomicStore(&waiting, 0);
+#endif
+}
+
+void TuioRelay::wake() {
+#ifndef WIN32
+	pthread_mutex_lock(&wakeMutex);
+	pthread_cond_signal(&wakeCondition);
+	pthread_mutex_unlock(&wakeMutex);
+#else
+	SetEvent(wakeEvent);
+#endif
+}
+
+#ifndef WIN32
+void* TuioRelay::senderThreadFunc( void* obj )
+#else
+DWORD WINAPI TuioRelay::senderThreadFunc( LPVOID obj )
+#endif
+{
+	TuioRelay *relay = static_cast<TuioRelay*>(obj);
+	TuioThreadRoleScope role(relay->threadRole, "relay");
+	while (atomicLoad(&relay->running)) {
+		int pending = relay->send();
+		if (pending==0) relay->waitForPackets();
+		else if (pending==(int)relay->destinationList.size()) {
+			// every destination with packets is blocked, give the send buffers time to drain
+#ifndef WIN32
+			usleep(1000);
+#else
+			Sleep(1);
+#endif
+		}
+	}
+	return 0;
+}
+
+void TuioRelay::releaseQueued() {
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++) {
+		TuioRelayDestination *destination = *iter;
+		for (long i=destination->tail; i!=destination->head; i++)
+			ReleaseReceiveBuffer(destination->data[i&(queueLength-1)]);
+		destination->tail = destination->head;
+	}
+}
+
+void TuioRelay::stop() {
+	if (!atomicExchange(&running, 0)) return;
+
+	wake();
+#ifndef WIN32
+	pthread_join(senderThread, NULL);
+#else
+	WaitForSingleObject(senderThread, INFINITE);
+	CloseHandle(senderThread);
+	senderThread = NULL;
+#endif
+	releaseQueued();
+}
+
+long long TuioRelay::getSentPackets(int index) const {
+	return atomicLoad64(&destinationList[index]->sent);
+}
+
+long long TuioRelay::getDroppedPackets(int index) const {
+	return atomicLoad64(&destinationList[index]->dropped);
+}
+
+void TuioRelay::writeStats(TuioStatsReport &report) {
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++) {
+		TuioRelayDestination *destination = *iter;
+		report.beginSection(destination->name);
+		report.addValue("sent", atomicLoad64(&destination->sent)-destination->sentBaseline);
+		report.addValue("dropped", atomicLoad64(&destination->dropped)-destination->droppedBaseline);
+		report.addValue("queued", atomicLoad(&destination->head)-atomicLoad(&destination->tail));
+	}
+}
+
+void TuioRelay::resetStats() {
+	for (std::vector<TuioRelayDestination*>::iterator iter=destinationList.begin(); iter!=destinationList.end(); iter++) {
+		(*iter)->sentBaseline = atomicLoad64(&(*iter)->sent);
+		(*iter)->droppedBaseline = atomicLoad64(&(*iter)->dropped);
+	}
+}
+
+TuioCalibratedRelay::TuioCalibratedRelay(TuioServer *s)
+: server   (s)
+, frameOpen(false)
+{
+}
+
+void TuioCalibratedRelay::setCalibration(bool ix, bool iy, float x0, float x1, float y0, float y1, bool swap) {
+	calibration.setInvert(ix, iy);
+	calibration.setRange(x0, x1, y0, y1);
+	calibration.setSwap(swap);
+}
+
+void TuioCalibratedRelay::beginFrame() {
+	if (frameOpen) return;
+	server->initFrame(TuioTime::getSessionTime());
+	frameOpen = true;
+}
+
+void TuioCalibratedRelay::addTuioObject(TuioObject *tobj) {
+	float x = tobj->getX(), y = tobj->getY(), angle = tobj->getAngle();
+	calibration.apply(x, y, angle);
+	beginFrame();
+	objectMap[tobj->getSessionID()] = server->addTuioObject(tobj->getSymbolID(), x, y, angle);
+}
+
+void TuioCalibratedRelay::updateTuioObject(TuioObject *tobj) {
+	std::map<long, TuioObject*>::iterator iter = objectMap.find(tobj->getSessionID());
+	if (iter==objectMap.end()) return;
+	float x = tobj->getX(), y = tobj->getY(), angle = tobj->getAngle();
+	calibration.apply(x, y, angle);
+	beginFrame();
+	server->updateTuioObject(iter->second, x, y, angle);
+}
+
+void TuioCalibratedRelay::removeTuioObject(TuioObject *tobj) {
+	std::map<long, TuioObject*>::iterator iter = objectMap.find(tobj->getSessionID());
+	if (iter==objectMap.end()) return;
+	beginFrame();
+	server->removeTuioObject(iter->second);
+	objectMap.erase(iter);
+}
+
+void TuioCalibratedRelay::addTuioCursor(TuioCursor *tcur) {
+	float x = tcur->getX(), y = tcur->getY(), angle = 0;
+	calibration.apply(x, y, angle);
+	beginFrame();
+	cursorMap[tcur->getSessionID()] = server->addTuioCursor(x, y);
+}
+
+void TuioCalibratedRelay::updateTuioCursor(TuioCursor *tcur) {
+	std::map<long, TuioCursor*>::iterator iter = cursorMap.find(tcur->getSessionID());
+	if (iter==cursorMap.end()) return;
+	float x = tcur->getX(), y = tcur->getY(), angle = 0;
+	calibration.apply(x, y, angle);
+	beginFrame();
+	server->updateTuioCursor(iter->second, x, y);
+}
+
+void TuioCalibratedRelay::removeTuioCursor(TuioCursor *tcur) {
+	std::map<long, TuioCursor*>::iterator iter = cursorMap.find(tcur->getSessionID());
+	if (iter==cursorMap.end()) return;
+	beginFrame();
+	server->removeTuioCursor(iter->second);
+	cursorMap.erase(iter);
+}
+
+void TuioCalibratedRelay::refresh(TuioTime frameTime) {
+	beginFrame();
+	server->commitFrame();
+	frameOpen = false;
+}
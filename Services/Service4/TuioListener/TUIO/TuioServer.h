@@ -31,6 +31,8 @@
 
 #include <iostream>
 #include <list>
+#include <map>
+#include <vector>
 #include <algorithm>
 
 #include "osc/OscOutboundPacketStream.h"
@@ -39,12 +41,25 @@
 
 #include "TuioObject.h"
 #include "TuioCursor.h"
+#include "TuioLock.h"
+#include "TuioSharedMemory.h"
+#include "TuioTimerWheel.h"
 
 #define IP_MTU_SIZE 1500
 #define MAX_UDP_SIZE 65536
 #define MIN_UDP_SIZE 576
-#define OBJ_MESSAGE_SIZE 108	// setMessage + seqMessage size
-#define CUR_MESSAGE_SIZE 88
+#define IPV4_HEADER_SIZE 20
+#define IPV6_HEADER_SIZE 40
+#define UDP_HEADER_SIZE 8
+
+// the exact sizes of the elements of a TUIO bundle, including their OSC size prefix
+#define BUNDLE_HEADER_SIZE 16
+#define OBJ_MESSAGE_SIZE 76	// object set message
+#define CUR_MESSAGE_SIZE 56	// cursor set message
+#define FSEQ_MESSAGE_SIZE 32
+#define FRAG_MESSAGE_SIZE 44
+
+#define KEYFRAME_INTERVAL 30
 
 namespace TUIO {
 	/**
@@ -75,7 +90,7 @@ namespace TUIO {
 	 * @author Martin Kaltenbrunner
 	 * @version 1.4
 	 */ 
-	class TuioServer { 
+	class TuioServer : public TimerListener { 
 		
 	public:
 
@@ -87,9 +102,9 @@ namespace TUIO {
 
 		/**
 		 * This constructor creates a TuioServer that sends to the provided port on the the given host
-		 * using a default packet size of 1492 bytes to deliver unfragmented UDP packets on a LAN
+		 * using packets that fit into the 1500 bytes MTU of an Ethernet LAN without IP fragmentation
 		 *
-		 * @param  host  the receiving host name
+		 * @param  host  the receiving host name, IPv4 or IPv6 address, or multicast group
 		 * @param  port  the outgoing TUIO UDP port number
 		 */
 		TuioServer(const char *host, int port);
@@ -98,12 +113,21 @@ namespace TUIO {
 		 * This constructor creates a TuioServer that sends to the provided port on the the given host
 		 * the packet UDP size can be set to a value between 576 and 65536 bytes
 		 *
-		 * @param  host  the receiving host name
+		 * @param  host  the receiving host name, IPv4 or IPv6 address, or multicast group
 		 * @param  port  the outgoing TUIO UDP port number
 		 * @param  size  the maximum UDP packet size
 		 */
 		TuioServer(const char *host, int port, int size);
 
+		/**
+		 * This constructor creates a TuioServer that writes to a shared memory ring
+		 * which a TuioClient on the same machine reads, see {@link TuioClient::enableSharedMemory}.
+		 * The packet size is limited by the ring.
+		 *
+		 * @param  sharedMemory  the ring, it has to outlive the TuioServer
+		 */
+		TuioServer(TuioSharedMemory *sharedMemory);
+
 		/**
 		 * The destructor is doing nothing in particular. 
 		 */
@@ -249,17 +273,80 @@ namespace TUIO {
 		void sendFullMessages();		
 
 		/**
-		 * Disables the periodic full update of all currently active TuioObjects and TuioCursors 
+		 * Sets the largest UDP payload. Frames that do not fit into one packet are split into fragments,
+		 * which all repeat the alive message and carry the frame ID in their fseq message. A frag message
+		 * numbers the fragments, so that a TuioClient only commits the frame once all of them arrived.
+		 * Other TUIO clients ignore it and apply each fragment on its own.
+		 *
+		 * @param	size	the maximum UDP packet size between 576 and 65536 bytes
+		 */
+		void setMaxPacketSize(int size);
+
+		/**
+		 * Sizes the packets to fit into the provided MTU of the path to the receiver, after the IP and UDP headers
+		 *
+		 * @param	mtu	the MTU in bytes, 1500 on Ethernet
+		 */
+		void setMTU(int mtu);
+
+		/**
+		 * Returns the largest UDP payload.
+		 * @return	the largest UDP payload in bytes
+		 */
+		int getMaxPacketSize() {
+			return max_packet_size;
+		}
+
+		/**
+		 * Enables the delta update, which only sends the TuioObjects and TuioCursors that changed since
+		 * they were last sent, and all of them in periodic keyframes, so that receivers recover from lost packets
+		 *
+		 * @param	keyframeInterval	the number of frames between two keyframes
+		 */
+		void enableDeltaUpdate(int keyframeInterval=KEYFRAME_INTERVAL);
+
+		/**
+		 * Disables the delta update, all updated TuioObjects and TuioCursors are sent in every frame
+		 */
+		void disableDeltaUpdate();
+
+		/**
+		 * Returns true if the delta update is enabled.
+		 * @return	true if the delta update is enabled
+		 */
+		bool deltaUpdateEnabled() {
+			return delta_update;
+		}
+
+		/**
+		 * Enables the periodic full update of all currently active TuioObjects and TuioCursors 
 		 *
 		 * @param	interval	update interval in seconds, defaults to one second
 		 */
 		void enablePeriodicMessages(int interval=1);
 
+		/**
+		 * Enables the periodic full update of all currently active TuioObjects and TuioCursors
+		 * with an update period below one second, for example TuioTime(250) for four updates per second
+		 *
+		 * @param	period	the update period, rounded up to the resolution of the timer wheel
+		 */
+		void enablePeriodicMessages(TuioTime period);
+
 		/**
 		 * Disables the periodic full update of all currently active and inactive TuioObjects and TuioCursors 
 		 */
 		void disablePeriodicMessages();
 
+		/**
+		 * Sends the periodic full update on the provided timer wheel instead of the shared one, for example
+		 * on a wheel attached to the TuioClient whose listener feeds this server. Has to be called
+		 * before the periodic messages are enabled.
+		 *
+		 * @param	wheel	the timer wheel, owned by the caller, or NULL for the shared timer wheel
+		 */
+		void setTimerWheel(TuioTimerWheel *wheel);
+
 		/**
 		 * Enables the full update of all currently active and inactive TuioObjects and TuioCursors 
 		 *
@@ -290,6 +377,19 @@ namespace TUIO {
 		int getUpdateInterval() {
 			return update_interval;
 		}
+
+		/**
+		 * Returns the periodic update period.
+		 * @return	the periodic update period
+		 */
+		TuioTime getUpdatePeriod() {
+			return update_period;
+		}
+
+		/**
+		 * Sends the periodic full update, called by the timer wheel
+		 */
+		void TimerExpired();
 		
 		/**
 		 * Returns a List of all currently inactive TuioObjects
@@ -391,28 +491,61 @@ namespace TUIO {
 		int maxCursorID;
 		std::list<TuioCursor*> freeCursorList;
 		std::list<TuioCursor*> freeCursorBuffer;
+
+		// guards the object and cursor lists against the periodic full update on the timer wheel
+		TuioMutex listMutex;
 		
 		UdpTransmitSocket *socket;	
+		TuioSharedMemory *sharedMemory;
+		// the ring has a single producer, the frame and the periodic full update take turns
+		TuioMutex sendMutex;
 		osc::OutboundPacketStream  *oscPacket;
 		char *oscBuffer; 
 		osc::OutboundPacketStream  *fullPacket;
 		char *fullBuffer; 
 		
 		void initialize(const char *host, int port, int size);
+		void resizeBuffers(int size);
+		void sendPacket(osc::OutboundPacketStream *packet);
 
 		void sendEmptyCursorBundle();
-		void startCursorBundle();
-		void addCursorMessage(TuioCursor *tcur);
-		void sendCursorBundle(long fseq);
+		void startCursorBundle(osc::OutboundPacketStream *packet);
+		void addCursorMessage(osc::OutboundPacketStream *packet, TuioCursor *tcur);
+		void sendCursorBundle(osc::OutboundPacketStream *packet, long fseq);
+		bool selectCursorUpdates(bool keyframe);
+		void sendCursorFrame(osc::OutboundPacketStream *packet, std::vector<TuioCursor*> &updates, long fseq);
 		
 		void sendEmptyObjectBundle();
-		void startObjectBundle();
-		void addObjectMessage(TuioObject *tobj);
-		void sendObjectBundle(long fseq);
+		void startObjectBundle(osc::OutboundPacketStream *packet);
+		void addObjectMessage(osc::OutboundPacketStream *packet, TuioObject *tobj);
+		void sendObjectBundle(osc::OutboundPacketStream *packet, long fseq);
+		bool selectObjectUpdates(bool keyframe);
+		void sendObjectFrame(osc::OutboundPacketStream *packet, std::vector<TuioObject*> &updates, long fseq);
+
+		void addFragmentMessage(osc::OutboundPacketStream *packet, const char *profile, long fseq, int index, int count);
 		
 		bool full_update;
 		int update_interval;
+		TuioTime update_period;
 		bool periodic_update;
+		TuioTimerWheel *timerWheel;
+
+		int max_packet_size;
+		bool ipv6;
+		std::vector<TuioCursor*> cursorUpdates, fullCursors;
+		std::vector<TuioObject*> objectUpdates, fullObjects;
+
+		// the values last sent of each TuioObject and TuioCursor, for the delta update
+		struct TuioSentState {
+			float x, y, angle;
+			float xspeed, yspeed, rspeed, maccel, raccel;
+			long frame;
+		};
+		std::map<long, TuioSentState> sentCursors, sentObjects;
+		bool delta_update;
+		int keyframe_interval;
+		long lastKeyframe;
+		bool warned;
 
 		long currentFrame;
 		TuioTime currentFrameTime;
@@ -422,11 +555,6 @@ namespace TUIO {
 		long sessionID;
 		bool verbose;
 
-#ifndef WIN32
-		pthread_t thread;
-#else
-		HANDLE thread;
-#endif	
 		bool connected;
 	};
 };
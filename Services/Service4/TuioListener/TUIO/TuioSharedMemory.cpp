@@ -0,0 +1,360 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioSharedMemory.h"
+#include "TuioAtomic.h"
+#include "TuioLog.h"
+
+#include "ip/NetworkingUtils.h"
+
+#include <string.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#else
+#include <sddl.h>
+#endif
+
+using namespace TUIO;
+
+#define TUIO_SHARED_MEMORY_MAGIC   0x54554952
+#define TUIO_SHARED_MEMORY_VERSION 1
+#define TUIO_SHARED_MEMORY_WRAP    -1
+
+// the fields of the producer and the consumer are on separate cache lines. all fields are
+// explicitly sized and placed, so that 32 and 64-bit processes agree on the layout
+struct TUIO::TuioSharedMemoryHeader {
+	volatile int magic; // stored last by the creator
+	int version;
+	int capacity;
+	volatile int closed; // set when the consumer goes away
+	char pad0[48];
+
+	// written by the producer
+	volatile long long writePosition;
+	volatile long long sentPackets;
+	volatile long long droppedPackets;
+	volatile int doorbell; // the futex word, advanced for every wakeup
+	int reserved1;
+	char pad1[32];
+
+	// written by the consumer
+	volatile long long readPosition;
+	volatile int consumerWaiting;
+	int reserved2;
+	char pad2[48];
+};
+
+typedef char TuioSharedMemoryHeaderSizeCheck[(sizeof(TuioSharedMemoryHeader)==192)?1:-1];
+
+// every packet is preceded by a record, records start 8 byte aligned.
+// a record that doesn't fit before the end of the ring starts at the
+// beginning, a WRAP size marks the skipped space
+struct TuioSharedMemoryRecord {
+	int size;
+	int reserved;
+	long long sendTime;
+};
+
+static int recordLength(int size) {
+	return (int)sizeof(TuioSharedMemoryRecord) + ((size+7)&~7);
+}
+
+TuioSharedMemory::TuioSharedMemory(const char *n, int c)
+: name        (n)
+, requestedCapacity(c)
+, header      (NULL)
+, ring        (NULL)
+, capacity    (0)
+, consumer    (false)
+, readPosition(0)
+, stopped     (0)
+#ifndef WIN32
+, mappingSize (0)
+#else
+, mapping     (NULL)
+, doorbellEvent(NULL)
+#endif
+{
+	if (open()) TUIO_LOG_INFO("mapped the %d byte TUIO ring %s", capacity, name.c_str());
+}
+
+TuioSharedMemory::~TuioSharedMemory() {
+	close();
+}
+
+#ifndef WIN32
+bool TuioSharedMemory::open() {
+	// a posix shared memory name has a leading and no other slash
+	std::string path = "/";
+	for (size_t i=0; i<name.size(); i++) path += ((name[i]=='/') || (name[i]=='\\')) ? '_' : name[i];
+
+	int size = (int)sizeof(TuioSharedMemoryHeader) + ((requestedCapacity+4095)&~4095);
+	int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	bool created = (fd>=0);
+	if (created) {
+		if (ftruncate(fd, size)!=0) {
+			::close(fd);
+			shm_unlink(path.c_str());
+			fd = -1;
+		}
+	} else if (errno==EEXIST) {
+		fd = shm_open(path.c_str(), O_RDWR, 0600);
+		// the creator may not have sized it yet
+		struct stat status;
+		for (int i=0; (fd>=0) && (i<1000); i++) {
+			if ((fstat(fd, &status)==0) && (status.st_size>=(off_t)sizeof(TuioSharedMemoryHeader))) break;
+			usleep(1000);
+		}
+		size = ((fd>=0) && (fstat(fd, &status)==0)) ? (int)status.st_size : 0;
+	}
+	if ((fd<0) || (size<(int)sizeof(TuioSharedMemoryHeader))) {
+		if (fd>=0) ::close(fd);
+		TUIO_LOG_ERROR("could not map the TUIO ring %s", name.c_str());
+		return false;
+	}
+
+	void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (memory==MAP_FAILED) {
+		TUIO_LOG_ERROR("could not map the TUIO ring %s", name.c_str());
+		return false;
+	}
+	header = (TuioSharedMemoryHeader*)memory;
+	mappingSize = size;
+#else
+bool TuioSharedMemory::open() {
+	// the producer and the consumer may run as different users, a service and a tracker
+	SECURITY_ATTRIBUTES attributes;
+	attributes.nLength = sizeof(attributes);
+	attributes.bInheritHandle = FALSE;
+	attributes.lpSecurityDescriptor = NULL;
+	ConvertStringSecurityDescriptorToSecurityDescriptorA("D:(A;;GA;;;SY)(A;;GA;;;BA)(A;;GA;;;AU)", SDDL_REVISION_1, &attributes.lpSecurityDescriptor, NULL);
+
+	int size = (int)sizeof(TuioSharedMemoryHeader) + ((requestedCapacity+4095)&~4095);
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, &attributes, PAGE_READWRITE, 0, size, name.c_str());
+	bool created = (mapping!=NULL) && (GetLastError()!=ERROR_ALREADY_EXISTS);
+	std::string eventName = name + "_doorbell";
+	doorbellEvent = CreateEventA(&attributes, FALSE, FALSE, eventName.c_str());
+	LocalFree(attributes.lpSecurityDescriptor);
+
+	void *memory = (mapping!=NULL) ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : NULL;
+	if ((memory==NULL) || (doorbellEvent==NULL)) {
+		if (memory!=NULL) UnmapViewOfFile(memory);
+		if (mapping!=NULL) CloseHandle(mapping);
+		if (doorbellEvent!=NULL) CloseHandle(doorbellEvent);
+		mapping = doorbellEvent = NULL;
+		TUIO_LOG_ERROR("could not map the TUIO ring %s", name.c_str());
+		return false;
+	}
+	header = (TuioSharedMemoryHeader*)memory;
+	MEMORY_BASIC_INFORMATION region;
+	VirtualQuery(memory, &region, sizeof(region));
+	size = (int)region.RegionSize;
+#endif
+
+	if (created) {
+		header->version = TUIO_SHARED_MEMORY_VERSION;
+		header->capacity = size-(int)sizeof(TuioSharedMemoryHeader);
+		atomicStore32(&header->magic, TUIO_SHARED_MEMORY_MAGIC);
+	} else {
+		for (int i=0; (i<1000) && (atomicLoad32(&header->magic)!=TUIO_SHARED_MEMORY_MAGIC); i++) {
+#ifndef WIN32
+			usleep(1000);
+#else
+			Sleep(1);
+#endif
+		}
+		if ((atomicLoad32(&header->magic)!=TUIO_SHARED_MEMORY_MAGIC) || (header->version!=TUIO_SHARED_MEMORY_VERSION)
+				|| (header->capacity<=0) || (header->capacity>size-(int)sizeof(TuioSharedMemoryHeader))) {
+			TUIO_LOG_ERROR("the TUIO ring %s has an unknown format", name.c_str());
+			close();
+			return false;
+		}
+	}
+
+	ring = (char*)header + sizeof(TuioSharedMemoryHeader);
+	capacity = header->capacity;
+	return true;
+}
+
+void TuioSharedMemory::close() {
+	if (header==NULL) return;
+
+	// the producer maps the ring of the next consumer
+	if (consumer) atomicStore32(&header->closed, 1);
+
+#ifndef WIN32
+	if (consumer) {
+		std::string path = "/";
+		for (size_t i=0; i<name.size(); i++) path += ((name[i]=='/') || (name[i]=='\\')) ? '_' : name[i];
+		shm_unlink(path.c_str());
+	}
+	munmap(header, mappingSize);
+#else
+	UnmapViewOfFile(header);
+	CloseHandle(mapping);
+	CloseHandle(doorbellEvent);
+	mapping = doorbellEvent = NULL;
+#endif
+	header = NULL;
+	ring = NULL;
+	capacity = 0;
+}
+
+int TuioSharedMemory::getMaxPacketSize() const {
+	return capacity/4;
+}
+
+long long TuioSharedMemory::getSentPackets() const {
+	return (header!=NULL) ? atomicLoad64(&header->sentPackets) : 0;
+}
+
+long long TuioSharedMemory::getDroppedPackets() const {
+	return (header!=NULL) ? atomicLoad64(&header->droppedPackets) : 0;
+}
+
+bool TuioSharedMemory::send(const char *data, int size) {
+	if ((header!=NULL) && atomicLoad32(&header->closed)) {
+		close();
+		if (open()) TUIO_LOG_INFO("mapped the TUIO ring %s of a new consumer", name.c_str());
+	}
+	if (header==NULL) return false;
+	if ((size<=0) || (size>getMaxPacketSize())) {
+		atomicAdd64(&header->droppedPackets, 1);
+		return false;
+	}
+
+	// only the producer writes the write position
+	long long write = header->writePosition;
+	int offset = (int)(write%capacity);
+	int length = recordLength(size);
+	int skip = (offset+length>capacity) ? capacity-offset : 0;
+	if (write+skip+length-atomicLoad64(&header->readPosition)>capacity) {
+		atomicAdd64(&header->droppedPackets, 1);
+		return false;
+	}
+
+	if (skip>0) {
+		((TuioSharedMemoryRecord*)(ring+offset))->size = TUIO_SHARED_MEMORY_WRAP;
+		write += skip;
+		offset = 0;
+	}
+	TuioSharedMemoryRecord *record = (TuioSharedMemoryRecord*)(ring+offset);
+	record->size = size;
+	record->sendTime = GetCurrentTimeNanoseconds();
+	memcpy(ring+offset+sizeof(TuioSharedMemoryRecord), data, size);
+
+	atomicStore64(&header->writePosition, write+length);
+	atomicStore64(&header->sentPackets, header->sentPackets+1);
+
+	// the consumer announces that it sleeps before it looks at the write position a last
+	// time, so either it sees this packet or this sees it waiting. only the first packet
+	// after it fell asleep wakes it
+	atomicFence();
+	if (atomicExchange32(&header->consumerWaiting, 0)) wakeConsumer();
+	return true;
+}
+
+void TuioSharedMemory::wakeConsumer() {
+	atomicAdd32(&header->doorbell, 1);
+#ifdef __linux__
+	syscall(SYS_futex, &header->doorbell, FUTEX_WAKE, 1, NULL, NULL, 0);
+#elif defined(WIN32)
+	SetEvent(doorbellEvent);
+#endif
+}
+
+void TuioSharedMemory::waitForProducer(int doorbell) {
+	// the timeout only guards against a producer that died while ringing
+#ifdef __linux__
+	struct timespec timeout;
+	timeout.tv_sec = 1;
+	timeout.tv_nsec = 0;
+	syscall(SYS_futex, &header->doorbell, FUTEX_WAIT, doorbell, &timeout, NULL, 0);
+#elif defined(WIN32)
+	WaitForSingleObject(doorbellEvent, 1000);
+#else
+	// no futex, poll
+	if (atomicLoad32(&header->doorbell)==doorbell) usleep(1000);
+#endif
+}
+
+bool TuioSharedMemory::nextPacket(const char *&data, int &size, long long &sendTime) {
+	if (header==NULL) return false;
+
+	if (!consumer) {
+		// packets of an earlier session are stale
+		consumer = true;
+		atomicStore32(&header->closed, 0);
+		readPosition = atomicLoad64(&header->writePosition);
+		atomicStore64(&header->readPosition, readPosition);
+	}
+
+	for (;;) {
+		if (atomicExchange(&stopped, 0)) return false;
+
+		if (readPosition!=atomicLoad64(&header->writePosition)) {
+			int offset = (int)(readPosition%capacity);
+			const TuioSharedMemoryRecord *record = (const TuioSharedMemoryRecord*)(ring+offset);
+			if (record->size==TUIO_SHARED_MEMORY_WRAP) {
+				readPosition += capacity-offset;
+				continue;
+			}
+			if ((record->size<=0) || (record->size>getMaxPacketSize()) || (offset+recordLength(record->size)>capacity)) {
+				TUIO_LOG_ERROR("dropped the corrupt TUIO ring %s", name.c_str());
+				readPosition = atomicLoad64(&header->writePosition);
+				atomicStore64(&header->readPosition, readPosition);
+				continue;
+			}
+
+			data = ring+offset+sizeof(TuioSharedMemoryRecord);
+			size = record->size;
+			sendTime = record->sendTime;
+			readPosition += recordLength(size);
+			return true;
+		}
+
+		// the ring is empty, sleep until the producer rings the doorbell
+		int doorbell = atomicLoad32(&header->doorbell);
+		atomicStore32(&header->consumerWaiting, 1);
+		atomicFence();
+		if ((readPosition==atomicLoad64(&header->writePosition)) && !atomicLoad(&stopped))
+			waitForProducer(doorbell);
+		atomicStore32(&header->consumerWaiting, 0);
+	}
+}
+
+void TuioSharedMemory::releasePacket() {
+	if (header!=NULL) atomicStore64(&header->readPosition, readPosition);
+}
+
+void TuioSharedMemory::breakReceive() {
+	atomicStore(&stopped, 1);
+	if (header!=NULL) wakeConsumer();
+}
@@ -0,0 +1,134 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOSUPERVISOR_H
+#define INCLUDED_TUIOSUPERVISOR_H
+
+#ifndef WIN32
+#include <pthread.h>
+#else
+#include <windows.h>
+#endif
+
+#include "TuioClient.h"
+
+// the first delay before a failed sensor is started again, in milliseconds
+#define TUIO_SUPERVISOR_INITIAL_DELAY 500
+// the delay doubles with every failure up to this delay
+#define TUIO_SUPERVISOR_MAX_DELAY 30000
+// a sensor that ran this long before it failed starts again with the first delay
+#define TUIO_SUPERVISOR_STABLE_TIME 60000
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioSupervisor runs a sensor until it is stopped. The thread that runs the sensor starts a
+	 * {@link TuioClient} in the foreground, and when it fails to start or its connect() returns, the
+	 * supervisor waits before the next attempt, twice as long after every failure in a row. Another
+	 * thread stops the supervisor, which breaks the running client out of its multiplexer with
+	 * AsynchronousBreak() and ends a pending wait at once.</p>
+	 *
+	 * <pre>
+	 * while (supervisor.start()) {
+	 *     TuioClient client(port);
+	 *     ...
+	 *     if (supervisor.attach(&client)) {
+	 *         client.connect(true);
+	 *         supervisor.detach();
+	 *     }
+	 *     client.disconnect();
+	 * }
+	 * </pre>
+	 */
+	class TuioSupervisor {
+
+	public:
+		enum State { STARTING, RUNNING, WAITING, STOPPED };
+
+		/**
+		 * @param  initialDelay	the first delay in milliseconds
+		 * @param  maxDelay	the longest delay in milliseconds
+		 * @param  stableTime	the time in milliseconds after which a running sensor is considered stable
+		 */
+		TuioSupervisor(int initialDelay=TUIO_SUPERVISOR_INITIAL_DELAY, int maxDelay=TUIO_SUPERVISOR_MAX_DELAY, int stableTime=TUIO_SUPERVISOR_STABLE_TIME);
+		~TuioSupervisor();
+
+		/**
+		 * Begins the next attempt, after the delay if the previous attempt failed
+		 *
+		 * @return	false once the supervisor is stopped
+		 */
+		bool start();
+
+		/**
+		 * Registers the client that is about to run, so that stop() can break it
+		 *
+		 * @param  client	the client that is connected next
+		 * @return	false if the supervisor was stopped meanwhile, the client must not be connected then
+		 */
+		bool attach(TuioClient *client);
+
+		/**
+		 * Unregisters the client after its connect() returned
+		 */
+		void detach();
+
+		/**
+		 * Ends the attempts, breaks the running client and ends the delay, from any thread
+		 */
+		void stop();
+
+		/**
+		 * Returns the state of the sensor
+		 * @return	the state of the sensor
+		 */
+		State getState();
+
+		/**
+		 * Returns the number of failures in a row
+		 * @return	the number of failures in a row
+		 */
+		int getFailures();
+
+	private:
+		TuioSupervisor(const TuioSupervisor&);
+		TuioSupervisor& operator=(const TuioSupervisor&);
+
+		bool wait(int milliseconds);
+		static long long currentTime();
+
+		int initialDelay, maxDelay, stableTime;
+		int delay;
+		int failures;
+		long long startTime;
+		bool attempted;
+		bool stopping;
+		State state;
+		TuioClient *client;
+
+#ifndef WIN32
+		pthread_mutex_t mutex;
+		pthread_cond_t condition;
+#else
+		CRITICAL_SECTION mutex;
+		HANDLE stopEvent;
+#endif
+	};
+};
+#endif /* INCLUDED_TUIOSUPERVISOR_H */
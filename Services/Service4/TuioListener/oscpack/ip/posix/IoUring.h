@@ -0,0 +1,160 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef INCLUDED_IOURING_H
+#define INCLUDED_IOURING_H
+
+
+// the io_uring receive backend needs kernel headers with provided buffer
+// rings and multishot recvmsg (Linux 6.0). it is set up with raw system
+// calls, liburing is not required
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_FEAT_EXT_ARG) && defined(__NR_io_uring_setup)
+#define OSC_HAVE_IO_URING
+#endif
+#endif
+#endif
+
+
+#ifdef OSC_HAVE_IO_URING
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <pthread.h>
+
+#include "ip/ReceiveBufferPool.h"
+
+
+// IoUring is one io_uring instance with a ring of provided receive buffers.
+// every buffer is laid out the way multishot recvmsg fills it: an
+// io_uring_recvmsg_out header, the source address, the control messages
+// and the payload. payloads are lent to listeners like ReceiveBufferPool
+// buffers, the reference count lives in the unused end of the control
+// area, and go back to the kernel when the last reference is released.
+
+class IoUring : public ReceiveBufferOwner{
+public:
+    enum{
+        NAME_SIZE = (sizeof(struct sockaddr_in6) + 7) & ~7, // keeps the control messages aligned
+        CONTROL_SIZE = 128,
+        PAYLOAD_OFFSET = sizeof(struct io_uring_recvmsg_out) + NAME_SIZE + CONTROL_SIZE,
+        BUFFER_SIZE = PAYLOAD_OFFSET + RECEIVE_BUFFER_SIZE,
+        BUFFER_GROUP = 0
+    };
+
+    IoUring();
+    ~IoUring();
+
+    // returns false if the kernel does not support io_uring or buffer
+    // rings. bufferCount must be a power of two. wakeFd is written to when
+    // a buffer is recycled while the loop waits for one, see WaitForBuffers()
+    bool Initialize( unsigned entries, unsigned bufferCount, int wakeFd );
+
+    // cancels all requests. lent buffers stay valid until they are released
+    void Close();
+
+    // queues a multishot recvmsg on fd. its completions carry userData
+    bool PrepareReceive( int fd, unsigned long long userData );
+
+    // queues a one shot poll for input on fd
+    bool PreparePoll( int fd, unsigned long long userData );
+
+    // submits the queued requests and waits for a completion for at most
+    // timeoutMs, or forever if timeoutMs is negative. returns 0 or -errno
+    int SubmitAndWait( double timeoutMs );
+
+    struct io_uring_cqe *PeekCompletion();
+    void AdvanceCompletion();
+
+    // interprets the buffer a receive completed into. returns the payload
+    // and fills in msg with the address and control messages as recvmsg()
+    // would, or returns 0 if the completion is malformed
+    char *ReceivedMessage( unsigned bufferId, int length, struct msghdr& msg, int& size );
+
+    // makes the payload of a received buffer retainable, returns false if
+    // the control messages left no room for the reference count
+    bool Lend( char *payload );
+
+    // returns a buffer that was not lent to the kernel
+    void Recycle( unsigned bufferId );
+
+    // true if the kernel has buffers to receive into. otherwise the next
+    // recycled buffer writes to wakeFd
+    bool WaitForBuffers();
+
+    int BuffersLent() const { return (int)lent_; }
+
+    virtual void RecycleReceiveBuffer( char *data );
+
+private:
+    struct io_uring_sqe *GetSqe();
+    unsigned Flush();
+    void AddBuffer( unsigned bufferId );
+
+    int ringFd_;
+    void *ringMemory_;
+    size_t ringSize_;
+    struct io_uring_sqe *sqes_;
+    size_t sqesSize_;
+
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned *sqArray_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned sqeTail_; // entries handed out by GetSqe(), some not yet submitted
+
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    struct io_uring_cqe *cqes_;
+
+    // the ring is addressed as an array of io_uring_buf, its tail overlays
+    // the resv field of the first entry. struct io_uring_buf_ring has a
+    // different layout in C++, where its empty flexible array helper takes a byte
+    struct io_uring_buf *bufferRing_;
+    size_t bufferRingSize_;
+    unsigned bufferCount_;
+    unsigned short bufferTail_;
+    char *buffers_;
+
+    pthread_mutex_t recycleMutex_;
+    volatile long available_;
+    volatile long lent_;
+    volatile long wakeRequested_;
+    int wakeFd_;
+
+    struct msghdr receiveHeader_;
+};
+
+
+#endif /* OSC_HAVE_IO_URING */
+
+#endif /* INCLUDED_IOURING_H */
@@ -0,0 +1,108 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioConfig.h"
+
+#include <stdlib.h>
+#include <fstream>
+
+using namespace TUIO;
+
+static const char *WHITESPACE = " \t\r\n";
+
+bool TuioConfig::load(const char *path) {
+	values.clear();
+	std::ifstream file(path);
+	if (!file.is_open()) return false;
+
+	std::string line;
+	while (std::getline(file, line)) {
+		size_t start = line.find_first_not_of(WHITESPACE);
+		if ((start==std::string::npos) || (line[start]=='#')) continue;
+		size_t end = line.find_first_of(WHITESPACE, start);
+		std::string key = line.substr(start, end-start);
+		std::string value;
+		if (end!=std::string::npos) {
+			size_t valueStart = line.find_first_not_of(WHITESPACE, end);
+			size_t valueEnd = line.find_last_not_of(WHITESPACE);
+			if (valueStart!=std::string::npos) value = line.substr(valueStart, valueEnd-valueStart+1);
+		}
+		add(key, value);
+	}
+	return true;
+}
+
+bool TuioConfig::save(const char *path) const {
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+	for (size_t i=0; i<values.size(); i++) file << values[i].first << " " << values[i].second << "\n";
+	file.close();
+	return !file.fail();
+}
+
+void TuioConfig::add(const std::string &key, const std::string &value) {
+	values.push_back(std::make_pair(key, value));
+}
+
+void TuioConfig::merge(const TuioConfig &config) {
+	std::vector<std::pair<std::string, std::string> > merged;
+	for (size_t i=0; i<values.size(); i++) {
+		if (!config.has(values[i].first.c_str())) merged.push_back(values[i]);
+	}
+	merged.insert(merged.end(), config.values.begin(), config.values.end());
+	values.swap(merged);
+}
+
+bool TuioConfig::has(const char *key) const {
+	for (size_t i=0; i<values.size(); i++) {
+		if (values[i].first==key) return true;
+	}
+	return false;
+}
+
+std::string TuioConfig::getString(const char *key, const char *defaultValue) const {
+	for (size_t i=values.size(); i>0; i--) {
+		if (values[i-1].first==key) return values[i-1].second;
+	}
+	return defaultValue;
+}
+
+int TuioConfig::getInt(const char *key, int defaultValue) const {
+	if (!has(key)) return defaultValue;
+	return atoi(getString(key).c_str());
+}
+
+float TuioConfig::getFloat(const char *key, float defaultValue) const {
+	if (!has(key)) return defaultValue;
+	return (float)atof(getString(key).c_str());
+}
+
+bool TuioConfig::getBool(const char *key, bool defaultValue) const {
+	if (!has(key)) return defaultValue;
+	std::string value = getString(key);
+	return (value=="true") || (value=="True") || (value=="yes") || (value=="1");
+}
+
+std::vector<std::string> TuioConfig::getAll(const char *key) const {
+	std::vector<std::string> all;
+	for (size_t i=0; i<values.size(); i++) {
+		if (values[i].first==key) all.push_back(values[i].second);
+	}
+	return all;
+}
@@ -0,0 +1,108 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOCONFIG_H
+#define INCLUDED_TUIOCONFIG_H
+
+#include <string>
+#include <vector>
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioConfig class holds the settings of a sensor, read from a text file with one
+	 * "key value" line per setting. Empty lines and lines starting with # are ignored. A key may
+	 * appear more than once, for lists such as destinations or calibration points.</p>
+	 *
+	 * <p>It is meant to be read while the settings are compiled into the objects that run on the
+	 * receiving thread, never from the receiving thread itself.</p>
+	 */
+	class TuioConfig {
+
+	public:
+		/**
+		 * Replaces the settings with the ones in the provided file
+		 *
+		 * @param  path	the file to read
+		 * @return	false if the file could not be opened, the settings are empty then
+		 */
+		bool load(const char *path);
+
+		/**
+		 * Writes the settings to the provided file in the format that is read by {@link #load}
+		 *
+		 * @param  path	the file to write
+		 * @return	false if the file could not be written
+		 */
+		bool save(const char *path) const;
+
+		/**
+		 * Removes all settings
+		 */
+		void clear() { values.clear(); }
+
+		/**
+		 * Adds a setting, after the ones with the same key
+		 */
+		void add(const std::string &key, const std::string &value);
+
+		/**
+		 * Replaces the settings with the values of the provided config, all values of a key that is
+		 * present in both are replaced, the other settings are kept
+		 *
+		 * @param  config	the settings that take precedence
+		 */
+		void merge(const TuioConfig &config);
+
+		/**
+		 * Returns true if the setting is present
+		 */
+		bool has(const char *key) const;
+
+		/**
+		 * Returns the last value of a setting
+		 *
+		 * @param  key	the key of the setting
+		 * @param  defaultValue	returned if the setting is missing
+		 * @return	the value of the setting
+		 */
+		std::string getString(const char *key, const char *defaultValue="") const;
+		int getInt(const char *key, int defaultValue=0) const;
+		float getFloat(const char *key, float defaultValue=0) const;
+
+		/**
+		 * Returns the last value of a setting as a boolean, "true", "True", "yes" and "1" are true
+		 */
+		bool getBool(const char *key, bool defaultValue=false) const;
+
+		/**
+		 * Returns all values of a setting in the order of the file
+		 */
+		std::vector<std::string> getAll(const char *key) const;
+
+		/**
+		 * Returns true if both contain the same values for the provided key
+		 */
+		bool same(const TuioConfig &config, const char *key) const { return getAll(key)==config.getAll(key); }
+
+	private:
+		std::vector<std::pair<std::string, std::string> > values;
+	};
+};
+#endif /* INCLUDED_TUIOCONFIG_H */
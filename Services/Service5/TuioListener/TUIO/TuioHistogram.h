@@ -0,0 +1,160 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOHISTOGRAM_H
+#define INCLUDED_TUIOHISTOGRAM_H
+
+#ifdef WIN32
+#include <windows.h>
+#include <intrin.h>
+#endif
+
+#include "TuioAtomic.h"
+
+// every power of two range is split into 2^(TUIO_HISTOGRAM_SUB_BITS-1) linear buckets
+#define TUIO_HISTOGRAM_SUB_BITS 6
+// values up to 2^TUIO_HISTOGRAM_MAX_BITS (in nanoseconds about two minutes) are kept apart
+#define TUIO_HISTOGRAM_MAX_BITS 37
+#define TUIO_HISTOGRAM_BUCKETS ((TUIO_HISTOGRAM_MAX_BITS-TUIO_HISTOGRAM_SUB_BITS+2)<<(TUIO_HISTOGRAM_SUB_BITS-1))
+
+namespace TUIO {
+
+	/**
+	 * <p>The TuioHistogram class is a fixed-size log-linear histogram in the style of HdrHistogram.
+	 * Values below 2^TUIO_HISTOGRAM_SUB_BITS are counted exactly, larger values with a relative
+	 * error of at most 2^-(TUIO_HISTOGRAM_SUB_BITS-1), about 3%.</p>
+	 * <p>record() is lock-free and never allocates, so it can be called on the touch path
+	 * while another thread reads percentiles. Readers see an approximate snapshot.</p>
+	 */
+	class TuioHistogram {
+
+	public:
+		TuioHistogram() {
+			reset();
+		}
+
+		/**
+		 * Adds a value, negative values count as zero
+		 *
+		 * @param	value	the value to add, usually a duration in nanoseconds
+		 */
+		void record(long long value) {
+			if (value<0) value = 0;
+			atomicAdd(&counts[bucketIndex(value)], 1);
+			atomicAdd64(&total, 1);
+			atomicAdd64(&sum, value);
+			atomicMax64(&max, value);
+		}
+
+		/**
+		 * Clears all recorded values
+		 */
+		void reset() {
+			for (int i=0; i<TUIO_HISTOGRAM_BUCKETS; i++) atomicStore(&counts[i], 0);
+			atomicStore64(&total, 0);
+			atomicStore64(&sum, 0);
+			atomicStore64(&max, 0);
+		}
+
+		/**
+		 * Returns the number of recorded values
+		 */
+		long long getCount() const {
+			return atomicLoad64(&total);
+		}
+
+		/**
+		 * Returns the largest recorded value
+		 */
+		long long getMax() const {
+			return atomicLoad64(&max);
+		}
+
+		/**
+		 * Returns the mean of all recorded values
+		 */
+		long long getMean() const {
+			long long count = atomicLoad64(&total);
+			return (count>0)?atomicLoad64(&sum)/count:0;
+		}
+
+		/**
+		 * Returns the value below which the given percentage of the recorded values fall,
+		 * rounded up to the upper bound of its bucket and never above the maximum
+		 *
+		 * @param	percentile	the percentile between 0 and 100
+		 */
+		long long getPercentile(double percentile) const {
+			long long count = 0;
+			for (int i=0; i<TUIO_HISTOGRAM_BUCKETS; i++) count += atomicLoad(&counts[i]);
+			if (count==0) return 0;
+
+			long long target = (long long)(percentile*count/100.0+0.5);
+			if (target<1) target = 1;
+			if (target>count) target = count;
+
+			long long seen = 0;
+			for (int i=0; i<TUIO_HISTOGRAM_BUCKETS; i++) {
+				seen += atomicLoad(&counts[i]);
+				if (seen>=target) {
+					long long value = bucketUpperBound(i);
+					long long maxValue = getMax();
+					return (value<maxValue)?value:maxValue;
+				}
+			}
+			return getMax();
+		}
+
+	private:
+		static int highestBit(long long value) {
+#ifdef WIN32
+			unsigned long index;
+			unsigned long high = (unsigned long)(value>>32);
+			if (high!=0) {
+				_BitScanReverse(&index, high);
+				return (int)index+32;
+			}
+			_BitScanReverse(&index, (unsigned long)value);
+			return (int)index;
+#else
+			return 63-__builtin_clzll((unsigned long long)value);
+#endif
+		}
+
+		static int bucketIndex(long long value) {
+			if (value < (1LL<<TUIO_HISTOGRAM_SUB_BITS)) return (int)value;
+			int shift = highestBit(value)-TUIO_HISTOGRAM_SUB_BITS+1;
+			if (shift>TUIO_HISTOGRAM_MAX_BITS-TUIO_HISTOGRAM_SUB_BITS) return TUIO_HISTOGRAM_BUCKETS-1;
+			return (shift<<(TUIO_HISTOGRAM_SUB_BITS-1)) + (int)(value>>shift);
+		}
+
+		static long long bucketUpperBound(int index) {
+			if (index < (1<<TUIO_HISTOGRAM_SUB_BITS)) return index;
+			int shift = (index>>(TUIO_HISTOGRAM_SUB_BITS-1))-1;
+			long long sub = index-(shift<<(TUIO_HISTOGRAM_SUB_BITS-1));
+			return (sub<<shift) + (1LL<<shift) - 1;
+		}
+
+		mutable volatile long counts[TUIO_HISTOGRAM_BUCKETS];
+		mutable volatile long long total;
+		mutable volatile long long sum;
+		mutable volatile long long max;
+	};
+};
+#endif /* INCLUDED_TUIOHISTOGRAM_H */
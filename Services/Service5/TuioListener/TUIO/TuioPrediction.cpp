@@ -0,0 +1,105 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioPrediction.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace TUIO;
+
+TuioPrediction::TuioPrediction()
+: latency        (0)
+, measuredLatency(0)
+, automatic      (false)
+, maxDistance    (PREDICTION_MAX_DISTANCE)
+{
+}
+
+void TuioPrediction::setLatency(float seconds, bool a) {
+	latency = seconds;
+	automatic = a;
+}
+
+bool TuioPrediction::configure(const char *config) {
+	char name[32];
+	float milliseconds = 0, distance = PREDICTION_MAX_DISTANCE;
+	setLatency(0);
+	setMaxDistance(PREDICTION_MAX_DISTANCE);
+
+	if (sscanf(config, "%31s", name)!=1) return false;
+	if (strcmp(name, "none")==0) return true;
+	if (strcmp(name, "auto")==0) {
+		sscanf(config, "%*s %f %f", &milliseconds, &distance);
+		setLatency(milliseconds/1000.0f, true);
+	} else {
+		if (sscanf(config, "%f %f", &milliseconds, &distance)<1) return false;
+		setLatency(milliseconds/1000.0f);
+	}
+	setMaxDistance(distance);
+	return true;
+}
+
+void TuioPrediction::reset(TuioPredictionState &state) const {
+	state.xSpeed = state.ySpeed = 0;
+	state.damping = 0;
+}
+
+void TuioPrediction::apply(TuioPredictionState &state, float &x, float &y, float xSpeed, float ySpeed, float motionAccel) const {
+	float horizon = getLatency();
+	if (horizon<=0) return;
+
+	float speed = sqrtf(xSpeed*xSpeed+ySpeed*ySpeed);
+	// TuioContainer derives infinite speeds from updates within the same millisecond
+	if (!(speed<=FLT_MAX) || !(motionAccel>=-FLT_MAX) || !(motionAccel<=FLT_MAX)) {
+		reset(state);
+		return;
+	}
+	float lastSpeed = sqrtf(state.xSpeed*state.xSpeed+state.ySpeed*state.ySpeed);
+	// the cosine of the turn since the last update, a contact that just started moving has not turned
+	float turn = 1.0f;
+	if ((speed>0) && (lastSpeed>0)) turn = (xSpeed*state.xSpeed+ySpeed*state.ySpeed)/(speed*lastSpeed);
+	state.xSpeed = xSpeed;
+	state.ySpeed = ySpeed;
+
+	if (speed<PREDICTION_MIN_SPEED) {
+		state.damping = 0;
+		return;
+	}
+	float damping = state.damping+PREDICTION_RECOVERY;
+	if (turn<damping) damping = (turn>0) ? turn : 0;
+	if (damping>1) damping = 1;
+	state.damping = damping;
+
+	// a decelerating contact is extrapolated up to where it stops
+	float distance = speed*horizon;
+	if (motionAccel<0) {
+		if (speed+motionAccel*horizon>0) distance += 0.5f*motionAccel*horizon*horizon;
+		else distance = -0.5f*speed*speed/motionAccel;
+	}
+	distance *= damping;
+	if (distance>maxDistance) distance = maxDistance;
+
+	x += xSpeed/speed*distance;
+	y += ySpeed/speed*distance;
+	if (x<0) x = 0; else if (x>1) x = 1;
+	if (y<0) y = 0; else if (y>1) y = 1;
+}
@@ -20,169 +20,101 @@
 */
 
 #include "TuioServer.h"
+#include "TuioLog.h"
 
 using namespace TUIO;
 using namespace osc;
 
-#ifndef WIN32
-static void* ThreadFunc( void* obj )
-#else
-static DWORD WINAPI ThreadFunc( LPVOID obj )
-#endif
-{
-	TuioServer *tuioServer = static_cast<TuioServer*>(obj);
-	while ((tuioServer->isConnected()) && (tuioServer->periodicMessagesEnabled())) {
-		tuioServer->sendFullMessages();
-#ifndef WIN32
-		usleep(USEC_SECOND*tuioServer->getUpdateInterval());
-#else
-		Sleep(MSEC_SECOND*tuioServer->getUpdateInterval());
-#endif
-	}	
-	return 0;
-};
-
 void TuioServer::enablePeriodicMessages(int interval) {
+	enablePeriodicMessages(TuioTime(interval,0));
+}
+
+void TuioServer::enablePeriodicMessages(TuioTime period) {
 	if (periodic_update) return;
 	
-	update_interval = interval;
+	update_period = period;
+	update_interval = period.getSeconds();
+	if (update_interval<1) update_interval = 1;
 	periodic_update = true;
-	
-#ifndef WIN32
-	pthread_create(&thread , NULL, ThreadFunc, this);
-#else
-	DWORD threadId;
-	thread = CreateThread( 0, 0, ThreadFunc, this, 0, &threadId );
-#endif
+
+	// all servers share the thread of the timer wheel, or run on the receiving thread it is attached to
+	if (timerWheel==NULL) timerWheel = TuioTimerWheel::getShared();
+	timerWheel->schedule(this, (int)period.getTotalMilliseconds());
 }
 
 void TuioServer::disablePeriodicMessages() {
 	if (!periodic_update) return;
 	periodic_update = false;
-	
-#ifdef WIN32
-	if( thread ) CloseHandle( thread );
-#endif
-	thread = NULL;	
+
+	// returns once a full update in progress is sent
+	timerWheel->cancel(this);
 }
 
-void TuioServer::sendFullMessages() {
-	
-	// prepare the cursor packet
-	fullPacket->Clear();
-	(*fullPacket) << osc::BeginBundleImmediate;
-	
-	// add the cursor alive message
-	(*fullPacket) << osc::BeginMessage( "/tuio/2Dcur") << "alive";
-	for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++)
-		(*fullPacket) << (int32)((*tuioCursor)->getSessionID());	
-	(*fullPacket) << osc::EndMessage;	
+void TuioServer::setTimerWheel(TuioTimerWheel *wheel) {
+	if (periodic_update) return;
+	timerWheel = wheel;
+}
 
-	// add all current cursor set messages
-	for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++) {
-		
-		// start a new packet if we exceed the packet capacity
-		if ((fullPacket->Capacity()-fullPacket->Size())<CUR_MESSAGE_SIZE) {
-			
-			// add the immediate fseq message and send the cursor packet
-			(*fullPacket) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << -1 << osc::EndMessage;
-			(*fullPacket) << osc::EndBundle;
-			socket->Send( fullPacket->Data(), fullPacket->Size() );
-
-			// prepare the new cursor packet
-			fullPacket->Clear();	
-			(*fullPacket) << osc::BeginBundleImmediate;
-			
-			// add the cursor alive message
-			(*fullPacket) << osc::BeginMessage( "/tuio/2Dcur") << "alive";
-			for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++)
-				(*fullPacket) << (int32)((*tuioCursor)->getSessionID());	
-			(*fullPacket) << osc::EndMessage;				
-		}
+void TuioServer::TimerExpired() {
+	if (connected) sendFullMessages();
+}
 
-		// add the actual cursor set message
-		(*fullPacket) << osc::BeginMessage( "/tuio/2Dcur") << "set";
-		(*fullPacket) << (int32)((*tuioCursor)->getSessionID()) << (*tuioCursor)->getX() << (*tuioCursor)->getY();
-		(*fullPacket) << (*tuioCursor)->getXSpeed() << (*tuioCursor)->getYSpeed() <<(*tuioCursor)->getMotionAccel();	
-		(*fullPacket) << osc::EndMessage;	
-	}
-	
-	// add the immediate fseq message and send the cursor packet
-	(*fullPacket) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << -1 << osc::EndMessage;
-	(*fullPacket) << osc::EndBundle;
-	socket->Send( fullPacket->Data(), fullPacket->Size() );
-	
-	// prepare the object packet
-	fullPacket->Clear();
-	(*fullPacket) << osc::BeginBundleImmediate;
+void TuioServer::sendFullMessages() {
 	
-	// add the object alive message
-	(*fullPacket) << osc::BeginMessage( "/tuio/2Dobj") << "alive";
-	for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++)
-		(*fullPacket) << (int32)((*tuioObject)->getSessionID());	
-	(*fullPacket) << osc::EndMessage;	
+	// the lists are only modified by the frame thread, which holds the mutex while doing so
+	TuioScopedLock listLock(listMutex);
+	TuioScopedLock sendLock(sendMutex);
 
-	for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++) {
-		
-		// start a new packet if we exceed the packet capacity
-		if ((fullPacket->Capacity()-fullPacket->Size())<OBJ_MESSAGE_SIZE) {
-			// add the immediate fseq message and send the object packet
-			(*fullPacket) << osc::BeginMessage( "/tuio/2Dobj") << "fseq" << -1 << osc::EndMessage;
-			(*fullPacket) << osc::EndBundle;
-			socket->Send( fullPacket->Data(), fullPacket->Size() );
-			
-			// prepare the new object packet
-			fullPacket->Clear();	
-			(*fullPacket) << osc::BeginBundleImmediate;
-			
-			// add the object alive message
-			(*fullPacket) << osc::BeginMessage( "/tuio/2Dobj") << "alive";
-			for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++)
-				(*fullPacket) << (int32)((*tuioObject)->getSessionID());	
-			(*fullPacket) << osc::EndMessage;	
-		}
-
-		// add the actual object set message
-		(*fullPacket) << osc::BeginMessage( "/tuio/2Dobj") << "set";
-		(*fullPacket) << (int32)((*tuioObject)->getSessionID()) << (*tuioObject)->getSymbolID() << (*tuioObject)->getX() << (*tuioObject)->getY() << (*tuioObject)->getAngle();
-		(*fullPacket) << (*tuioObject)->getXSpeed() << (*tuioObject)->getYSpeed() << (*tuioObject)->getRotationSpeed() << (*tuioObject)->getMotionAccel() << (*tuioObject)->getRotationAccel();	
-		(*fullPacket) << osc::EndMessage;
-		
-	}
-	// add the immediate fseq message and send the object packet
-	(*fullPacket) << osc::BeginMessage( "/tuio/2Dobj") << "fseq" << -1 << osc::EndMessage;
-	(*fullPacket) << osc::EndBundle;
-	socket->Send( fullPacket->Data(), fullPacket->Size() );
+	// labelled with the last frame, so that receivers reassemble the fragments and skip it once it is late
+	fullCursors.assign(cursorList.begin(), cursorList.end());
+	sendCursorFrame(fullPacket, fullCursors, currentFrame);
+	fullObjects.assign(objectList.begin(), objectList.end());
+	sendObjectFrame(fullPacket, fullObjects, currentFrame);
 }
 
-TuioServer::TuioServer() {
+TuioServer::TuioServer() : sharedMemory(NULL) {
 	initialize("127.0.0.1",3333,MAX_UDP_SIZE);
 }
 
-TuioServer::TuioServer(const char *host, int port) {
+TuioServer::TuioServer(const char *host, int port) : sharedMemory(NULL) {
 	initialize(host,port,IP_MTU_SIZE);
+	setMTU(IP_MTU_SIZE);
 }
 
-TuioServer::TuioServer(const char *host, int port, int size) {
+TuioServer::TuioServer(const char *host, int port, int size) : sharedMemory(NULL) {
 	initialize(host,port,size);
 }
 
+TuioServer::TuioServer(TuioSharedMemory *shm) : sharedMemory(shm) {
+	initialize(NULL,0,shm->getMaxPacketSize());
+}
+
 void TuioServer::initialize(const char *host, int port, int size) {
 	if (size>MAX_UDP_SIZE) size = MAX_UDP_SIZE;
 	else if (size<MIN_UDP_SIZE) size = MIN_UDP_SIZE;
 
+	socket = NULL;
+	ipv6 = false;
 	try {
-		long unsigned int ip = GetHostByName(host);
-		socket = new UdpTransmitSocket(IpEndpointName(ip, port));
-
-		oscBuffer = new char[size];
-		oscPacket = new osc::OutboundPacketStream(oscBuffer,size);
-		fullBuffer = new char[size];
-		fullPacket = new osc::OutboundPacketStream(fullBuffer,size);
+		if (host!=NULL) {
+			// IPv4 or IPv6, to one host or a multicast group
+			IpEndpointName endpoint(host, port);
+			ipv6 = endpoint.isIpv6;
+			socket = new UdpTransmitSocket(endpoint);
+		}
 	} catch (std::exception &e) { 
-		std::cout << "could not create socket" << std::endl;
+		TUIO_LOG_ERROR("could not create a socket to %s port %d", host, port);
 		socket = NULL;
 	}
+
+	oscBuffer = fullBuffer = NULL;
+	oscPacket = fullPacket = NULL;
+	resizeBuffers(size);
+
+	delta_update = false;
+	keyframe_interval = KEYFRAME_INTERVAL;
+	lastKeyframe = -1;
+	warned = false;
 	
 	currentFrameTime = TuioTime::getSessionTime().getSeconds();
 	currentFrame = sessionID = maxCursorID = -1;
@@ -192,16 +124,74 @@ void TuioServer::initialize(const char *host, int port, int size) {
 	sendEmptyCursorBundle();
 	sendEmptyObjectBundle();
 
+	update_interval = 1;
+	update_period = TuioTime(1,0);
 	periodic_update = false;
+	timerWheel = NULL;
 	full_update = false;
 	connected = true;
 }
 
+// the caller holds the send mutex, the ring has a single producer and the frame
+// and the periodic message thread share the packet buffers with setMaxPacketSize()
+void TuioServer::sendPacket(osc::OutboundPacketStream *packet) {
+	if (sharedMemory!=NULL) sharedMemory->send( packet->Data(), packet->Size() );
+	else if (socket!=NULL) socket->Send( packet->Data(), packet->Size() );
+}
+
+void TuioServer::resizeBuffers(int size) {
+	if (sharedMemory!=NULL && size>sharedMemory->getMaxPacketSize()) size = sharedMemory->getMaxPacketSize();
+
+	delete oscPacket;
+	delete []oscBuffer;
+	delete fullPacket;
+	delete []fullBuffer;
+
+	oscBuffer = new char[size];
+	oscPacket = new osc::OutboundPacketStream(oscBuffer,size);
+	fullBuffer = new char[size];
+	fullPacket = new osc::OutboundPacketStream(fullBuffer,size);
+	max_packet_size = size;
+}
+
+void TuioServer::setMaxPacketSize(int size) {
+	if (size>MAX_UDP_SIZE) size = MAX_UDP_SIZE;
+	else if (size<MIN_UDP_SIZE) size = MIN_UDP_SIZE;
+
+	TuioScopedLock lock(sendMutex);
+	resizeBuffers(size);
+	warned = false;
+}
+
+void TuioServer::setMTU(int mtu) {
+	if (mtu>MAX_UDP_SIZE) mtu = MAX_UDP_SIZE;
+	else if (mtu<MIN_UDP_SIZE) mtu = MIN_UDP_SIZE;
+
+	TuioScopedLock lock(sendMutex);
+	resizeBuffers(mtu-UDP_HEADER_SIZE-(ipv6 ? IPV6_HEADER_SIZE : IPV4_HEADER_SIZE));
+	warned = false;
+}
+
+void TuioServer::enableDeltaUpdate(int keyframeInterval) {
+	keyframe_interval = (keyframeInterval>0) ? keyframeInterval : 1;
+	lastKeyframe = -1;
+	delta_update = true;
+}
+
+void TuioServer::disableDeltaUpdate() {
+	delta_update = false;
+	sentCursors.clear();
+	sentObjects.clear();
+}
+
 TuioServer::~TuioServer() {
+	disablePeriodicMessages();
 	connected = false;
 
+	sendMutex.lock();
 	sendEmptyCursorBundle();
 	sendEmptyObjectBundle();
+	sendMutex.unlock();
 
 	delete oscPacket;
 	delete []oscBuffer;
@@ -214,7 +204,9 @@ TuioServer::~TuioServer() {
 TuioObject* TuioServer::addTuioObject(int f_id, float x, float y, float a) {
 	sessionID++;
 	TuioObject *tobj = new TuioObject(currentFrameTime, sessionID, f_id, x, y, a);
+	listMutex.lock();
 	objectList.push_back(tobj);
+	listMutex.unlock();
 	updateObject = true;
 
 	if (verbose)
@@ -225,7 +217,9 @@ TuioObject* TuioServer::addTuioObject(int f_id, float x, float y, float a) {
 
 void TuioServer::addExternalTuioObject(TuioObject *tobj) {
 	if (tobj==NULL) return;
+	listMutex.lock();
 	objectList.push_back(tobj);
+	listMutex.unlock();
 	updateObject = true;
 	
 	if (verbose)
@@ -253,7 +247,9 @@ void TuioServer::updateExternalTuioObject(TuioObject *tobj) {
 
 void TuioServer::removeTuioObject(TuioObject *tobj) {
 	if (tobj==NULL) return;
+	listMutex.lock();
 	objectList.remove(tobj);
+	listMutex.unlock();
 	delete tobj;
 	updateObject = true;
 	
@@ -263,7 +259,9 @@ void TuioServer::removeTuioObject(TuioObject *tobj) {
 
 void TuioServer::removeExternalTuioObject(TuioObject *tobj) {
 	if (tobj==NULL) return;
+	listMutex.lock();
 	objectList.remove(tobj);
+	listMutex.unlock();
 	updateObject = true;
 	
 	if (verbose)
@@ -288,7 +286,9 @@ TuioCursor* TuioServer::addTuioCursor(float x, float y) {
 	} else maxCursorID = cursorID;	
 	
 	TuioCursor *tcur = new TuioCursor(currentFrameTime, sessionID, cursorID, x, y);
+	listMutex.lock();
 	cursorList.push_back(tcur);
+	listMutex.unlock();
 	updateCursor = true;
 
 	if (verbose) 
@@ -299,7 +299,9 @@ TuioCursor* TuioServer::addTuioCursor(float x, float y) {
 
 void TuioServer::addExternalTuioCursor(TuioCursor *tcur) {
 	if (tcur==NULL) return;
+	listMutex.lock();
 	cursorList.push_back(tcur);
+	listMutex.unlock();
 	updateCursor = true;
 	
 	if (verbose) 
@@ -327,7 +329,9 @@ void TuioServer::updateExternalTuioCursor(TuioCursor *tcur) {
 
 void TuioServer::removeTuioCursor(TuioCursor *tcur) {
 	if (tcur==NULL) return;
+	listMutex.lock();
 	cursorList.remove(tcur);
+	listMutex.unlock();
 	tcur->remove(currentFrameTime);
 	updateCursor = true;
 
@@ -367,7 +371,9 @@ void TuioServer::removeTuioCursor(TuioCursor *tcur) {
 
 void TuioServer::removeExternalTuioCursor(TuioCursor *tcur) {
 	if (tcur==NULL) return;
+	listMutex.lock();
 	cursorList.remove(tcur);
+	listMutex.unlock();
 	updateCursor = true;
 	
 	if (verbose)
@@ -393,82 +399,212 @@ void TuioServer::initFrame(TuioTime ttime) {
 }
 
 void TuioServer::commitFrame() {
-	
-	if(updateCursor) {
-		startCursorBundle();
-		for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++) {
-			
-			// start a new packet if we exceed the packet capacity
-			if ((oscPacket->Capacity()-oscPacket->Size())<CUR_MESSAGE_SIZE) {
-				sendCursorBundle(currentFrame);
-				startCursorBundle();
-			}
+	TuioScopedLock lock(sendMutex);
 
-			TuioCursor *tcur = (*tuioCursor);
-			if ((full_update) || (tcur->getTuioTime()==currentFrameTime)) addCursorMessage(tcur);				
-		}
-		sendCursorBundle(currentFrame);
+	// a keyframe of the delta update sends every contact, so that receivers recover from lost packets
+	bool keyframe = delta_update && ((currentFrame-lastKeyframe)>=keyframe_interval);
+	if (keyframe) lastKeyframe = currentFrame;
+
+	if ((updateCursor || keyframe) && selectCursorUpdates(keyframe)) {
+		sendCursorFrame(oscPacket, cursorUpdates, currentFrame);
 	} else if ((!periodic_update) && (lastCursorUpdate<currentFrameTime.getSeconds())) {
 		lastCursorUpdate = currentFrameTime.getSeconds();
-		startCursorBundle();
-		sendCursorBundle(currentFrame);
+		startCursorBundle(oscPacket);
+		sendCursorBundle(oscPacket, currentFrame);
 	}
 	updateCursor = false;
 	
-	if(updateObject) {
-		startObjectBundle();
-		for (std::list<TuioObject*>::iterator  tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++) {
-			
-			// start a new packet if we exceed the packet capacity
-			if ((oscPacket->Capacity()-oscPacket->Size())<OBJ_MESSAGE_SIZE) {
-				sendObjectBundle(currentFrame);
-				startObjectBundle();
-			}
-			
-			TuioObject *tobj = (*tuioObject);
-			if  ((full_update) || (tobj->getTuioTime()==currentFrameTime)) addObjectMessage(tobj);
-		} 
-		sendObjectBundle(currentFrame);
+	if ((updateObject || keyframe) && selectObjectUpdates(keyframe)) {
+		sendObjectFrame(oscPacket, objectUpdates, currentFrame);
 	} else if ((!periodic_update) && (lastObjectUpdate<currentFrameTime.getSeconds())) {
 		lastObjectUpdate = currentFrameTime.getSeconds();
-		startObjectBundle();
-		sendObjectBundle(currentFrame);
+		startObjectBundle(oscPacket);
+		sendObjectBundle(oscPacket, currentFrame);
 	}
 	updateObject = false;
 }
 
+// the exact size of an alive message with the provided number of session IDs
+static int aliveMessageSize(int count) {
+	// size prefix, address, type tags with the comma, the command and the terminator, command, IDs
+	return 4 + 12 + ((2+count+1+3)&~3) + 8 + 4*count;
+}
+
+// returns the number of fragments for the set messages of the provided size, or 0 if not even one fits
+static int fragmentCount(int packetSize, int alive, int updates, int messageSize, int &perFragment) {
+	int capacity = packetSize-BUNDLE_HEADER_SIZE-aliveMessageSize(alive)-FSEQ_MESSAGE_SIZE;
+	perFragment = capacity/messageSize;
+	if ((capacity>=0) && (updates<=perFragment)) return 1;
+
+	perFragment = (capacity-FRAG_MESSAGE_SIZE)/messageSize;
+	if (perFragment<1) return 0;
+	return (updates+perFragment-1)/perFragment;
+}
+
+// fills cursorUpdates with the cursors to send, returns false if there is nothing to send at all
+bool TuioServer::selectCursorUpdates(bool keyframe) {
+	cursorUpdates.clear();
+	if (!delta_update) {
+		for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++) {
+			TuioCursor *tcur = (*tuioCursor);
+			if ((full_update) || (tcur->getTuioTime()==currentFrameTime)) cursorUpdates.push_back(tcur);
+		}
+		return true;
+	}
+
+	for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++) {
+		TuioCursor *tcur = (*tuioCursor);
+		std::map<long, TuioSentState>::iterator sent = sentCursors.find(tcur->getSessionID());
+		bool changed = (sent==sentCursors.end());
+		if (changed) sent = sentCursors.insert(std::make_pair(tcur->getSessionID(), TuioSentState())).first;
+		else changed = (sent->second.x!=tcur->getX()) || (sent->second.y!=tcur->getY()) || (sent->second.xspeed!=tcur->getXSpeed())
+			|| (sent->second.yspeed!=tcur->getYSpeed()) || (sent->second.maccel!=tcur->getMotionAccel());
+
+		sent->second.frame = currentFrame;
+		if (changed || keyframe || full_update) {
+			sent->second.x = tcur->getX();
+			sent->second.y = tcur->getY();
+			sent->second.xspeed = tcur->getXSpeed();
+			sent->second.yspeed = tcur->getYSpeed();
+			sent->second.maccel = tcur->getMotionAccel();
+			cursorUpdates.push_back(tcur);
+		}
+	}
+
+	// the removed cursors only change the alive message
+	bool removed = false;
+	std::map<long, TuioSentState>::iterator sent = sentCursors.begin();
+	while (sent!=sentCursors.end()) {
+		if (sent->second.frame!=currentFrame) {
+			sentCursors.erase(sent++);
+			removed = true;
+		} else sent++;
+	}
+
+	return keyframe || removed || !cursorUpdates.empty();
+}
+
+void TuioServer::sendCursorFrame(osc::OutboundPacketStream *packet, std::vector<TuioCursor*> &updates, long fseq) {
+	int perFragment;
+	int count = fragmentCount(packet->Capacity(), (int)cursorList.size(), (int)updates.size(), CUR_MESSAGE_SIZE, perFragment);
+	if (count==0) {
+		if (!warned) TUIO_LOG_WARNING("the alive message of %d cursors exceeds the packet size of %d bytes", (int)cursorList.size(), (int)packet->Capacity());
+		warned = true;
+		return;
+	}
+
+	// the set messages are spread evenly over the fragments
+	int size = (int)updates.size();
+	for (int index=0; index<count; index++) {
+		startCursorBundle(packet);
+		if (count>1) addFragmentMessage(packet, "/tuio/2Dcur", fseq, index, count);
+		for (int i=index*size/count; i<(index+1)*size/count; i++) addCursorMessage(packet, updates[i]);
+		sendCursorBundle(packet, fseq);
+	}
+}
+
+// fills objectUpdates with the objects to send, returns false if there is nothing to send at all
+bool TuioServer::selectObjectUpdates(bool keyframe) {
+	objectUpdates.clear();
+	if (!delta_update) {
+		for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++) {
+			TuioObject *tobj = (*tuioObject);
+			if ((full_update) || (tobj->getTuioTime()==currentFrameTime)) objectUpdates.push_back(tobj);
+		}
+		return true;
+	}
+
+	for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++) {
+		TuioObject *tobj = (*tuioObject);
+		std::map<long, TuioSentState>::iterator sent = sentObjects.find(tobj->getSessionID());
+		bool changed = (sent==sentObjects.end());
+		if (changed) sent = sentObjects.insert(std::make_pair(tobj->getSessionID(), TuioSentState())).first;
+		else changed = (sent->second.x!=tobj->getX()) || (sent->second.y!=tobj->getY()) || (sent->second.angle!=tobj->getAngle())
+			|| (sent->second.xspeed!=tobj->getXSpeed()) || (sent->second.yspeed!=tobj->getYSpeed()) || (sent->second.rspeed!=tobj->getRotationSpeed())
+			|| (sent->second.maccel!=tobj->getMotionAccel()) || (sent->second.raccel!=tobj->getRotationAccel());
+
+		sent->second.frame = currentFrame;
+		if (changed || keyframe || full_update) {
+			sent->second.x = tobj->getX();
+			sent->second.y = tobj->getY();
+			sent->second.angle = tobj->getAngle();
+			sent->second.xspeed = tobj->getXSpeed();
+			sent->second.yspeed = tobj->getYSpeed();
+			sent->second.rspeed = tobj->getRotationSpeed();
+			sent->second.maccel = tobj->getMotionAccel();
+			sent->second.raccel = tobj->getRotationAccel();
+			objectUpdates.push_back(tobj);
+		}
+	}
+
+	// the removed objects only change the alive message
+	bool removed = false;
+	std::map<long, TuioSentState>::iterator sent = sentObjects.begin();
+	while (sent!=sentObjects.end()) {
+		if (sent->second.frame!=currentFrame) {
+			sentObjects.erase(sent++);
+			removed = true;
+		} else sent++;
+	}
+
+	return keyframe || removed || !objectUpdates.empty();
+}
+
+void TuioServer::sendObjectFrame(osc::OutboundPacketStream *packet, std::vector<TuioObject*> &updates, long fseq) {
+	int perFragment;
+	int count = fragmentCount(packet->Capacity(), (int)objectList.size(), (int)updates.size(), OBJ_MESSAGE_SIZE, perFragment);
+	if (count==0) {
+		if (!warned) TUIO_LOG_WARNING("the alive message of %d objects exceeds the packet size of %d bytes", (int)objectList.size(), (int)packet->Capacity());
+		warned = true;
+		return;
+	}
+
+	// the set messages are spread evenly over the fragments
+	int size = (int)updates.size();
+	for (int index=0; index<count; index++) {
+		startObjectBundle(packet);
+		if (count>1) addFragmentMessage(packet, "/tuio/2Dobj", fseq, index, count);
+		for (int i=index*size/count; i<(index+1)*size/count; i++) addObjectMessage(packet, updates[i]);
+		sendObjectBundle(packet, fseq);
+	}
+}
+
+void TuioServer::addFragmentMessage(osc::OutboundPacketStream *packet, const char *profile, long fseq, int index, int count) {
+	(*packet) << osc::BeginMessage(profile) << "frag" << (int32)fseq << (int32)index << (int32)count << osc::EndMessage;
+}
+
 void TuioServer::sendEmptyCursorBundle() {
 	oscPacket->Clear();	
 	(*oscPacket) << osc::BeginBundleImmediate;
 	(*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "alive" << osc::EndMessage;	
 	(*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << -1 << osc::EndMessage;
 	(*oscPacket) << osc::EndBundle;
-	socket->Send( oscPacket->Data(), oscPacket->Size() );
+	sendPacket( oscPacket );
 }
 
-void TuioServer::startCursorBundle() {	
-	oscPacket->Clear();	
-	(*oscPacket) << osc::BeginBundleImmediate;
+void TuioServer::startCursorBundle(osc::OutboundPacketStream *packet) {	
+	packet->Clear();	
+	(*packet) << osc::BeginBundleImmediate;
 	
-	(*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "alive";
+	(*packet) << osc::BeginMessage( "/tuio/2Dcur") << "alive";
 	for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++) {
-		(*oscPacket) << (int32)((*tuioCursor)->getSessionID());	
+		(*packet) << (int32)((*tuioCursor)->getSessionID());	
 	}
-	(*oscPacket) << osc::EndMessage;	
+	(*packet) << osc::EndMessage;	
 }
 
-void TuioServer::addCursorMessage(TuioCursor *tcur) {
+void TuioServer::addCursorMessage(osc::OutboundPacketStream *packet, TuioCursor *tcur) {
 
-	 (*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "set";
-	 (*oscPacket) << (int32)(tcur->getSessionID()) << tcur->getX() << tcur->getY();
-	 (*oscPacket) << tcur->getXSpeed() << tcur->getYSpeed() << tcur->getMotionAccel();	
-	 (*oscPacket) << osc::EndMessage;
+	 (*packet) << osc::BeginMessage( "/tuio/2Dcur") << "set";
+	 (*packet) << (int32)(tcur->getSessionID()) << tcur->getX() << tcur->getY();
+	 (*packet) << tcur->getXSpeed() << tcur->getYSpeed() << tcur->getMotionAccel();	
+	 (*packet) << osc::EndMessage;
 }
 
-void TuioServer::sendCursorBundle(long fseq) {
-	(*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << (int32)fseq << osc::EndMessage;
-	(*oscPacket) << osc::EndBundle;
-	socket->Send( oscPacket->Data(), oscPacket->Size() );
+void TuioServer::sendCursorBundle(osc::OutboundPacketStream *packet, long fseq) {
+	(*packet) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << (int32)fseq << osc::EndMessage;
+	(*packet) << osc::EndBundle;
+	sendPacket( packet );
 }
 
 void TuioServer::sendEmptyObjectBundle() {
@@ -477,31 +613,31 @@ void TuioServer::sendEmptyObjectBundle() {
 	(*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "alive" << osc::EndMessage;	
 	(*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "fseq" << -1 << osc::EndMessage;
 	(*oscPacket) << osc::EndBundle;
-	socket->Send( oscPacket->Data(), oscPacket->Size() );
+	sendPacket( oscPacket );
 }
 
-void TuioServer::startObjectBundle() {
-	oscPacket->Clear();	
-	(*oscPacket) << osc::BeginBundleImmediate;
+void TuioServer::startObjectBundle(osc::OutboundPacketStream *packet) {
+	packet->Clear();	
+	(*packet) << osc::BeginBundleImmediate;
 	
-	(*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "alive";
+	(*packet) << osc::BeginMessage( "/tuio/2Dobj") << "alive";
 	for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++) {
-		(*oscPacket) << (int32)((*tuioObject)->getSessionID());	
+		(*packet) << (int32)((*tuioObject)->getSessionID());	
 	}
-	(*oscPacket) << osc::EndMessage;	
+	(*packet) << osc::EndMessage;	
 }
 
-void TuioServer::addObjectMessage(TuioObject *tobj) {
-	(*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "set";
-	(*oscPacket) << (int32)(tobj->getSessionID()) << tobj->getSymbolID() << tobj->getX() << tobj->getY() << tobj->getAngle();
-	(*oscPacket) << tobj->getXSpeed() << tobj->getYSpeed() << tobj->getRotationSpeed() << tobj->getMotionAccel() << tobj->getRotationAccel();	
-	(*oscPacket) << osc::EndMessage;
+void TuioServer::addObjectMessage(osc::OutboundPacketStream *packet, TuioObject *tobj) {
+	(*packet) << osc::BeginMessage( "/tuio/2Dobj") << "set";
+	(*packet) << (int32)(tobj->getSessionID()) << tobj->getSymbolID() << tobj->getX() << tobj->getY() << tobj->getAngle();
+	(*packet) << tobj->getXSpeed() << tobj->getYSpeed() << tobj->getRotationSpeed() << tobj->getMotionAccel() << tobj->getRotationAccel();	
+	(*packet) << osc::EndMessage;
 }
 
-void TuioServer::sendObjectBundle(long fseq) {
-	(*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "fseq" << (int32)fseq << osc::EndMessage;
-	(*oscPacket) << osc::EndBundle;
-	socket->Send( oscPacket->Data(), oscPacket->Size() );
+void TuioServer::sendObjectBundle(osc::OutboundPacketStream *packet, long fseq) {
+	(*packet) << osc::BeginMessage( "/tuio/2Dobj") << "fseq" << (int32)fseq << osc::EndMessage;
+	(*packet) << osc::EndBundle;
+	sendPacket( packet );
 }
 
 TuioObject* TuioServer::getTuioObject(long s_id) {
@@ -0,0 +1,145 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOSHAREDMEMORY_H
+#define INCLUDED_TUIOSHAREDMEMORY_H
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <string>
+
+#define TUIO_SHARED_MEMORY_CAPACITY (1024*1024)
+
+namespace TUIO {
+
+	struct TuioSharedMemoryHeader;
+
+	/**
+	 * <p>A ring of OSC packets in shared memory that carries TUIO from a tracker on the same machine
+	 * to a {@link TuioClient}, without the system calls and copies of a loopback UDP socket. There is
+	 * one producer, the tracker, usually through a {@link TuioServer}, and one consumer. The producer
+	 * copies each packet into the ring once and the consumer decodes it in place.</p>
+	 *
+	 * <p>The consumer only sleeps when the ring is empty. The producer then wakes it with one futex
+	 * wake on Linux, or one event on Windows, for the first packet it sends, and sends without any
+	 * system call while the consumer is busy. A packet that does not fit the free space is dropped,
+	 * like a datagram that overflows a socket buffer.</p>
+	 *
+	 * <p>Whichever side comes first creates the ring, the other one maps it. The consumer marks the
+	 * ring closed when it goes away, the producer then maps the ring of the next consumer. On Windows
+	 * the name is created in the session namespace unless it starts with "Global\", which a service
+	 * has to use to share the ring with a tracker in a user session.</p>
+	 */
+	class TuioSharedMemory {
+
+	public:
+		/**
+		 * Creates or maps the named ring
+		 *
+		 * @param  name  the name of the ring
+		 * @param  capacity  the size of the ring in bytes if it is created, rounded up to 4 KB
+		 */
+		TuioSharedMemory(const char *name, int capacity=TUIO_SHARED_MEMORY_CAPACITY);
+
+		/**
+		 * Unmaps the ring, it is removed once neither side maps it
+		 */
+		~TuioSharedMemory();
+
+		/**
+		 * Returns true if the ring could be created or mapped
+		 * @return	true if the ring is mapped
+		 */
+		bool isOpen() const { return header!=NULL; }
+
+		/**
+		 * Returns the size of the largest packet the ring takes, a quarter of its capacity
+		 * @return	the maximum packet size in bytes
+		 */
+		int getMaxPacketSize() const;
+
+		/**
+		 * Copies a packet into the ring and wakes the consumer if it sleeps. Only one thread may send.
+		 *
+		 * @param  data	the OSC packet
+		 * @param  size	the size of the packet in bytes
+		 * @return	false if the packet was dropped because the ring is full
+		 */
+		bool send(const char *data, int size);
+
+		/**
+		 * Waits for the next packet. The packet stays valid and its space is not reused until
+		 * releasePacket() is called. Only one thread may receive.
+		 *
+		 * @param  data	the start of the packet in the ring
+		 * @param  size	the size of the packet in bytes
+		 * @param  sendTime	the time the producer sent the packet, in GetCurrentTimeNanoseconds() nanoseconds
+		 * @return	false if breakReceive() was called
+		 */
+		bool nextPacket(const char *&data, int &size, long long &sendTime);
+
+		/**
+		 * Hands the space of the packet returned by nextPacket() back to the producer
+		 */
+		void releasePacket();
+
+		/**
+		 * Makes the current or the next call to nextPacket() return false, from any thread
+		 */
+		void breakReceive();
+
+		/**
+		 * Returns the number of packets the producer sent
+		 * @return	the number of packets sent
+		 */
+		long long getSentPackets() const;
+
+		/**
+		 * Returns the number of packets the producer dropped because the ring was full
+		 * @return	the number of packets dropped
+		 */
+		long long getDroppedPackets() const;
+
+	private:
+		bool open();
+		void close();
+		void wakeConsumer();
+		void waitForProducer(int doorbell);
+
+		std::string name;
+		int requestedCapacity;
+
+		TuioSharedMemoryHeader *header;
+		char *ring;
+		int capacity;
+		bool consumer;
+		long long readPosition;
+		volatile long stopped;
+
+#ifndef WIN32
+		int mappingSize;
+#else
+		HANDLE mapping;
+		HANDLE doorbellEvent;
+#endif
+	};
+};
+#endif /* INCLUDED_TUIOSHAREDMEMORY_H */
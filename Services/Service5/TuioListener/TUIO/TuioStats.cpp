@@ -0,0 +1,310 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioStats.h"
+#include "TuioLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace TUIO;
+
+// largest report answered in a single datagram
+#define TUIO_STATS_MAX_REPLY 65000
+// control connections open at the same time
+#define TUIO_STATS_MAX_CONNECTIONS 4
+
+TuioMutex TuioStats::sourceMutex;
+std::list<TuioStatsSource*> TuioStats::sourceList;
+
+static void appendJsonString(std::string &json, const char *value) {
+	json += '"';
+	for (const char *c=value; *c!=0; c++) {
+		if ((*c=='"') || (*c=='\\')) json += '\\';
+		if ((unsigned char)*c>=0x20) json += *c;
+	}
+	json += '"';
+}
+
+void TuioStatsReport::beginSection(const char *name) {
+	section = name;
+}
+
+std::string& TuioStatsReport::members() {
+	for (size_t i=0; i<objects.size(); i++) {
+		if (objects[i].first==section) return objects[i].second;
+	}
+	objects.push_back(std::make_pair(section, std::string()));
+	return objects.back().second;
+}
+
+void TuioStatsReport::addValue(const char *key, long long value) {
+	char line[128];
+	if (format==JSON) {
+		std::string &json = members();
+		if (!json.empty()) json += ',';
+		appendJsonString(json, key);
+		sprintf(line, ":%lld", value);
+		json += line;
+		return;
+	}
+	sprintf(line, "%s %s %lld\n", section.c_str(), key, value);
+	text += line;
+}
+
+void TuioStatsReport::addHistogram(const char *key, const TuioHistogram &histogram) {
+	char line[192];
+	if (format==JSON) {
+		std::string &json = members();
+		if (!json.empty()) json += ',';
+		appendJsonString(json, key);
+		sprintf(line, ":{\"count\":%lld,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}", histogram.getCount(),
+			histogram.getPercentile(50.0)/1000.0, histogram.getPercentile(99.0)/1000.0, histogram.getPercentile(99.9)/1000.0, histogram.getMax()/1000.0);
+		json += line;
+		return;
+	}
+	sprintf(line, "%s %s count %lld p50 %.1fus p99 %.1fus p999 %.1fus max %.1fus\n", section.c_str(), key, histogram.getCount(),
+		histogram.getPercentile(50.0)/1000.0, histogram.getPercentile(99.0)/1000.0, histogram.getPercentile(99.9)/1000.0, histogram.getMax()/1000.0);
+	text += line;
+}
+
+std::string TuioStatsReport::getText() const {
+	if (format==TEXT) return text;
+
+	std::string json = "{";
+	for (size_t i=0; i<objects.size(); i++) {
+		if (i>0) json += ',';
+		appendJsonString(json, objects[i].first.c_str());
+		json += ":{" + objects[i].second + "}";
+	}
+	json += "}";
+	return json;
+}
+
+void TuioStats::addSource(TuioStatsSource *source) {
+	TuioScopedLock lock(sourceMutex);
+	sourceList.push_back(source);
+}
+
+void TuioStats::removeSource(TuioStatsSource *source) {
+	TuioScopedLock lock(sourceMutex);
+	sourceList.remove(source);
+}
+
+std::string TuioStats::getReport(TuioStatsReport::Format format) {
+	TuioStatsReport report(format);
+	TuioScopedLock lock(sourceMutex);
+	for (std::list<TuioStatsSource*>::iterator iter=sourceList.begin(); iter != sourceList.end(); iter++)
+		(*iter)->writeStats(report);
+	return report.getText();
+}
+
+void TuioStats::reset() {
+	TuioScopedLock lock(sourceMutex);
+	for (std::list<TuioStatsSource*>::iterator iter=sourceList.begin(); iter != sourceList.end(); iter++)
+		(*iter)->resetStats();
+}
+
+TuioSocketStats::TuioSocketStats(const char *n, UdpSocket *s)
+: socket(s)
+{
+	strncpy(name, n, sizeof(name)-1);
+	name[sizeof(name)-1] = 0;
+	memset(&baseline, 0, sizeof(baseline));
+	TuioStats::addSource(this);
+}
+
+TuioSocketStats::~TuioSocketStats() {
+	TuioStats::removeSource(this);
+}
+
+void TuioSocketStats::writeStats(TuioStatsReport &report) {
+	UdpSocketStatistics statistics = socket->Statistics();
+	report.beginSection(name);
+	report.addValue("datagrams", (long long)(statistics.datagrams-baseline.datagrams));
+	report.addValue("bytes", (long long)(statistics.bytes-baseline.bytes));
+	report.addValue("kernel_drops", (long long)(statistics.kernelDrops-baseline.kernelDrops));
+	report.addValue("truncated", (long long)(statistics.truncated-baseline.truncated));
+	report.addValue("rcvbuf", socket->ReceiveBufferSize());
+}
+
+void TuioSocketStats::resetStats() {
+	// the socket counters are owned by the receiving thread, remember where we started instead
+	baseline = socket->Statistics();
+}
+
+TuioFrameStats::TuioFrameStats(const char *n)
+: frames  (0)
+, late    (0)
+, dropped (0)
+, contacts(0)
+{
+	setName(n);
+	TuioStats::addSource(this);
+}
+
+TuioFrameStats::~TuioFrameStats() {
+	TuioStats::removeSource(this);
+}
+
+void TuioFrameStats::setName(const char *n) {
+	strncpy(name, n, sizeof(name)-1);
+	name[sizeof(name)-1] = 0;
+}
+
+void TuioFrameStats::writeStats(TuioStatsReport &report) {
+	report.beginSection(name);
+	report.addValue("frames", atomicLoad64(&frames));
+	report.addValue("late_frames", atomicLoad64(&late));
+	report.addValue("dropped_frames", atomicLoad64(&dropped));
+	report.addValue("contacts", atomicLoad64(&contacts));
+}
+
+void TuioFrameStats::resetStats() {
+	// the contacts are a gauge, they stay
+	atomicStore64(&frames, 0);
+	atomicStore64(&late, 0);
+	atomicStore64(&dropped, 0);
+}
+
+// answers the lines of the control connections, on the connection they arrived on
+class TUIO::TuioControlReceiver : public PacketListener {
+public:
+	TuioControlReceiver(TuioStatsEndpoint *e):endpoint(e) {}
+	void ProcessPacket( const char *data, int size, const IpEndpointName& remoteEndpoint ) {
+		std::string reply = endpoint->answer(data, size);
+		endpoint->controlSocket->SendTo(remoteEndpoint, reply.data(), (int)reply.size());
+	}
+private:
+	TuioStatsEndpoint *endpoint;
+};
+
+TuioStatsEndpoint::TuioStatsEndpoint(int port, int dumpSeconds, int controlPort, TuioControlListener *listener)
+: socket         (NULL)
+, controlSocket  (NULL)
+, controlReceiver(NULL)
+, controlListener(listener)
+, dumpSeconds    (dumpSeconds)
+{
+	if (port>0) {
+		try {
+			socket = new UdpReceiveSocket(IpEndpointName( 127, 0, 0, 1, port ));
+			TUIO_LOG_INFO("statistics on UDP port %d", port);
+		} catch (std::exception &e) {
+			TUIO_LOG_ERROR("could not bind statistics endpoint to UDP port %d", port);
+			socket = NULL;
+		}
+	}
+
+	if (controlPort>0) {
+		try {
+			controlSocket = new TcpListeningSocket(IpEndpointName( 127, 0, 0, 1, controlPort ), StreamDecoder::LINE_FRAMING, TUIO_STATS_MAX_CONNECTIONS);
+			controlReceiver = new TuioControlReceiver(this);
+			TUIO_LOG_INFO("statistics and control on TCP port %d", controlPort);
+		} catch (std::exception &e) {
+			TUIO_LOG_ERROR("could not bind control endpoint to TCP port %d", controlPort);
+			controlSocket = NULL;
+		}
+	}
+}
+
+TuioStatsEndpoint::~TuioStatsEndpoint() {
+	delete socket;
+	delete controlSocket;
+	delete controlReceiver;
+}
+
+void TuioStatsEndpoint::attach(SocketReceiveMultiplexer &multiplexer) {
+	if (socket!=NULL) multiplexer.AttachSocketListener(socket, this);
+	if (controlSocket!=NULL) multiplexer.AttachStreamListener(controlSocket, controlReceiver);
+	if (dumpSeconds>0) multiplexer.AttachPeriodicTimerListener(dumpSeconds*1000, this);
+}
+
+void TuioStatsEndpoint::detach(SocketReceiveMultiplexer &multiplexer) {
+	if (socket!=NULL) multiplexer.DetachSocketListener(socket, this);
+	if (controlSocket!=NULL) multiplexer.DetachStreamListener(controlSocket, controlReceiver);
+	if (dumpSeconds>0) multiplexer.DetachPeriodicTimerListener(this);
+}
+
+std::string TuioStatsEndpoint::answer(const char *data, int size) {
+	std::string request(data, size);
+	size_t end = request.find_last_not_of(" \t\r\n");
+	request.erase((end==std::string::npos) ? 0 : end+1);
+
+	bool json = false;
+	if (request=="json") {
+		json = true;
+		request.clear();
+	} else if ((request.size()>5) && (request.compare(request.size()-5, 5, " json")==0)) {
+		json = true;
+		request.erase(request.size()-5);
+	}
+
+	size_t start = request.find_first_not_of(" \t");
+	if (start==std::string::npos) start = request.size();
+	size_t space = request.find_first_of(" \t", start);
+	std::string command = request.substr(start, space-start);
+	std::string argument;
+	if (space!=std::string::npos) {
+		size_t argumentStart = request.find_first_not_of(" \t", space);
+		if (argumentStart!=std::string::npos) argument = request.substr(argumentStart);
+	}
+
+	if (command.empty() || (command=="stats")) {
+		if (json) return TuioStats::getReport(TuioStatsReport::JSON)+"\n";
+		return TuioStats::getReport()+"\n";
+	}
+
+	bool ok = false;
+	std::string message;
+	if (command=="reset") {
+		TuioStats::reset();
+		ok = true;
+		message = "statistics reset";
+	} else if (controlListener!=NULL) {
+		ok = controlListener->processCommand(command, argument, message);
+	}
+	if (!ok && message.empty()) message = "unknown command "+command;
+
+	if (json) {
+		std::string reply = ok ? "{\"ok\":true,\"message\":" : "{\"ok\":false,\"message\":";
+		appendJsonString(reply, message.c_str());
+		return reply+"}\n";
+	}
+	return (ok ? "ok " : "error ")+message+"\n";
+}
+
+void TuioStatsEndpoint::ProcessPacket( const char *data, int size, const IpEndpointName &remoteEndpoint ) {
+	std::string reply = answer(data, size);
+	int length = (int)reply.size();
+	if (length>TUIO_STATS_MAX_REPLY) length = TUIO_STATS_MAX_REPLY;
+	socket->SendTo(remoteEndpoint, reply.data(), length);
+}
+
+void TuioStatsEndpoint::TimerExpired() {
+	std::string report = TuioStats::getReport();
+	size_t start = 0;
+	while (start<report.size()) {
+		size_t end = report.find('\n', start);
+		if (end==std::string::npos) end = report.size();
+		// not rate limited, the dump is periodic by itself
+		TuioLog::write(TUIO_LOG_LEVEL_INFO, NULL, "%.*s", (int)(end-start), report.c_str()+start);
+		start = end+1;
+	}
+}
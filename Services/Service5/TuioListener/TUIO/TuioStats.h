@@ -0,0 +1,254 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCLUDED_TUIOSTATS_H
+#define INCLUDED_TUIOSTATS_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "ip/UdpSocket.h"
+#include "ip/TcpListeningSocket.h"
+#include "ip/PacketListener.h"
+#include "ip/TimerListener.h"
+
+#include "TuioHistogram.h"
+#include "TuioLock.h"
+
+namespace TUIO {
+
+	/**
+	 * Collects the values of all statistics sources into a text report, one line per value,
+	 * or into a JSON object with one member object per source
+	 */
+	class TuioStatsReport {
+
+	public:
+		enum Format { TEXT, JSON };
+
+		TuioStatsReport(Format f=TEXT) : format(f) {}
+
+		/**
+		 * Starts the values of one source, all following lines are prefixed with its name
+		 */
+		void beginSection(const char *name);
+
+		/**
+		 * Adds a counter or gauge
+		 */
+		void addValue(const char *key, long long value);
+
+		/**
+		 * Adds the count, p50, p99, p999 and maximum of a histogram of nanosecond durations
+		 */
+		void addHistogram(const char *key, const TuioHistogram &histogram);
+
+		/**
+		 * Returns the report text, sources with the same name share one object in JSON
+		 */
+		std::string getText() const;
+
+	private:
+		Format format;
+		std::string section;
+		std::string text;
+		// the members of each JSON object, in the order the sources were added
+		std::vector<std::pair<std::string, std::string> > objects;
+		std::string& members();
+	};
+
+	/**
+	 * Interface of everything that contributes to the statistics report
+	 */
+	class TuioStatsSource {
+
+	public:
+		virtual ~TuioStatsSource() { };
+
+		/**
+		 * Adds the current values to the report, called from the thread that asks for the report
+		 */
+		virtual void writeStats(TuioStatsReport &report) = 0;
+
+		/**
+		 * Clears the accumulated values
+		 */
+		virtual void resetStats() = 0;
+	};
+
+	/**
+	 * The TuioStats class is the process-wide registry of statistics sources
+	 */
+	class TuioStats {
+
+	public:
+		static void addSource(TuioStatsSource *source);
+		static void removeSource(TuioStatsSource *source);
+
+		/**
+		 * Returns the report of all registered sources
+		 */
+		static std::string getReport(TuioStatsReport::Format format=TuioStatsReport::TEXT);
+
+		/**
+		 * Clears the values of all registered sources
+		 */
+		static void reset();
+
+	private:
+		static TuioMutex sourceMutex;
+		static std::list<TuioStatsSource*> sourceList;
+	};
+
+	/**
+	 * Reports the receive counters and the kernel receive buffer size of a UdpSocket
+	 */
+	class TuioSocketStats : public TuioStatsSource {
+
+	public:
+		/**
+		 * @param	name	the sensor name used in the statistics report
+		 * @param	socket	the socket to report, owned by the caller
+		 */
+		TuioSocketStats(const char *name, UdpSocket *socket);
+		~TuioSocketStats();
+
+		void writeStats(TuioStatsReport &report);
+		void resetStats();
+
+	private:
+		char name[32];
+		UdpSocket *socket;
+		UdpSocketStatistics baseline;
+	};
+
+	/**
+	 * Counts the frames a TuioClient passed to its listeners, the late frames it skipped because
+	 * a newer frame was passed on already, and the frames it dropped because fragments were
+	 * missing. Only the receiving thread counts.
+	 */
+	class TuioFrameStats : public TuioStatsSource {
+
+	public:
+		/**
+		 * @param	name	the sensor name used in the statistics report
+		 */
+		TuioFrameStats(const char *name);
+		~TuioFrameStats();
+
+		/**
+		 * Changes the sensor name used in the statistics report
+		 */
+		void setName(const char *name);
+
+		/**
+		 * Counts a frame that was passed on, with the number of contacts that are down after it
+		 */
+		void frame(int contactCount) {
+			atomicAdd64(&frames, 1);
+			atomicStore64(&contacts, contactCount);
+		}
+
+		void lateFrame() { atomicAdd64(&late, 1); }
+		void droppedFrame() { atomicAdd64(&dropped, 1); }
+
+		void writeStats(TuioStatsReport &report);
+		void resetStats();
+
+	private:
+		char name[32];
+		volatile long long frames, late, dropped, contacts;
+	};
+
+	/**
+	 * Interface of the objects that carry out the commands of a {@link TuioStatsEndpoint} which
+	 * change the running service, such as reloading the configuration or capturing a trace
+	 */
+	class TuioControlListener {
+
+	public:
+		virtual ~TuioControlListener() { };
+
+		/**
+		 * Called on the thread of the endpoint, which receives the frames as well. Work that takes
+		 * longer than answering a request has to be handed to another thread.
+		 *
+		 * @param	command	the first word of the request
+		 * @param	argument	the rest of the request, empty if there is none
+		 * @param	reply	receives a short message for the requester
+		 * @return	false if the command is unknown or failed, the reply says why
+		 */
+		virtual bool processCommand(const std::string &command, const std::string &argument, std::string &reply) = 0;
+	};
+
+	class TuioControlReceiver;
+
+	/**
+	 * <p>The TuioStatsEndpoint class makes the statistics report available on a local UDP port
+	 * and a local TCP port, and writes it to the log periodically. It runs on the
+	 * SocketReceiveMultiplexer of the TuioClient, so answering a request never needs another
+	 * thread, and the receiving of frames pays nothing while nobody asks.</p>
+	 * <p>A request is a datagram sent to 127.0.0.1:port, or a line sent on a connection to
+	 * 127.0.0.1:controlPort, in the form "command [argument] [json]":</p>
+	 * <ul>
+	 * <li>"stats", or a request without a command, answers the report, followed by an empty line</li>
+	 * <li>"reset" clears the values of all sources</li>
+	 * <li>any other command is passed to the {@link TuioControlListener}</li>
+	 * </ul>
+	 * <p>Commands are answered with "ok message" or "error message". With "json" at the end,
+	 * the report is a JSON object and the answer {"ok":true,"message":"..."}, on one line.</p>
+	 */
+	class TuioStatsEndpoint : public PacketListener, public TimerListener {
+
+	public:
+		/**
+		 * @param	port	the local UDP port to answer requests on, or 0 for no endpoint
+		 * @param	dumpSeconds	the period of the log dump in seconds, or 0 for no dump
+		 * @param	controlPort	the local TCP port to answer requests on, or 0 for none
+		 * @param	listener	carries out the other commands, or NULL to refuse them
+		 */
+		TuioStatsEndpoint(int port, int dumpSeconds, int controlPort=0, TuioControlListener *listener=NULL);
+		~TuioStatsEndpoint();
+
+		/**
+		 * Attaches the endpoint sockets and dump timer, the multiplexer must not be running
+		 */
+		void attach(SocketReceiveMultiplexer &multiplexer);
+
+		/**
+		 * Detaches the endpoint sockets and dump timer, the multiplexer must not be running
+		 */
+		void detach(SocketReceiveMultiplexer &multiplexer);
+
+		void ProcessPacket( const char *data, int size, const IpEndpointName &remoteEndpoint );
+		void TimerExpired();
+
+	private:
+		friend class TuioControlReceiver;
+		std::string answer(const char *data, int size);
+
+		UdpSocket *socket;
+		TcpListeningSocket *controlSocket;
+		TuioControlReceiver *controlReceiver;
+		TuioControlListener *controlListener;
+		int dumpSeconds;
+	};
+};
+#endif /* INCLUDED_TUIOSTATS_H */
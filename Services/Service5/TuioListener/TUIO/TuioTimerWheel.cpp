@@ -0,0 +1,350 @@
+/*
+ TUIO C++ Library - part of the reacTIVision project
+ http://reactivision.sourceforge.net/
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TuioTimerWheel.h"
+#include "TuioLog.h"
+
+#ifndef WIN32
+#include <time.h>
+#include <unistd.h>
+#else
+#include "ip/NetworkingUtils.h"
+#endif
+
+using namespace TUIO;
+
+#define TUIO_TIMER_SLOT_MASK (TUIO_TIMER_SLOTS-1)
+// the longest delay the top level holds, longer timers are cascaded again
+#define TUIO_TIMER_MAX_TICKS ((1LL<<(TUIO_TIMER_SLOT_BITS*TUIO_TIMER_LEVELS))-1)
+
+namespace TUIO {
+
+	// a scheduled listener, linked into a slot of the wheel, or a slot head
+	struct TuioTimerEntry {
+		TimerListener *listener;
+		long long period;
+		long long expiry;
+		TuioTimerEntry *prev, *next;
+		bool cancelled;
+		bool rescheduled;
+	};
+}
+
+static TuioTimerEntry* newEntry(TimerListener *listener) {
+	TuioTimerEntry *entry = new TuioTimerEntry;
+	entry->listener = listener;
+	entry->period = entry->expiry = 0;
+	entry->prev = entry->next = entry;
+	entry->cancelled = entry->rescheduled = false;
+	return entry;
+}
+
+static void unlinkEntry(TuioTimerEntry *entry) {
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+	entry->prev = entry->next = entry;
+}
+
+static void linkEntry(TuioTimerEntry *head, TuioTimerEntry *entry) {
+	entry->prev = head->prev;
+	entry->next = head;
+	head->prev->next = entry;
+	head->prev = entry;
+}
+
+// moves all entries of a slot to an empty list
+static void spliceEntries(TuioTimerEntry *head, TuioTimerEntry *list) {
+	if (head->next==head) return;
+	list->next = head->next;
+	list->prev = head->prev;
+	list->next->prev = list;
+	list->prev->next = list;
+	head->prev = head->next = head;
+}
+
+static TuioMutex sharedMutex;
+static TuioTimerWheel *sharedWheel = NULL;
+
+TuioTimerWheel* TuioTimerWheel::getShared() {
+	TuioScopedLock lock(sharedMutex);
+	if (sharedWheel==NULL) sharedWheel = new TuioTimerWheel();
+	return sharedWheel;
+}
+
+TuioTimerWheel::TuioTimerWheel(int resolution)
+: resolution (resolution>0 ? resolution : TUIO_TIMER_RESOLUTION)
+, tick       (0)
+, advanced   (0)
+, current    (NULL)
+, dispatching(0)
+, running    (0)
+, threadStarted(false)
+{
+	origin = currentTime();
+	for (int level=0; level<TUIO_TIMER_LEVELS; level++)
+		for (int index=0; index<TUIO_TIMER_SLOTS; index++)
+			slots[level][index] = newEntry(NULL);
+}
+
+TuioTimerWheel::~TuioTimerWheel() {
+	if (threadStarted) {
+		atomicStore(&running, 0);
+#ifndef WIN32
+		pthread_join(thread, NULL);
+#else
+		WaitForSingleObject(thread, INFINITE);
+		CloseHandle(thread);
+#endif
+	}
+
+	for (std::map<TimerListener*, TuioTimerEntry*>::iterator iter=entryMap.begin(); iter!=entryMap.end(); iter++)
+		delete iter->second;
+	for (int level=0; level<TUIO_TIMER_LEVELS; level++)
+		for (int index=0; index<TUIO_TIMER_SLOTS; index++)
+			delete slots[level][index];
+}
+
+// a monotonic clock, the realtime clock of the multiplexer may jump
+long long TuioTimerWheel::currentTime() const {
+#ifndef WIN32
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec*1000000000LL+ts.tv_nsec;
+#else
+	return GetCurrentTimeNanoseconds();
+#endif
+}
+
+bool TuioTimerWheel::isDispatchThread() {
+	if (!atomicLoad(&dispatching)) return false;
+#ifndef WIN32
+	return pthread_equal(dispatchThread, pthread_self())!=0;
+#else
+	return dispatchThread==GetCurrentThreadId();
+#endif
+}
+
+// listeners may schedule and cancel timers from within TimerExpired(), the dispatching thread already holds the mutex
+void TuioTimerWheel::lock() {
+	if (!isDispatchThread()) mutex.lock();
+}
+
+void TuioTimerWheel::unlock() {
+	if (!isDispatchThread()) mutex.unlock();
+}
+
+void TuioTimerWheel::insert(TuioTimerEntry *entry) {
+	long long expiry = entry->expiry;
+	long long delay = expiry-tick;
+
+	TuioTimerEntry *head;
+	if (delay<0) {
+		// already due, expires with the next tick
+		head = slots[0][tick & TUIO_TIMER_SLOT_MASK];
+	} else {
+		if (delay>TUIO_TIMER_MAX_TICKS) {
+			// the entry keeps its expiry and is put back into the wheel once its slot comes around
+			expiry = tick+TUIO_TIMER_MAX_TICKS;
+			delay = TUIO_TIMER_MAX_TICKS;
+		}
+		int level = 0;
+		while ((level<TUIO_TIMER_LEVELS-1) && (delay>=(1LL<<(TUIO_TIMER_SLOT_BITS*(level+1))))) level++;
+		head = slots[level][(expiry>>(TUIO_TIMER_SLOT_BITS*level)) & TUIO_TIMER_SLOT_MASK];
+	}
+	linkEntry(head, entry);
+}
+
+// moves the entries of a slot one level down, on the tick the slot covers
+void TuioTimerWheel::cascade(int level, int index) {
+	TuioTimerEntry list;
+	list.prev = list.next = &list;
+	spliceEntries(slots[level][index], &list);
+	while (list.next!=&list) {
+		TuioTimerEntry *entry = list.next;
+		unlinkEntry(entry);
+		insert(entry);
+	}
+}
+
+void TuioTimerWheel::expire(TuioTimerEntry *list, long long target) {
+	while (list->next!=list) {
+		TuioTimerEntry *entry = list->next;
+		unlinkEntry(entry);
+		if (entry->expiry>=tick) {
+			// held back at the top level
+			insert(entry);
+			continue;
+		}
+
+		current = entry;
+		entry->listener->TimerExpired();
+		current = NULL;
+
+		if (entry->cancelled) {
+			delete entry;
+			continue;
+		}
+		if (entry->rescheduled) {
+			entry->rescheduled = false;
+		} else {
+			// skip the periods that were missed while the wheel was not advanced, rather than catching up in a burst
+			entry->expiry += entry->period;
+			if (entry->expiry<=target) entry->expiry += ((target-entry->expiry)/entry->period+1)*entry->period;
+		}
+		insert(entry);
+	}
+}
+
+void TuioTimerWheel::step() {
+	if (isDispatchThread()) return;
+
+	TuioScopedLock scopedLock(mutex);
+#ifndef WIN32
+	dispatchThread = pthread_self();
+#else
+	dispatchThread = GetCurrentThreadId();
+#endif
+	atomicStore(&dispatching, 1);
+
+	long long target = (currentTime()-origin)/(resolution*1000000LL);
+	if (entryMap.empty() && (tick<=target)) tick = target+1;
+
+	TuioTimerEntry expired;
+	expired.prev = expired.next = &expired;
+	while (tick<=target) {
+		int index = (int)(tick & TUIO_TIMER_SLOT_MASK);
+		for (int level=1; (index==0) && (level<TUIO_TIMER_LEVELS); level++) {
+			index = (int)((tick>>(TUIO_TIMER_SLOT_BITS*level)) & TUIO_TIMER_SLOT_MASK);
+			cascade(level, index);
+		}
+
+		spliceEntries(slots[0][tick & TUIO_TIMER_SLOT_MASK], &expired);
+		tick++;
+		expire(&expired, target);
+	}
+
+	atomicStore(&dispatching, 0);
+}
+
+void TuioTimerWheel::advance() {
+	atomicStore(&advanced, 1);
+	step();
+}
+
+void TuioTimerWheel::TimerExpired() {
+	advance();
+}
+
+void TuioTimerWheel::schedule(TimerListener *listener, int period, int initialDelay) {
+	if (listener==NULL) return;
+
+	long long periodTicks = (period+resolution-1)/resolution;
+	if (periodTicks<1) periodTicks = 1;
+	else if (periodTicks>TUIO_TIMER_MAX_TICKS) periodTicks = TUIO_TIMER_MAX_TICKS;
+	long long delayTicks = periodTicks;
+	if (initialDelay>=0) delayTicks = (initialDelay+resolution-1)/resolution;
+
+	lock();
+	long long now = (currentTime()-origin)/(resolution*1000000LL);
+	// an idle wheel is not advanced, it starts over at the current tick
+	if (entryMap.empty() && (tick<now)) tick = now;
+
+	TuioTimerEntry *entry;
+	std::map<TimerListener*, TuioTimerEntry*>::iterator iter = entryMap.find(listener);
+	if (iter!=entryMap.end()) {
+		entry = iter->second;
+		if (entry!=current) unlinkEntry(entry);
+	} else {
+		entry = newEntry(listener);
+		entryMap[listener] = entry;
+	}
+
+	entry->period = periodTicks;
+	entry->expiry = now+delayTicks;
+	if (entry==current) entry->rescheduled = true;
+	else insert(entry);
+
+	startThread();
+	unlock();
+}
+
+void TuioTimerWheel::cancel(TimerListener *listener) {
+	lock();
+	std::map<TimerListener*, TuioTimerEntry*>::iterator iter = entryMap.find(listener);
+	if (iter!=entryMap.end()) {
+		TuioTimerEntry *entry = iter->second;
+		entryMap.erase(iter);
+		// the entry being dispatched is deleted once its listener returns
+		if (entry==current) entry->cancelled = true;
+		else {
+			unlinkEntry(entry);
+			delete entry;
+		}
+	}
+	unlock();
+}
+
+bool TuioTimerWheel::isScheduled(TimerListener *listener) {
+	lock();
+	bool scheduled = (entryMap.find(listener)!=entryMap.end());
+	unlock();
+	return scheduled;
+}
+
+void TuioTimerWheel::attach(SocketReceiveMultiplexer &multiplexer) {
+	multiplexer.AttachPeriodicTimerListener(resolution, this);
+}
+
+void TuioTimerWheel::detach(SocketReceiveMultiplexer &multiplexer) {
+	multiplexer.DetachPeriodicTimerListener(this);
+}
+
+// the caller holds the mutex
+void TuioTimerWheel::startThread() {
+	if (threadStarted) return;
+
+	atomicStore(&running, 1);
+#ifndef WIN32
+	threadStarted = (pthread_create(&thread, NULL, threadFunc, this)==0);
+#else
+	DWORD threadId;
+	thread = CreateThread(0, 0, threadFunc, this, 0, &threadId);
+	threadStarted = (thread!=NULL);
+#endif
+	if (!threadStarted) TUIO_LOG_ERROR("could not start the timer thread, timers only run on an attached multiplexer");
+}
+
+// advances the wheel whenever no multiplexer did within the last tick
+#ifndef WIN32
+void* TuioTimerWheel::threadFunc( void* obj )
+#else
+DWORD WINAPI TuioTimerWheel::threadFunc( LPVOID obj )
+#endif
+{
+	TuioTimerWheel *wheel = static_cast<TuioTimerWheel*>(obj);
+	while (atomicLoad(&wheel->running)) {
+#ifndef WIN32
+		usleep(wheel->resolution*1000);
+#else
+		Sleep(wheel->resolution);
+#endif
+		if (!atomicExchange(&wheel->advanced, 0)) wheel->step();
+	}
+	return 0;
+}
@@ -0,0 +1,77 @@
+/*
+	TUIO C++ Example - part of the reacTIVision project
+	http://reactivision.sourceforge.net/
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef INCLUDED_TUIOPROFILE_H
+#define INCLUDED_TUIOPROFILE_H
+
+#include "TuioConfig.h"
+
+using namespace TUIO;
+
+/**
+ * <p>The TuioProfile reads the settings of the sensors from one XML file, with TinyXML, in the
+ * layout described by tuio_ports.xsd:</p>
+ *
+ * <pre>
+ * &lt;profile&gt;
+ *   &lt;sensor id="1"&gt;
+ *     &lt;input port="3333" stats_port="3340" control_port="3341" rcvbuf="1048576" receive_backend="select" stream_port="" shared_memory="" multicast_group="" multicast_source=""/&gt;
+ *     &lt;transform invert_x="False" invert_y="False" swap_xy="False"&gt;
+ *       &lt;point sensor_x="0.1" sensor_y="0.1" screen_x="0.12" screen_y="0.09"/&gt;
+ *     &lt;/transform&gt;
+ *     &lt;filter&gt;oneeuro 1.0 40 2.0&lt;/filter&gt;
+ *     &lt;prediction&gt;auto&lt;/prediction&gt;
+ *     &lt;display xrange_min="0" xrange_max="1" yrange_min="0" yrange_max="1" x_offset="0" y_offset="0"/&gt;
+ *     &lt;output device="1" frame_mirror="Global\TuioFrames1"&gt;
+ *       &lt;relay host="192.168.1.20" port="3333"/&gt;
+ *       &lt;calibrated_relay host="localhost" port="3334"/&gt;
+ *     &lt;/output&gt;
+ *     &lt;threads receive_thread="realtime 80 cpu 2" relay_thread="high" lock_memory="true"/&gt;
+ *   &lt;/sensor&gt;
+ * &lt;/profile&gt;
+ * </pre>
+ *
+ * <p>The settings of a sensor are returned in the keys of the TuioConfig of sensorN.cfg, so that
+ * both are compiled the same way. Only the settings that are present are returned.</p>
+ */
+class TuioProfile {
+
+	public:
+		/**
+		 * Reads the settings of a sensor from a profile
+		 *
+		 * @param  path	the profile to read
+		 * @param  sensor	the id of the sensor
+		 * @param  config	receives the settings of the sensor
+		 * @return	false if the profile could not be read or has no such sensor
+		 */
+		static bool load(const char *path, int sensor, TuioConfig &config);
+};
+
+#endif /* INCLUDED_TUIOPROFILE_H */
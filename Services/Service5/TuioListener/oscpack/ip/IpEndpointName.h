@@ -33,37 +33,59 @@
 
 class IpEndpointName{
     static unsigned long GetHostByName( const char *s );
+    void SetAddressName( const char *s );
+    void SetAddress6( const unsigned char *address6_ );
 public:
     static const unsigned long ANY_ADDRESS = 0xFFFFFFFF;
     static const int ANY_PORT = -1;
 
     IpEndpointName()
-		: address( ANY_ADDRESS ), port( ANY_PORT ) {}
+		: address( ANY_ADDRESS ), port( ANY_PORT ), isIpv6( false ) { ClearAddress6(); }
     IpEndpointName( int port_ ) 
-		: address( ANY_ADDRESS ), port( port_ ) {}
+		: address( ANY_ADDRESS ), port( port_ ), isIpv6( false ) { ClearAddress6(); }
     IpEndpointName( unsigned long ipAddress_, int port_ ) 
-		: address( ipAddress_ ), port( port_ ) {}
+		: address( ipAddress_ ), port( port_ ), isIpv6( false ) { ClearAddress6(); }
+    // names that contain a colon are IPv6 addresses like "ff15::7475:696f",
+    // everything else is resolved to an IPv4 address
     IpEndpointName( const char *addressName, int port_=ANY_PORT )
-		: address( GetHostByName( addressName ) )
-		, port( port_ ) {}
+		: port( port_ ) { SetAddressName( addressName ); }
     IpEndpointName( int addressA, int addressB, int addressC, int addressD, int port_=ANY_PORT )
 		: address( ( (addressA << 24) | (addressB << 16) | (addressC << 8) | addressD ) )
-		, port( port_ ) {}
+		, port( port_ ), isIpv6( false ) { ClearAddress6(); }
+    // an IPv6 endpoint from 16 address bytes in network byte order. IPv4
+    // mapped addresses (::ffff:a.b.c.d) become IPv4 endpoints
+    IpEndpointName( const unsigned char *address6_, int port_ )
+		: port( port_ ) { SetAddress6( address6_ ); }
 
 	// address and port are maintained in host byte order here
     unsigned long address;
     int port;
 
-	enum { ADDRESS_STRING_LENGTH=17 };
+	// IPv6 endpoints keep their address in address6 in network byte order,
+	// address is 0 then. all zero is the IPv6 any address (::)
+    bool isIpv6;
+    unsigned char address6[16];
+
+    void ClearAddress6() { for( int i=0; i < 16; ++i ) address6[i] = 0; }
+
+	bool IsMulticastAddress() const
+		{ return isIpv6 ? (address6[0] == 0xFF) : ((address >> 28) == 0xE); }
+
+	enum { ADDRESS_STRING_LENGTH=48 };
 	void AddressAsString( char *s ) const;
 
-	enum { ADDRESS_AND_PORT_STRING_LENGTH=23};
+	enum { ADDRESS_AND_PORT_STRING_LENGTH=56 };
 	void AddressAndPortAsString( char *s ) const;
 };
 
 inline bool operator==( const IpEndpointName& lhs, const IpEndpointName& rhs )
 {	
-	return (lhs.address == rhs.address && lhs.port == rhs.port );
+	if( lhs.address != rhs.address || lhs.port != rhs.port || lhs.isIpv6 != rhs.isIpv6 )
+		return false;
+	for( int i=0; lhs.isIpv6 && i < 16; ++i )
+		if( lhs.address6[i] != rhs.address6[i] )
+			return false;
+	return true;
 }
 
 inline bool operator!=( const IpEndpointName& lhs, const IpEndpointName& rhs )
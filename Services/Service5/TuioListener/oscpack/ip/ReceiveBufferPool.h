@@ -0,0 +1,94 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifndef INCLUDED_RECEIVEBUFFERPOOL_H
+#define INCLUDED_RECEIVEBUFFERPOOL_H
+
+
+// the largest UDP payload, datagrams up to this size are never truncated
+#define RECEIVE_BUFFER_SIZE 65536
+
+
+// ReceiveBufferPool hands out reference counted receive buffers. the
+// multiplexer reads each datagram into a pooled buffer and releases it
+// after ProcessPacket() returns. a listener that passes the data on to a
+// later stage, for example another thread, calls RetainReceiveBuffer()
+// on the data pointer instead of copying it, and ReleaseReceiveBuffer()
+// once that stage is done. buffers return to the pool when the last
+// reference is released, from any thread.
+//
+// only data passed to ProcessPacket() by a SocketReceiveMultiplexer for
+// a UdpSocket can be retained, and the multiplexer must outlive the
+// retained buffers.
+
+// implemented by multiplexer backends that lend buffers they did not get
+// from a ReceiveBufferPool, for example buffers the kernel received into.
+// a lent buffer must leave RECEIVE_BUFFER_HEADER_SIZE bytes free in front
+// of its data for the reference count.
+class ReceiveBufferOwner{
+public:
+    virtual ~ReceiveBufferOwner() {}
+
+    // called once the last reference to data is released, from any thread
+    virtual void RecycleReceiveBuffer( char *data ) = 0;
+};
+
+#define RECEIVE_BUFFER_HEADER_SIZE 32
+
+
+class ReceiveBufferPool{
+    class Implementation;
+    Implementation *impl_;
+
+public:
+    // keeps up to maxFreeBuffers released buffers for reuse
+    ReceiveBufferPool( int maxFreeBuffers=8 );
+    ~ReceiveBufferPool();
+
+    // returns the data of a buffer of RECEIVE_BUFFER_SIZE bytes with one reference
+    char *Acquire();
+
+    // the number of buffers currently handed out
+    int BuffersInUse() const;
+
+    // makes data retainable like a pooled buffer, with one reference.
+    // owner recycles it when the last reference is released
+    static void Lend( char *data, ReceiveBufferOwner *owner );
+
+    static void Retain( const char *data );
+    static void Release( const char *data );
+
+    // true if someone besides the caller holds a reference
+    static bool IsShared( const char *data );
+};
+
+
+inline void RetainReceiveBuffer( const char *data ) { ReceiveBufferPool::Retain( data ); }
+inline void ReleaseReceiveBuffer( const char *data ) { ReceiveBufferPool::Release( data ); }
+
+
+#endif /* INCLUDED_RECEIVEBUFFERPOOL_H */
@@ -43,12 +43,14 @@ class PacketListener;
 class TimerListener;
 
 class UdpSocket;
+class TcpListeningSocket;
 
 class SocketReceiveMultiplexer{
     class Implementation;
     Implementation *impl_;
 
 	friend class UdpSocket;
+	friend class TcpListeningSocket;
 
 public:
     SocketReceiveMultiplexer();
@@ -60,15 +62,42 @@ public:
     void AttachSocketListener( UdpSocket *socket, PacketListener *listener );
     void DetachSocketListener( UdpSocket *socket, PacketListener *listener );
 
+    // accept and read the connections of a TCP socket, see TcpListeningSocket.h
+    void AttachStreamListener( TcpListeningSocket *socket, PacketListener *listener );
+    void DetachStreamListener( TcpListeningSocket *socket, PacketListener *listener );
+
     void AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener );
 	void AttachPeriodicTimerListener(
             int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener );
     void DetachPeriodicTimerListener( TimerListener *listener );  
 
+    // the default backend waits with select() on posix systems and with
+    // event objects on Windows. IO_URING_BACKEND receives with multishot
+    // recvmsg into kernel provided buffers that are passed to the listeners
+    // without a copy (Linux 6.0 and later), it falls back to the default
+    // backend when the kernel does not support it or stream listeners are
+    // attached. call before Run
+    enum Backend { DEFAULT_BACKEND, IO_URING_BACKEND };
+    void SetBackend( Backend backend );
+
+    // the backend used by the current or the last call to Run
+    Backend ActiveBackend() const;
+
     void Run();      // loop and block processing messages indefinitely
 	void RunUntilSigInt();
     void Break();    // call this from a listener to exit once the listener returns
-    void AsynchronousBreak(); // call this from another thread or signal handler to exit the Run() state
+    void AsynchronousBreak(); // call this from another thread or signal handler to exit the Run() state, also when Run() is about to start
+};
+
+
+// counters of the datagrams returned by UdpSocket::ReceiveFrom(). they are
+// updated by the receiving thread without synchronization, read them from
+// that thread or treat them as approximate
+struct UdpSocketStatistics{
+    unsigned long long datagrams;
+    unsigned long long bytes;
+    unsigned long long kernelDrops; // datagrams the kernel dropped because the receive buffer was full (SO_RXQ_OVFL, Linux only)
+    unsigned long long truncated;   // datagrams larger than the buffer passed to ReceiveFrom()
 };
 
 
@@ -101,13 +130,56 @@ public:
 	void Send( const char *data, int size );
     void SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size );
 
+	// send up to count datagrams to the connected endpoint without blocking,
+	// with one sendmmsg() call per 64 datagrams on Linux. returns how many
+	// were sent, fewer than count if the send buffer is full. datagrams the
+	// system refuses, for example after an ICMP port unreachable, count as
+	// sent, because they would be lost on the way just as well
+	int SendMultiple( const char * const *data, const int *sizes, int count );
+
 
 	// Bind a local endpoint to receive incoming data. Endpoint
-	// can be 'any' for the system to choose an endpoint
+	// can be 'any' for the system to choose an endpoint. on posix
+	// systems binding the any address receives IPv4 and IPv6, IPv4
+	// senders keep their IPv4 endpoint names. IPv6 endpoints are not
+	// supported on Windows, the methods taking one throw or fail there
 	void Bind( const IpEndpointName& localEndpoint );
 	bool IsBound() const;
 
+	// join a multicast group on a bound socket, to receive what is sent to
+	// the group and the port the socket is bound to. with an 'any' source
+	// every source is received (any-source multicast, ASM), otherwise only
+	// the given source (source-specific multicast, SSM, which needs IGMPv3
+	// or MLDv2 on the network). call once per source to receive several.
+	// interfaceIndex selects the network interface, 0 lets the system
+	// choose. several sockets that join the same group each receive every
+	// datagram, bind them with SetReusePort. returns false if the group
+	// could not be joined, IPv4 groups only on Windows
+	bool JoinGroup( const IpEndpointName& group, const IpEndpointName& source=IpEndpointName(), unsigned int interfaceIndex=0 );
+	bool LeaveGroup( const IpEndpointName& group, const IpEndpointName& source=IpEndpointName(), unsigned int interfaceIndex=0 );
+
+	// let several sockets bind the same port (SO_REUSEPORT), the kernel
+	// spreads datagrams over them by a hash of the source address and
+	// port. call before Bind. returns false if the system can't balance
+	// datagrams over sockets, as on Windows
+	bool SetReusePort( bool enable );
+
+	// request a kernel receive buffer of the given size in bytes (SO_RCVBUF).
+	// call before receiving, bursts that do not fit are dropped by the kernel
+	void SetReceiveBufferSize( int size );
+
+	// the receive buffer size the kernel actually granted
+	int ReceiveBufferSize() const;
+
 	int ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size );
+
+	// the arrival time of the datagram returned by the last call to
+	// ReceiveFrom(), in nanoseconds of GetCurrentTimeNanoseconds().
+	// taken by the kernel where the platform supports it (SO_TIMESTAMPNS),
+	// otherwise right after the datagram was read
+	long long LastReceiveTime() const;
+
+	UdpSocketStatistics Statistics() const;
 };
 
 
@@ -137,9 +209,11 @@ class UdpListeningReceiveSocket : public UdpSocket{
     SocketReceiveMultiplexer mux_;
     PacketListener *listener_;
 public:
-	UdpListeningReceiveSocket( const IpEndpointName& localEndpoint, PacketListener *listener )
+	UdpListeningReceiveSocket( const IpEndpointName& localEndpoint, PacketListener *listener, bool reusePort=false )
         : listener_( listener )
     {
+        if( reusePort )
+            SetReusePort( true );
         Bind( localEndpoint );
         mux_.AttachSocketListener( this, listener_ );
     }
@@ -152,6 +226,9 @@ public:
 	void RunUntilSigInt() { mux_.RunUntilSigInt(); }
     void Break() { mux_.Break(); }
     void AsynchronousBreak() { mux_.AsynchronousBreak(); }
+
+    // attach further sockets or timers to the multiplexer, before calling Run
+    SocketReceiveMultiplexer& Multiplexer() { return mux_; }
 };
 
 
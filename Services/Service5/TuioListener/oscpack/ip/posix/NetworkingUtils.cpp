@@ -34,6 +34,7 @@
 #include <netinet/in.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 
 
@@ -55,3 +56,30 @@ unsigned long GetHostByName( const char *name )
 
     return result;
 }
+
+
+bool GetHostByName6( const char *name, unsigned char *address6 )
+{
+    struct addrinfo hints;
+    memset( &hints, 0, sizeof(hints) );
+    hints.ai_family = AF_INET6;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo *info = 0;
+    if( getaddrinfo( name, 0, &hints, &info ) != 0 || info == 0 )
+        return false;
+
+    memcpy( address6, &((struct sockaddr_in6*)info->ai_addr)->sin6_addr, 16 );
+    freeaddrinfo( info );
+    return true;
+}
+
+
+long long GetCurrentTimeNanoseconds()
+{
+    // the realtime clock, because SO_TIMESTAMPNS stamps datagrams with it
+    struct timespec t;
+    clock_gettime( CLOCK_REALTIME, &t );
+
+    return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
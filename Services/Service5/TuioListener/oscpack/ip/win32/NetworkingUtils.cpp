@@ -30,6 +30,7 @@
 #include "ip/NetworkingUtils.h"
 
 #include <winsock2.h>   // this must come first to prevent errors with MSVC7
+#include <ws2tcpip.h>   // for getaddrinfo()
 #include <windows.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -86,3 +87,37 @@ unsigned long GetHostByName( const char *name )
 
     return result;
 }
+
+
+bool GetHostByName6( const char *name, unsigned char *address6 )
+{
+    NetworkInitializer networkInitializer;
+
+    struct addrinfo hints;
+    memset( &hints, 0, sizeof(hints) );
+    hints.ai_family = AF_INET6;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo *info = 0;
+    if( getaddrinfo( name, 0, &hints, &info ) != 0 || info == 0 )
+        return false;
+
+    memcpy( address6, &((struct sockaddr_in6*)info->ai_addr)->sin6_addr, 16 );
+    freeaddrinfo( info );
+    return true;
+}
+
+
+long long GetCurrentTimeNanoseconds()
+{
+    static LARGE_INTEGER frequency = { 0 };
+    if( frequency.QuadPart == 0 )
+        QueryPerformanceFrequency( &frequency );
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+
+    long long seconds = counter.QuadPart / frequency.QuadPart;
+    long long remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000LL + remainder * 1000000000LL / frequency.QuadPart;
+}
@@ -30,6 +30,7 @@
 #include "ip/UdpSocket.h"
 
 #include <winsock2.h>   // this must come first to prevent errors with MSVC7
+#include <ws2tcpip.h>   // for ip_mreq_source
 #include <windows.h>
 #include <mmsystem.h>   // for timeGetTime()
 
@@ -41,6 +42,8 @@
 
 #include "ip/NetworkingUtils.h"
 #include "ip/PacketListener.h"
+#include "ip/ReceiveBufferPool.h"
+#include "ip/TcpListeningSocket.h"
 #include "ip/TimerListener.h"
 
 
@@ -49,6 +52,10 @@ typedef int socklen_t;
 
 static void SockaddrFromIpEndpointName( struct sockaddr_in& sockAddr, const IpEndpointName& endpoint )
 {
+	// the sockets here are IPv4 only
+	if( endpoint.isIpv6 )
+		throw std::runtime_error("ipv6 endpoints are not supported\n");
+
     memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
     sockAddr.sin_family = AF_INET;
 
@@ -87,13 +94,19 @@ class UdpSocket::Implementation{
 	struct sockaddr_in connectedAddr_;
 	struct sockaddr_in sendToAddr_;
 
+	long long lastReceiveTime_;
+	UdpSocketStatistics statistics_;
+
 public:
 
 	Implementation()
 		: isBound_( false )
 		, isConnected_( false )
 		, socket_( INVALID_SOCKET )
+		, lastReceiveTime_( 0 )
 	{
+		memset( &statistics_, 0, sizeof(statistics_) );
+
 		if( (socket_ = socket( AF_INET, SOCK_DGRAM, 0 )) == INVALID_SOCKET ){
             throw std::runtime_error("unable to create udp socket\n");
         }
@@ -171,8 +184,27 @@ public:
         send( socket_, data, size, 0 );
 	}
 
+	// winsock has no sendmmsg() and no per call non-blocking flag, the
+	// socket blocks only while its send buffer is full
+	int SendMultiple( const char * const *data, const int *sizes, int count )
+	{
+		assert( isConnected_ );
+
+		int sent = 0;
+		while( sent < count ){
+			if( send( socket_, data[sent], sizes[sent], 0 ) < 0
+					&& WSAGetLastError() == WSAEWOULDBLOCK )
+				break;
+			++sent;
+		}
+		return sent;
+	}
+
     void SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
 	{
+		if( remoteEndpoint.isIpv6 )
+			return;
+
 		sendToAddr_.sin_addr.s_addr = htonl( remoteEndpoint.address );
         sendToAddr_.sin_port = htons( (short)remoteEndpoint.port );
 
@@ -193,6 +225,45 @@ public:
 
 	bool IsBound() const { return isBound_; }
 
+	// IPv4 groups only. the interface is given by index as 0.0.0.index,
+	// which winsock accepts in place of an interface address
+	bool ChangeMembership( bool join, const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+	{
+		if( group.isIpv6 || source.isIpv6 || !group.IsMulticastAddress() )
+			return false;
+
+		if( source.address == IpEndpointName::ANY_ADDRESS ){
+			struct ip_mreq request;
+			memset( &request, 0, sizeof(request) );
+			request.imr_multiaddr.s_addr = htonl( group.address );
+			request.imr_interface.s_addr = htonl( interfaceIndex );
+			return setsockopt(socket_, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+					(char*)&request, sizeof(request)) == 0;
+		}
+
+		struct ip_mreq_source request;
+		memset( &request, 0, sizeof(request) );
+		request.imr_multiaddr.s_addr = htonl( group.address );
+		request.imr_sourceaddr.s_addr = htonl( source.address );
+		request.imr_interface.s_addr = htonl( interfaceIndex );
+		return setsockopt(socket_, IPPROTO_IP, join ? IP_ADD_SOURCE_MEMBERSHIP : IP_DROP_SOURCE_MEMBERSHIP,
+				(char*)&request, sizeof(request)) == 0;
+	}
+
+	void SetReceiveBufferSize( int size )
+	{
+		setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, (char*)&size, sizeof(size));
+	}
+
+	int ReceiveBufferSize() const
+	{
+		int size = 0;
+		socklen_t length = sizeof(size);
+		if( getsockopt(socket_, SOL_SOCKET, SO_RCVBUF, (char*)&size, &length) < 0 )
+			return 0;
+		return size;
+	}
+
     int ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size )
 	{
 		assert( isBound_ );
@@ -202,8 +273,20 @@ public:
              	 
         int result = recvfrom(socket_, data, size, 0,
                     (struct sockaddr *) &fromAddr, (socklen_t*)&fromAddrLen);
-		if( result < 0 )
+		if( result < 0 ){
+			if( WSAGetLastError() == WSAEMSGSIZE ){
+				statistics_.datagrams++;
+				statistics_.bytes += size;
+				statistics_.truncated++;
+			}
 			return 0;
+		}
+
+		statistics_.datagrams++;
+		statistics_.bytes += result;
+
+		// winsock has no receive timestamps before Windows 10, take it here
+		lastReceiveTime_ = GetCurrentTimeNanoseconds();
 
 		remoteEndpoint.address = ntohl(fromAddr.sin_addr.s_addr);
 		remoteEndpoint.port = ntohs(fromAddr.sin_port);
@@ -211,6 +294,10 @@ public:
 		return result;
 	}
 
+	long long LastReceiveTime() const { return lastReceiveTime_; }
+
+	UdpSocketStatistics Statistics() const { return statistics_; }
+
 	SOCKET& Socket() { return socket_; }
 };
 
@@ -244,6 +331,11 @@ void UdpSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data,
 	impl_->SendTo( remoteEndpoint, data, size );
 }
 
+int UdpSocket::SendMultiple( const char * const *data, const int *sizes, int count )
+{
+	return impl_->SendMultiple( data, sizes, count );
+}
+
 void UdpSocket::Bind( const IpEndpointName& localEndpoint )
 {
 	impl_->Bind( localEndpoint );
@@ -254,11 +346,257 @@ bool UdpSocket::IsBound() const
 	return impl_->IsBound();
 }
 
+bool UdpSocket::SetReusePort( bool )
+{
+	// SO_REUSEADDR on Windows lets sockets steal the port from each other
+	// instead of sharing the load, so every port keeps a single socket
+	return false;
+}
+
+void UdpSocket::SetReceiveBufferSize( int size )
+{
+	impl_->SetReceiveBufferSize( size );
+}
+
+int UdpSocket::ReceiveBufferSize() const
+{
+	return impl_->ReceiveBufferSize();
+}
+
+bool UdpSocket::JoinGroup( const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+{
+	return impl_->ChangeMembership( true, group, source, interfaceIndex );
+}
+
+bool UdpSocket::LeaveGroup( const IpEndpointName& group, const IpEndpointName& source, unsigned int interfaceIndex )
+{
+	return impl_->ChangeMembership( false, group, source, interfaceIndex );
+}
+
 int UdpSocket::ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size )
 {
 	return impl_->ReceiveFrom( remoteEndpoint, data, size );
 }
 
+long long UdpSocket::LastReceiveTime() const
+{
+	return impl_->LastReceiveTime();
+}
+
+UdpSocketStatistics UdpSocket::Statistics() const
+{
+	return impl_->Statistics();
+}
+
+
+struct StreamConnection{
+	StreamConnection( SOCKET s, const IpEndpointName& endpoint, StreamDecoder::Framing framing )
+		: socket( s )
+		, remoteEndpoint( endpoint )
+		, decoder( framing ) {}
+	SOCKET socket;
+	IpEndpointName remoteEndpoint;
+	StreamDecoder decoder;
+	// what the listener sent with SendTo() while it processed the packets
+	std::string reply;
+};
+
+class TcpListeningSocket::Implementation{
+    NetworkInitializer networkInitializer_;
+
+	SOCKET socket_;
+	StreamDecoder::Framing framing_;
+	int maxConnections_;
+	std::vector< StreamConnection* > connections_;
+	HANDLE event_;
+
+	// replies are a few kilobytes at most, they fit the empty send buffer
+	// of a connection. a peer that doesn't read them is dropped
+	static bool SendReply( SOCKET socket, const std::string& reply )
+	{
+		size_t sent = 0;
+		while( sent < reply.size() ){
+			int result = send( socket, reply.data() + sent, (int)(reply.size() - sent), 0 );
+			if( result <= 0 )
+				return false;
+			sent += result;
+		}
+		return true;
+	}
+
+	// reads what arrived on a connection and passes the packets it
+	// completed to the listener. returns false once the connection is done
+	static bool Receive( StreamConnection& connection, PacketListener *listener )
+	{
+		int space;
+		char *buffer = connection.decoder.ReceiveBuffer( space );
+		if( buffer == 0 )
+			return false;
+
+		int result = recv( connection.socket, buffer, space, 0 );
+		if( result == SOCKET_ERROR )
+			return (WSAGetLastError() == WSAEWOULDBLOCK);
+		if( result == 0 )
+			return false;
+		connection.decoder.Received( result );
+
+		char *data;
+		int size;
+		while( connection.decoder.NextPacket( data, size ) )
+			listener->ProcessPacket( data, size, connection.remoteEndpoint );
+
+		if( !connection.decoder.Reply().empty() ){
+			if( !SendReply( connection.socket, connection.decoder.Reply() ) )
+				return false;
+			connection.decoder.ReplySent();
+		}
+		if( !connection.reply.empty() ){
+			if( !SendReply( connection.socket, connection.reply ) )
+				return false;
+			connection.reply.clear();
+		}
+		return !connection.decoder.Finished();
+	}
+
+	void Accept()
+	{
+		for(;;){
+			struct sockaddr_in fromAddr;
+			socklen_t length = sizeof(fromAddr);
+			SOCKET connection = accept( socket_, (struct sockaddr *)&fromAddr, &length );
+			if( connection == INVALID_SOCKET )
+				return; // WSAEWOULDBLOCK, or out of resources until a connection closes
+
+			if( (int)connections_.size() >= maxConnections_ ){
+				closesocket( connection );
+				continue;
+			}
+
+			int on=1;
+			setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on));
+			// accepted sockets inherit the event selection of the listening socket, set it
+			// anyway so that they are non-blocking and signal the event
+			WSAEventSelect( connection, event_, FD_READ | FD_CLOSE );
+			connections_.push_back( new StreamConnection( connection, IpEndpointNameFromSockaddr( fromAddr ), framing_ ) );
+		}
+	}
+
+public:
+	Implementation( const IpEndpointName& localEndpoint, StreamDecoder::Framing framing, int maxConnections )
+		: framing_( framing )
+		, maxConnections_( maxConnections )
+		, event_( 0 )
+	{
+		if( (socket_ = socket( AF_INET, SOCK_STREAM, 0 )) == INVALID_SOCKET ){
+            throw std::runtime_error("unable to create tcp socket\n");
+        }
+
+		// unlike on posix systems SO_REUSEADDR would let other processes take over the port
+		struct sockaddr_in bindSockAddr;
+		SockaddrFromIpEndpointName( bindSockAddr, localEndpoint );
+		if( bind(socket_, (struct sockaddr *)&bindSockAddr, sizeof(bindSockAddr)) == SOCKET_ERROR
+				|| listen(socket_, SOMAXCONN) == SOCKET_ERROR ){
+			closesocket(socket_);
+            throw std::runtime_error("unable to bind tcp socket\n");
+        }
+	}
+
+	~Implementation()
+	{
+		for( std::vector< StreamConnection* >::iterator i = connections_.begin(); i != connections_.end(); ++i ){
+			closesocket( (*i)->socket );
+			delete *i;
+		}
+		closesocket(socket_);
+	}
+
+	IpEndpointName LocalEndpoint() const
+	{
+		struct sockaddr_in sockAddr;
+		memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
+		socklen_t length = sizeof(sockAddr);
+		if (getsockname(socket_, (struct sockaddr *)&sockAddr, &length) < 0) {
+			throw std::runtime_error("unable to getsockname\n");
+		}
+		return IpEndpointNameFromSockaddr( sockAddr );
+	}
+
+	int ConnectionCount() const { return (int)connections_.size(); }
+
+	bool SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
+	{
+		for( std::vector< StreamConnection* >::iterator i = connections_.begin(); i != connections_.end(); ++i ){
+			if( (*i)->remoteEndpoint == remoteEndpoint ){
+				(*i)->reply.append( data, size );
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// the listening socket and all its connections signal one event, so
+	// that the number of connections isn't limited by MAXIMUM_WAIT_OBJECTS
+	void SelectEvent( HANDLE event )
+	{
+		event_ = event;
+		WSAEventSelect( socket_, event_, FD_ACCEPT );
+		for( std::vector< StreamConnection* >::iterator i = connections_.begin(); i != connections_.end(); ++i )
+			WSAEventSelect( (*i)->socket, event_, FD_READ | FD_CLOSE );
+	}
+
+	void DeselectEvent()
+	{
+		WSAEventSelect( socket_, event_, 0 );
+		for( std::vector< StreamConnection* >::iterator i = connections_.begin(); i != connections_.end(); ++i )
+			WSAEventSelect( (*i)->socket, event_, 0 );
+		event_ = 0;
+	}
+
+	// accepts new connections and reads every connection once, recv() fails
+	// with WSAEWOULDBLOCK on those without data. FD_READ is posted again
+	// after each recv() while data remains
+	void Process( PacketListener *listener )
+	{
+		std::vector< StreamConnection* >::iterator i = connections_.begin();
+		while( i != connections_.end() ){
+			if( !Receive( **i, listener ) ){
+				closesocket( (*i)->socket );
+				delete *i;
+				i = connections_.erase( i );
+			}else{
+				++i;
+			}
+		}
+
+		Accept();
+	}
+};
+
+TcpListeningSocket::TcpListeningSocket( const IpEndpointName& localEndpoint, StreamDecoder::Framing framing, int maxConnections )
+{
+	impl_ = new Implementation( localEndpoint, framing, maxConnections );
+}
+
+TcpListeningSocket::~TcpListeningSocket()
+{
+	delete impl_;
+}
+
+IpEndpointName TcpListeningSocket::LocalEndpoint() const
+{
+	return impl_->LocalEndpoint();
+}
+
+int TcpListeningSocket::ConnectionCount() const
+{
+	return impl_->ConnectionCount();
+}
+
+bool TcpListeningSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
+{
+	return impl_->SendTo( remoteEndpoint, data, size );
+}
+
 
 struct AttachedTimerListener{
 	AttachedTimerListener( int id, int p, TimerListener *tl )
@@ -292,7 +630,9 @@ class SocketReceiveMultiplexer::Implementation{
     NetworkInitializer networkInitializer_;
 
 	std::vector< std::pair< PacketListener*, UdpSocket* > > socketListeners_;
+	std::vector< std::pair< PacketListener*, TcpListeningSocket* > > streamListeners_;
 	std::vector< AttachedTimerListener > timerListeners_;
+	ReceiveBufferPool bufferPool_;
 
 	volatile bool break_;
 	HANDLE breakEvent_;
@@ -302,8 +642,17 @@ class SocketReceiveMultiplexer::Implementation{
 		return timeGetTime(); // FIXME: bad choice if you want to run for more than 40 days
 	}
 
+	char *AcquireBuffer()
+	{
+		char *data = bufferPool_.Acquire();
+		if( data == 0 )
+			throw std::runtime_error( "unable to allocate receive buffer\n" );
+		return data;
+	}
+
 public:
     Implementation()
+		: break_( false )
 	{
 		breakEvent_ = CreateEvent( NULL, FALSE, FALSE, NULL );
 	}
@@ -329,6 +678,21 @@ public:
 		socketListeners_.erase( i );
 	}
 
+    void AttachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+	{
+		assert( std::find( streamListeners_.begin(), streamListeners_.end(), std::make_pair(listener, socket) ) == streamListeners_.end() );
+		streamListeners_.push_back( std::make_pair( listener, socket ) );
+	}
+
+    void DetachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+	{
+		std::vector< std::pair< PacketListener*, TcpListeningSocket* > >::iterator i =
+				std::find( streamListeners_.begin(), streamListeners_.end(), std::make_pair(listener, socket) );
+		assert( i != streamListeners_.end() );
+
+		streamListeners_.erase( i );
+	}
+
     void AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
 	{
 		timerListeners_.push_back( AttachedTimerListener( periodMilliseconds, periodMilliseconds, listener ) );
@@ -355,13 +719,11 @@ public:
 
     void Run()
 	{
-		break_ = false;
-
 		// prepare the window events which we use to wake up on incoming data
 		// we use this instead of select() primarily to support the AsyncBreak() 
 		// mechanism.
 
-		std::vector<HANDLE> events( socketListeners_.size() + 1, 0 );
+		std::vector<HANDLE> events( socketListeners_.size() + streamListeners_.size() + 1, 0 );
 		int j=0;
 		for( std::vector< std::pair< PacketListener*, UdpSocket* > >::iterator i = socketListeners_.begin();
 				i != socketListeners_.end(); ++i, ++j ){
@@ -371,8 +733,16 @@ public:
 			events[j] = event;
 		}
 
+		// one event per stream listener, for its listening socket and connections
+		for( std::vector< std::pair< PacketListener*, TcpListeningSocket* > >::iterator i = streamListeners_.begin();
+				i != streamListeners_.end(); ++i, ++j ){
 
-		events[ socketListeners_.size() ] = breakEvent_; // last event in the collection is the break event
+			HANDLE event = CreateEvent( NULL, FALSE, FALSE, NULL );
+			i->second->impl_->SelectEvent( event );
+			events[j] = event;
+		}
+
+		events[ events.size() - 1 ] = breakEvent_; // last event in the collection is the break event
 
 		
 		// configure the timer queue
@@ -385,8 +755,7 @@ public:
 			timerQueue_.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
 		std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
 
-		const int MAX_BUFFER_SIZE = 4098;
-		char *data = new char[ MAX_BUFFER_SIZE ];
+		char *data = AcquireBuffer();
 		IpEndpointName remoteEndpoint;
 
 		while( !break_ ){
@@ -401,19 +770,35 @@ public:
                             : 0 );
             }
 
-			DWORD waitResult = WaitForMultipleObjects( (DWORD)socketListeners_.size() + 1, &events[0], FALSE, waitTime );
+			DWORD waitResult = WaitForMultipleObjects( (DWORD)events.size(), &events[0], FALSE, waitTime );
 			if( break_ )
 				break;
 
 			if( waitResult != WAIT_TIMEOUT ){
 				for( int i = waitResult - WAIT_OBJECT_0; i < (int)socketListeners_.size(); ++i ){
-					int size = socketListeners_[i].second->ReceiveFrom( remoteEndpoint, data, MAX_BUFFER_SIZE );
+					int size = socketListeners_[i].second->ReceiveFrom( remoteEndpoint, data, RECEIVE_BUFFER_SIZE );
 					if( size > 0 ){
 						socketListeners_[i].first->ProcessPacket( data, size, remoteEndpoint );
+
+						// the listener kept the buffer for a later stage, continue with a fresh one
+						if( ReceiveBufferPool::IsShared( data ) ){
+							ReleaseReceiveBuffer( data );
+							data = AcquireBuffer();
+						}
+
 						if( break_ )
 							break;
 					}
 				}
+
+				// like the sockets above, serve the signaled listener and all after it
+				int first = (int)(waitResult - WAIT_OBJECT_0);
+				if( first < (int)socketListeners_.size() )
+					first = (int)socketListeners_.size();
+				for( int i = first; i < (int)events.size() - 1 && !break_; ++i ){
+					std::pair< PacketListener*, TcpListeningSocket* >& streamListener = streamListeners_[ i - socketListeners_.size() ];
+					streamListener.second->impl_->Process( streamListener.first );
+				}
 			}
 
 			// execute any expired timers
@@ -433,7 +818,7 @@ public:
 				std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
 		}
 
-		delete [] data;
+		ReleaseReceiveBuffer( data );
 
 		// free events
 		j = 0;
@@ -445,6 +830,16 @@ public:
 			unsigned long enableNonblocking = 0;
 			ioctlsocket( i->second->impl_->Socket(), FIONBIO, &enableNonblocking );  // make the socket blocking again
 		}
+		for( std::vector< std::pair< PacketListener*, TcpListeningSocket* > >::iterator i = streamListeners_.begin();
+				i != streamListeners_.end(); ++i, ++j ){
+
+			i->second->impl_->DeselectEvent();
+			CloseHandle( events[j] );
+		}
+
+		// cleared on the way out rather than on the way in, so that a break
+		// from another thread just before Run() is not lost
+		break_ = false;
 	}
 
     void Break()
@@ -481,6 +876,16 @@ void SocketReceiveMultiplexer::DetachSocketListener( UdpSocket *socket, PacketLi
 	impl_->DetachSocketListener( socket, listener );
 }
 
+void SocketReceiveMultiplexer::AttachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+{
+	impl_->AttachStreamListener( socket, listener );
+}
+
+void SocketReceiveMultiplexer::DetachStreamListener( TcpListeningSocket *socket, PacketListener *listener )
+{
+	impl_->DetachStreamListener( socket, listener );
+}
+
 void SocketReceiveMultiplexer::AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
 {
 	impl_->AttachPeriodicTimerListener( periodMilliseconds, listener );
@@ -496,6 +901,16 @@ void SocketReceiveMultiplexer::DetachPeriodicTimerListener( TimerListener *liste
 	impl_->DetachPeriodicTimerListener( listener );
 }
 
+void SocketReceiveMultiplexer::SetBackend( Backend )
+{
+	// io_uring is Linux only, Windows always waits on event objects
+}
+
+SocketReceiveMultiplexer::Backend SocketReceiveMultiplexer::ActiveBackend() const
+{
+	return DEFAULT_BACKEND;
+}
+
 void SocketReceiveMultiplexer::Run()
 {
 	impl_->Run();
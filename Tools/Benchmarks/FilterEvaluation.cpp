@@ -0,0 +1,462 @@
+/*
+	Offline evaluation of the contact smoothing filters (TuioFilter) and
+	the latency compensation (TuioPrediction).
+
+	Replays the same traces through every combination of a filter and a
+	prediction configuration and reports how much of the jitter remains
+	and how far the contacts trail behind the finger, to choose both for
+	a sensor before configuring a service. The prediction extrapolates
+	with the speed and acceleration a TuioCursor derives from the raw
+	positions, as the TuioClient of a service does for the cursors of the
+	tracker.
+
+	The synthetic traces hold, drag slowly, drag fast, flick and circle at
+	the frame rate, with gaussian noise and optionally the quantization of
+	the tracker camera. Their true path is known. A recorded trace has no
+	true path, it is estimated with a centered moving average of the raw
+	positions, which is fine for the jitter of resting contacts but hides
+	the lag of quick changes of direction.
+
+	Traces are text files with one "seconds id x y" line per position.
+	With -p, the tool records the cursors a TuioClient receives on the
+	port, for instance from a real sensor or the LoadGenerator, to the
+	file given with -o, and evaluates them afterwards.
+
+	The positions are shown the pipeline latency of -l after they were
+	measured, and are compared with where the finger is by then. Reports
+	in thousandths of the surface: the jitter (RMS error) of contacts that
+	rest for a while without and with the filter, the RMS error while
+	moving, the largest error, which shows the lag of flicks and the
+	overshoot after sudden stops and reversals, and the latency, the delay
+	of the true path that best matches the shown one. Without prediction
+	the latency is the pipeline latency plus the lag of the filter.
+
+	usage: FilterEvaluation [options]
+		-r file       evaluate a recorded trace instead of synthetic ones
+		-p port       record a trace from this TUIO port first, to the file of -o
+		-o file       the file to record to (trace.txt)
+		-t seconds    duration of the recording (10)
+		-n noise      standard deviation of the synthetic noise (0.002)
+		-g grid       quantization of the synthetic positions, 1/640 for a VGA camera (0)
+		-f fps        frame rate of the synthetic traces (60)
+		-c config     evaluate this filter configuration, as in the filter file of a service,
+		              instead of the default set, may be repeated
+		-a config     evaluate this prediction configuration, as in the prediction file of
+		              a service, may be repeated (none)
+		-l latency    pipeline latency from the sensor to the screen in milliseconds (0)
+		-x seed       random seed (1)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TuioClient.h"
+#include "TuioFilter.h"
+#include "TuioPrediction.h"
+
+using namespace TUIO;
+
+// the window of the moving average that estimates the path of recorded contacts, in frames to either side
+static const int REFERENCE_WINDOW = 4;
+// a contact slower than this, in surfaces per second, rests
+static const double REST_SPEED = 0.005;
+// the jitter is measured once a contact rested this long, in seconds, before that the filter still settles
+static const double SETTLE_TIME = 0.25;
+// the latencies tried, in seconds, negative ones are ahead of the finger
+static const double MAX_LAG = 0.15;
+static const double LAG_STEP = 0.0005;
+
+struct Sample {
+	double time;
+	float x, y;
+	// the true position, or its estimate for recorded traces
+	float truthX, truthY;
+	bool resting, settled;
+};
+
+typedef std::vector<Sample> Trace;
+
+class Random {
+public:
+	Random(unsigned long long seed) : state(seed*0x9E3779B97F4A7C15ULL+1) { next(); }
+	unsigned long long next() {
+		state ^= state>>12;
+		state ^= state<<25;
+		state ^= state>>27;
+		return state*2685821657736338717ULL;
+	}
+	// uniform in (0,1)
+	double uniform() { return ((next()>>11)+0.5)*(1.0/9007199254740992.0); }
+	double gaussian() { return sqrt(-2*log(uniform()))*cos(2*M_PI*uniform()); }
+private:
+	unsigned long long state;
+};
+
+// a contact that rests, moves and rests again, on a line with the given speed or on a circle
+struct Gesture {
+	const char *name;
+	double speed, duration;
+	bool circle;
+};
+
+static const Gesture gestures[] = {
+	{ "slow drag", 0.05, 2.0, false },
+	{ "drag", 0.3, 1.0, false },
+	{ "fast drag", 1.5, 0.3, false },
+	{ "flick", 4.0, 0.1, false },
+	{ "circle", 0.6, 2.0, true },
+};
+
+static const double REST_TIME = 0.5;
+
+static void truePosition(const Gesture &gesture, double direction, double t, double &x, double &y) {
+	double moving = t-REST_TIME;
+	if (moving<0) moving = 0;
+	if (moving>gesture.duration) moving = gesture.duration;
+	x = 0.5;
+	y = 0.5;
+	if (gesture.circle) {
+		// speed along the circle of radius 0.1, starting and ending at its left
+		double angle = moving*gesture.speed/0.1;
+		x += 0.1-0.1*cos(angle);
+		y += 0.1*sin(angle);
+	} else {
+		x += cos(direction)*gesture.speed*moving;
+		y += sin(direction)*gesture.speed*moving;
+	}
+}
+
+static void settle(Trace &trace) {
+	double restingSince = 0;
+	for (size_t i=0; i<trace.size(); i++) {
+		if (!trace[i].resting || (i==0)) restingSince = trace[i].time;
+		trace[i].settled = trace[i].resting && (trace[i].time-restingSince>=SETTLE_TIME);
+	}
+}
+
+static void synthesize(std::vector<Trace> &traces, double noise, double grid, int fps, unsigned long long seed) {
+	Random random(seed);
+	for (size_t g=0; g<sizeof(gestures)/sizeof(gestures[0]); g++) {
+		const Gesture &gesture = gestures[g];
+		double direction = random.uniform()*2*M_PI;
+		double duration = REST_TIME+gesture.duration+REST_TIME;
+		Trace trace;
+		for (int frame=0; frame<=duration*fps; frame++) {
+			Sample sample;
+			sample.time = (double)frame/fps;
+			double x, y, lastX, lastY;
+			truePosition(gesture, direction, sample.time, x, y);
+			truePosition(gesture, direction, sample.time-1.0/fps, lastX, lastY);
+			sample.truthX = (float)x;
+			sample.truthY = (float)y;
+			sample.resting = (hypot(x-lastX, y-lastY)*fps<REST_SPEED);
+			x += noise*random.gaussian();
+			y += noise*random.gaussian();
+			if (grid>0) {
+				x = floor(x/grid+0.5)*grid;
+				y = floor(y/grid+0.5)*grid;
+			}
+			sample.x = (float)x;
+			sample.y = (float)y;
+			trace.push_back(sample);
+		}
+		settle(trace);
+		traces.push_back(trace);
+	}
+}
+
+static bool readTrace(std::vector<Trace> &traces, const char *file) {
+	FILE *input = fopen(file, "r");
+	if (input==NULL) return false;
+
+	std::map<int,Trace> contacts;
+	double time;
+	int id;
+	float x, y;
+	while (fscanf(input, "%lf %d %f %f", &time, &id, &x, &y)==4) {
+		Sample sample;
+		sample.time = time;
+		sample.x = x;
+		sample.y = y;
+		contacts[id].push_back(sample);
+	}
+	fclose(input);
+
+	for (std::map<int,Trace>::iterator contact=contacts.begin(); contact!=contacts.end(); contact++) {
+		Trace &trace = contact->second;
+		int size = (int)trace.size();
+		for (int i=0; i<size; i++) {
+			int first = (i>=REFERENCE_WINDOW) ? i-REFERENCE_WINDOW : 0;
+			int last = (i+REFERENCE_WINDOW<size) ? i+REFERENCE_WINDOW : size-1;
+			// a symmetric window, so that the estimate does not lag itself
+			int half = (i-first<last-i) ? i-first : last-i;
+			double sumX = 0, sumY = 0;
+			for (int j=i-half; j<=i+half; j++) {
+				sumX += trace[j].x;
+				sumY += trace[j].y;
+			}
+			trace[i].truthX = (float)(sumX/(2*half+1));
+			trace[i].truthY = (float)(sumY/(2*half+1));
+		}
+		for (int i=0; i<size; i++) {
+			int a = (i>0) ? i-1 : i, b = (i+1<size) ? i+1 : i;
+			double dt = trace[b].time-trace[a].time;
+			double distance = hypot(trace[b].truthX-trace[a].truthX, trace[b].truthY-trace[a].truthY);
+			trace[i].resting = (dt<=0) || (distance/dt<REST_SPEED);
+		}
+		settle(trace);
+		if (size>1) traces.push_back(trace);
+	}
+	return true;
+}
+
+class Recorder : public TuioListener {
+public:
+	Recorder(FILE *output) : positions(0), output(output) {}
+
+	void addTuioObject(TuioObject *tobj) {}
+	void updateTuioObject(TuioObject *tobj) {}
+	void removeTuioObject(TuioObject *tobj) {}
+
+	void addTuioCursor(TuioCursor *tcur) { record(tcur); }
+	void updateTuioCursor(TuioCursor *tcur) { record(tcur); }
+	void removeTuioCursor(TuioCursor *tcur) {}
+
+	void refresh(TuioTime frameTime) {}
+
+	long positions;
+
+private:
+	void record(TuioCursor *tcur) {
+		TuioTime time = tcur->getTuioTime();
+		fprintf(output, "%ld.%06ld %d %f %f\n", time.getSeconds(), time.getMicroseconds(), tcur->getCursorID(), tcur->getX(), tcur->getY());
+		positions++;
+	}
+
+	FILE *output;
+};
+
+static bool record(int port, const char *file, double seconds) {
+	FILE *output = fopen(file, "w");
+	if (output==NULL) return false;
+
+	Recorder recorder(output);
+	TuioClient client(port);
+	client.addTuioListener(&recorder);
+	client.connect(false);
+	if (!client.isConnected()) {
+		fclose(output);
+		return false;
+	}
+	printf("recording port %d for %.0f seconds to %s\n", port, seconds, file);
+	usleep((useconds_t)(seconds*1000000));
+	client.disconnect();
+	client.removeTuioListener(&recorder);
+	fclose(output);
+	printf("%ld positions\n", recorder.positions);
+	return true;
+}
+
+// the true position at a time, interpolated between the samples
+static void truthAt(const Trace &trace, double time, size_t &index, float &x, float &y) {
+	while ((index+1<trace.size()) && (trace[index+1].time<=time)) index++;
+	while ((index>0) && (trace[index].time>time)) index--;
+	const Sample &a = trace[index];
+	if ((time<=a.time) || (index+1>=trace.size())) {
+		x = a.truthX;
+		y = a.truthY;
+		return;
+	}
+	const Sample &b = trace[index+1];
+	float f = (float)((time-a.time)/(b.time-a.time));
+	x = a.truthX+f*(b.truthX-a.truthX);
+	y = a.truthY+f*(b.truthY-a.truthY);
+}
+
+static TuioTime tuioTime(double seconds) {
+	long sec = (long)seconds;
+	return TuioTime(sec, (long)((seconds-sec)*1000000));
+}
+
+struct Result {
+	double rawJitter, jitter, movingError, maxError, latency;
+};
+
+static Result evaluate(const std::vector<Trace> &traces, const TuioFilter &filter, const TuioPrediction &prediction, double latency) {
+	Result result;
+	double rawRest = 0, rest = 0, moving = 0;
+	long restCount = 0, movingCount = 0;
+	result.maxError = 0;
+
+	std::vector<std::vector<float> > filteredX(traces.size()), filteredY(traces.size());
+	for (size_t t=0; t<traces.size(); t++) {
+		const Trace &trace = traces[t];
+		TuioFilterState state;
+		TuioPredictionState predictionState;
+		TuioCursor cursor(tuioTime(trace[0].time), 0, 0, trace[0].x, trace[0].y);
+		prediction.reset(predictionState);
+		size_t index = 0;
+		for (size_t i=0; i<trace.size(); i++) {
+			const Sample &sample = trace[i];
+			float x = sample.x, y = sample.y;
+			if (i==0) filter.reset(state, x, y, sample.time);
+			else {
+				filter.apply(state, x, y, sample.time);
+				if (sample.time>trace[i-1].time) cursor.update(tuioTime(sample.time), sample.x, sample.y);
+				prediction.apply(predictionState, x, y, cursor.getXSpeed(), cursor.getYSpeed(), cursor.getMotionAccel());
+			}
+			filteredX[t].push_back(x);
+			filteredY[t].push_back(y);
+
+			// where the finger is when the position is shown
+			float truthX, truthY;
+			truthAt(trace, sample.time+latency, index, truthX, truthY);
+			double error = hypot(x-truthX, y-truthY);
+			if (error>result.maxError) result.maxError = error;
+			// the jitter of contacts that still rest when they are shown
+			bool resting = sample.settled && trace[index].resting && ((index+1==trace.size()) || trace[index+1].resting);
+			if (resting) {
+				double rawError = hypot(sample.x-truthX, sample.y-truthY);
+				rawRest += rawError*rawError;
+				rest += error*error;
+				restCount++;
+			} else if (!sample.resting) {
+				moving += error*error;
+				movingCount++;
+			}
+		}
+	}
+	result.rawJitter = (restCount>0) ? sqrt(rawRest/restCount) : 0;
+	result.jitter = (restCount>0) ? sqrt(rest/restCount) : 0;
+	result.movingError = (movingCount>0) ? sqrt(moving/movingCount) : 0;
+
+	// the delay of the true path that matches the shown positions of moving contacts best
+	result.latency = 0;
+	double best = -1;
+	for (double lag=-MAX_LAG; lag<=MAX_LAG; lag+=LAG_STEP) {
+		double sum = 0;
+		for (size_t t=0; t<traces.size(); t++) {
+			const Trace &trace = traces[t];
+			size_t index = 0;
+			for (size_t i=0; i<trace.size(); i++) {
+				if (trace[i].resting) continue;
+				float x, y;
+				truthAt(trace, trace[i].time+latency-lag, index, x, y);
+				double dx = filteredX[t][i]-x, dy = filteredY[t][i]-y;
+				sum += dx*dx+dy*dy;
+			}
+		}
+		if ((best<0) || (sum<best)) {
+			best = sum;
+			result.latency = lag;
+		}
+	}
+	return result;
+}
+
+static const char *defaultConfigs[] = {
+	"none",
+	"oneeuro", "oneeuro 0.5 40 2", "oneeuro 2 40 2", "oneeuro 1 10 2", "oneeuro 1 100 2",
+	"kalman", "kalman 0.2", "kalman 5",
+};
+
+static void usage() {
+	printf("usage: FilterEvaluation [-r trace file] [-p port [-o file] [-t seconds]] [-n noise] [-g grid] [-f fps]\n"
+		"                        [-c filter config]... [-a prediction config]... [-l latency] [-x seed]\n");
+}
+
+int main(int argc, char *argv[]) {
+	const char *traceFile = NULL;
+	const char *outputFile = "trace.txt";
+	int port = 0;
+	double seconds = 10;
+	double noise = 0.002;
+	double grid = 0;
+	int fps = 60;
+	unsigned long long seed = 1;
+	double latency = 0;
+	std::vector<std::string> configs;
+	std::vector<std::string> predictions;
+
+	int option;
+	while ((option = getopt(argc, argv, "r:p:o:t:n:g:f:c:a:l:x:"))!=-1) {
+		switch (option) {
+			case 'r': traceFile = optarg; break;
+			case 'p': port = atoi(optarg); break;
+			case 'o': outputFile = optarg; break;
+			case 't': seconds = atof(optarg); break;
+			case 'n': noise = atof(optarg); break;
+			case 'g':
+				// accepts 1/640 as well as 0.0015625
+				if (strchr(optarg, '/')!=NULL) grid = atof(optarg)/atof(strchr(optarg, '/')+1);
+				else grid = atof(optarg);
+				break;
+			case 'f': fps = atoi(optarg); break;
+			case 'c': configs.push_back(optarg); break;
+			case 'a': predictions.push_back(optarg); break;
+			case 'l': latency = atof(optarg)/1000; break;
+			case 'x': seed = strtoull(optarg, NULL, 10); break;
+			default: usage(); return 1;
+		}
+	}
+	if ((fps<1) || (seconds<=0) || (latency<0) || (noise<0) || (grid<0) || (port<0) || (port>65535)) {
+		usage();
+		return 1;
+	}
+
+	std::vector<Trace> traces;
+	if (port>0) {
+		if (!record(port, outputFile, seconds)) {
+			printf("could not record port %d to %s\n", port, outputFile);
+			return 1;
+		}
+		traceFile = outputFile;
+	}
+	if (traceFile!=NULL) {
+		if (!readTrace(traces, traceFile)) {
+			printf("could not read %s\n", traceFile);
+			return 1;
+		}
+		printf("%d contacts from %s, path estimated from the raw positions\n", (int)traces.size(), traceFile);
+	} else {
+		synthesize(traces, noise, grid, fps, seed);
+		printf("%d synthetic gestures at %d fps, noise %g, grid %g\n", (int)traces.size(), fps, noise, grid);
+	}
+	if (traces.empty()) {
+		printf("no contacts to evaluate\n");
+		return 1;
+	}
+
+	if (configs.empty()) configs.assign(defaultConfigs, defaultConfigs+sizeof(defaultConfigs)/sizeof(defaultConfigs[0]));
+	if (predictions.empty()) predictions.push_back("none");
+
+	printf("errors in thousandths of the surface, latency %.1f ms\n", latency*1000);
+	printf("%-22s %-12s %10s %10s %10s %10s %10s %10s\n", "filter", "prediction", "raw jitter", "jitter", "reduction", "moving", "max error", "latency ms");
+	for (size_t c=0; c<configs.size(); c++) {
+		TuioFilter filter;
+		if (!filter.configure(configs[c].c_str())) {
+			printf("%-22s invalid configuration\n", configs[c].c_str());
+			continue;
+		}
+		for (size_t p=0; p<predictions.size(); p++) {
+			TuioPrediction prediction;
+			if (!prediction.configure(predictions[p].c_str())) {
+				printf("%-22s %-12s invalid configuration\n", configs[c].c_str(), predictions[p].c_str());
+				continue;
+			}
+			// the measured latency of the service is the pipeline latency here
+			prediction.setMeasuredLatency((float)latency);
+			Result result = evaluate(traces, filter, prediction, latency);
+			double reduction = (result.rawJitter>0) ? 100*(1-result.jitter/result.rawJitter) : 0;
+			printf("%-22s %-12s %10.3f %10.3f %9.1f%% %10.3f %10.3f %10.1f\n", configs[c].c_str(), predictions[p].c_str(),
+				result.rawJitter*1000, result.jitter*1000, reduction, result.movingError*1000, result.maxError*1000, result.latency*1000);
+		}
+	}
+	return 0;
+}
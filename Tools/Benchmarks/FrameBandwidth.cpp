@@ -0,0 +1,124 @@
+/*
+	Bandwidth of TuioServer on a 60 contact trace.
+
+	Replays a synthetic trace of 60 cursors at 60 frames per second: a
+	group of 15 cursors drags across the surface while the others rest,
+	and every second five resting cursors are lifted and put down again.
+	The trace is sent to a local socket once in a single packet per frame,
+	once fragmented for a 1500 bytes MTU, with the full update, and with
+	the delta update at two keyframe intervals. Reports the UDP payload and
+	the bytes on an Ethernet wire including the UDP header and the IPv4
+	headers of all IP fragments, per frame and per second, and the packets
+	per frame.
+
+	usage: FrameBandwidth [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "TuioServer.h"
+
+using namespace TUIO;
+
+static const int PORT = 7700;
+static const int CONTACTS = 60;
+static const int MOVING = 15;
+static const int FPS = 60;
+
+static int openReceiver() {
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	int size = 8*1024*1024;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(PORT);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(fd, (struct sockaddr*)&address, sizeof(address))<0) {
+		perror("bind");
+		exit(1);
+	}
+	return fd;
+}
+
+static void drain(int fd, long long &packets, long long &bytes, long long &wire) {
+	char buffer[65536];
+	int size;
+	while ((size = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT))>0) {
+		packets++;
+		bytes += size;
+		// datagrams larger than the MTU leave in several IP fragments
+		int fragments = (size+UDP_HEADER_SIZE+IP_MTU_SIZE-IPV4_HEADER_SIZE-1)/(IP_MTU_SIZE-IPV4_HEADER_SIZE);
+		wire += size+UDP_HEADER_SIZE+fragments*IPV4_HEADER_SIZE;
+	}
+}
+
+static void runTrace(int fd, const char *name, int mtu, bool fullUpdate, int keyframeInterval, int frames) {
+	TuioServer *server = (mtu>0) ? new TuioServer("127.0.0.1", PORT) : new TuioServer("127.0.0.1", PORT, MAX_UDP_SIZE);
+	if (mtu>0) server->setMTU(mtu);
+	if (fullUpdate) server->enableFullUpdate();
+	if (keyframeInterval>0) server->enableDeltaUpdate(keyframeInterval);
+
+	long long packets = 0, bytes = 0, wire = 0;
+	drain(fd, packets, bytes, wire);
+	packets = bytes = wire = 0;
+
+	TuioCursor *cursor[CONTACTS];
+	float restX[CONTACTS], restY[CONTACTS];
+	TuioTime frameTime = TuioTime::getSessionTime();
+	for (int frame=0; frame<frames; frame++) {
+		frameTime = frameTime+(long)(1000000/FPS);
+		server->initFrame(frameTime);
+		for (int i=0; i<CONTACTS; i++) {
+			if (frame==0) {
+				restX[i] = (i%10+0.5f)/10.0f;
+				restY[i] = (i/10+0.5f)/6.0f;
+				cursor[i] = server->addTuioCursor(restX[i], restY[i]);
+			} else if ((i>=MOVING) && (frame%FPS==0) && ((i+frame/FPS)%9==0)) {
+				// lift a resting cursor and put it down again
+				server->removeTuioCursor(cursor[i]);
+				cursor[i] = server->addTuioCursor(restX[i], restY[i]);
+			} else if (i<MOVING) {
+				float phase = (float)frame/FPS+i*0.4f;
+				server->updateTuioCursor(cursor[i], 0.5f+0.3f*(float)cos(phase), 0.5f+0.3f*(float)sin(phase));
+			} else {
+				// trackers report the resting cursors at the same position in every frame
+				server->updateTuioCursor(cursor[i], restX[i], restY[i]);
+			}
+		}
+		server->commitFrame();
+		drain(fd, packets, bytes, wire);
+	}
+
+	server->initFrame(frameTime+(long)(1000000/FPS));
+	for (int i=0; i<CONTACTS; i++) server->removeTuioCursor(cursor[i]);
+	server->commitFrame();
+	delete server;
+
+	printf("%-22s %7.0f bytes/frame  %7.0f wire bytes/frame  %6.1f kB/s on the wire  %5.2f packets/frame\n",
+		name, (double)bytes/frames, (double)wire/frames, wire*FPS/1000.0/frames, (double)packets/frames);
+}
+
+int main(int argc, char *argv[]) {
+	int frames = 1200;
+	if (argc>1) frames = atoi(argv[1]);
+	if (frames<=0) {
+		printf("usage: FrameBandwidth [frames]\n");
+		return 1;
+	}
+
+	int fd = openReceiver();
+	runTrace(fd, "single packet", 0, false, 0, frames);
+	runTrace(fd, "MTU 1500", IP_MTU_SIZE, false, 0, frames);
+	runTrace(fd, "MTU 1500 full update", IP_MTU_SIZE, true, 0, frames);
+	runTrace(fd, "MTU 1500 delta 30", IP_MTU_SIZE, false, 30, frames);
+	runTrace(fd, "MTU 1500 delta 120", IP_MTU_SIZE, false, 120, frames);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+	Cost and consistency of the frame mirror.
+
+	A publisher writes frames of contacts into a TuioFrameMirror as fast as
+	it can, the way the service does after every frame, while reader threads
+	copy the last frame in a loop. Every contact of a frame carries values
+	derived from the frame ID, so a reader detects a frame that was torn by
+	a concurrent write. Reports the publish time per frame, the frames the
+	readers copied, the reads that gave up while the publisher kept writing,
+	and the torn frames, which have to be zero.
+
+	usage: FrameMirror [seconds] [contacts] [readers]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "TuioFrameMirror.h"
+#include "TuioAtomic.h"
+#include "ip/NetworkingUtils.h"
+
+using namespace TUIO;
+
+static const char *NAME = "tuio-frame-mirror-benchmark";
+static const int MAX_READERS = 16;
+
+static volatile long running = 1;
+
+struct ReaderResult {
+	long long reads, failed, torn;
+};
+
+static void* readerThread(void *obj) {
+	ReaderResult *result = static_cast<ReaderResult*>(obj);
+	TuioFrameMirror mirror(NAME, false);
+	TuioFrameMirrorFrame frame;
+	TuioFrameMirrorContact contacts[TUIO_FRAME_MIRROR_CONTACTS];
+	while (atomicLoad(&running)) {
+		if (!mirror.read(frame, contacts, TUIO_FRAME_MIRROR_CONTACTS)) {
+			result->failed++;
+			continue;
+		}
+		result->reads++;
+		for (int i=0; i<frame.contactCount; i++) {
+			if ((contacts[i].id!=i) || (contacts[i].status!=(int)(frame.frameID&0xff)) || (contacts[i].x!=(float)(frame.frameID%1000))) {
+				result->torn++;
+				break;
+			}
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int seconds = 2;
+	int contacts = 10;
+	int readers = 2;
+	if (argc>1) seconds = atoi(argv[1]);
+	if (argc>2) contacts = atoi(argv[2]);
+	if (argc>3) readers = atoi(argv[3]);
+	if ((seconds<=0) || (contacts<0) || (contacts>TUIO_FRAME_MIRROR_CONTACTS) || (readers<1) || (readers>MAX_READERS)) {
+		printf("usage: FrameMirror [seconds] [contacts 0-%d] [readers 1-%d]\n", TUIO_FRAME_MIRROR_CONTACTS, MAX_READERS);
+		return 1;
+	}
+
+	TuioFrameMirror mirror(NAME, true);
+	if (!mirror.isOpen()) return 1;
+
+	pthread_t threads[MAX_READERS];
+	ReaderResult results[MAX_READERS] = {};
+	for (int r=0; r<readers; r++) pthread_create(&threads[r], NULL, readerThread, &results[r]);
+
+	long long start = GetCurrentTimeNanoseconds();
+	long long end = start+seconds*1000000000LL;
+	long long frame = 0;
+	while (GetCurrentTimeNanoseconds()<end) {
+		for (int batch=0; batch<1000; batch++, frame++) {
+			mirror.beginFrame(frame, frame*1000);
+			for (int c=0; c<contacts; c++) {
+				float value = (float)(frame%1000);
+				mirror.addContact(c, (int)(frame&0xff), value, value, value, value, value, value);
+			}
+			mirror.commitFrame(1);
+		}
+	}
+	long long elapsed = GetCurrentTimeNanoseconds()-start;
+
+	atomicStore(&running, 0);
+	ReaderResult total = {};
+	for (int r=0; r<readers; r++) {
+		pthread_join(threads[r], NULL);
+		total.reads += results[r].reads;
+		total.failed += results[r].failed;
+		total.torn += results[r].torn;
+	}
+
+	printf("contacts %2d  readers %2d  publish %6.1f ns/frame  %10lld reads  %8lld gave up  %lld torn\n",
+		contacts, readers, (double)elapsed/frame, total.reads, total.failed, total.torn);
+	return (total.torn==0) ? 0 : 1;
+}
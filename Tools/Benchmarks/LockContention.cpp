@@ -0,0 +1,199 @@
+/*
+	Lock contention benchmark for the TUIO synchronization primitives (pthread path).
+
+	Compares TuioMutex against a System V semaphore, which like the former
+	named Win32 mutexes is a kernel object and costs a system call on every
+	acquire and release, and measures the TuioSeqLock single-writer path with
+	concurrent readers.
+
+	usage: LockContention [iterations per thread]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/ipc.h>
+#include <sys/sem.h>
+
+#include "TuioLock.h"
+
+using namespace TUIO;
+
+static const int MAX_THREADS = 8;
+
+static double nowSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+class BenchLock {
+public:
+	virtual ~BenchLock() {}
+	virtual void lock() = 0;
+	virtual void unlock() = 0;
+};
+
+class MutexLock : public BenchLock {
+	TuioMutex mutex;
+public:
+	void lock() { mutex.lock(); }
+	void unlock() { mutex.unlock(); }
+};
+
+class SemaphoreLock : public BenchLock {
+	int semid;
+public:
+	SemaphoreLock() {
+		semid = semget(IPC_PRIVATE, 1, IPC_CREAT | 0600);
+		if (semid<0) { perror("semget"); exit(1); }
+		semctl(semid, 0, SETVAL, 1);
+	}
+	~SemaphoreLock() { semctl(semid, 0, IPC_RMID); }
+	void lock() { struct sembuf op = {0, -1, 0}; semop(semid, &op, 1); }
+	void unlock() { struct sembuf op = {0, 1, 0}; semop(semid, &op, 1); }
+};
+
+struct LockTask {
+	BenchLock *lock;
+	long iterations;
+	volatile long *counter;
+	volatile long *start;
+};
+
+static void* lockThread(void *arg) {
+	LockTask *task = (LockTask*)arg;
+	while (!atomicLoad(task->start)) cpuRelax();
+	for (long i=0; i<task->iterations; i++) {
+		task->lock->lock();
+		(*task->counter)++;
+		task->lock->unlock();
+	}
+	return NULL;
+}
+
+static void runLockBenchmark(const char *name, BenchLock *lock, int threads, long iterations) {
+	pthread_t tid[MAX_THREADS];
+	LockTask task[MAX_THREADS];
+	volatile long counter = 0;
+	volatile long start = 0;
+
+	for (int t=0; t<threads; t++) {
+		task[t].lock = lock;
+		task[t].iterations = iterations;
+		task[t].counter = &counter;
+		task[t].start = &start;
+		pthread_create(&tid[t], NULL, lockThread, &task[t]);
+	}
+
+	double begin = nowSeconds();
+	atomicStore(&start, 1);
+	for (int t=0; t<threads; t++) pthread_join(tid[t], NULL);
+	double elapsed = nowSeconds()-begin;
+
+	long total = iterations*threads;
+	printf("%-12s threads %d  %10.1f ns/op  %s\n", name, threads, elapsed*1e9/total, (counter==total)?"ok":"COUNTER MISMATCH");
+}
+
+struct SeqData {
+	long a, b, c, d;
+};
+
+struct SeqTask {
+	TuioSeqLock *seqlock;
+	SeqData *data;
+	long iterations;
+	volatile long *start;
+	volatile long *writing;
+	long torn;
+	double elapsed;
+};
+
+static void* seqWriterThread(void *arg) {
+	SeqTask *task = (SeqTask*)arg;
+	while (!atomicLoad(task->start)) cpuRelax();
+	double begin = nowSeconds();
+	for (long i=1; i<=task->iterations; i++) {
+		task->seqlock->writeBegin();
+		task->data->a = i; task->data->b = i; task->data->c = i; task->data->d = i;
+		task->seqlock->writeEnd();
+	}
+	task->elapsed = nowSeconds()-begin;
+	atomicStore(task->writing, 0);
+	return NULL;
+}
+
+static void* seqReaderThread(void *arg) {
+	SeqTask *task = (SeqTask*)arg;
+	while (!atomicLoad(task->start)) cpuRelax();
+	double begin = nowSeconds();
+	long reads = 0;
+	while (atomicLoad(task->writing) || reads<task->iterations) {
+		SeqData copy;
+		long seq;
+		do {
+			seq = task->seqlock->readBegin();
+			volatile SeqData *shared = task->data;
+			copy.a = shared->a; copy.b = shared->b; copy.c = shared->c; copy.d = shared->d;
+		} while (task->seqlock->readRetry(seq));
+		if ((copy.a!=copy.b) || (copy.b!=copy.c) || (copy.c!=copy.d)) task->torn++;
+		reads++;
+	}
+	task->iterations = reads;
+	task->elapsed = nowSeconds()-begin;
+	return NULL;
+}
+
+static void runSeqLockBenchmark(int threads, long iterations) {
+	pthread_t tid[MAX_THREADS];
+	SeqTask task[MAX_THREADS];
+	TuioSeqLock seqlock;
+	SeqData data = {0, 0, 0, 0};
+	volatile long start = 0;
+	volatile long writing = 1;
+
+	for (int t=0; t<threads; t++) {
+		task[t].seqlock = &seqlock;
+		task[t].data = &data;
+		task[t].iterations = iterations;
+		task[t].start = &start;
+		task[t].writing = &writing;
+		task[t].torn = 0;
+		task[t].elapsed = 0;
+		pthread_create(&tid[t], NULL, (t==0)?seqWriterThread:seqReaderThread, &task[t]);
+	}
+
+	atomicStore(&start, 1);
+	for (int t=0; t<threads; t++) pthread_join(tid[t], NULL);
+
+	double readNs = 0;
+	long torn = 0;
+	for (int t=1; t<threads; t++) {
+		readNs += task[t].elapsed*1e9/task[t].iterations;
+		torn += task[t].torn;
+	}
+	if (threads>1) readNs /= threads-1;
+
+	printf("%-12s threads %d  %10.1f ns/write  %8.1f ns/read  %s\n", "TuioSeqLock", threads,
+		task[0].elapsed*1e9/iterations, readNs, (torn==0)?"ok":"TORN READS");
+}
+
+int main(int argc, char *argv[]) {
+	long iterations = 1000000;
+	if (argc>1) iterations = atol(argv[1]);
+	if (iterations<=0) {
+		printf("usage: LockContention [iterations per thread]\n");
+		return 1;
+	}
+
+	MutexLock mutex;
+	SemaphoreLock semaphore;
+
+	for (int threads=1; threads<=MAX_THREADS; threads*=2) {
+		runLockBenchmark("TuioMutex", &mutex, threads, iterations);
+		runLockBenchmark("SysV sem", &semaphore, threads, iterations/10);
+		runSeqLockBenchmark(threads, iterations);
+	}
+	return 0;
+}
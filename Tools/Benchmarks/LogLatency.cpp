@@ -0,0 +1,92 @@
+/*
+	Caller-side cost of the asynchronous TuioLog.
+
+	Measures how long a TUIO_LOG_* statement blocks its caller, first at a
+	steady rate the writer thread keeps up with, then as a burst from several
+	threads that overruns the ring and the per statement rate limit, and
+	compares against a flushed fprintf, which is what the former std::endl
+	and std::ofstream output cost on the touch path.
+
+	usage: LogLatency [log file]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TuioLog.h"
+
+using namespace TUIO;
+
+static const int THREADS = 4;
+static const long BURST = 100000;
+
+static double nowSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void* burstThread(void *arg) {
+	double *elapsed = (double*)arg;
+	double begin = nowSeconds();
+	for (long i=0; i<BURST; i++) {
+		TUIO_LOG_ERROR("touch failed %ld", i);
+	}
+	*elapsed = nowSeconds()-begin;
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	const char *path = (argc>1)?argv[1]:"/dev/null";
+
+	if (!TuioLog::open(path)) {
+		printf("could not open %s\n", path);
+		return 1;
+	}
+
+	// steady: distinct call sites are not rate limited, stay below the ring size per writer wakeup
+	double worst = 0, total = 0;
+	long steady = 2000;
+	for (long i=0; i<steady; i++) {
+		double begin = nowSeconds();
+		TuioLog::write(TUIO_LOG_LEVEL_INFO, NULL, "steady message %ld x %f y %f", i, 0.5, 0.25);
+		double elapsed = nowSeconds()-begin;
+		total += elapsed;
+		if (elapsed>worst) worst = elapsed;
+		if ((i%64)==63) usleep(1000);
+	}
+	printf("steady       %10.1f ns/msg  worst %8.1f us\n", total*1e9/steady, worst*1e6);
+
+	// burst: one rate limited statement hammered from several threads
+	pthread_t tid[THREADS];
+	double elapsed[THREADS];
+	for (int t=0; t<THREADS; t++) pthread_create(&tid[t], NULL, burstThread, &elapsed[t]);
+	double burstTotal = 0;
+	for (int t=0; t<THREADS; t++) {
+		pthread_join(tid[t], NULL);
+		burstTotal += elapsed[t];
+	}
+	printf("burst        %10.1f ns/msg  (%d threads, %ld suppressed, %ld dropped)\n",
+		burstTotal*1e9/(BURST*THREADS), THREADS, TuioLog::getSuppressedCount(), TuioLog::getDroppedCount());
+
+	TuioLog::close();
+
+	// reference: synchronous flushed write per message
+	FILE *file = fopen(path, "a");
+	if (file==NULL) return 1;
+	worst = 0; total = 0;
+	for (long i=0; i<steady; i++) {
+		double begin = nowSeconds();
+		fprintf(file, "steady message %ld x %f y %f\n", i, 0.5, 0.25);
+		fflush(file);
+		double e = nowSeconds()-begin;
+		total += e;
+		if (e>worst) worst = e;
+	}
+	fclose(file);
+	printf("fflush       %10.1f ns/msg  worst %8.1f us\n", total*1e9/steady, worst*1e6);
+	return 0;
+}
@@ -0,0 +1,449 @@
+/*
+	Microbenchmarks of the touch pipeline, in the style of Google Benchmark.
+
+	Covers the stages a frame passes through in the service: parsing a
+	TUIO bundle with osc::ReceivedPacket and ReceivedMessage, encoding one
+	with OutboundPacketStream, TuioClient::ProcessPacket() for recorded
+	bundles of 1 to 256 cursors, TuioContainer::update(), the smoothing
+	filters (TuioFilter), the calibration (TuioCalibration) with and
+	without a correction grid, and packing the TOUCH reports for VMulti.
+
+	Every benchmark is repeated until it ran for the given time. Reports
+	nanoseconds, heap allocations and allocated bytes per operation, and
+	instructions and cache misses per operation from the perf counters
+	where the kernel allows them (perf_event_paranoid, virtual machines).
+	Compare runs before and after a change of the hot path.
+
+	usage: Pipeline [name filter] [seconds per benchmark]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <new>
+#include <vector>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "TuioClient.h"
+#include "TuioCalibration.h"
+#include "TuioFilter.h"
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscReceivedElements.h"
+
+// the VMulti report layout, as used by the Windows client library
+typedef unsigned char BYTE;
+typedef unsigned short USHORT;
+#include "vmulticommon.h"
+
+using namespace TUIO;
+
+static const int PORT = 7800;
+static const int BUFFER_SIZE = 65536;
+
+// heap allocations of the benchmarked code, the benchmarks run on the main thread only
+static long long allocations = 0;
+static long long allocatedBytes = 0;
+
+void* operator new(size_t size) {
+	__atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&allocatedBytes, (long long)size, __ATOMIC_RELAXED);
+	void *p = malloc(size ? size : 1);
+	if (p==NULL) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) throw() {
+	free(p);
+}
+
+void operator delete[](void *p) throw() {
+	free(p);
+}
+
+static long long now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+
+// keeps the compiler from dropping a computation whose result is unused
+template <class T> inline void doNotOptimize(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class PerfCounter {
+public:
+	PerfCounter(unsigned long long config) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+	~PerfCounter() { if (fd>=0) close(fd); }
+	bool available() const { return fd>=0; }
+	void start() {
+		if (fd<0) return;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	long long stop() {
+		if (fd<0) return -1;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		long long value = 0;
+		if (read(fd, &value, sizeof(value))!=sizeof(value)) return -1;
+		return value;
+	}
+private:
+	int fd;
+};
+
+class State {
+public:
+	State(int arg, long long iterations, PerfCounter &instructions, PerfCounter &cacheMisses)
+	: arg(arg), iterations(iterations), count(0), instructions(instructions), cacheMisses(cacheMisses) {}
+
+	// the setup before the first call is not measured
+	bool keepRunning() {
+		if (count==0) start();
+		if (count==iterations) {
+			stop();
+			return false;
+		}
+		count++;
+		return true;
+	}
+
+	int range() const { return arg; }
+
+	long long elapsed, allocs, bytes, instructionCount, cacheMissCount;
+
+private:
+	void start() {
+		allocs = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+		bytes = __atomic_load_n(&allocatedBytes, __ATOMIC_RELAXED);
+		instructions.start();
+		cacheMisses.start();
+		elapsed = now();
+	}
+	void stop() {
+		elapsed = now()-elapsed;
+		cacheMissCount = cacheMisses.stop();
+		instructionCount = instructions.stop();
+		allocs = __atomic_load_n(&allocations, __ATOMIC_RELAXED)-allocs;
+		bytes = __atomic_load_n(&allocatedBytes, __ATOMIC_RELAXED)-bytes;
+	}
+
+	int arg;
+	long long iterations, count;
+	PerfCounter &instructions, &cacheMisses;
+};
+
+// a frame of the 2Dcur profile with the given cursors, the fseq argument is the last four bytes
+static int buildFrame(char *buffer, int size, int cursors, int fseq, float shift) {
+	osc::OutboundPacketStream packet(buffer, size);
+	packet << osc::BeginBundleImmediate;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "source" << "pipeline" << osc::EndMessage;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "alive";
+	for (int c=0; c<cursors; c++) packet << (osc::int32)(c+1);
+	packet << osc::EndMessage;
+	for (int c=0; c<cursors; c++) {
+		float x = ((c*37)%100)/100.0f+shift;
+		float y = ((c*61)%100)/100.0f+shift;
+		packet << osc::BeginMessage("/tuio/2Dcur") << "set" << (osc::int32)(c+1) << x << y << 0.1f << -0.1f << 0.5f << osc::EndMessage;
+	}
+	packet << osc::BeginMessage("/tuio/2Dcur") << "fseq" << (osc::int32)fseq << osc::EndMessage;
+	packet << osc::EndBundle;
+	return (int)packet.Size();
+}
+
+static void setFrameSequence(char *buffer, int size, int fseq) {
+	unsigned char *p = (unsigned char*)buffer+size-4;
+	p[0] = (unsigned char)(fseq>>24);
+	p[1] = (unsigned char)(fseq>>16);
+	p[2] = (unsigned char)(fseq>>8);
+	p[3] = (unsigned char)fseq;
+}
+
+static void parsePacket(State &state) {
+	std::vector<char> buffer(BUFFER_SIZE);
+	int size = buildFrame(&buffer[0], BUFFER_SIZE, state.range(), 1, 0);
+	while (state.keepRunning()) {
+		float sum = 0;
+		osc::ReceivedPacket packet(&buffer[0], size);
+		osc::ReceivedBundle bundle(packet);
+		for (osc::ReceivedBundle::const_iterator element=bundle.ElementsBegin(); element!=bundle.ElementsEnd(); element++) {
+			osc::ReceivedMessage message(*element);
+			osc::ReceivedMessageArgumentStream args = message.ArgumentStream();
+			const char *command;
+			args >> command;
+			if (strcmp(command, "set")==0) {
+				osc::int32 id;
+				float x, y, xspeed, yspeed, accel;
+				args >> id >> x >> y >> xspeed >> yspeed >> accel;
+				sum += x+y;
+			} else if (strcmp(command, "alive")==0) {
+				for (osc::ReceivedMessage::const_iterator arg=message.ArgumentsBegin(); ++arg!=message.ArgumentsEnd(); )
+					sum += (float)arg->AsInt32();
+			}
+		}
+		doNotOptimize(sum);
+	}
+}
+
+static void encodePacket(State &state) {
+	std::vector<char> buffer(BUFFER_SIZE);
+	int fseq = 0;
+	while (state.keepRunning()) {
+		int size = buildFrame(&buffer[0], BUFFER_SIZE, state.range(), fseq++, 0);
+		doNotOptimize(size);
+	}
+}
+
+class NullListener : public TuioListener {
+public:
+	NullListener() : frames(0) {}
+	void addTuioObject(TuioObject *tobj) {}
+	void updateTuioObject(TuioObject *tobj) {}
+	void removeTuioObject(TuioObject *tobj) {}
+	void addTuioCursor(TuioCursor *tcur) {}
+	void updateTuioCursor(TuioCursor *tcur) {}
+	void removeTuioCursor(TuioCursor *tcur) {}
+	void refresh(TuioTime frameTime) { frames++; }
+	long long frames;
+};
+
+// two recorded frames with the cursors at different positions, so that every cursor is updated
+static void processPacket(State &state) {
+	int cursors = state.range();
+	std::vector<char> frame[2];
+	int size[2];
+	for (int i=0; i<2; i++) {
+		frame[i].resize(BUFFER_SIZE);
+		size[i] = buildFrame(&frame[i][0], BUFFER_SIZE, cursors, 1, i*0.01f);
+	}
+
+	TuioClient client(PORT);
+	NullListener listener;
+	client.addTuioListener(&listener);
+	IpEndpointName source(127, 0, 0, 1, PORT+1);
+	int fseq = 1;
+	client.ProcessPacket(&frame[0][0], size[0], source);
+
+	while (state.keepRunning()) {
+		int i = ++fseq & 1;
+		setFrameSequence(&frame[i][0], size[i], fseq);
+		client.ProcessPacket(&frame[i][0], size[i], source);
+	}
+	doNotOptimize(listener.frames);
+	client.removeTuioListener(&listener);
+}
+
+// a cursor lives for 1024 frames, about 17 seconds at 60 fps, its path grows with every update
+static void containerUpdate(State &state) {
+	TuioCursor *cursor = NULL;
+	long frame = 0;
+	while (state.keepRunning()) {
+		if ((frame & 1023)==0) {
+			delete cursor;
+			cursor = new TuioCursor(TuioTime(0,0), 1, 0, 0.5f, 0.5f);
+		}
+		frame++;
+		TuioTime frameTime(frame/60, (frame%60)*16666);
+		cursor->update(frameTime, 0.5f+(frame & 15)*0.001f, 0.5f-(frame & 7)*0.001f);
+	}
+	delete cursor;
+}
+
+// every contact moves on its own line with some jitter, at 60 fps
+static void filterContacts(State &state, const TuioFilter &filter) {
+	int contacts = state.range();
+	std::vector<TuioFilterState> filterState(contacts);
+	for (int i=0; i<contacts; i++) filter.reset(filterState[i], 0.5f, 0.5f, 0);
+	long frame = 0;
+	while (state.keepRunning()) {
+		frame++;
+		double time = frame/60.0;
+		for (int i=0; i<contacts; i++) {
+			float x = 0.5f+(frame & 255)*0.001f+(frame & 3)*0.0005f;
+			float y = 0.5f-i*0.001f+(frame & 7)*0.0005f;
+			filter.apply(filterState[i], x, y, time);
+			doNotOptimize(x);
+			doNotOptimize(y);
+		}
+	}
+}
+
+static void filterOneEuro(State &state) {
+	TuioFilter filter;
+	filter.setOneEuro();
+	filterContacts(state, filter);
+}
+
+static void filterKalman(State &state) {
+	TuioFilter filter;
+	filter.setKalman();
+	filterContacts(state, filter);
+}
+
+static void calibration(State &state) {
+	int contacts = state.range();
+	TuioCalibration calibration;
+	calibration.setInvert(true, false);
+	calibration.setRange(0.05f, 0.95f, 0.1f, 0.9f);
+	calibration.setSwap(true);
+	std::vector<float> x(contacts), y(contacts);
+	while (state.keepRunning()) {
+		for (int i=0; i<contacts; i++) {
+			float cx = (i%10)*0.1f, cy = (i/10)*0.01f;
+			calibration.apply(cx, cy);
+			x[i] = cx;
+			y[i] = cy;
+		}
+		doNotOptimize(x[0]);
+	}
+}
+
+// the correction of a fitted keystone and lens distortion grid before the linear calibration
+static void calibrationGrid(State &state) {
+	int contacts = state.range();
+	std::vector<TuioCalibrationPoint> points;
+	for (int i=0; i<25; i++) {
+		TuioCalibrationPoint point;
+		point.sensorX = (i%5)*0.25f;
+		point.sensorY = (i/5)*0.25f;
+		point.screenX = point.sensorX*(0.9f+0.1f*point.sensorY)+0.02f;
+		point.screenY = point.sensorY+0.03f*point.sensorX*point.sensorX;
+		points.push_back(point);
+	}
+	TuioCalibrationGrid grid;
+	grid.fit(points);
+	TuioCalibration calibration;
+	calibration.setRange(0.05f, 0.95f, 0.1f, 0.9f);
+	calibration.setGrid(&grid);
+	std::vector<float> x(contacts), y(contacts);
+	while (state.keepRunning()) {
+		for (int i=0; i<contacts; i++) {
+			float cx = (i%10)*0.1f, cy = (i/10)*0.01f;
+			calibration.apply(cx, cy);
+			x[i] = cx;
+			y[i] = cy;
+		}
+		doNotOptimize(x[0]);
+	}
+}
+
+// the TOUCH array of the service and the control reports vmulti_update_multitouch() writes, two contacts each
+static void touchReport(State &state) {
+	int contacts = state.range();
+	std::vector<TOUCH> touch(contacts);
+	BYTE report[CONTROL_REPORT_SIZE];
+	memset(report, 0, sizeof(report));
+	while (state.keepRunning()) {
+		for (int i=0; i<contacts; i++) {
+			float x = (i%10)*0.1f, y = (i/10)*0.01f;
+			touch[i].ContactID = (BYTE)i;
+			touch[i].Status = MULTI_CONFIDENCE_BIT | MULTI_IN_RANGE_BIT | MULTI_TIPSWITCH_BIT;
+			touch[i].XValue = (USHORT)(x*(int)MULTI_MAX_COORDINATE);
+			touch[i].YValue = (USHORT)(y*(int)MULTI_MAX_COORDINATE);
+			touch[i].Width = 20;
+			touch[i].Height = 30;
+		}
+
+		VMultiControlReportHeader *header = (VMultiControlReportHeader*)report;
+		header->ReportID = REPORTID_CONTROL;
+		header->ReportLength = sizeof(VMultiMultiTouchReport);
+		VMultiMultiTouchReport *multiReport = (VMultiMultiTouchReport*)(report+sizeof(VMultiControlReportHeader));
+		for (int sent=0; sent<contacts; sent+=2) {
+			multiReport->ReportID = REPORTID_MTOUCH;
+			memcpy(multiReport->Touch, &touch[sent], sizeof(TOUCH));
+			if (sent<=contacts-2) memcpy(multiReport->Touch+1, &touch[sent+1], sizeof(TOUCH));
+			else memset(multiReport->Touch+1, 0, sizeof(TOUCH));
+			multiReport->ActualCount = (sent==0) ? (BYTE)contacts : 0;
+			doNotOptimize(report);
+		}
+	}
+}
+
+struct Benchmark {
+	const char *name;
+	void (*function)(State &state);
+	int args[8];
+};
+
+static const Benchmark benchmarks[] = {
+	{ "ParsePacket", parsePacket, { 1, 4, 16, 64, 256, 0 } },
+	{ "EncodePacket", encodePacket, { 1, 4, 16, 64, 256, 0 } },
+	{ "ProcessPacket", processPacket, { 1, 4, 16, 64, 256, 0 } },
+	{ "ContainerUpdate", containerUpdate, { 1, 0 } },
+	{ "FilterOneEuro", filterOneEuro, { 1, 10, 100, 0 } },
+	{ "FilterKalman", filterKalman, { 1, 10, 100, 0 } },
+	{ "Calibration", calibration, { 1, 10, 100, 0 } },
+	{ "CalibrationGrid", calibrationGrid, { 1, 10, 100, 0 } },
+	{ "TouchReport", touchReport, { 1, 2, 10, 20, 0 } },
+};
+
+static void printPerOperation(long long value, long long iterations) {
+	if (value<0) printf(" %12s", "-");
+	else printf(" %12.1f", (double)value/iterations);
+}
+
+int main(int argc, char *argv[]) {
+	const char *filter = (argc>1) ? argv[1] : "";
+	double seconds = 0.5;
+	if (argc>2) seconds = atof(argv[2]);
+	if (seconds<=0) {
+		printf("usage: Pipeline [name filter] [seconds per benchmark]\n");
+		return 1;
+	}
+
+	PerfCounter instructions(PERF_COUNT_HW_INSTRUCTIONS);
+	PerfCounter cacheMisses(PERF_COUNT_HW_CACHE_MISSES);
+	if (!instructions.available() || !cacheMisses.available())
+		printf("perf counters are not available, see /proc/sys/kernel/perf_event_paranoid\n");
+
+	printf("%-22s %12s %12s %12s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op", "instr/op", "misses/op");
+	for (size_t b=0; b<sizeof(benchmarks)/sizeof(benchmarks[0]); b++) {
+		const Benchmark &benchmark = benchmarks[b];
+		for (int a=0; (a==0) || (benchmark.args[a]>0); a++) {
+			char name[64];
+			sprintf(name, "%s/%d", benchmark.name, benchmark.args[a]);
+			if (strstr(name, filter)==NULL) continue;
+
+			// grow the iterations until a run takes a tenth of the time, then scale to the full time
+			long long iterations = 1;
+			while (true) {
+				State trial(benchmark.args[a], iterations, instructions, cacheMisses);
+				benchmark.function(trial);
+				if ((trial.elapsed>=seconds*1e8) || (iterations>=1000000000LL)) {
+					iterations = (long long)(iterations*seconds*1e9/(trial.elapsed>0 ? trial.elapsed : 1));
+					break;
+				}
+				iterations *= 10;
+			}
+			if (iterations<1) iterations = 1;
+
+			State state(benchmark.args[a], iterations, instructions, cacheMisses);
+			benchmark.function(state);
+			printf("%-22s %12lld %12.1f", name, iterations, (double)state.elapsed/iterations);
+			printPerOperation(state.allocs, iterations);
+			printPerOperation(state.bytes, iterations);
+			printPerOperation(state.instructionCount, iterations);
+			printPerOperation(state.cacheMissCount, iterations);
+			printf("\n");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+	Receive cost of the SocketReceiveMultiplexer backends.
+
+	Sends TUIO sized datagrams to several sockets attached to one
+	multiplexer and measures the CPU time the receiving thread spends per
+	datagram with the select() backend, which copies every datagram out of
+	the kernel with one recvmsg() call after each wakeup, and with the
+	io_uring backend, which receives into provided buffers with one
+	multishot request per socket and hands them to the listener in place.
+
+	usage: ReceiveBackend [datagrams per socket] [sockets] [datagram size]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ip/UdpSocket.h"
+#include "ip/PacketListener.h"
+
+static const int BASE_PORT = 7400;
+static const int MAX_SOCKETS = 16;
+static const int BURST = 32;
+
+static double threadCpuSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static double nowSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+class CountingListener : public PacketListener {
+public:
+	long datagrams;
+	long checksum;
+	CountingListener():datagrams(0),checksum(0) {}
+	void ProcessPacket(const char *data, int size, const IpEndpointName&) {
+		// touch the payload like the OSC parser would
+		checksum += data[0] + data[size-1];
+		datagrams++;
+	}
+};
+
+struct Receiver {
+	SocketReceiveMultiplexer *mux;
+	double cpuSeconds;
+};
+
+static void* receiveThread(void *arg) {
+	Receiver *receiver = (Receiver*)arg;
+	double begin = threadCpuSeconds();
+	receiver->mux->Run();
+	receiver->cpuSeconds = threadCpuSeconds()-begin;
+	return NULL;
+}
+
+static void runBenchmark(SocketReceiveMultiplexer::Backend backend, long count, int sockets, int size) {
+	UdpReceiveSocket *receive[MAX_SOCKETS];
+	UdpTransmitSocket *transmit[MAX_SOCKETS];
+	CountingListener listener[MAX_SOCKETS];
+	SocketReceiveMultiplexer mux;
+
+	for (int i=0; i<sockets; i++) {
+		receive[i] = new UdpReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, BASE_PORT+i));
+		receive[i]->SetReceiveBufferSize(4*1024*1024);
+		transmit[i] = new UdpTransmitSocket(IpEndpointName(127, 0, 0, 1, BASE_PORT+i));
+		mux.AttachSocketListener(receive[i], &listener[i]);
+	}
+	mux.SetBackend(backend);
+
+	Receiver receiver = { &mux, 0 };
+	pthread_t thread;
+	pthread_create(&thread, NULL, receiveThread, &receiver);
+	usleep(100000);
+
+	char *data = new char[size];
+	memset(data, 0x55, size);
+
+	// bursts of one frame per sensor, paced so that the receiver keeps up
+	double begin = nowSeconds();
+	for (long sent=0; sent<count; sent+=BURST) {
+		for (int b=0; b<BURST; b++)
+			for (int i=0; i<sockets; i++) transmit[i]->Send(data, size);
+		usleep(200);
+	}
+	double elapsed = nowSeconds()-begin;
+	usleep(200000);
+
+	mux.AsynchronousBreak();
+	pthread_join(thread, NULL);
+
+	long received = 0;
+	unsigned long long drops = 0;
+	for (int i=0; i<sockets; i++) {
+		received += listener[i].datagrams;
+		drops += receive[i]->Statistics().kernelDrops;
+	}
+
+	long sent = ((count+BURST-1)/BURST)*BURST*sockets;
+	printf("%-8s sockets %2d  size %5d  %8ld/%ld datagrams  %6llu drops  %7.0f ns cpu/datagram  %6.0f kdgram/s offered\n",
+		(mux.ActiveBackend()==SocketReceiveMultiplexer::IO_URING_BACKEND)?"io_uring":"select",
+		sockets, size, received, sent, drops, (received>0)?receiver.cpuSeconds*1e9/received:0, sent/elapsed/1000);
+
+	delete [] data;
+	for (int i=0; i<sockets; i++) {
+		delete transmit[i];
+		delete receive[i];
+	}
+}
+
+int main(int argc, char *argv[]) {
+	long count = 100000;
+	int sockets = 4;
+	int size = 512;
+	if (argc>1) count = atol(argv[1]);
+	if (argc>2) sockets = atoi(argv[2]);
+	if (argc>3) size = atoi(argv[3]);
+	if ((count<=0) || (sockets<=0) || (sockets>MAX_SOCKETS) || (size<=0) || (size>65000)) {
+		printf("usage: ReceiveBackend [datagrams per socket] [sockets 1-%d] [datagram size]\n", MAX_SOCKETS);
+		return 1;
+	}
+
+	runBenchmark(SocketReceiveMultiplexer::DEFAULT_BACKEND, count, sockets, size);
+	runBenchmark(SocketReceiveMultiplexer::IO_URING_BACKEND, count, sockets, size);
+	runBenchmark(SocketReceiveMultiplexer::DEFAULT_BACKEND, count, 1, size);
+	runBenchmark(SocketReceiveMultiplexer::IO_URING_BACKEND, count, 1, size);
+	return 0;
+}
@@ -0,0 +1,182 @@
+/*
+	Cost of fanning TUIO packets out to several destinations.
+
+	A ten cursor bundle is forwarded to 1, 2, 4 and 8 local destinations,
+	once with a plain UdpTransmitSocket::Send() per destination on the
+	forwarding thread, as a listener would do it, and once through a
+	TuioRelay. The packets are built in pooled receive buffers like the
+	ones a SocketReceiveMultiplexer hands to a TuioClient, so the relay
+	queues them without a copy. Reports the time the forwarding thread
+	spends per packet, the packets delivered per second, and the packets the
+	relay dropped because a destination queue was full. The packets are
+	forwarded at the given rate, 0 forwards them as fast as possible; on a
+	single CPU that starves the sender thread of the relay.
+
+	usage: RelayFanout [packets per run] [packets per second]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TuioRelay.h"
+#include "ip/ReceiveBufferPool.h"
+#include "TuioAtomic.h"
+#include "osc/OscOutboundPacketStream.h"
+
+using namespace TUIO;
+
+static const int PORT = 7600;
+static const int CURSORS = 10;
+static const int MAX_DESTINATIONS = 8;
+
+static long long now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+
+struct Receivers {
+	int fd[MAX_DESTINATIONS];
+	int count;
+	volatile long long received[MAX_DESTINATIONS];
+	volatile long running;
+};
+
+static void* receiverThread(void *arg) {
+	Receivers *receivers = (Receivers*)arg;
+	struct pollfd fds[MAX_DESTINATIONS];
+	for (int i=0; i<receivers->count; i++) {
+		fds[i].fd = receivers->fd[i];
+		fds[i].events = POLLIN;
+	}
+
+	char buffer[2048];
+	while (atomicLoad(&receivers->running)) {
+		if (poll(fds, receivers->count, 50)<=0) continue;
+		for (int i=0; i<receivers->count; i++) {
+			if (!(fds[i].revents & POLLIN)) continue;
+			while (recv(fds[i].fd, buffer, sizeof(buffer), MSG_DONTWAIT)>0) receivers->received[i]++;
+		}
+	}
+	return NULL;
+}
+
+static int openReceiver(int port) {
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	int size = 4*1024*1024;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(fd, (struct sockaddr*)&address, sizeof(address))<0) {
+		perror("bind");
+		exit(1);
+	}
+	return fd;
+}
+
+static int buildPacket(char *buffer, int size, int fseq) {
+	osc::OutboundPacketStream packet(buffer, size);
+	packet << osc::BeginBundleImmediate;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "alive";
+	for (int c=0; c<CURSORS; c++) packet << (osc::int32)c;
+	packet << osc::EndMessage;
+	for (int c=0; c<CURSORS; c++) {
+		float x = ((fseq+c*7)%100)/100.0f;
+		packet << osc::BeginMessage("/tuio/2Dcur") << "set" << (osc::int32)c << x << 1.0f-x << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+	}
+	packet << osc::BeginMessage("/tuio/2Dcur") << "fseq" << (osc::int32)fseq << osc::EndMessage;
+	packet << osc::EndBundle;
+	return (int)packet.Size();
+}
+
+static void runBenchmark(bool useRelay, int destinations, int packets, int rate) {
+	Receivers receivers;
+	receivers.count = destinations;
+	receivers.running = 1;
+	for (int i=0; i<destinations; i++) {
+		receivers.fd[i] = openReceiver(PORT+i);
+		receivers.received[i] = 0;
+	}
+	pthread_t thread;
+	pthread_create(&thread, NULL, receiverThread, &receivers);
+
+	TuioRelay *relay = NULL;
+	UdpTransmitSocket *sockets[MAX_DESTINATIONS];
+	if (useRelay) {
+		relay = new TuioRelay();
+		for (int i=0; i<destinations; i++) relay->addDestination("127.0.0.1", PORT+i);
+	} else {
+		for (int i=0; i<destinations; i++) sockets[i] = new UdpTransmitSocket(IpEndpointName(127, 0, 0, 1, PORT+i));
+	}
+
+	ReceiveBufferPool pool;
+	long long busy = 0;
+	long long start = now();
+	for (int p=0; p<packets; p++) {
+		char *buffer = pool.Acquire();
+		int size = buildPacket(buffer, RECEIVE_BUFFER_SIZE, p);
+		if (rate>0) {
+			long long due = start+(long long)p*1000000000LL/rate;
+			while (now()<due) {}
+		}
+
+		long long before = now();
+		if (useRelay) relay->forward(buffer, size, true);
+		else for (int i=0; i<destinations; i++) sockets[i]->Send(buffer, size);
+		busy += now()-before;
+		ReleaseReceiveBuffer(buffer);
+	}
+
+	// let the relay and the receivers catch up
+	long long received = 0;
+	for (int wait=0; wait<100; wait++) {
+		usleep(20000);
+		long long total = 0;
+		for (int i=0; i<destinations; i++) total += receivers.received[i];
+		if (total==received && wait>0) break;
+		received = total;
+	}
+	long long elapsed = now()-start;
+
+	long long dropped = 0;
+	if (useRelay) {
+		for (int i=0; i<destinations; i++) dropped += relay->getDroppedPackets(i);
+		delete relay;
+	} else {
+		for (int i=0; i<destinations; i++) delete sockets[i];
+	}
+	atomicStore(&receivers.running, 0);
+	pthread_join(thread, NULL);
+	for (int i=0; i<destinations; i++) close(receivers.fd[i]);
+
+	long long expected = (long long)packets*destinations;
+	printf("%-6s destinations %d  %7.0f ns/packet forwarding  %9.0f packets/s delivered  received %5.1f%%  dropped %lld\n",
+		useRelay ? "relay" : "send", destinations, (double)busy/packets, received*1e9/elapsed, 100.0*received/expected, dropped);
+}
+
+int main(int argc, char *argv[]) {
+	int packets = 100000;
+	int rate = 10000;
+	if (argc>1) packets = atoi(argv[1]);
+	if (argc>2) rate = atoi(argv[2]);
+	if ((packets<=0) || (rate<0)) {
+		printf("usage: RelayFanout [packets per run] [packets per second]\n");
+		return 1;
+	}
+
+	for (int destinations=1; destinations<=MAX_DESTINATIONS; destinations*=2) {
+		runBenchmark(false, destinations, packets, rate);
+		runBenchmark(true, destinations, packets, rate);
+	}
+	return 0;
+}
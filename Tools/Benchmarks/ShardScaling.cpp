@@ -0,0 +1,138 @@
+/*
+	Receive throughput of TuioShardedClient over the number of shards.
+
+	Many TUIO sources, each with its own UDP source port, send ten cursor
+	frames as fast as they can to one port that is received by 1, 2, 4 and
+	8 shards. Reports the datagrams decoded and frames committed per second
+	and the kernel drops. SO_REUSEPORT keeps every source on one shard, so
+	the shards scale with the number of free CPUs; with fewer CPUs than
+	shards plus senders the numbers show the overhead of the extra threads.
+
+	usage: ShardScaling [seconds per run] [sources]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TuioShardedClient.h"
+#include "osc/OscOutboundPacketStream.h"
+
+using namespace TUIO;
+
+static const int PORT = 7500;
+static const int CURSORS = 10;
+static const int MAX_SOURCES = 64;
+static const int SENDERS = 2;
+
+class FrameCounter : public TuioListener {
+public:
+	volatile long frames;
+	FrameCounter():frames(0) {}
+	void addTuioObject(TuioObject*) {}
+	void updateTuioObject(TuioObject*) {}
+	void removeTuioObject(TuioObject*) {}
+	void addTuioCursor(TuioCursor*) {}
+	void updateTuioCursor(TuioCursor*) {}
+	void removeTuioCursor(TuioCursor*) {}
+	void refresh(TuioTime) { atomicAdd(&frames, 1); }
+};
+
+struct SenderTask {
+	int firstSource;
+	int sources;
+	volatile long *running;
+	long sent;
+};
+
+static void* senderThread(void *arg) {
+	SenderTask *task = (SenderTask*)arg;
+	UdpTransmitSocket *sockets[MAX_SOURCES];
+	for (int i=0; i<task->sources; i++)
+		sockets[i] = new UdpTransmitSocket(IpEndpointName(127, 0, 0, 1, PORT));
+
+	char buffer[2048];
+	int fseq = 1;
+	task->sent = 0;
+	while (atomicLoad(task->running)) {
+		for (int i=0; i<task->sources; i++) {
+			// session IDs are unique per source, as they have to be in a relay
+			long base = (task->firstSource+i)*1000;
+			osc::OutboundPacketStream packet(buffer, sizeof(buffer));
+			packet << osc::BeginBundleImmediate;
+			packet << osc::BeginMessage("/tuio/2Dcur") << "alive";
+			for (int c=0; c<CURSORS; c++) packet << (osc::int32)(base+c);
+			packet << osc::EndMessage;
+			for (int c=0; c<CURSORS; c++) {
+				float x = ((fseq+c*7)%100)/100.0f;
+				packet << osc::BeginMessage("/tuio/2Dcur") << "set" << (osc::int32)(base+c) << x << 1.0f-x << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+			}
+			packet << osc::BeginMessage("/tuio/2Dcur") << "fseq" << (osc::int32)fseq << osc::EndMessage;
+			packet << osc::EndBundle;
+			sockets[i]->Send(packet.Data(), packet.Size());
+			task->sent++;
+		}
+		fseq++;
+	}
+
+	for (int i=0; i<task->sources; i++) delete sockets[i];
+	return NULL;
+}
+
+static void runBenchmark(int shardCount, int sources, double seconds) {
+	TuioShardedClient client(PORT, shardCount);
+	FrameCounter counter;
+	client.addTuioListener(&counter);
+	client.setReceiveBufferSize(4*1024*1024);
+	client.connect();
+
+	volatile long running = 1;
+	pthread_t thread[SENDERS];
+	SenderTask task[SENDERS];
+	for (int s=0; s<SENDERS; s++) {
+		task[s].firstSource = s*sources/SENDERS;
+		task[s].sources = (s+1)*sources/SENDERS-task[s].firstSource;
+		task[s].running = &running;
+		pthread_create(&thread[s], NULL, senderThread, &task[s]);
+	}
+
+	usleep((useconds_t)(seconds*1000000));
+	atomicStore(&running, 0);
+	long sent = 0;
+	for (int s=0; s<SENDERS; s++) {
+		pthread_join(thread[s], NULL);
+		sent += task[s].sent;
+	}
+	usleep(200000);
+	client.disconnect();
+
+	unsigned long long datagrams = 0, drops = 0;
+	int busiest = 0, idlest = -1;
+	for (int i=0; i<client.getShardCount(); i++) {
+		UdpSocketStatistics statistics = client.getShard(i)->socket->Statistics();
+		datagrams += statistics.datagrams;
+		drops += statistics.kernelDrops;
+		if ((int)statistics.datagrams>busiest) busiest = (int)statistics.datagrams;
+		if ((idlest<0) || ((int)statistics.datagrams<idlest)) idlest = (int)statistics.datagrams;
+	}
+
+	printf("shards %d  sources %2d  %9.0f datagrams/s  %9.0f frames/s  sent %9.0f/s  drops %8llu  shard min/max %d/%d\n",
+		client.getShardCount(), sources, datagrams/seconds, counter.frames/seconds, sent/seconds, drops, idlest, busiest);
+}
+
+int main(int argc, char *argv[]) {
+	double seconds = 2;
+	int sources = 32;
+	if (argc>1) seconds = atof(argv[1]);
+	if (argc>2) sources = atoi(argv[2]);
+	if ((seconds<=0) || (sources<SENDERS) || (sources>MAX_SOURCES*SENDERS)) {
+		printf("usage: ShardScaling [seconds per run] [sources %d-%d]\n", SENDERS, MAX_SOURCES*SENDERS);
+		return 1;
+	}
+
+	printf("%d CPUs\n", TuioShardedClient::getCpuCount());
+	for (int shards=1; shards<=8; shards*=2) runBenchmark(shards, sources, seconds);
+	return 0;
+}
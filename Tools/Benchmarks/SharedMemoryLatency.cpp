@@ -0,0 +1,129 @@
+/*
+	Latency and receive cost of TUIO over a shared memory ring and over UDP.
+
+	A TuioServer sends frames of cursors to a TuioClient in the same
+	process, once over the loopback device and once through a
+	TuioSharedMemory ring. The time from before commitFrame() until the
+	client calls refresh() is recorded per frame, together with the CPU
+	time of the receiving thread per frame. Frames are paced, so the
+	receiver sleeps between them and every frame includes its wakeup.
+
+	usage: SharedMemoryLatency [frames] [cursors] [frames per second]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+#include "TuioClient.h"
+#include "TuioServer.h"
+
+using namespace TUIO;
+
+static const int PORT = 7700;
+static const char *RING = "tuio-latency-benchmark";
+static const int MAX_CURSORS = 64;
+
+class LatencyListener : public TuioListener {
+public:
+	TuioClient *client;
+	std::vector<long long> sendTimes;
+	std::vector<long long> latencies;
+	double cpuSeconds;
+
+	LatencyListener(long frames):client(NULL),sendTimes(frames+16, 0),cpuSeconds(0) {}
+	void addTuioObject(TuioObject*) {}
+	void updateTuioObject(TuioObject*) {}
+	void removeTuioObject(TuioObject*) {}
+	void addTuioCursor(TuioCursor*) {}
+	void updateTuioCursor(TuioCursor*) {}
+	void removeTuioCursor(TuioCursor*) {}
+	void refresh(TuioTime) {
+		long long now = GetCurrentTimeNanoseconds();
+		long frame = client->getFrameInfo().frameID;
+		// the server repeats the last frame now and then, only count its first arrival
+		if ((frame>=0) && (frame<(long)sendTimes.size()) && (sendTimes[frame]>0)) {
+			latencies.push_back(now-sendTimes[frame]);
+			sendTimes[frame] = 0;
+		}
+
+		struct timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		cpuSeconds = ts.tv_sec + ts.tv_nsec*1e-9;
+	}
+};
+
+static void runBenchmark(bool sharedMemory, long frames, int cursorCount, int fps) {
+	TuioClient client(PORT);
+	LatencyListener listener(frames);
+	listener.client = &client;
+	client.addTuioListener(&listener);
+
+	TuioSharedMemory *ring = NULL;
+	TuioServer *server;
+	if (sharedMemory) {
+		client.enableSharedMemory(RING);
+		ring = new TuioSharedMemory(RING);
+		server = new TuioServer(ring);
+	} else server = new TuioServer("127.0.0.1", PORT);
+	client.connect();
+	usleep(100000);
+
+	TuioCursor *cursor[MAX_CURSORS];
+	double startCpu = 0;
+	for (long frame=0; frame<frames; frame++) {
+		server->initFrame(TuioTime::getSessionTime());
+		for (int c=0; c<cursorCount; c++) {
+			float x = ((frame+c*7)%100)/100.0f;
+			if (frame==0) cursor[c] = server->addTuioCursor(x, 0.5f);
+			else server->updateTuioCursor(cursor[c], x, 0.5f);
+		}
+		long id = server->getFrameID();
+		if (id<(long)listener.sendTimes.size()) listener.sendTimes[id] = GetCurrentTimeNanoseconds();
+		server->commitFrame();
+		if (frame==0) {
+			usleep(10000);
+			startCpu = listener.cpuSeconds;
+		}
+		usleep(1000000/fps);
+	}
+	server->initFrame(TuioTime::getSessionTime());
+	for (int c=0; c<cursorCount; c++) server->removeTuioCursor(cursor[c]);
+	server->commitFrame();
+	usleep(100000);
+	client.disconnect();
+
+	std::vector<long long> &l = listener.latencies;
+	std::sort(l.begin(), l.end());
+	long received = (long)l.size();
+	if (received>0)
+		printf("%-13s cursors %2d  %6ld/%ld frames  latency p50 %6.1f us  p99 %6.1f us  max %7.1f us  %5.1f us cpu/frame\n",
+			sharedMemory?"shared memory":"udp loopback", cursorCount, received, frames,
+			l[received/2]/1000.0, l[received*99/100]/1000.0, l[received-1]/1000.0,
+			(listener.cpuSeconds-startCpu)*1e6/received);
+	else printf("%-13s no frames received\n", sharedMemory?"shared memory":"udp loopback");
+
+	delete server;
+	delete ring;
+}
+
+int main(int argc, char *argv[]) {
+	long frames = 2000;
+	int cursors = 10;
+	int fps = 500;
+	if (argc>1) frames = atol(argv[1]);
+	if (argc>2) cursors = atoi(argv[2]);
+	if (argc>3) fps = atoi(argv[3]);
+	if ((frames<=0) || (cursors<1) || (cursors>MAX_CURSORS) || (fps<=0)) {
+		printf("usage: SharedMemoryLatency [frames] [cursors 1-%d] [frames per second]\n", MAX_CURSORS);
+		return 1;
+	}
+
+	TuioTime::initSession();
+	runBenchmark(false, frames, cursors, fps);
+	runBenchmark(true, frames, cursors, fps);
+	return 0;
+}
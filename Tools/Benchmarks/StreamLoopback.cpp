@@ -0,0 +1,386 @@
+/*
+	TUIO over TCP loopback test and benchmark.
+
+	Connects to a TcpListeningSocket with automatic framing and sends
+	packets framed with SLIP, with a length prefix and as masked WebSocket
+	messages, written in chunks of random size so that packets and frame
+	headers are split across reads. WebSocket messages are fragmented at
+	random with pings in between. The listener checks the order, size and
+	content of every packet, the sender checks the pongs and the closing
+	handshake. Large packets fill the receive buffer of a connection.
+
+	Then many connections send small packets at once and the CPU time the
+	receiving thread spends per packet is measured for every framing, and
+	finally a TuioClient receives a TUIO frame over a WebSocket.
+
+	usage: StreamLoopback [packets per connection] [connections]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <map>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "ip/TcpListeningSocket.h"
+#include "ip/PacketListener.h"
+#include "osc/OscOutboundPacketStream.h"
+#include "TuioClient.h"
+#include "TuioAtomic.h"
+
+using namespace TUIO;
+
+static const int MAX_CONNECTIONS = 256;
+static const int TUIO_UDP_PORT = 7600;
+static const int TUIO_TCP_PORT = 7601;
+
+enum Framing { SLIP, LENGTH_PREFIX, WEBSOCKET };
+static const char *framingName[] = { "slip", "length", "websocket" };
+
+static double threadCpuSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static double nowSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// test packets start with their sequence number and size, the content
+// covers all byte values so that SLIP has to escape
+static unsigned char patternByte(long seq, int i) {
+	return (unsigned char)((seq*7 + i*13) ^ (i>>3));
+}
+
+static void putInt(std::string &out, unsigned long value) {
+	out += (char)(value>>24);
+	out += (char)(value>>16);
+	out += (char)(value>>8);
+	out += (char)value;
+}
+
+static unsigned long getInt(const char *data) {
+	const unsigned char *p = (const unsigned char*)data;
+	return ((unsigned long)p[0]<<24) | ((unsigned long)p[1]<<16) | ((unsigned long)p[2]<<8) | p[3];
+}
+
+static std::string makePacket(long seq, int size) {
+	std::string packet;
+	putInt(packet, seq);
+	putInt(packet, size);
+	for (int i=8; i<size; i++) packet += (char)patternByte(seq, i);
+	return packet;
+}
+
+class CheckingListener : public PacketListener {
+public:
+	volatile long packets;
+	long errors;
+	std::map<int, long> nextSeq; // by the port of the connection
+
+	CheckingListener():packets(0),errors(0) {}
+
+	void ProcessPacket(const char *data, int size, const IpEndpointName &remoteEndpoint) {
+		bool valid = (size>=8) && ((int)getInt(data+4)==size);
+		long seq = valid ? (long)getInt(data) : -1;
+		if (valid && (seq!=nextSeq[remoteEndpoint.port])) valid = false;
+		for (int i=8; valid && (i<size); i++)
+			if ((unsigned char)data[i]!=patternByte(seq, i)) valid = false;
+		if (!valid) {
+			if (errors<10) printf("  invalid packet of %d bytes from port %d, expected #%ld\n", size, remoteEndpoint.port, nextSeq[remoteEndpoint.port]);
+			errors++;
+		}
+		nextSeq[remoteEndpoint.port] = seq+1;
+		atomicAdd(&packets, 1);
+	}
+};
+
+static void slipEncode(std::string &out, const std::string &packet) {
+	for (size_t i=0; i<packet.size(); i++) {
+		unsigned char c = (unsigned char)packet[i];
+		if (c==0xC0) out += "\xDB\xDC";
+		else if (c==0xDB) out += "\xDB\xDD";
+		else out += (char)c;
+	}
+	out += (char)0xC0;
+}
+
+static void webSocketFrame(std::string &out, int opcode, bool final, const char *payload, size_t size) {
+	out += (char)((final?0x80:0) | opcode);
+	if (size<126) out += (char)(0x80 | size);
+	else if (size<65536) {
+		out += (char)(0x80 | 126);
+		out += (char)(size>>8);
+		out += (char)size;
+	} else {
+		out += (char)(0x80 | 127);
+		putInt(out, 0);
+		putInt(out, (unsigned long)size);
+	}
+	unsigned char mask[4];
+	for (int i=0; i<4; i++) mask[i] = (unsigned char)rand();
+	out.append((const char*)mask, 4);
+	for (size_t i=0; i<size; i++) out += (char)(payload[i] ^ mask[i&3]);
+}
+
+// returns the number of pings sent between the fragments
+static int encode(std::string &out, Framing framing, const std::string &packet, bool fragment) {
+	switch (framing) {
+		case SLIP:
+			slipEncode(out, packet);
+			return 0;
+		case LENGTH_PREFIX:
+			putInt(out, (unsigned long)packet.size());
+			out += packet;
+			return 0;
+		default:
+			break;
+	}
+
+	if (!fragment) {
+		webSocketFrame(out, 0x2, true, packet.data(), packet.size());
+		return 0;
+	}
+	size_t first = rand()%packet.size();
+	size_t second = first + rand()%(packet.size()-first);
+	webSocketFrame(out, 0x2, false, packet.data(), first);
+	webSocketFrame(out, 0x9, true, "ping", 4);
+	webSocketFrame(out, 0x0, false, packet.data()+first, second-first);
+	webSocketFrame(out, 0x0, true, packet.data()+second, packet.size()-second);
+	return 1;
+}
+
+static int connectTo(int port) {
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	if (connect(s, (struct sockaddr*)&address, sizeof(address))<0) {
+		perror("connect");
+		exit(1);
+	}
+	return s;
+}
+
+static bool sendAll(int s, const char *data, size_t size) {
+	while (size>0) {
+		ssize_t sent = send(s, data, size, MSG_NOSIGNAL);
+		if (sent<=0) return false;
+		data += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+static std::string receiveUntil(int s, const char *end) {
+	std::string received;
+	char c;
+	while ((received.find(end)==std::string::npos) && (recv(s, &c, 1, 0)==1)) received += c;
+	return received;
+}
+
+static bool webSocketHandshake(int s) {
+	// the key and accept value of the example in RFC 6455
+	const char *request = "GET /tuio HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+		"sec-websocket-key:  dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+	sendAll(s, request, strlen(request));
+	std::string response = receiveUntil(s, "\r\n\r\n");
+	return (response.compare(0, 12, "HTTP/1.1 101")==0) && (response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n")!=std::string::npos);
+}
+
+struct Receiver {
+	SocketReceiveMultiplexer *mux;
+	double cpuSeconds;
+};
+
+static void* receiveThread(void *arg) {
+	Receiver *receiver = (Receiver*)arg;
+	double begin = threadCpuSeconds();
+	receiver->mux->Run();
+	receiver->cpuSeconds = threadCpuSeconds()-begin;
+	return NULL;
+}
+
+static bool waitForPackets(CheckingListener &listener, long count) {
+	double deadline = nowSeconds()+10;
+	while ((atomicLoad(&listener.packets)<count) && (nowSeconds()<deadline)) usleep(1000);
+	return atomicLoad(&listener.packets)==count;
+}
+
+static bool testFraming(Framing framing, int port, CheckingListener &listener, long count) {
+	int s = connectTo(port);
+	if ((framing==WEBSOCKET) && !webSocketHandshake(s)) {
+		printf("%-10s websocket handshake failed\n", framingName[framing]);
+		close(s);
+		return false;
+	}
+
+	std::string stream;
+	// the END in front lets automatic framing tell SLIP from a length prefix
+	if (framing==SLIP) stream += (char)0xC0;
+	int pings = 0;
+	for (long seq=0; seq<count; seq++) {
+		int size = 8 + rand()%1500;
+		if (seq%100==99) size = 20000 + rand()%(65536-20000+1);
+		pings += encode(stream, framing, makePacket(seq, size), (rand()%4)==0);
+	}
+
+	long before = atomicLoad(&listener.packets);
+	long errors = listener.errors;
+	for (size_t sent=0; sent<stream.size(); ) {
+		size_t chunk = 1 + rand()%((rand()%8==0) ? 8 : 5000);
+		if (chunk>stream.size()-sent) chunk = stream.size()-sent;
+		if (!sendAll(s, stream.data()+sent, chunk)) break;
+		sent += chunk;
+	}
+	bool received = waitForPackets(listener, before+count);
+
+	bool closed = true;
+	int pongs = 0;
+	if (framing==WEBSOCKET) {
+		std::string frames;
+		webSocketFrame(frames, 0x8, true, "\x03\xE8", 2);
+		sendAll(s, frames.data(), frames.size());
+		// pongs and the close reply, then the server closes the connection
+		std::string reply;
+		char buffer[4096];
+		ssize_t n;
+		while ((n=recv(s, buffer, sizeof(buffer), 0))>0) reply.append(buffer, n);
+		closed = false;
+		for (size_t i=0; i+1<reply.size(); i+=2+(unsigned char)reply[i+1]) {
+			if ((unsigned char)reply[i]==0x8A) pongs++;
+			if (((unsigned char)reply[i]==0x88) && (reply.compare(i+2, 2, "\x03\xE8")==0)) closed = true;
+		}
+	}
+	close(s);
+
+	bool passed = received && (listener.errors==errors) && (pongs==pings) && closed;
+	printf("%-10s %6ld packets %9lu stream bytes  %s%s%s\n", framingName[framing], atomicLoad(&listener.packets)-before,
+		(unsigned long)stream.size(), passed?"ok":"FAILED", (framing==WEBSOCKET)?"  pongs ":"",
+		(framing==WEBSOCKET)?(pongs==pings?"ok":"missing"):"");
+	return passed;
+}
+
+static void benchmarkFraming(Framing framing, int connections, long count) {
+	TcpListeningSocket listening(IpEndpointName(127, 0, 0, 1, IpEndpointName::ANY_PORT), StreamDecoder::AUTO_FRAMING, MAX_CONNECTIONS);
+	CheckingListener listener;
+	SocketReceiveMultiplexer mux;
+	mux.AttachStreamListener(&listening, &listener);
+
+	Receiver receiver = { &mux, 0 };
+	pthread_t thread;
+	pthread_create(&thread, NULL, receiveThread, &receiver);
+
+	int sockets[MAX_CONNECTIONS];
+	for (int c=0; c<connections; c++) {
+		sockets[c] = connectTo(listening.LocalEndpoint().port);
+		if (framing==WEBSOCKET) webSocketHandshake(sockets[c]);
+	}
+
+	// every connection sends frames of 16 packets of the size of a TUIO bundle
+	const int BATCH = 16;
+	std::string stream;
+	double begin = nowSeconds();
+	for (long seq=0; seq<count; seq+=BATCH) {
+		for (int c=0; c<connections; c++) {
+			stream.clear();
+			if ((framing==SLIP) && (seq==0)) stream += (char)0xC0;
+			for (long i=seq; (i<seq+BATCH) && (i<count); i++) encode(stream, framing, makePacket(i, 256), false);
+			sendAll(sockets[c], stream.data(), stream.size());
+		}
+	}
+	bool complete = waitForPackets(listener, count*connections);
+	double elapsed = nowSeconds()-begin;
+
+	mux.AsynchronousBreak();
+	pthread_join(thread, NULL);
+	for (int c=0; c<connections; c++) close(sockets[c]);
+	mux.DetachStreamListener(&listening, &listener);
+
+	long packets = atomicLoad(&listener.packets);
+	printf("%-10s connections %3d  %8ld/%ld packets  %6.0f ns cpu/packet  %7.0f kpackets/s%s\n", framingName[framing],
+		connections, packets, count*connections, (packets>0)?receiver.cpuSeconds*1e9/packets:0, packets/elapsed/1000,
+		(complete && (listener.errors==0))?"":"  FAILED");
+}
+
+static bool testTuioClient() {
+	TuioClient client(TUIO_UDP_PORT);
+	if (!client.enableStream(TUIO_TCP_PORT)) return false;
+	client.connect();
+
+	int s = connectTo(TUIO_TCP_PORT);
+	bool passed = webSocketHandshake(s);
+
+	char buffer[1024];
+	osc::OutboundPacketStream packet(buffer, sizeof(buffer));
+	packet << osc::BeginBundleImmediate;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "alive" << (osc::int32)1 << (osc::int32)2 << osc::EndMessage;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "set" << (osc::int32)1 << 0.25f << 0.5f << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "set" << (osc::int32)2 << 0.75f << 0.5f << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+	packet << osc::BeginMessage("/tuio/2Dcur") << "fseq" << (osc::int32)1 << osc::EndMessage;
+	packet << osc::EndBundle;
+	std::string stream;
+	encode(stream, WEBSOCKET, std::string(packet.Data(), packet.Size()), true);
+	sendAll(s, stream.data(), stream.size());
+
+	double deadline = nowSeconds()+5;
+	while ((client.getFrameInfo().frameID!=1) && (nowSeconds()<deadline)) usleep(1000);
+	passed = passed && (client.getFrameInfo().cursorCount==2);
+
+	close(s);
+	client.disconnect();
+	printf("TuioClient received %d cursors over a websocket  %s\n", client.getFrameInfo().cursorCount, passed?"ok":"FAILED");
+	return passed;
+}
+
+int main(int argc, char *argv[]) {
+	long count = 20000;
+	int connections = 32;
+	if (argc>1) count = atol(argv[1]);
+	if (argc>2) connections = atoi(argv[2]);
+	if ((count<=0) || (connections<=0) || (connections>MAX_CONNECTIONS)) {
+		printf("usage: StreamLoopback [packets per connection] [connections 1-%d]\n", MAX_CONNECTIONS);
+		return 1;
+	}
+	srand(1);
+
+	bool passed = true;
+	{
+		TcpListeningSocket listening(IpEndpointName(127, 0, 0, 1, IpEndpointName::ANY_PORT));
+		CheckingListener listener;
+		SocketReceiveMultiplexer mux;
+		mux.AttachStreamListener(&listening, &listener);
+		Receiver receiver = { &mux, 0 };
+		pthread_t thread;
+		pthread_create(&thread, NULL, receiveThread, &receiver);
+
+		int port = listening.LocalEndpoint().port;
+		passed = testFraming(SLIP, port, listener, 2000) && passed;
+		passed = testFraming(LENGTH_PREFIX, port, listener, 2000) && passed;
+		passed = testFraming(WEBSOCKET, port, listener, 2000) && passed;
+
+		mux.AsynchronousBreak();
+		pthread_join(thread, NULL);
+		mux.DetachStreamListener(&listening, &listener);
+	}
+
+	benchmarkFraming(SLIP, connections, count);
+	benchmarkFraming(LENGTH_PREFIX, connections, count);
+	benchmarkFraming(WEBSOCKET, connections, count);
+	benchmarkFraming(LENGTH_PREFIX, 1, count);
+
+	passed = testTuioClient() && passed;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/*
+	Jitter of the receiving thread with and without a thread role.
+
+	A TuioServer sends frames of cursors at a fixed rate over the loopback
+	device to a TuioClient in the same process, once on an idle machine and
+	twice while one busy thread per CPU competes for the processors: with
+	the default scheduling of the receiving thread and with the provided
+	TuioThreadRole, after the memory was locked. Reports the percentiles of
+	the latency histogram of the client, from the kernel timestamp of the
+	datagram to the dispatch of the frame, which includes the wakeup of the
+	receiving thread. SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit, and
+	mlockall a large enough memlock limit; the role falls back with a warning.
+
+	usage: ThreadJitter [frames] [role]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "TuioClient.h"
+#include "TuioServer.h"
+
+using namespace TUIO;
+
+static const int PORT = 7800;
+static const int CURSORS = 10;
+static const int FPS = 500;
+static const int MAX_LOAD_THREADS = 256;
+
+static volatile long loaded = 0;
+
+static void* loadThread(void*) {
+	volatile double sink = 1.0;
+	while (atomicLoad(&loaded)) {
+		for (int i=0; i<100000; i++) sink = sink*1.0000001+0.0000001;
+	}
+	return 0;
+}
+
+static void runBenchmark(const char *name, long frames, int loadThreads, const TuioThreadRole &role) {
+	pthread_t load[MAX_LOAD_THREADS];
+	atomicStore(&loaded, 1);
+	for (int i=0; i<loadThreads; i++) pthread_create(&load[i], NULL, loadThread, NULL);
+
+	TuioClient client(PORT);
+	client.setThreadRole(role);
+	client.connect();
+	TuioServer server("127.0.0.1", PORT);
+	usleep(100000);
+
+	TuioCursor *cursor[CURSORS];
+	for (long frame=0; frame<frames; frame++) {
+		server.initFrame(TuioTime::getSessionTime());
+		for (int c=0; c<CURSORS; c++) {
+			float x = ((frame+c*7)%100)/100.0f;
+			if (frame==0) cursor[c] = server.addTuioCursor(x, 0.5f);
+			else server.updateTuioCursor(cursor[c], x, 0.5f);
+		}
+		server.commitFrame();
+		usleep(1000000/FPS);
+	}
+	server.initFrame(TuioTime::getSessionTime());
+	for (int c=0; c<CURSORS; c++) server.removeTuioCursor(cursor[c]);
+	server.commitFrame();
+	usleep(100000);
+	client.disconnect();
+
+	atomicStore(&loaded, 0);
+	for (int i=0; i<loadThreads; i++) pthread_join(load[i], NULL);
+
+	const TuioHistogram &h = client.getLatency().getTotalHistogram();
+	printf("%-22s %6lld/%ld frames  latency p50 %7.1f us  p99 %7.1f us  p99.9 %7.1f us  max %8.1f us\n",
+		name, h.getCount(), frames, h.getPercentile(50)/1000.0, h.getPercentile(99)/1000.0,
+		h.getPercentile(99.9)/1000.0, h.getMax()/1000.0);
+}
+
+int main(int argc, char *argv[]) {
+	long frames = 5000;
+	const char *description = "realtime 50";
+	if (argc>1) frames = atol(argv[1]);
+	if (argc>2) description = argv[2];
+
+	TuioThreadRole role;
+	if ((frames<=0) || !role.configure(description)) {
+		printf("usage: ThreadJitter [frames] [role, \"realtime 50 cpu 1\" for example]\n");
+		return 1;
+	}
+
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus<1) cpus = 1;
+	if (cpus>MAX_LOAD_THREADS) cpus = MAX_LOAD_THREADS;
+
+	TuioTime::initSession();
+	runBenchmark("idle, normal", frames, 0, TuioThreadRole());
+	runBenchmark("loaded, normal", frames, cpus, TuioThreadRole());
+	TuioThreadRole::lockMemory();
+	runBenchmark("loaded, role", frames, cpus, role);
+	return 0;
+}
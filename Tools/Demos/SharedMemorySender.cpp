@@ -0,0 +1,67 @@
+/*
+	Demo tracker that sends TUIO through a shared memory ring.
+
+	A TuioServer writes to the ring instead of a UDP socket and moves a few
+	cursors in circles. Run it on the machine of a service that reads the
+	same ring (the name in sharedmemoryN.txt), or of any TuioClient with
+	enableSharedMemory(). Start order doesn't matter, whichever side comes
+	first creates the ring.
+
+	usage: SharedMemorySender [ring name] [frames per second] [cursors] [seconds]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "TuioServer.h"
+
+using namespace TUIO;
+
+static const int MAX_CURSORS = 32;
+
+int main(int argc, char *argv[]) {
+	const char *name = "tuio";
+	int fps = 60;
+	int cursorCount = 3;
+	double seconds = 10;
+	if (argc>1) name = argv[1];
+	if (argc>2) fps = atoi(argv[2]);
+	if (argc>3) cursorCount = atoi(argv[3]);
+	if (argc>4) seconds = atof(argv[4]);
+	if ((fps<=0) || (cursorCount<1) || (cursorCount>MAX_CURSORS) || (seconds<=0)) {
+		printf("usage: SharedMemorySender [ring name] [frames per second] [cursors 1-%d] [seconds]\n", MAX_CURSORS);
+		return 1;
+	}
+
+	TuioSharedMemory ring(name);
+	if (!ring.isOpen()) {
+		printf("could not map the ring %s\n", name);
+		return 1;
+	}
+	TuioServer server(&ring);
+	TuioTime::initSession();
+
+	TuioCursor *cursor[MAX_CURSORS];
+	long frames = (long)(seconds*fps);
+	for (long frame=0; frame<frames; frame++) {
+		server.initFrame(TuioTime::getSessionTime());
+		for (int c=0; c<cursorCount; c++) {
+			double angle = 2*M_PI*(frame/(double)fps/4 + c/(double)cursorCount);
+			float x = (float)(0.5+0.3*cos(angle));
+			float y = (float)(0.5+0.3*sin(angle));
+			if (frame==0) cursor[c] = server.addTuioCursor(x, y);
+			else server.updateTuioCursor(cursor[c], x, y);
+		}
+		server.commitFrame();
+		usleep(1000000/fps);
+	}
+
+	server.initFrame(TuioTime::getSessionTime());
+	for (int c=0; c<cursorCount; c++) server.removeTuioCursor(cursor[c]);
+	server.commitFrame();
+
+	printf("sent %lld packets to %s, %lld dropped\n", ring.getSentPackets(), name, ring.getDroppedPackets());
+	return 0;
+}
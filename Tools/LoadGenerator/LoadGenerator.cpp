@@ -0,0 +1,442 @@
+/*
+	Synthetic TUIO load for stress and scaling tests of the services.
+
+	Simulates M sensors with N cursors each. Every sensor is a TuioServer
+	that sends to its own port, port+0 to port+M-1, so one service or
+	TuioClient per port (or one sharded client) receives the load. The
+	cursors rest, move on straight lines bouncing off the edges, move on
+	circles or walk randomly. With churn, cursors are lifted and put down
+	elsewhere at the given rate per sensor.
+
+	Each server sends to a local socket of the generator, which counts the
+	datagrams and forwards them to the destination. Packet loss, reordering
+	and duplicates are injected there: datagrams are dropped, held back by
+	one to three packets or repeated. All random decisions come from the
+	seed and the frame times follow the frame rate, not the clock, so two
+	runs with the same options send the same packets.
+
+	The frames are paced at the frame rate with absolute deadlines. A rate
+	of 0 sends as fast as possible, to find the ceiling of the receiver.
+	Reports the achieved frames, packets and bytes per second once per
+	second and in total, the frames that missed their deadline, and the
+	injected impairments.
+
+	usage: LoadGenerator [options]
+		-h host       destination host (127.0.0.1)
+		-p port       port of the first sensor (3333)
+		-s sensors    number of sensors and ports (1)
+		-n cursors    cursors per sensor (10)
+		-r fps        frames per second per sensor, 0 for unpaced (60)
+		-t seconds    duration of the run (10)
+		-m model      still, linear, circle or random (linear)
+		-c churn      cursors lifted and put down per second per sensor (0)
+		-l percent    packet loss (0)
+		-o percent    reordered packets (0)
+		-d percent    duplicated packets (0)
+		-u mtu        fragment the frames for this MTU, 0 for single packets (1500)
+		-k interval   delta update with this keyframe interval, 0 for full frames (0)
+		-x seed       random seed (1)
+		-q            only print the summary
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <vector>
+
+#include "TuioServer.h"
+
+using namespace TUIO;
+
+static const int MAX_SENSORS = 256;
+static const int MAX_HELD = 3;
+
+enum MotionModel { STILL, LINEAR, CIRCLE, RANDOM_WALK };
+
+// xorshift64*, the same sequence on every platform unlike rand()
+class Random {
+public:
+	Random(unsigned long long seed) : state(seed*0x9E3779B97F4A7C15ULL+1) { next(); }
+	unsigned long long next() {
+		state ^= state>>12;
+		state ^= state<<25;
+		state ^= state>>27;
+		return state*2685821657736338717ULL;
+	}
+	// uniform in [0,1)
+	double uniform() { return (next()>>11)*(1.0/9007199254740992.0); }
+	bool chance(double percent) { return (percent>0) && (uniform()*100.0<percent); }
+	int below(int n) { return (int)(uniform()*n); }
+private:
+	unsigned long long state;
+};
+
+static long long now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+
+static void sleepUntil(long long deadline) {
+	struct timespec ts;
+	ts.tv_sec = deadline/1000000000LL;
+	ts.tv_nsec = deadline%1000000000LL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)==EINTR) {}
+}
+
+struct Options {
+	const char *host;
+	int port, sensors, cursors, fps, mtu, keyframeInterval;
+	double seconds, churn, loss, reorder, duplicate;
+	MotionModel model;
+	unsigned long long seed;
+	bool quiet;
+};
+
+struct Contact {
+	TuioCursor *cursor;
+	float x, y, vx, vy;
+	float cx, cy, radius, phase, speed;
+};
+
+struct Counters {
+	long long frames, packets, bytes, late;
+	long long dropped, reordered, duplicated;
+	long long added, removed;
+};
+
+// a simulated sensor: a TuioServer, its contacts, and the impairment stage it sends through
+class Sensor {
+public:
+	Sensor(const Options &options, int index, const struct sockaddr_in &destination);
+	~Sensor();
+	void sendFrame(TuioTime frameTime, Counters &counters);
+	void flush(Counters &counters);
+
+private:
+	void place(Contact &contact);
+	void move(Contact &contact, float dt);
+	void forward(Counters &counters);
+	void transmit(const char *data, int size, Counters &counters);
+
+	const Options &options;
+	Random random;
+	TuioServer *server;
+	std::vector<Contact> contacts;
+	double churnCredit;
+
+	// the server sends to this socket, the generator forwards to the destination
+	int stageSocket;
+	int sendSocket;
+	struct sockaddr_in destination;
+	std::vector<char> held[MAX_HELD];
+	int heldSize[MAX_HELD];
+	int heldDelay[MAX_HELD];
+};
+
+Sensor::Sensor(const Options &options, int index, const struct sockaddr_in &destination)
+: options(options), random(options.seed*1000003ULL+index), server(NULL), churnCredit(0), destination(destination)
+{
+	for (int i=0; i<MAX_HELD; i++) heldSize[i] = heldDelay[i] = 0;
+
+	sendSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	int size = 4*1024*1024;
+	setsockopt(sendSocket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+	// an ephemeral loopback port in front of the destination
+	stageSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	setsockopt(stageSocket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t length = sizeof(address);
+	if ((bind(stageSocket, (struct sockaddr*)&address, sizeof(address))<0) ||
+		(getsockname(stageSocket, (struct sockaddr*)&address, &length)<0)) {
+		perror("stage socket");
+		exit(1);
+	}
+	server = new TuioServer("127.0.0.1", ntohs(address.sin_port), (options.mtu>0) ? options.mtu : MAX_UDP_SIZE);
+	if (options.mtu>0) server->setMTU(options.mtu);
+	if (options.keyframeInterval>0) server->enableDeltaUpdate(options.keyframeInterval);
+
+	contacts.resize(options.cursors);
+	server->initFrame(TuioTime(0,0));
+	for (int i=0; i<options.cursors; i++) {
+		place(contacts[i]);
+		contacts[i].cursor = server->addTuioCursor(contacts[i].x, contacts[i].y);
+	}
+	server->commitFrame();
+}
+
+Sensor::~Sensor() {
+	delete server;
+	close(stageSocket);
+	close(sendSocket);
+}
+
+void Sensor::place(Contact &contact) {
+	contact.x = (float)random.uniform();
+	contact.y = (float)random.uniform();
+	double angle = random.uniform()*2*M_PI;
+	double speed = 0.1+0.4*random.uniform();	// surface widths per second
+	contact.vx = (float)(speed*cos(angle));
+	contact.vy = (float)(speed*sin(angle));
+	contact.radius = (float)(0.05+0.2*random.uniform());
+	contact.cx = contact.radius+(float)random.uniform()*(1-2*contact.radius);
+	contact.cy = contact.radius+(float)random.uniform()*(1-2*contact.radius);
+	contact.phase = (float)angle;
+	contact.speed = (float)(speed/contact.radius);	// radians per second
+	if (options.model==CIRCLE) {
+		contact.x = contact.cx+contact.radius*(float)cos(contact.phase);
+		contact.y = contact.cy+contact.radius*(float)sin(contact.phase);
+	}
+}
+
+static float bounce(float position, float &velocity) {
+	if (position<0) { velocity = -velocity; return -position; }
+	if (position>1) { velocity = -velocity; return 2-position; }
+	return position;
+}
+
+void Sensor::move(Contact &contact, float dt) {
+	switch (options.model) {
+		case STILL:
+			break;
+		case LINEAR:
+			contact.x = bounce(contact.x+contact.vx*dt, contact.vx);
+			contact.y = bounce(contact.y+contact.vy*dt, contact.vy);
+			break;
+		case CIRCLE:
+			contact.phase += contact.speed*dt;
+			contact.x = contact.cx+contact.radius*(float)cos(contact.phase);
+			contact.y = contact.cy+contact.radius*(float)sin(contact.phase);
+			break;
+		case RANDOM_WALK: {
+			float step = 0.5f*dt;
+			float dx = step*(float)(2*random.uniform()-1);
+			float dy = step*(float)(2*random.uniform()-1);
+			contact.x = bounce(contact.x+dx, dx);
+			contact.y = bounce(contact.y+dy, dy);
+			break;
+		}
+	}
+}
+
+void Sensor::sendFrame(TuioTime frameTime, Counters &counters) {
+	float dt = (options.fps>0) ? 1.0f/options.fps : 1.0f/60;
+	server->initFrame(frameTime);
+
+	churnCredit += options.churn*dt;
+	while ((churnCredit>=1) && !contacts.empty()) {
+		churnCredit -= 1;
+		Contact &contact = contacts[random.below((int)contacts.size())];
+		server->removeTuioCursor(contact.cursor);
+		place(contact);
+		contact.cursor = server->addTuioCursor(contact.x, contact.y);
+		counters.removed++;
+		counters.added++;
+	}
+
+	for (size_t i=0; i<contacts.size(); i++) {
+		move(contacts[i], dt);
+		server->updateTuioCursor(contacts[i].cursor, contacts[i].x, contacts[i].y);
+	}
+	server->commitFrame();
+	counters.frames++;
+
+	forward(counters);
+}
+
+void Sensor::transmit(const char *data, int size, Counters &counters) {
+	if (sendto(sendSocket, data, size, 0, (struct sockaddr*)&destination, sizeof(destination))==size) {
+		counters.packets++;
+		counters.bytes += size;
+	}
+}
+
+// forwards the datagrams the server sent for the last frame, with the impairments applied
+void Sensor::forward(Counters &counters) {
+	char buffer[MAX_UDP_SIZE];
+	int size;
+	while ((size = (int)recv(stageSocket, buffer, sizeof(buffer), MSG_DONTWAIT))>=0) {
+		// held packets leave after the given number of later packets
+		for (int i=0; i<MAX_HELD; i++) {
+			if ((heldSize[i]>0) && (--heldDelay[i]<=0)) {
+				transmit(&held[i][0], heldSize[i], counters);
+				heldSize[i] = 0;
+			}
+		}
+
+		if (random.chance(options.loss)) {
+			counters.dropped++;
+			continue;
+		}
+		if (random.chance(options.reorder)) {
+			int slot = -1;
+			for (int i=0; i<MAX_HELD; i++) if (heldSize[i]==0) { slot = i; break; }
+			if (slot>=0) {
+				held[slot].assign(buffer, buffer+size);
+				heldSize[slot] = size;
+				heldDelay[slot] = 1+random.below(MAX_HELD);
+				counters.reordered++;
+				continue;
+			}
+		}
+		transmit(buffer, size, counters);
+		if (random.chance(options.duplicate)) {
+			transmit(buffer, size, counters);
+			counters.duplicated++;
+		}
+	}
+}
+
+void Sensor::flush(Counters &counters) {
+	for (int i=0; i<MAX_HELD; i++) {
+		if (heldSize[i]>0) transmit(&held[i][0], heldSize[i], counters);
+		heldSize[i] = 0;
+	}
+}
+
+static void accumulate(Counters &total, const Counters &counters) {
+	total.frames += counters.frames;
+	total.packets += counters.packets;
+	total.bytes += counters.bytes;
+	total.late += counters.late;
+	total.dropped += counters.dropped;
+	total.reordered += counters.reordered;
+	total.duplicated += counters.duplicated;
+	total.added += counters.added;
+	total.removed += counters.removed;
+}
+
+static void report(const char *label, const Counters &counters, double seconds) {
+	printf("%-8s %9.0f frames/s %9.0f packets/s %8.2f MB/s  late %lld  dropped %lld reordered %lld duplicated %lld  added %lld removed %lld\n",
+		label, counters.frames/seconds, counters.packets/seconds, counters.bytes/seconds/1e6, counters.late,
+		counters.dropped, counters.reordered, counters.duplicated, counters.added, counters.removed);
+}
+
+static void usage() {
+	printf("usage: LoadGenerator [-h host] [-p port] [-s sensors] [-n cursors] [-r fps] [-t seconds]\n"
+		"                     [-m still|linear|circle|random] [-c churn] [-l loss%%] [-o reorder%%] [-d duplicate%%]\n"
+		"                     [-u mtu] [-k keyframe interval] [-x seed] [-q]\n");
+}
+
+int main(int argc, char *argv[]) {
+	Options options;
+	options.host = "127.0.0.1";
+	options.port = 3333;
+	options.sensors = 1;
+	options.cursors = 10;
+	options.fps = 60;
+	options.seconds = 10;
+	options.model = LINEAR;
+	options.churn = options.loss = options.reorder = options.duplicate = 0;
+	options.mtu = IP_MTU_SIZE;
+	options.keyframeInterval = 0;
+	options.seed = 1;
+	options.quiet = false;
+
+	int option;
+	while ((option = getopt(argc, argv, "h:p:s:n:r:t:m:c:l:o:d:u:k:x:q"))!=-1) {
+		switch (option) {
+			case 'h': options.host = optarg; break;
+			case 'p': options.port = atoi(optarg); break;
+			case 's': options.sensors = atoi(optarg); break;
+			case 'n': options.cursors = atoi(optarg); break;
+			case 'r': options.fps = atoi(optarg); break;
+			case 't': options.seconds = atof(optarg); break;
+			case 'm':
+				if (strcmp(optarg, "still")==0) options.model = STILL;
+				else if (strcmp(optarg, "linear")==0) options.model = LINEAR;
+				else if (strcmp(optarg, "circle")==0) options.model = CIRCLE;
+				else if (strcmp(optarg, "random")==0) options.model = RANDOM_WALK;
+				else { usage(); return 1; }
+				break;
+			case 'c': options.churn = atof(optarg); break;
+			case 'l': options.loss = atof(optarg); break;
+			case 'o': options.reorder = atof(optarg); break;
+			case 'd': options.duplicate = atof(optarg); break;
+			case 'u': options.mtu = atoi(optarg); break;
+			case 'k': options.keyframeInterval = atoi(optarg); break;
+			case 'x': options.seed = strtoull(optarg, NULL, 10); break;
+			case 'q': options.quiet = true; break;
+			default: usage(); return 1;
+		}
+	}
+	if ((options.sensors<1) || (options.sensors>MAX_SENSORS) || (options.cursors<0) || (options.fps<0) || (options.seconds<=0) ||
+		(options.port<1) || (options.port+options.sensors>65536) || ((options.mtu!=0) && (options.mtu<MIN_UDP_SIZE))) {
+		usage();
+		return 1;
+	}
+
+	struct addrinfo hints, *address;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo(options.host, NULL, &hints, &address)!=0) {
+		printf("unknown host %s\n", options.host);
+		return 1;
+	}
+
+	std::vector<Sensor*> sensors;
+	for (int i=0; i<options.sensors; i++) {
+		struct sockaddr_in destination = *(struct sockaddr_in*)address->ai_addr;
+		destination.sin_port = htons(options.port+i);
+		sensors.push_back(new Sensor(options, i, destination));
+	}
+	freeaddrinfo(address);
+
+	if (!options.quiet) {
+		printf("%d sensors on ports %d-%d, %d cursors each, %d fps, seed %llu\n", options.sensors, options.port,
+			options.port+options.sensors-1, options.cursors, options.fps, options.seed);
+	}
+
+	Counters total, interval;
+	memset(&total, 0, sizeof(total));
+	memset(&interval, 0, sizeof(interval));
+
+	long long period = (options.fps>0) ? 1000000000LL/options.fps : 0;
+	long long start = now();
+	long long end = start+(long long)(options.seconds*1e9);
+	long long nextReport = start+1000000000LL;
+	long long intervalStart = start;
+	// the unpaced frames are a millisecond apart for the receivers
+	long long frameMicroseconds = (period>0) ? period/1000 : 1000;
+	for (long long frame=0; ; frame++) {
+		long long deadline = start+frame*period;
+		if (deadline>=end) break;
+		if (period>0) {
+			long long current = now();
+			if (current<deadline) sleepUntil(deadline);
+			else if (current-deadline>period) interval.late++;
+		} else if (now()>=end) break;
+
+		long long microseconds = (frame+1)*frameMicroseconds;
+		TuioTime frameTime((long)(microseconds/1000000), (long)(microseconds%1000000));
+		for (size_t i=0; i<sensors.size(); i++) sensors[i]->sendFrame(frameTime, interval);
+
+		long long current = now();
+		if (current>=nextReport) {
+			if (!options.quiet) report("second", interval, (current-intervalStart)/1e9);
+			accumulate(total, interval);
+			memset(&interval, 0, sizeof(interval));
+			intervalStart = current;
+			nextReport += 1000000000LL;
+		}
+	}
+
+	for (size_t i=0; i<sensors.size(); i++) sensors[i]->flush(interval);
+	accumulate(total, interval);
+	report("total", total, (now()-start)/1e9);
+
+	for (size_t i=0; i<sensors.size(); i++) delete sensors[i];
+	return 0;
+}